@@ -0,0 +1,99 @@
+namespace eval breakpoint_machine_test {
+
+set_help_text breakpoint_machine_test \
+{Checks that the condition and the command of a breakpoint are evaluated in the
+machine that triggered the breakpoint, also when that isn't the active machine
+(see 'batch_run -debug').
+
+ usage:
+   breakpoint_machine_test ?-machine <config>?
+
+Runs the same program on two new (inactive) machines, each with a different
+value in register A and in memory. Both have a breakpoint with a condition that
+is evaluated natively (see 'help debug set_bp') and one with a condition that
+needs Tcl. The commands of the breakpoints record the machine (and its
+register A) in which they're executed.
+
+The default machine is C-BIOS_MSX2+, any machine works:
+   openmsx -command "set renderer none" -command "after realtime 0 {puts \[breakpoint_machine_test\] ; exit}"
+
+Returns the list of recorded hits, throws an error when it's not the expected
+one.
+}
+
+variable bp_addr 0xC105
+variable hits [list]
+
+# ld a,<value> ; ld (0xC000),a ; nop (breakpoint) ; di ; halt
+proc program {value} {
+	binary format c* [list 0x3E $value 0x32 0x00 0xC0 0x00 0xF3 0x76]
+}
+
+proc hit {kind} {
+	variable hits
+	lappend hits [list $kind [machine] [format 0x%02X [reg A]]]
+}
+
+proc breakpoint_machine_test {args} {
+	variable bp_addr
+	variable hits
+
+	set config "C-BIOS_MSX2+"
+	while {[llength $args] > 0} {
+		set option [lindex $args 0]
+		switch -- $option {
+			"-machine" {
+				set config [lindex $args 1]
+				set args [lrange $args 2 end]
+			}
+			default {
+				error "Invalid option: $option"
+			}
+		}
+	}
+
+	set ids [list]
+	set bps [list]
+	set hits [list]
+	try {
+		foreach value {0x11 0x22} {
+			set id [create_machine]
+			lappend ids $id
+			${id}::load_machine $config
+			batch_run 3 $id
+			${id}::debug write_block memory 0xC100 [program $value]
+			${id}::debug write "CPU regs" 20 0xC1 ;# PC
+			${id}::debug write "CPU regs" 21 0x00
+		}
+		lassign $ids id1 id2
+
+		# Breakpoints are shared by all machines.
+		set ns [namespace current]
+		lappend bps [debug set_bp $bp_addr {[reg A] == 0x22} \
+			[list ${ns}::hit compiled]]
+		lappend bps [debug set_bp $bp_addr {[peek 0xC000] == [expr {0x11}]} \
+			[list ${ns}::hit tcl]]
+
+		set status [batch_run -debug 0.1 {*}$ids]
+		foreach id $ids {
+			if {[dict exists $status $id error]} {
+				error [dict get $status $id error]
+			}
+		}
+	} finally {
+		foreach bp $bps { debug remove_bp $bp }
+		foreach id $ids { delete_machine $id }
+	}
+
+	set expected [lsort [list [list tcl $id1 0x11] [list compiled $id2 0x22]]]
+	if {[lsort $hits] ne $expected} {
+		error "Expected hits: $expected, got: $hits"
+	}
+	return $hits
+}
+
+namespace export breakpoint_machine_test
+
+} ;# namespace breakpoint_machine_test
+
+namespace import breakpoint_machine_test::*
@@ -0,0 +1,309 @@
+namespace eval cpu_benchmark {
+
+set_help_text cpu_benchmark \
+{Reproducible benchmark for the Z80/R800 emulation.
+
+ usage:
+   cpu_benchmark ?-cpu z80|r800? ?-machine <config>? ?-duration <seconds>?
+                 ?-conditions <n>? ?<workload> ...?
+
+Creates a new (inactive) machine, lets it boot, replaces the running program
+by a synthetic workload and runs it for <duration> (default 10) emulated
+seconds with batch_run in turbo mode (so without video and sound). Reports
+the host time per emulated instruction and per emulated clock cycle.
+
+Workloads (default all of them):
+   alu    mix of arithmetic, logic, rotate, bit, 16-bit, index-register,
+          exchange, stack and call instructions (like the zexall loops)
+   ldir   block moves
+   irq    line interrupt on every VDP line, handled in IM 2
+   io     I/O port access (VDP, PSG, PPI) and the memory mapped
+          secondary slot select register
+
+-cpu z80 uses the C-BIOS_MSX2+ machine by default, -cpu r800 the
+Panasonic_FS-A1GT (this requires the system ROMs). The machine must be an MSX2
+or higher (the irq workload needs line interrupts), in case of R800 a turbo R
+that runs in R800 mode after boot.
+
+The workloads are fully deterministic, so two runs always execute exactly the
+same instructions. To evaluate a change in the CPU emulation, run this in both
+builds and compare the results. For example build once with and once without
+USE_COMPUTED_GOTO (the super-opt flavour enables it) and run:
+   openmsx -command "set renderer none" -command "after realtime 0 {puts \[cpu_benchmark\] ; exit}"
+
+-conditions <n> activates <n> debug conditions during the run. They never
+trigger, but they are checked after every instruction. This measures the
+overhead of conditions, e.g. compare the results for 0, 1 and 10 conditions:
+   foreach n {0 1 10} {puts "$n: [cpu_benchmark -conditions $n alu]"}
+With this option the workload runs with 'batch_run -debug' (the normal CPU
+loop instead of the fast-forward loop, which ignores conditions), also for
+-conditions 0, so that the results are comparable.
+
+Returns a dictionary with for each workload the number of emulated
+instructions, the ns per instruction, the ns per clock cycle and the number
+of emulated instructions per second.
+}
+
+set_tabcompletion_proc cpu_benchmark [namespace code tab_cpu_benchmark]
+
+proc tab_cpu_benchmark {args} {
+	variable workloads
+	if {[lindex $args end-1] eq "-cpu"} {
+		return [list z80 r800]
+	}
+	concat -cpu -machine -duration -conditions [dict keys $workloads]
+}
+
+# Memory layout, all in page 3 which is RAM on every MSX after boot.
+variable counter     0xC0F0 ;# 32-bit loop iteration counter
+variable irq_counter 0xC0F4 ;# 32-bit interrupt counter
+variable line        0xC0F8 ;# line of the next line interrupt
+variable sub         0xC0FF ;# 'ret', called from the alu workload
+variable start       0xC100 ;# start of the workload
+variable im2_table   0xC200 ;# 257 bytes 0xC4, so the handler is at 0xC4C4
+variable handler     0xC4C4
+
+# Z80 machine code for the body of each workload loop, and the number of
+# instructions in that body (LDIR counts as one instruction per byte, that's
+# also how the CPU emulation executes it).
+variable workloads [dict create \
+	alu [list 32 {
+		0x80 0x91 0xA2 0xB3 0xAC        ;# add a,b ; sub c ; and d ; or e ; xor h
+		0x0F 0x07                       ;# rrca ; rlca
+		0xCB 0x10 0xCB 0x39 0xCB 0x42   ;# rl b ; srl c ; bit 0,d
+		0xCB 0xC3 0xCB 0x83             ;# set 0,e ; res 0,e
+		0x04 0x0D                       ;# inc b ; dec c
+		0x09 0xED 0x42                  ;# add hl,bc ; sbc hl,bc
+		0xDD 0x23 0xFD 0x2B             ;# inc ix ; dec iy
+		0xDD 0x7E 0x00                  ;# ld a,(ix+0)
+		0x27 0x2F 0x3F 0x37 0xED 0x44   ;# daa ; cpl ; ccf ; scf ; neg
+		0xD9 0x08 0xD9 0x08             ;# exx ; ex af,af' ; exx ; ex af,af'
+		0xC5 0xD1                       ;# push bc ; pop de
+		0xCD 0xFF 0xC0                  ;# call sub (ret)
+	}] \
+	ldir [list [expr {3 + 0x400}] {
+		0x21 0x00 0xD0                  ;# ld hl,0xD000
+		0x11 0x00 0xD8                  ;# ld de,0xD800
+		0x01 0x00 0x04                  ;# ld bc,0x0400
+		0xED 0xB0                       ;# ldir
+	}] \
+	irq [list 0 {}] \
+	io [list 12 {
+		0xD3 0x98 0xDB 0x98             ;# out (0x98),a ; in a,(0x98)
+		0x3E 0x08 0xD3 0xA0 0xD3 0xA1   ;# ld a,8 ; out (0xA0),a ; out (0xA1),a
+		0xDB 0xA2                       ;# in a,(0xA2)
+		0xDB 0xA8 0xDB 0xAA 0xD3 0xAA   ;# in a,(0xA8) ; in a,(0xAA) ; out (0xAA),a
+		0x3A 0xFF 0xFF 0x2F             ;# ld a,(0xFFFF) ; cpl
+		0x32 0xFF 0xFF                  ;# ld (0xFFFF),a
+	}]]
+
+# Condition for the -conditions option: never true, but not trivially false
+# either (the first term needs a memory read).
+variable condition {[peek [reg SP]] == 0x99 && [reg SP] == 0}
+
+# Number of instructions in the loop tail (in the common case).
+variable tail_instructions 6
+
+# IM 2 interrupt handler: acknowledge the line and vblank interrupt, program
+# the line interrupt for the next line and count the interrupt.
+variable handler_instructions 28
+variable handler_code {
+	0xF5                                    ;# push af
+	0x3E 0x01 0xD3 0x99 0x3E 0x8F 0xD3 0x99 ;# ld a,1 ; out (0x99),a ; ld a,0x8F ; out (0x99),a
+	0xDB 0x99                               ;# in a,(0x99)  (S#1: ack line interrupt)
+	0xAF 0xD3 0x99 0x3E 0x8F 0xD3 0x99      ;# xor a ; out (0x99),a ; ld a,0x8F ; out (0x99),a
+	0xDB 0x99                               ;# in a,(0x99)  (S#0: ack vblank interrupt)
+	0x3A 0xF8 0xC0 0x3C 0x32 0xF8 0xC0      ;# ld a,(line) ; inc a ; ld (line),a
+	0xD3 0x99 0x3E 0x93 0xD3 0x99           ;# out (0x99),a ; ld a,0x93 ; out (0x99),a  (R#19)
+	0xE5                                    ;# push hl
+	0x2A 0xF4 0xC0 0x23 0x22 0xF4 0xC0      ;# ld hl,(irq_counter) ; inc hl ; ld (irq_counter),hl
+	0x7C 0xB5 0x20 0x07                     ;# ld a,h ; or l ; jr nz,+7
+	0x2A 0xF6 0xC0 0x23 0x22 0xF6 0xC0      ;# ld hl,(irq_counter+2) ; inc hl ; ld (irq_counter+2),hl
+	0xE1 0xF1                               ;# pop hl ; pop af
+	0xFB 0xED 0x4D                          ;# ei ; reti
+}
+
+proc strip_comments {code} {
+	regsub -all -line {;#.*$} $code {}
+}
+
+proc lo {addr} { expr {$addr & 0xFF} }
+proc hi {addr} { expr {$addr >> 8} }
+
+proc write_code {id addr bytes} {
+	${id}::debug write_block memory $addr [binary format c* $bytes]
+}
+
+proc read_counter {id addr} {
+	binary scan [${id}::debug read_block memory $addr 4] iu result
+	return $result
+}
+
+proc load_workload {id name} {
+	variable workloads
+	variable counter
+	variable irq_counter
+	variable line
+	variable sub
+	variable start
+	variable im2_table
+	variable handler
+	variable handler_code
+
+	set body [strip_comments [lindex [dict get $workloads $name] 1]]
+
+	# di ; ld sp,0xF000 ; ld a,hi(im2_table) ; ld i,a ; im 2 ; (ei)
+	set code [list 0xF3 0x31 0x00 0xF0 0x3E [hi $im2_table] 0xED 0x47 0xED 0x5E]
+	if {$name eq "irq"} {
+		lappend code 0xFB
+	}
+	set loop [expr {$start + [llength $code]}]
+	lappend code {*}$body
+	# 32-bit iteration counter:
+	#   ld hl,(counter) ; inc hl ; ld (counter),hl ; ld a,h ; or l ; jp nz,loop
+	#   ld hl,(counter+2) ; inc hl ; ld (counter+2),hl ; jp loop
+	lappend code 0x2A [lo $counter] [hi $counter] 0x23 \
+	             0x22 [lo $counter] [hi $counter] 0x7C 0xB5 \
+	             0xC2 [lo $loop] [hi $loop] \
+	             0x2A [lo [expr {$counter + 2}]] [hi $counter] 0x23 \
+	             0x22 [lo [expr {$counter + 2}]] [hi $counter] \
+	             0xC3 [lo $loop] [hi $loop]
+
+	write_code $id $counter [lrepeat 9 0] ;# counters and line
+	write_code $id $sub [list 0xC9]
+	write_code $id $start $code
+	write_code $id $im2_table [lrepeat 257 [hi $handler]]
+	write_code $id $handler [strip_comments $handler_code]
+
+	if {$name eq "irq"} {
+		# enable the line interrupt, first one on line 0
+		set r0 [${id}::debug read "VDP regs" 0]
+		${id}::debug write "VDP regs" 0 [expr {$r0 | 0x10}]
+		${id}::debug write "VDP regs" 19 0
+	}
+	${id}::debug write "CPU regs" 20 [hi $start] ;# PC
+	${id}::debug write "CPU regs" 21 [lo $start]
+}
+
+proc run_workload {cpu config duration conditions debug name} {
+	variable workloads
+	variable condition
+	variable counter
+	variable irq_counter
+	variable tail_instructions
+	variable handler_instructions
+
+	set id [create_machine]
+	try {
+		${id}::load_machine $config
+		# let the BIOS initialize the hardware (memory, VDP)
+		batch_run 3 $id
+		set active "z80"
+		catch {
+			if {([${id}::debug read "S1990 regs" 6] & 0x20) == 0} {
+				set active "r800"
+			}
+		}
+		if {$active ne $cpu} {
+			error "Machine $config runs on the [string toupper $active] instead of the [string toupper $cpu]."
+		}
+		set freq [${id}::machine_info ${cpu}_freq]
+
+		load_workload $id $name
+		set ids [list]
+		try {
+			for {set i 0} {$i < $conditions} {incr i} {
+				lappend ids [${id}::debug set_condition $condition]
+			}
+			set options [expr {$debug ? "-debug" : ""}]
+			set status [dict get [batch_run {*}$options $duration $id] $id]
+		} finally {
+			foreach cond $ids {
+				${id}::debug remove_condition $cond
+			}
+		}
+		if {[dict exists $status error]} {
+			error [dict get $status error]
+		}
+		set real_time [expr {$duration / [dict get $status speed]}]
+
+		set per_loop [expr {[lindex [dict get $workloads $name] 0] + $tail_instructions}]
+		set instructions [expr {[read_counter $id $counter] * $per_loop +
+		                        [read_counter $id $irq_counter] * $handler_instructions}]
+		set cycles [expr {$duration * $freq}]
+		return [dict create \
+			instructions $instructions \
+			ns_per_instruction [expr {1e9 * $real_time / $instructions}] \
+			ns_per_cycle [expr {1e9 * $real_time / $cycles}] \
+			instructions_per_second [expr {$instructions / $real_time}]]
+	} finally {
+		delete_machine $id
+	}
+}
+
+proc cpu_benchmark {args} {
+	variable workloads
+
+	set cpu "z80"
+	set config ""
+	set duration 10
+	set conditions 0
+	set debug false
+	set names [list]
+	while {[llength $args] > 0} {
+		set option [lindex $args 0]
+		switch -- $option {
+			"-cpu" {
+				set cpu [string tolower [lindex $args 1]]
+				if {$cpu ni {z80 r800}} {
+					error "Unknown CPU type: [lindex $args 1], must be z80 or r800."
+				}
+				set args [lrange $args 2 end]
+			}
+			"-machine" {
+				set config [lindex $args 1]
+				set args [lrange $args 2 end]
+			}
+			"-duration" {
+				set duration [lindex $args 1]
+				set args [lrange $args 2 end]
+			}
+			"-conditions" {
+				set conditions [lindex $args 1]
+				set debug true
+				set args [lrange $args 2 end]
+			}
+			default {
+				if {![dict exists $workloads $option]} {
+					error "Unknown workload: $option, must be one of: [dict keys $workloads]."
+				}
+				lappend names $option
+				set args [lrange $args 1 end]
+			}
+		}
+	}
+	if {$config eq ""} {
+		set config [expr {($cpu eq "z80") ? "C-BIOS_MSX2+" : "Panasonic_FS-A1GT"}]
+	}
+	if {[llength $names] == 0} {
+		set names [dict keys $workloads]
+	}
+
+	set old_turbo $::turbo
+	set ::turbo true
+	set result [dict create]
+	try {
+		foreach name $names {
+			dict set result $name [run_workload $cpu $config $duration $conditions $debug $name]
+		}
+	} finally {
+		set ::turbo $old_turbo
+	}
+	return $result
+}
+
+namespace export cpu_benchmark
+
+} ;# namespace cpu_benchmark
+
+namespace import cpu_benchmark::*
@@ -0,0 +1,134 @@
+namespace eval replay_cache_test {
+
+set_help_text replay_cache_test \
+{Checks that jumping around in a replay that was loaded with a snapshot cache
+(see 'reverse build_cache' and 'reverse loadreplay -cache') gives the same
+machine state as without the cache.
+
+ usage:
+   replay_cache_test ?-machine <config>?
+
+Records a replay with some key presses in a new (inactive) machine and builds
+its snapshot cache. Then the replay is loaded with the cache, replayed past one
+of the cached snapshots (while replaying, new snapshots replace the cached
+ones) and then it goes back to a moment right after that snapshot. The state
+of the machine (memory and CPU registers) is compared to the state at that
+same moment when the replay is loaded without the cache.
+
+The default machine is C-BIOS_MSX2+, any machine works:
+   openmsx -command "set renderer none" -command "after realtime 0 {puts \[replay_cache_test\] ; exit}"
+
+Returns the time that was compared, throws an error when the states differ.
+}
+
+# IDs of the machines created by this test (some may no longer exist).
+variable created [list]
+
+proc create {} {
+	variable created
+	set id [create_machine]
+	lappend created $id
+	return $id
+}
+
+# Both 'reverse loadreplay' and 'reverse goto' (usually) replace the machine,
+# then it gets a new ID.
+proc new_machine {id old_ids} {
+	variable created
+	if {$id in [list_machines]} { return $id }
+	foreach id [list_machines] {
+		if {$id ni $old_ids} {
+			lappend created $id
+			return $id
+		}
+	}
+	error "No new machine found."
+}
+
+proc run {id seconds} {
+	set status [dict get [batch_run $seconds $id] $id]
+	if {[dict exists $status error]} {
+		error [dict get $status error]
+	}
+}
+
+proc machine_state {id} {
+	list [${id}::debug read_block memory 0 0x10000] \
+	     [${id}::debug read_block "CPU regs" 0 [${id}::debug size "CPU regs"]]
+}
+
+# Load the replay in a new machine and go to the given time, returns the ID
+# of the machine.
+proc load_and_goto {config replay options time {run_first 0}} {
+	set id [create]
+	${id}::load_machine $config
+	set ids [list_machines]
+	${id}::reverse loadreplay {*}$options $replay
+	set id [new_machine $id $ids]
+	if {$run_first > 0} { run $id $run_first }
+	set ids [list_machines]
+	${id}::reverse goto $time
+	new_machine $id $ids
+}
+
+proc replay_cache_test {args} {
+	variable created
+
+	set config "C-BIOS_MSX2+"
+	while {[llength $args] > 0} {
+		set option [lindex $args 0]
+		switch -- $option {
+			"-machine" {
+				set config [lindex $args 1]
+				set args [lrange $args 2 end]
+			}
+			default {
+				error "Invalid option: $option"
+			}
+		}
+	}
+
+	close [file tempfile replay replay_cache_test.omr]
+	set created [list]
+	try {
+		# record a replay of 12 seconds
+		set id [create]
+		${id}::load_machine $config
+		${id}::reverse start
+		foreach row {4 5 6} {
+			run $id 1.5
+			${id}::keymatrixdown $row 0x01
+			run $id 1.5
+			${id}::keymatrixup $row 0x01
+		}
+		run $id 3
+		${id}::reverse savereplay $replay
+		set begin [dict get [${id}::reverse status] begin]
+		${id}::reverse build_cache $replay
+
+		# A bit after the cached snapshot at 5 seconds (the cache has a
+		# snapshot every 5 seconds).
+		set time [expr {$begin + 5.3}]
+
+		set id [load_and_goto $config $replay {} $time]
+		set expected [machine_state $id]
+
+		# Replay for 8 seconds, this replaces the cached snapshots.
+		set id [load_and_goto $config $replay {-cache} $time 8]
+		if {[machine_state $id] ne $expected} {
+			error "State at $time differs when using the snapshot cache."
+		}
+	} finally {
+		foreach id $created {
+			if {$id in [list_machines]} { delete_machine $id }
+		}
+		file delete -- $replay $replay.cache
+	}
+	return $time
+}
+
+namespace export replay_cache_test
+
+} ;# namespace replay_cache_test
+
+namespace import replay_cache_test::*
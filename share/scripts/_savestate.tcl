@@ -11,7 +11,19 @@ proc savestate_common {} {
 	}
 }
 
-proc savestate {{name ""}} {
+user_setting create boolean savestate_binary \
+{Store savestates in the binary format (loads faster, but only usable with the same openMSX build).} false
+
+proc savestate {args} {
+	set binary $::savestate_binary
+	if {[lindex $args 0] eq "-binary"} {
+		set binary true
+		set args [lrange $args 1 end]
+	}
+	if {[llength $args] > 1} {
+		error "wrong # args: should be \"savestate ?-binary? ?name?\""
+	}
+	set name [lindex $args 0]
 	savestate_common
 	file mkdir $directory
 	if {[catch {screenshot -raw -doublesize $png}]} {
@@ -23,7 +35,11 @@ proc savestate {{name ""}} {
 		}
 	}
 	set currentID [machine]
-	store_machine $currentID $fullname
+	if {$binary} {
+		store_machine -binary $currentID $fullname
+	} else {
+		store_machine $currentID $fullname
+	}
 	return $name
 }
 
@@ -92,21 +108,27 @@ proc savestate_tab {args} {
 	list_savestates
 }
 
+proc savestate_save_tab {args} {
+	concat -binary [list_savestates]
+}
+
 proc savestate_list_tab {args} {
 	list "-t"
 }
 
 # savestate
 set_help_text savestate \
-{savestate [<name>]
+{savestate [-binary] [<name>]
 
 Create a snapshot of the current emulated MSX machine.
 
 Optionally you can specify a name for the savestate. If you omit this the default name 'quicksave' will be taken.
 
+With -binary (or when the 'savestate_binary' setting is enabled) the snapshot is stored in the binary format. That loads a lot faster, but it can only be loaded by the exact same openMSX build, see 'help store_machine'.
+
 See also 'loadstate', 'list_savestates', 'delete_savestate'.
 }
-set_tabcompletion_proc savestate [namespace code savestate_tab]
+set_tabcompletion_proc savestate [namespace code savestate_save_tab]
 
 # loadstate
 set_help_text loadstate \
@@ -116,6 +138,8 @@ Restore a previously created savestate.
 
 You can specify the name of the savestate that should be loaded. If you omit this name, the default savestate will be loaded.
 
+Both the XML and the binary format (see 'savestate -binary') are recognized.
+
 See also 'savestate', 'list_savestates', 'delete_savestate'.
 }
 set_tabcompletion_proc loadstate [namespace code savestate_tab]
@@ -0,0 +1,98 @@
+namespace eval savestate_benchmark {
+
+set_help_text savestate_benchmark \
+{Benchmark for storing and restoring savestates, in the XML and in the binary
+format.
+
+ usage:
+   savestate_benchmark ?-machine <config>? ?-iterations <n>?
+
+Creates a new (inactive) machine and lets it boot. Then it stores that
+machine <n> (default 10) times with 'store_machine' and restores it <n> times
+with 'restore_machine', once for each format. These are the same commands
+the 'savestate' and 'loadstate' scripts use, so this measures everything:
+serializing all devices, compression, file I/O and for restore also creating
+the new machine. Only deleting the restored machines is not included.
+
+The default machine is C-BIOS_MSX2+. A machine with a lot of RAM gives a
+better idea of the cost of the large blocks, e.g.:
+   openmsx -command "set renderer none" -command "after realtime 0 {puts \[savestate_benchmark -machine Panasonic_FS-A1GT\] ; exit}"
+
+Returns a dictionary with for each format the ms per store, the ms per
+restore and the file size in kB.
+}
+
+set_tabcompletion_proc savestate_benchmark [namespace code tab_savestate_benchmark]
+
+proc tab_savestate_benchmark {args} {
+	list -machine -iterations
+}
+
+# Average time in ms of executing 'script' (in the caller's scope) n times.
+proc time_ms {n script} {
+	set start [clock microseconds]
+	for {set i 0} {$i < $n} {incr i} {
+		uplevel 1 $script
+	}
+	expr {([clock microseconds] - $start) / (1000.0 * $n)}
+}
+
+proc run_format {id filename iterations options} {
+	set store_ms [time_ms $iterations {store_machine {*}$options $id $filename}]
+	set restored [list]
+	try {
+		set restore_ms [time_ms $iterations {lappend restored [restore_machine $filename]}]
+	} finally {
+		foreach r $restored {delete_machine $r}
+	}
+	return [dict create \
+		store_ms $store_ms \
+		restore_ms $restore_ms \
+		size_kB [expr {[file size $filename] / 1024}]]
+}
+
+proc savestate_benchmark {args} {
+	set config "C-BIOS_MSX2+"
+	set iterations 10
+	while {[llength $args] > 0} {
+		set option [lindex $args 0]
+		switch -- $option {
+			"-machine" {
+				set config [lindex $args 1]
+				set args [lrange $args 2 end]
+			}
+			"-iterations" {
+				set iterations [lindex $args 1]
+				set args [lrange $args 2 end]
+			}
+			default {
+				error "Invalid option: $option"
+			}
+		}
+	}
+	if {$iterations < 1} {
+		error "The number of iterations must be at least 1."
+	}
+
+	close [file tempfile filename savestate_benchmark.oms]
+	set id [create_machine]
+	try {
+		${id}::load_machine $config
+		# let the BIOS initialize the hardware (memory, VDP)
+		batch_run 3 $id
+
+		set result [dict create]
+		dict set result xml    [run_format $id $filename $iterations {}]
+		dict set result binary [run_format $id $filename $iterations -binary]
+		return $result
+	} finally {
+		delete_machine $id
+		file delete -- $filename
+	}
+}
+
+namespace export savestate_benchmark
+
+} ;# namespace savestate_benchmark
+
+namespace import savestate_benchmark::*
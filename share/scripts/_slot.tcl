@@ -114,7 +114,7 @@ proc address_in_slot {addr ps {ss "X"} {block "X"}} {
 	if {($ss ne "X") && ($pc_ss ne "X") && ($pc_ss != $ss)} {return 0}
 
 	# need to check block?
-	if {$block eq "X"} {return true}
+	if {$block eq "X"} {return 1}
 
 	# first (try to) check memory mapper
 	if {$pc_ss eq "X"} {set pc_ss 0}
@@ -0,0 +1,98 @@
+namespace eval turbo_sound_test {
+
+set_help_text turbo_sound_test \
+{Checks that the sound devices keep running while sound synthesis is skipped
+(see the turbo setting).
+
+ usage:
+   turbo_sound_test ?-machine <config>?
+
+Inserts a Konami Keyboard Master cartridge with a generated voice ROM in a new
+(inactive) machine, starts a phrase on its VLM5030 and runs the machine in
+turbo mode. The BSY pin of the VLM5030 is only updated while the chip
+generates its samples, so when that doesn't happen in turbo mode, BSY never
+drops.
+
+The default machine is C-BIOS_MSX2+, any machine with a cartridge slot works:
+   openmsx -command "set renderer none" -command "after realtime 0 {puts \[turbo_sound_test\] ; exit}"
+
+Returns the emulated time (in seconds) it took before BSY dropped, throws an
+error when it didn't drop.
+}
+
+# Voice ROM with one phrase (number 0): some silent frames and an end mark.
+proc voice_rom {} {
+	set rom [binary format cc 0x00 0x10]
+	append rom [string repeat "\0" 14]
+	append rom [binary format cc 0x1D 0x03]
+	append rom [string repeat "\0" [expr {0x100 - [string length $rom]}]]
+}
+
+proc write_file {filename data} {
+	set f [open $filename wb]
+	puts -nonewline $f $data
+	close $f
+}
+
+proc bsy {id} {
+	expr {([${id}::debug read ioports 0x00] & 0x10) != 0}
+}
+
+proc turbo_sound_test {args} {
+	set config "C-BIOS_MSX2+"
+	while {[llength $args] > 0} {
+		set option [lindex $args 0]
+		switch -- $option {
+			"-machine" {
+				set config [lindex $args 1]
+				set args [lrange $args 2 end]
+			}
+			default {
+				error "Invalid option: $option"
+			}
+		}
+	}
+
+	# The voice ROM is found next to the cartridge ROM: <name>_voice.rom
+	close [file tempfile rom turbo_sound_test.rom]
+	set voice "[file rootname $rom]_voice.rom"
+	set old_turbo $::turbo
+	set id [create_machine]
+	try {
+		write_file $rom [string repeat "\0" 0x4000]
+		write_file $voice [voice_rom]
+		${id}::load_machine $config
+		${id}::carta insert $rom -romtype KeyboardMaster
+		batch_run 1 $id
+
+		set ::turbo true
+		# Start phrase 0: latch the phrase number, then ST high and low.
+		${id}::debug write ioports 0x00 0
+		${id}::debug write ioports 0x20 0x02
+		${id}::debug write ioports 0x20 0x00
+		if {![bsy $id]} {
+			error "VLM5030 isn't busy after starting the phrase."
+		}
+		set step 0.05
+		for {set t $step} {$t <= 2} {set t [expr {$t + $step}]} {
+			set status [dict get [batch_run $step $id] $id]
+			if {[dict exists $status error]} {
+				error [dict get $status error]
+			}
+			if {![bsy $id]} {
+				return $t
+			}
+		}
+		error "VLM5030 stays busy in turbo mode."
+	} finally {
+		set ::turbo $old_turbo
+		delete_machine $id
+		file delete -- $rom $voice
+	}
+}
+
+namespace export turbo_sound_test
+
+} ;# namespace turbo_sound_test
+
+namespace import turbo_sound_test::*
@@ -0,0 +1,256 @@
+namespace eval vdp_cmd_benchmark {
+
+set_help_text vdp_cmd_benchmark \
+{Reproducible benchmark for the emulation of the VDP block commands.
+
+ usage:
+   vdp_cmd_benchmark ?-machine <config>? ?-duration <seconds>? ?-mode <mode>?
+                     ?<workload> ...?
+
+Creates a new (inactive) machine, lets it boot, switches to the given display
+mode and replaces the running program by a loop that executes full screen
+(256x212 or 512x212) VDP commands back to back. It runs this for <duration>
+(default 10) emulated seconds with batch_run in turbo mode (so without video
+and sound). Reports the host time per VDP command and the number of emulated
+pixels per host second.
+
+Modes (-mode can be given several times, default all of them):
+   G4 G5 G6 G7   Graphic 4 to 7 (screen 5 to 8)
+
+Workloads (default all of them):
+   hmmv   fill (high speed)
+   hmmm   copy (high speed)
+   lmmv   fill with a logical operation
+   lmmm   copy with a logical operation
+
+Each workload alternates between two commands that change the VRAM content
+(different colors or different source areas). The destination is page 1,
+which is not displayed.
+
+Each workload runs twice: once with the vdpcmdfastpath setting enabled
+('fast') and once with it disabled ('exact'). A machine that runs in
+batch_run is never rendered, so there the fast path is always possible. But
+while rendering, the commands take the 'exact' path in Graphic 6 and 7 and
+when they write to the displayed page in Graphic 4 and 5. So 'fast' is the
+best case and 'exact' is the normal case of most games.
+
+The default machine is C-BIOS_MSX2+, any MSX2 or higher works. The workloads
+are fully deterministic (the commands take the same emulated time in each
+build). To evaluate a change in the VDP command engine, run this in both
+builds and compare the results:
+   openmsx -command "set renderer none" -command "after realtime 0 {puts \[vdp_cmd_benchmark\] ; exit}"
+
+Returns a dictionary with for each mode, for each workload and for 'fast' and
+'exact' the number of executed VDP commands, the ns per command and the
+number of pixels per second.
+}
+
+set_tabcompletion_proc vdp_cmd_benchmark [namespace code tab_vdp_cmd_benchmark]
+
+proc tab_vdp_cmd_benchmark {args} {
+	variable workloads
+	concat -machine -duration -mode [dict keys $workloads]
+}
+
+# Memory layout, all in page 3 which is RAM on every MSX after boot.
+variable counter 0xC0F0 ;# 32-bit loop iteration counter
+variable cmd1    0xC0D0 ;# register values R#32..R#46 of the first command
+variable cmd2    0xC0E0 ;# idem for the second command
+variable start   0xC100 ;# start of the workload
+
+# Height of each command, the width is the width of the screen.
+variable height 212
+
+# For each mode the values of R#0, the width of the screen and the values of
+# SY of the two copy commands: the pages 2 and 3 in Graphic 4 and 5 and two
+# areas in page 0 in Graphic 6 and 7 (these only have two pages).
+variable modes [dict create \
+	G4 {0x06 256 {512 768}} \
+	G5 {0x08 512 {512 768}} \
+	G6 {0x0A 512 {0 32}} \
+	G7 {0x0E 256 {0 32}}]
+
+# For each workload the values of the registers CLR and CMD of the two
+# commands. All commands have SX = DX = 0 and DY = 256 (page 1).
+variable workloads [dict create \
+	hmmv [list {0x11 0xC0} {0x22 0xC0}] \
+	hmmm [list {0x00 0xD0} {0x00 0xD0}] \
+	lmmv [list {0x01 0x80} {0x02 0x80}] \
+	lmmm [list {0x00 0x90} {0x00 0x90}]]
+
+proc lo {addr} { expr {$addr & 0xFF} }
+proc hi {addr} { expr {$addr >> 8} }
+
+proc write_code {id addr bytes} {
+	${id}::debug write_block memory $addr [binary format c* $bytes]
+}
+
+proc read_counter {id addr} {
+	binary scan [${id}::debug read_block memory $addr 4] iu result
+	return $result
+}
+
+# Register values R#32..R#46 for one command.
+proc command_regs {width sy clr cmd} {
+	variable height
+	list 0 0 [lo $sy] [hi $sy] 0 0 0 1 \
+	     [lo $width] [hi $width] [lo $height] [hi $height] $clr 0 $cmd
+}
+
+# Code that executes the command with the registers at the given address and
+# waits till it's done (assumes R#15 = 2):
+#   ld a,32 ; out (0x99),a ; ld a,0x91 ; out (0x99),a   (R#17 = 32)
+#   ld hl,regs ; ld bc,0x0F9B ; otir
+#   wait: in a,(0x99) ; rrca ; jr c,wait   (CE bit in S#2)
+proc command_code {regs} {
+	list 0x3E 32 0xD3 0x99 0x3E 0x91 0xD3 0x99 \
+	     0x21 [lo $regs] [hi $regs] 0x01 0x9B 0x0F 0xED 0xB3 \
+	     0xDB 0x99 0x0F 0x38 0xFB
+}
+
+proc load_workload {id mode name} {
+	variable modes
+	variable workloads
+	variable counter
+	variable cmd1
+	variable cmd2
+	variable start
+
+	lassign [dict get $modes $mode] r0 width sources
+	# display and vblank interrupt enabled, 212 lines, sprites disabled,
+	# showing page 0. The BIOS waits in a 'halt', the interrupt wakes up
+	# the CPU, which then returns to the program (that starts with 'di').
+	foreach {reg value} [list 0 $r0 1 0x60 2 0x1F 8 0x0A 9 0x80] {
+		${id}::debug write "VDP regs" $reg $value
+	}
+	# different (but deterministic) content in the source areas
+	set pattern ""
+	for {set i 0} {$i < 256} {incr i} {
+		append pattern [binary format c [expr {($i * 37) & 0xFF}]]
+	}
+	${id}::debug write_block VRAM 0 [string repeat $pattern 512]
+
+	lassign [dict get $workloads $name] regs1 regs2
+	lassign $sources sy1 sy2
+	write_code $id $cmd1 [command_regs $width $sy1 {*}$regs1]
+	write_code $id $cmd2 [command_regs $width $sy2 {*}$regs2]
+
+	# di ; ld sp,0xF000 ; ld a,2 ; out (0x99),a ; ld a,0x8F ; out (0x99),a
+	set code [list 0xF3 0x31 0x00 0xF0 0x3E 0x02 0xD3 0x99 0x3E 0x8F 0xD3 0x99]
+	set loop [expr {$start + [llength $code]}]
+	lappend code {*}[command_code $cmd1] {*}[command_code $cmd2]
+	# 32-bit iteration counter:
+	#   ld hl,(counter) ; inc hl ; ld (counter),hl ; ld a,h ; or l ; jp nz,loop
+	#   ld hl,(counter+2) ; inc hl ; ld (counter+2),hl ; jp loop
+	lappend code 0x2A [lo $counter] [hi $counter] 0x23 \
+	             0x22 [lo $counter] [hi $counter] 0x7C 0xB5 \
+	             0xC2 [lo $loop] [hi $loop] \
+	             0x2A [lo [expr {$counter + 2}]] [hi $counter] 0x23 \
+	             0x22 [lo [expr {$counter + 2}]] [hi $counter] \
+	             0xC3 [lo $loop] [hi $loop]
+
+	write_code $id $counter [lrepeat 4 0]
+	write_code $id $start $code
+	${id}::debug write "CPU regs" 20 [hi $start] ;# PC
+	${id}::debug write "CPU regs" 21 [lo $start]
+}
+
+proc run_workload {config duration mode name fast} {
+	variable counter
+	variable modes
+	variable height
+
+	set width [lindex [dict get $modes $mode] 1]
+	set id [create_machine]
+	try {
+		${id}::load_machine $config
+		# let the BIOS initialize the hardware (memory, VDP)
+		batch_run 3 $id
+
+		set ::${id}::vdpcmdfastpath $fast
+		load_workload $id $mode $name
+		set status [dict get [batch_run $duration $id] $id]
+		if {[dict exists $status error]} {
+			error [dict get $status error]
+		}
+		set real_time [expr {$duration / [dict get $status speed]}]
+
+		set commands [expr {2 * [read_counter $id $counter]}]
+		if {$commands == 0} {
+			error "No VDP command finished, increase the duration."
+		}
+		return [dict create \
+			commands $commands \
+			ns_per_command [expr {1e9 * $real_time / $commands}] \
+			pixels_per_second [expr {$commands * $width * $height / $real_time}]]
+	} finally {
+		delete_machine $id
+	}
+}
+
+proc vdp_cmd_benchmark {args} {
+	variable modes
+	variable workloads
+
+	set config "C-BIOS_MSX2+"
+	set duration 10
+	set mode_names [list]
+	set names [list]
+	while {[llength $args] > 0} {
+		set option [lindex $args 0]
+		switch -- $option {
+			"-machine" {
+				set config [lindex $args 1]
+				set args [lrange $args 2 end]
+			}
+			"-duration" {
+				set duration [lindex $args 1]
+				set args [lrange $args 2 end]
+			}
+			"-mode" {
+				set mode [lindex $args 1]
+				if {![dict exists $modes $mode]} {
+					error "Unknown mode: $mode, must be one of: [dict keys $modes]."
+				}
+				lappend mode_names $mode
+				set args [lrange $args 2 end]
+			}
+			default {
+				if {![dict exists $workloads $option]} {
+					error "Unknown workload: $option, must be one of: [dict keys $workloads]."
+				}
+				lappend names $option
+				set args [lrange $args 1 end]
+			}
+		}
+	}
+	if {[llength $mode_names] == 0} {
+		set mode_names [dict keys $modes]
+	}
+	if {[llength $names] == 0} {
+		set names [dict keys $workloads]
+	}
+
+	set old_turbo $::turbo
+	set ::turbo true
+	set result [dict create]
+	try {
+		foreach mode $mode_names {
+			foreach name $names {
+				foreach {path fast} {fast true exact false} {
+					dict set result $mode $name $path \
+						[run_workload $config $duration $mode $name $fast]
+				}
+			}
+		}
+	} finally {
+		set ::turbo $old_turbo
+	}
+	return $result
+}
+
+namespace export vdp_cmd_benchmark
+
+} ;# namespace vdp_cmd_benchmark
+
+namespace import vdp_cmd_benchmark::*
@@ -0,0 +1,231 @@
+namespace eval vdp_cmd_test {
+
+set_help_text vdp_cmd_test \
+{Checks that the fast path of the VDP block commands (see the vdpcmdfastpath
+setting) gives exactly the same result as executing them one VRAM access at a
+time.
+
+ usage:
+   vdp_cmd_test ?-machine <config>? ?<command> ...?
+
+Runs each of the block commands HMMV, HMMM, YMMM, LMMV and LMMM (default all
+of them) in Graphic 4, 5, 6 and 7, in all four directions, with all logical
+operations, with a rectangle that fits on the screen and with one that is
+clipped at the edge of the screen (in the 256 pixels wide modes). Each case runs twice on a new (inactive) machine: once with
+vdpcmdfastpath enabled and once with it disabled. Then it compares the VRAM
+content and the state of the command engine, which includes the time when the
+command finished and the status register.
+
+Each case also runs in two ways: once with the CPU halted while the command
+executes (so the whole command executes at once) and once with the CPU
+polling the status register and reading VRAM (which makes the command engine
+execute in many small steps).
+
+The default machine is C-BIOS_MSX2+, any MSX2 or higher works:
+   openmsx -command "set renderer none" -command "after realtime 0 {puts \[vdp_cmd_test\] ; exit}"
+
+Returns the number of checked cases, throws an error that describes the first
+difference.
+}
+
+set_tabcompletion_proc vdp_cmd_test [namespace code tab_vdp_cmd_test]
+
+proc tab_vdp_cmd_test {args} {
+	variable commands
+	concat -machine [dict keys $commands]
+}
+
+# Memory layout, all in page 3 which is RAM on every MSX after boot.
+variable regs_addr 0xC0E0 ;# register values R#32..R#46 of the command
+variable start 0xC100 ;# start of the program
+
+variable commands [dict create HMMV 0xC0 HMMM 0xD0 YMMM 0xE0 LMMV 0x80 LMMM 0x90]
+variable logops {0 1 2 3 4 8 9 10 11 12} ;# IMP AND OR XOR NOT TIMP .. TNOT
+
+# Value of R#0 for each display mode (R#1 is the same for all of them).
+variable modes [dict create G4 0x06 G5 0x08 G6 0x0A G7 0x0E]
+
+proc lo {addr} { expr {$addr & 0xFF} }
+proc hi {addr} { expr {$addr >> 8} }
+
+proc write_code {id addr bytes} {
+	${id}::debug write_block memory $addr [binary format c* $bytes]
+}
+
+# Deterministic 'random' content for the whole VRAM.
+proc vram_pattern {size} {
+	set seed 12345
+	set result ""
+	for {set i 0} {$i < $size} {incr i} {
+		set seed [expr {($seed * 1103515245 + 12345) & 0x7FFFFFFF}]
+		append result [binary format c [expr {$seed >> 16}]]
+	}
+	return $result
+}
+
+# Register values R#32..R#46 for one case.
+proc command_regs {cmd logop dix diy nx} {
+	set sx [expr {$dix ? 170 : 13}]
+	set dx [expr {$dix ? 201 : 77}]
+	set sy [expr {$diy ? 90 : 30}]
+	set dy [expr {$diy ? 160 : 100}]
+	set ny 37
+	set arg [expr {($dix << 2) | ($diy << 3)}]
+	list [lo $sx] [hi $sx] [lo $sy] [hi $sy] [lo $dx] [hi $dx] [lo $dy] [hi $dy] \
+	     [lo $nx] [hi $nx] [lo $ny] [hi $ny] 0x5B $arg [expr {$cmd | $logop}]
+}
+
+# Program that starts the command. When 'poll' is set it then reads VRAM
+# and S#2 till the command is done, otherwise it halts right away.
+proc program {poll} {
+	variable regs_addr
+	# di ; ld sp,0xF000
+	# ld a,2 ; out (0x99),a ; ld a,0x8F ; out (0x99),a   (R#15 = 2)
+	# xor a ; out (0x99),a ; out (0x99),a                (VRAM read address 0)
+	# ld a,32 ; out (0x99),a ; ld a,0x91 ; out (0x99),a  (R#17 = 32)
+	# ld hl,regs ; ld bc,0x0F9B ; otir
+	set code [list 0xF3 0x31 0x00 0xF0 \
+	               0x3E 0x02 0xD3 0x99 0x3E 0x8F 0xD3 0x99 \
+	               0xAF 0xD3 0x99 0xD3 0x99 \
+	               0x3E 32 0xD3 0x99 0x3E 0x91 0xD3 0x99 \
+	               0x21 [lo $regs_addr] [hi $regs_addr] 0x01 0x9B 0x0F 0xED 0xB3]
+	if {$poll} {
+		# wait: in a,(0x98) ; in a,(0x99) ; rrca ; jr c,wait
+		lappend code 0xDB 0x98 0xDB 0x99 0x0F 0x38 0xF9
+	}
+	lappend code 0x76 ;# halt (with interrupts disabled)
+}
+
+# Extract the state of the command engine from a savestate.
+proc cmd_engine_state {id} {
+	close [file tempfile filename vdp_cmd_test.xml.gz]
+	try {
+		store_machine $id $filename
+		set f [open $filename rb]
+		zlib push gunzip $f
+		set xml [read $f]
+		close $f
+	} finally {
+		file delete -- $filename
+	}
+	if {![regexp {<cmdEngine[^>]*>.*?</cmdEngine>} $xml state]} {
+		error "No command engine state found in the savestate."
+	}
+	return $state
+}
+
+proc run_case {base mode regs poll fast} {
+	variable modes
+	variable start
+	variable regs_addr
+
+	set id [restore_machine $base]
+	try {
+		set ::${id}::vdpcmdfastpath $fast
+		# display and vblank interrupt enabled, 212 lines, sprites disabled,
+		# showing page 0. The BIOS waits in a 'halt', the interrupt wakes up
+		# the CPU, which then returns to the program (that starts with 'di').
+		foreach {reg value} [list 0 [dict get $modes $mode] 1 0x60 2 0x1F 8 0x0A 9 0x80] {
+			${id}::debug write "VDP regs" $reg $value
+		}
+		write_code $id $regs_addr $regs
+		write_code $id $start [program $poll]
+		${id}::debug write "CPU regs" 20 [hi $start] ;# PC
+		${id}::debug write "CPU regs" 21 [lo $start]
+
+		set status [dict get [batch_run 1 $id] $id]
+		if {[dict exists $status error]} {
+			error [dict get $status error]
+		}
+		if {[${id}::debug read "VDP status regs" 2] & 1} {
+			error "VDP command didn't finish."
+		}
+		return [list [${id}::debug read_block VRAM 0 [${id}::debug size VRAM]] \
+		             [cmd_engine_state $id]]
+	} finally {
+		delete_machine $id
+	}
+}
+
+proc vdp_cmd_test {args} {
+	variable commands
+	variable logops
+	variable modes
+
+	set config "C-BIOS_MSX2+"
+	set names [list]
+	while {[llength $args] > 0} {
+		set option [lindex $args 0]
+		switch -- $option {
+			"-machine" {
+				set config [lindex $args 1]
+				set args [lrange $args 2 end]
+			}
+			default {
+				if {![dict exists $commands $option]} {
+					error "Unknown command: $option, must be one of: [dict keys $commands]."
+				}
+				lappend names $option
+				set args [lrange $args 1 end]
+			}
+		}
+	}
+	if {[llength $names] == 0} {
+		set names [dict keys $commands]
+	}
+
+	# Boot once, each case starts from a savestate of this machine.
+	close [file tempfile base vdp_cmd_test.oms]
+	set id [create_machine]
+	try {
+		${id}::load_machine $config
+		batch_run 3 $id
+		set pattern [vram_pattern [${id}::debug size VRAM]]
+		${id}::debug write_block VRAM 0 $pattern
+		store_machine $id $base
+	} finally {
+		delete_machine $id
+	}
+
+	set old_turbo $::turbo
+	set ::turbo true
+	set count 0
+	try {
+		foreach name $names {
+			set cmd [dict get $commands $name]
+			set ops [expr {($name in {LMMV LMMM}) ? $logops : {0}}]
+			foreach mode [dict keys $modes] {
+			foreach op $ops {
+			foreach {dix diy} {0 0 1 0 0 1 1 1} {
+			foreach nx {91 200} {
+			foreach poll {0 1} {
+				set regs [command_regs $cmd $op $dix $diy $nx]
+				set exact [run_case $base $mode $regs $poll false]
+				set fast  [run_case $base $mode $regs $poll true]
+				# (Some logical operations, e.g. AND with all bits set,
+				# don't change VRAM, so only check IMP.)
+				if {$op == 0 && [lindex $exact 0] eq $pattern} {
+					error "$name didn't change VRAM (did the program run?):\
+					       mode $mode, logop $op, DIX $dix, DIY $diy, NX $nx, poll $poll"
+				}
+				if {$exact ne $fast} {
+					set what [expr {([lindex $exact 0] ne [lindex $fast 0])
+					                ? "VRAM" : "command engine state"}]
+					error "$name differs ($what): mode $mode, logop $op,\
+					       DIX $dix, DIY $diy, NX $nx, poll $poll"
+				}
+				incr count
+			}}}}}
+		}
+	} finally {
+		set ::turbo $old_turbo
+		file delete -- $base
+	}
+	return $count
+}
+
+namespace export vdp_cmd_test
+
+} ;# namespace vdp_cmd_test
+
+namespace import vdp_cmd_test::*
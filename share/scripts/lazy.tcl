@@ -3,8 +3,10 @@
 #  (preferably keep this list sorted on script name)
 register_lazy "_about.tcl" about
 register_lazy "_backwards_compatibility.tcl" {quit decr restoredefault alias}
+register_lazy "_breakpoint_machine_test.tcl" breakpoint_machine_test
 register_lazy "_cheat.tcl" {findcheat start search}
 register_lazy "_cashandler.tcl" {casload cassave caslist casrun caspos caseject tapedeck}
+register_lazy "_cpu_benchmark.tcl" cpu_benchmark
 register_lazy "_cpuregs.tcl" {reg cpuregs get_active_cpu}
 register_lazy "_cycle.tcl" {cycle cycle_back toggle}
 register_lazy "_cycle_machine.tcl" {cycle_machine cycle_back_machine}
@@ -36,6 +38,7 @@ register_lazy "_record_channels.tcl" {
 register_lazy "_record_chunks.tcl" {
 	record_chunks record_chunks_on_framerate_changes}
 register_lazy "_reg_log.tcl" reg_log
+register_lazy "_replay_cache_test.tcl" replay_cache_test
 register_lazy "_reverse.tcl" {
 	reverse_prev reverse_next goto_time_delta go_back_one_step
 	go_forward_one_step reverse_bookmarks
@@ -47,6 +50,7 @@ register_lazy "_save_debuggable.tcl" {
 register_lazy "_save_msx_screen.tcl" save_msx_screen
 register_lazy "_savestate.tcl" {
 	savestate loadstate delete_savestate list_savestates list_savestates_raw}
+register_lazy "_savestate_benchmark.tcl" savestate_benchmark
 register_lazy "_scc_toys.tcl" {
 	toggle_scc_editor toggle_psg2scc set_scc_wave toggle_scc_viewer}
 register_lazy "_showdebuggable.tcl" {showdebuggable showmem}
@@ -66,6 +70,7 @@ register_lazy "_test_machines_and_extensions.tcl" {
 register_lazy "_text_echo.tcl" text_echo
 register_lazy "_toggle_freq.tcl" toggle_freq
 register_lazy "_trainer.tcl" {trainer load_trainers}
+register_lazy "_turbo_sound_test.tcl" turbo_sound_test
 register_lazy "_type_from_file.tcl" {type_from_file type_password_from_file}
 register_lazy "_type_via_keybuf.tcl" {type_via_keybuf}
 register_lazy "_utils.tcl" {
@@ -80,6 +85,8 @@ register_lazy "_vdp.tcl" {
 	v9990regs vpeek vpoke palette get_frame_duration}
 register_lazy "_vdp_access_test.tcl" toggle_vdp_access_test
 register_lazy "_vdp_busy.tcl" toggle_vdp_busy
+register_lazy "_vdp_cmd_benchmark.tcl" vdp_cmd_benchmark
+register_lazy "_vdp_cmd_test.tcl" vdp_cmd_test
 register_lazy "_vdrive.tcl" vdrive
 register_lazy "_vgmrecorder.tcl" {vgm_rec vgm_rec_next vgm_rec_end}
 register_lazy "_vu-meters.tcl" toggle_vu_meters
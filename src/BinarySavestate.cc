@@ -0,0 +1,286 @@
+#include "BinarySavestate.hh"
+
+#include "DeltaBlock.hh"
+#include "File.hh"
+#include "MSXException.hh"
+#include "Version.hh"
+
+#include "endian.hh"
+#include "enumerate.hh"
+#include "lz4.hh"
+#include "narrow.hh"
+#include "ranges.hh"
+#include "stl.hh"
+#include "strCat.hh"
+#include "view.hh"
+#include "build-info.hh"
+
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <string_view>
+#include <zlib.h>
+
+namespace openmsx {
+
+// File layout (all values little endian):
+//   Header
+//   savestate data
+//   Section table with one entry per block (8-byte aligned)
+//   block data (each block aligned on a BLOCK_ALIGNMENT boundary)
+// The header is written last, so an interrupted write results in an invalid
+// file (wrong magic) instead of a corrupt one.
+
+static constexpr std::array<char, 8> MAGIC = {'o', 'M', 'S', 'X', 'b', 's', 's', 't'};
+static constexpr uint32_t VERSION = 1;
+static constexpr size_t KEY_SIZE = 128;
+static constexpr size_t BLOCK_ALIGNMENT = 4096;
+
+enum Flags : uint32_t { LZ4_COMPRESSED = 1 };
+
+struct Section {
+	Endian::L64 offset;
+	Endian::L32 storedSize; // size in the file
+	Endian::L32 size;       // size after decompression
+	Endian::L32 crc;        // crc32 of the stored data
+	Endian::L32 flags;
+};
+static_assert(sizeof(Section) == 24);
+
+struct Header {
+	std::array<char, 8> magic;
+	Endian::L32 version;
+	Endian::L32 numBlocks;
+	Endian::L64 blockTableOffset;
+	Section state;
+	std::array<char, KEY_SIZE> key; // zero-padded
+};
+static_assert(sizeof(Header) == 176);
+
+// MemOutputArchive output can only be read back by the same build.
+[[nodiscard]] static std::string getKey()
+{
+	return strCat(Version::full(), ' ', TARGET_PLATFORM, ' ', TARGET_CPU);
+}
+
+[[nodiscard]] static uint32_t calcCrc(std::span<const uint8_t> data)
+{
+	return narrow_cast<uint32_t>(crc32(0, data.data(), narrow<uInt>(data.size())));
+}
+
+[[nodiscard]] static bool inRange(std::span<const uint8_t> data, uint64_t offset, uint64_t size)
+{
+	return (offset <= data.size()) && (size <= (data.size() - offset));
+}
+
+// Returns the stored data of the given section. Only the layout is checked,
+// the content (crc) is checked by verifySection().
+[[nodiscard]] static std::span<const uint8_t> getSection(
+	std::span<const uint8_t> data, const Section& s)
+{
+	if (!inRange(data, s.offset, s.storedSize)) {
+		throw MSXException("Invalid binary savestate: truncated file");
+	}
+	if (((s.flags & ~LZ4_COMPRESSED) != 0) ||
+	    (!(s.flags & LZ4_COMPRESSED) && (s.storedSize != s.size))) {
+		throw MSXException("Invalid binary savestate: corrupt data");
+	}
+	return data.subspan(s.offset, s.storedSize);
+}
+
+static void verifySection(std::span<const uint8_t> stored, uint32_t crc)
+{
+	if (calcCrc(stored) != crc) {
+		throw MSXException("Invalid binary savestate: corrupt data");
+	}
+}
+
+// Copies or decompresses a section of the (mapped) file into the destination
+// buffer. The crc is only verified at that point, so blocks that are never
+// applied are never read from disk.
+class SectionBlock final : public DeltaBlock
+{
+public:
+	SectionBlock(std::shared_ptr<const void> owner_,
+	             std::span<const uint8_t> stored_, const Section& s)
+		: owner(std::move(owner_)), stored(stored_)
+		, size(s.size), crc(s.crc), lz4(s.flags & LZ4_COMPRESSED) {}
+
+	void apply(std::span<uint8_t> dst) const override
+	{
+		assert(dst.size() == size);
+		verifySection(stored, crc);
+		if (lz4) {
+			// The crc protects against corruption, but a crafted file
+			// could still make the decompressor run past the end.
+			auto n = LZ4::decompress(stored.data(), dst.data(),
+			                         narrow<int>(stored.size()), narrow<int>(size));
+			if (n != narrow<int>(size)) {
+				throw MSXException("Invalid binary savestate: corrupt data");
+			}
+		} else {
+			ranges::copy(stored, dst);
+		}
+	}
+	[[nodiscard]] size_t getStorageSize() const override { return stored.size(); }
+	[[nodiscard]] size_t getSize() const override { return size; }
+
+private:
+	const std::shared_ptr<const void> owner;
+	const std::span<const uint8_t> stored;
+	const size_t size;
+	const uint32_t crc;
+	const bool lz4;
+};
+
+bool BinarySavestate::isBinarySavestate(const std::string& filename)
+{
+	try {
+		File f(filename);
+		std::array<char, 8> magic;
+		if (f.getSize() < sizeof(magic)) return false;
+		f.read(std::span<char>{magic});
+		return magic == MAGIC;
+	} catch (MSXException&) {
+		return false;
+	}
+}
+
+BinarySavestate::BinarySavestate(const std::string& filename)
+	: file(std::make_shared<File>(filename))
+{
+	auto data = file->mmap();
+
+	Header header;
+	if (!inRange(data, 0, sizeof(header))) {
+		throw MSXException("Invalid binary savestate: truncated file");
+	}
+	memcpy(&header, data.data(), sizeof(header));
+	if (header.magic != MAGIC) {
+		throw MSXException("Not a binary savestate: ", filename);
+	}
+	if (header.version != VERSION) {
+		throw MSXException("Unsupported binary savestate version: ", header.version);
+	}
+	std::string_view storedKey(header.key.data(), header.key.size());
+	storedKey = storedKey.substr(0, storedKey.find('\0'));
+	if (storedKey != getKey()) {
+		throw MSXException("Binary savestate was created by a different openMSX build (",
+		                   storedKey, "), use the XML format to transfer savestates");
+	}
+
+	// The main savestate data is relatively small, decompress it right away.
+	auto state = getSection(data, header.state);
+	verifySection(state, header.state.crc);
+	if (header.state.flags & LZ4_COMPRESSED) {
+		savestate.resize(header.state.size);
+		auto n = LZ4::decompress(state.data(), savestate.data(),
+		                         narrow<int>(state.size()), narrow<int>(savestate.size()));
+		if (n != narrow<int>(savestate.size())) {
+			throw MSXException("Invalid binary savestate: corrupt data");
+		}
+	} else {
+		savestate.assign(state.begin(), state.end());
+	}
+
+	std::vector<Section> table(header.numBlocks);
+	if (!inRange(data, header.blockTableOffset, table.size() * sizeof(Section))) {
+		throw MSXException("Invalid binary savestate: truncated file");
+	}
+	memcpy(table.data(), data.data() + header.blockTableOffset, table.size() * sizeof(Section));
+
+	// The blocks only check and decompress their data when it's actually
+	// needed (and then directly into the destination buffer). The owner
+	// keeps the mapping alive for as long as the blocks are used.
+	std::shared_ptr<const void> owner = file;
+	blocks = to_vector(view::transform(table, [&](const Section& s) -> std::shared_ptr<DeltaBlock> {
+		return std::make_shared<SectionBlock>(owner, getSection(data, s), s);
+	}));
+}
+
+BinarySavestate::~BinarySavestate() = default;
+
+void BinarySavestate::save(const std::string& filename,
+                           std::span<const uint8_t> savestate,
+                           std::span<const std::shared_ptr<DeltaBlock>> blocks)
+{
+	Header header = {};
+	auto key = getKey();
+	if (key.size() > header.key.size()) {
+		throw MSXException("Binary savestate key too long");
+	}
+
+	File file(filename, File::OpenMode::TRUNCATE);
+	file.write(std::span{&header, 1}); // placeholder, rewritten at the end
+	uint64_t pos = sizeof(header);
+	auto write = [&](std::span<const uint8_t> buf) {
+		auto offset = pos;
+		file.write(buf);
+		pos += buf.size();
+		return offset;
+	};
+	auto align = [&](size_t alignment) {
+		static constexpr std::array<uint8_t, BLOCK_ALIGNMENT> zeros = {};
+		write(std::span{zeros}.first((alignment - (pos % alignment)) % alignment));
+	};
+	std::vector<uint8_t> compressed;
+	auto writeStored = [&](std::span<const uint8_t> buf, size_t size, uint32_t flags) {
+		Section s;
+		s.offset = write(buf);
+		s.storedSize = narrow<uint32_t>(buf.size());
+		s.size = narrow<uint32_t>(size);
+		s.crc = calcCrc(buf);
+		s.flags = flags;
+		return s;
+	};
+	auto writeSection = [&](std::span<const uint8_t> buf) {
+		compressed.resize(LZ4::compressBound(narrow<int>(buf.size())));
+		auto n = size_t(LZ4::compress(buf.data(), compressed.data(), narrow<int>(buf.size())));
+		return (n < buf.size())
+		     ? writeStored(std::span{compressed}.first(n), buf.size(), LZ4_COMPRESSED)
+		     : writeStored(buf, buf.size(), 0);
+	};
+
+	header.state = writeSection(savestate);
+
+	// Reserve space for the table, the blocks follow it.
+	std::vector<Section> table(blocks.size());
+	auto tableBytes = std::span{std::bit_cast<const uint8_t*>(table.data()),
+	                            table.size() * sizeof(Section)};
+	align(8);
+	header.blockTableOffset = write(tableBytes);
+
+	std::vector<uint8_t> buf;
+	for (const auto& [i, block] : enumerate(blocks)) {
+		align(BLOCK_ALIGNMENT);
+		auto size = block->getSize();
+		if (auto* copy = dynamic_cast<DeltaBlockCopy*>(block.get())) {
+			// Write the lz4 data of the block itself (possibly already
+			// compressed in the background), don't compress it again.
+			copy->compress(size);
+			if (copy->withCompressedData([&](std::span<const uint8_t> c) {
+				table[i] = writeStored(c, size, LZ4_COMPRESSED); })) {
+				continue;
+			}
+			// not compressible (or still being compressed by another thread)
+			buf.resize(size);
+			block->apply(buf);
+			table[i] = writeStored(buf, size, 0);
+			continue;
+		}
+		buf.resize(size);
+		block->apply(buf);
+		table[i] = writeSection(buf);
+	}
+	file.seek(header.blockTableOffset);
+	file.write(tableBytes);
+
+	header.magic = MAGIC;
+	header.version = VERSION;
+	header.numBlocks = narrow<uint32_t>(table.size());
+	ranges::copy(key, header.key.begin());
+	file.seek(0);
+	file.write(std::span{&header, 1});
+}
+
+} // namespace openmsx
@@ -0,0 +1,61 @@
+#ifndef BINARYSAVESTATE_HH
+#define BINARYSAVESTATE_HH
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+class DeltaBlock;
+class File;
+
+/** A savestate in the (binary) format of MemOutputArchive, as opposed to the
+  * usual XML format. Loading this format is a lot faster: the bulk of a
+  * savestate is made of a few large blobs (RAM, VRAM, ...), those are stored
+  * in separate (lz4 compressed) sections, aligned on a page boundary, that
+  * are decompressed directly from the memory mapped file into the device
+  * buffers.
+  *
+  * MemOutputArchive doesn't store class version information, so such a file
+  * can only be loaded by the exact same openMSX build that created it (this
+  * is checked). For long-term storage the XML format should be used.
+  */
+class BinarySavestate
+{
+public:
+	/** Is the given file a binary savestate (as opposed to an XML one)? */
+	[[nodiscard]] static bool isBinarySavestate(const std::string& filename);
+
+	/** Load (map) the given file. Only the header and the main savestate
+	  * data are read (and checked for corruption) here, the blocks are
+	  * checked when they're applied (which then throws MSXException).
+	  * @throws MSXException
+	  */
+	explicit BinarySavestate(const std::string& filename);
+	~BinarySavestate();
+
+	/** The data and blocks to pass to MemInputArchive. The blocks keep the
+	  * file mapped for as long as they're referenced.
+	  */
+	[[nodiscard]] std::span<const uint8_t> getSavestate() const { return savestate; }
+	[[nodiscard]] std::span<const std::shared_ptr<DeltaBlock>> getBlocks() const { return blocks; }
+
+	/** Write the output of MemOutputArchive (overwrites an existing file).
+	  * @throws MSXException
+	  */
+	static void save(const std::string& filename,
+	                 std::span<const uint8_t> savestate,
+	                 std::span<const std::shared_ptr<DeltaBlock>> blocks);
+
+private:
+	std::shared_ptr<File> file; // mapped, shared with the blocks
+	std::vector<uint8_t> savestate;
+	std::vector<std::shared_ptr<DeltaBlock>> blocks;
+};
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,71 @@
+#include "DeviceProfiler.hh"
+
+#include "ranges.hh"
+
+#include <cstdlib>
+#include <memory>
+
+#ifdef __GNUC__
+#include <cxxabi.h>
+#endif
+
+namespace openmsx {
+
+// Returns a human readable name for the given type, without the 'openmsx::'
+// namespace prefix.
+[[nodiscard]] static std::string typeName(const std::type_info& type)
+{
+	std::string result = type.name();
+#ifdef __GNUC__
+	int status = 0;
+	std::unique_ptr<char, decltype(&std::free)> demangled(
+		abi::__cxa_demangle(type.name(), nullptr, nullptr, &status), &std::free);
+	if (status == 0) result = demangled.get();
+#endif
+	// msvc: "class openmsx::VDP" or "struct openmsx::..."
+	for (std::string_view prefix : {"class ", "struct ", "openmsx::"}) {
+		if (result.starts_with(prefix)) result.erase(0, prefix.size());
+	}
+	return result;
+}
+
+DeviceProfiler::Id DeviceProfiler::getId(Category category, std::string_view name)
+{
+	auto it = ranges::find_if(entries, [&](const Entry& e) {
+		return (e.category == category) && (e.name == name);
+	});
+	if (it != entries.end()) return Id(it - entries.begin());
+	entries.push_back(Entry{std::string(name), category});
+	return Id(entries.size() - 1);
+}
+
+DeviceProfiler::Id DeviceProfiler::getId(Category category, const std::type_info& type)
+{
+	return getId(category, typeName(type));
+}
+
+void DeviceProfiler::setActive(bool active_, EmuTime::param time)
+{
+	if (active_ == active) return;
+	if (active) emulated = emulated + (time - activeSince);
+	activeSince = time;
+	active = active_;
+}
+
+void DeviceProfiler::reset(EmuTime::param time)
+{
+	for (auto& e : entries) {
+		e.calls = 0;
+		e.totalTime = 0;
+		e.selfTime = 0;
+	}
+	emulated = EmuDuration::zero();
+	activeSince = time;
+}
+
+EmuDuration DeviceProfiler::getEmulatedTime(EmuTime::param time) const
+{
+	return active ? emulated + (time - activeSince) : emulated;
+}
+
+} // namespace openmsx
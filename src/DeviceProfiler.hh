@@ -0,0 +1,129 @@
+#ifndef DEVICEPROFILER_HH
+#define DEVICEPROFILER_HH
+
+#include "EmuTime.hh"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <typeinfo>
+#include <vector>
+
+namespace openmsx {
+
+// Set to false to completely remove the instrumentation from the build
+// (similar to the ENABLED parameter of 'ProfileCounters'). When true the
+// cost of the (inactive) profiler is a single well predicted branch per
+// instrumented call.
+inline constexpr bool DEVICE_PROFILER_ENABLED = true;
+
+/** Measures the host time spent in the emulation of the individual devices
+  * of one machine, e.g. to find out which devices are the most expensive
+  * per emulated second.
+  *
+  * The instrumented code paths are: the executeUntil() calls made by the
+  * Scheduler, SoundDevice::updateBuffer() (via MSXMixer), the rendering in
+  * PixelRenderer and the VDP command engine.
+  *
+  * Measured sections can be nested (e.g. a VDP sync point that renders some
+  * lines). For each entry both the total time and the 'self' time (the total
+  * time minus the time of nested entries) is reported.
+  */
+class DeviceProfiler
+{
+public:
+	enum class Category : uint8_t { SYNC_POINT, SOUND, RENDER, VDP_COMMAND, NUM };
+	static constexpr std::array<std::string_view, size_t(Category::NUM)> categoryNames = {
+		"sync_point", "sound", "render", "vdp_command",
+	};
+
+	using Id = uint32_t;
+	static constexpr Id INVALID_ID = Id(-1);
+
+	struct Entry {
+		std::string name;
+		Category category;
+		uint64_t calls = 0;
+		uint64_t totalTime = 0; // host time in nanoseconds
+		uint64_t selfTime = 0;  // same, excluding nested entries
+	};
+
+	/** Measures one call, from construction till destruction. */
+	class Scope
+	{
+	public:
+		Scope(DeviceProfiler& profiler_, Id id_)
+			: profiler(profiler_), parent(profiler.current), id(id_)
+			, start(now())
+		{
+			profiler.current = this;
+		}
+		~Scope()
+		{
+			auto elapsed = now() - start;
+			auto& entry = profiler.entries[id];
+			++entry.calls;
+			entry.totalTime += elapsed;
+			entry.selfTime += elapsed - nested;
+			if (parent) parent->nested += elapsed;
+			profiler.current = parent;
+		}
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		DeviceProfiler& profiler;
+		Scope* parent;
+		Id id;
+		uint64_t start;
+		uint64_t nested = 0;
+	};
+
+	/** Get the id for the given name, this adds a new entry on first use.
+	  * Different objects with the same name share the same entry.
+	  */
+	[[nodiscard]] Id getId(Category category, std::string_view name);
+	/** Same as above, the name is derived from the dynamic type of the
+	  * object (e.g. "VDP::SyncHorAdjust").
+	  */
+	[[nodiscard]] Id getId(Category category, const std::type_info& type);
+
+	void setActive(bool active_, EmuTime::param time);
+	[[nodiscard]] bool isActive() const { return DEVICE_PROFILER_ENABLED && active; }
+
+	/** Clear all counters. Existing ids remain valid. */
+	void reset(EmuTime::param time);
+
+	[[nodiscard]] std::span<const Entry> getEntries() const { return entries; }
+	/** The emulated time during which the profiler was active. */
+	[[nodiscard]] EmuDuration getEmulatedTime(EmuTime::param time) const;
+
+	/** Execute 'f', and measure it when the profiler is active. */
+	template<typename F> decltype(auto) measure(Id id, F&& f)
+	{
+		if (!isActive()) [[likely]] return f();
+		Scope scope(*this, id);
+		return f();
+	}
+
+private:
+	[[nodiscard]] static uint64_t now()
+	{
+		using namespace std::chrono;
+		return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+	}
+
+private:
+	std::vector<Entry> entries;
+	Scope* current = nullptr;
+	EmuDuration emulated = EmuDuration::zero();
+	EmuTime activeSince = EmuTime::zero();
+	bool active = false;
+};
+
+} // namespace openmsx
+
+#endif
@@ -2,6 +2,7 @@
 
 #include "BooleanSetting.hh"
 #include "CartridgeSlotManager.hh"
+#include "CPURegs.hh"
 #include "CassettePort.hh"
 #include "Command.hh"
 #include "CommandException.hh"
@@ -38,6 +39,7 @@
 #include "SimpleDebuggable.hh"
 #include "StateChangeDistributor.hh"
 #include "TclObject.hh"
+#include "Thread.hh"
 #include "XMLElement.hh"
 #include "serialize.hh"
 #include "serialize_stl.hh"
@@ -575,6 +577,37 @@ void MSXMotherBoard::fastForward(EmuTime::param time, bool fast)
 	msxMixer->unmute();
 }
 
+bool MSXMotherBoard::batchRun(EmuTime::param time, bool stopOnHalt, bool debug)
+{
+	assert(powered);
+	assert(getMachineConfig());
+	assert(!debug || Thread::isRealMainThread());
+
+	// Run in chunks, so that the halt condition gets checked regularly.
+	static constexpr auto CHUNK = EmuDuration::msec(20);
+	ScopedAssign sa(fastForwarding, true);
+	auto target = getCurrentTime();
+	while (time > getCurrentTime()) {
+		if (stopOnHalt) {
+			const auto& regs = getCPU().getRegisters();
+			if (regs.getHALT() && !regs.getIFF1()) return true;
+		}
+		if (debug && MSXCPUInterface::isBreaked()) break;
+		if (getCurrentTime() >= target) {
+			target = std::min(time, getCurrentTime() + CHUNK);
+			fastForwardHelper->setTarget(target);
+		}
+		getCPU().execute(!debug); // fast-forward mode, unless debugging
+	}
+	return false;
+}
+
+bool MSXMotherBoard::skipRendering() const
+{
+	return fastForwarding ||
+	       reactor.getGlobalSettings().getThrottleManager().isTurbo();
+}
+
 void MSXMotherBoard::pause()
 {
 	if (getMachineConfig()) {
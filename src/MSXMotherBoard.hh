@@ -104,6 +104,22 @@ public:
 	 */
 	void fastForward(EmuTime::param time, bool fast);
 
+	/** Run emulation (in fast forward mode) until a certain time, or
+	 * until the CPU is halted with interrupts disabled ('di ; halt', the
+	 * usual way for test programs to signal they're done) when
+	 * 'stopOnHalt' is set.
+	 * Unlike fastForward() this doesn't touch anything outside this
+	 * machine, so it can run on a batch-run thread (see BatchRunCommand).
+	 * The caller must disable real-time synchronization and mute the
+	 * mixer.
+	 * With 'debug' set, the normal (not fast-forward) CPU loop is used,
+	 * so breakpoints, watchpoints and conditions are checked, and the run
+	 * stops when one of them breaks. Those can execute Tcl commands, so
+	 * then this must be called from the (real) main thread.
+	 * @return True if stopped because the CPU was halted.
+	 */
+	bool batchRun(EmuTime::param time, bool stopOnHalt, bool debug = false);
+
 	/** See CPU::exitCPULoopAsync(). */
 	void exitCPULoopAsync();
 	void exitCPULoopSync();
@@ -121,6 +137,9 @@ public:
 	void activate(bool active);
 	[[nodiscard]] bool isActive() const { return active; }
 	[[nodiscard]] bool isFastForwarding() const { return fastForwarding; }
+	/** The VDPs don't need to render while fast-forwarding (e.g. reverse
+	  * goto) or in turbo mode (see ThrottleManager::isTurbo()). */
+	[[nodiscard]] bool skipRendering() const;
 
 	[[nodiscard]] byte readIRQVector() const;
 
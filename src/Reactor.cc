@@ -2,10 +2,12 @@
 
 #include "AfterCommand.hh"
 #include "AviRecorder.hh"
+#include "BinarySavestate.hh"
 #include "BooleanSetting.hh"
 #include "Command.hh"
 #include "CommandException.hh"
 #include "CommandLineParser.hh"
+#include "DeltaBlock.hh"
 #include "DiskChanger.hh"
 #include "DiskFactory.hh"
 #include "DiskManipulator.hh"
@@ -24,17 +26,22 @@
 #include "InfoTopic.hh"
 #include "InputEventGenerator.hh"
 #include "Keyboard.hh"
+#include "MSXCliComm.hh"
+#include "MSXMixer.hh"
 #include "MSXMotherBoard.hh"
 #include "MessageCommand.hh"
 #include "Mixer.hh"
 #include "MsxChar2Unicode.hh"
 #include "RTScheduler.hh"
+#include "RealTime.hh"
 #include "RomDatabase.hh"
 #include "RomInfo.hh"
 #include "StateChangeDistributor.hh"
 #include "SymbolManager.hh"
+#include "TclArgParser.hh"
 #include "TclCallbackMessages.hh"
 #include "TclObject.hh"
+#include "ThrottleManager.hh"
 #include "UserSettings.hh"
 #include "VideoSystem.hh"
 #include "XMLElement.hh"
@@ -50,11 +57,16 @@
 #include "serialize.hh"
 #include "stl.hh"
 #include "unreachable.hh"
+#include "view.hh"
+#include "xrange.hh"
 #include "build-info.hh"
 
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <memory>
+#include <thread>
+#include <utility>
 
 using std::make_unique;
 using std::string;
@@ -162,6 +174,17 @@ private:
 	Reactor& reactor;
 };
 
+class BatchRunCommand final : public Command
+{
+public:
+	BatchRunCommand(CommandController& commandController, Reactor& reactor);
+	void execute(std::span<const TclObject> tokens, TclObject& result) override;
+	[[nodiscard]] string help(std::span<const TclObject> tokens) const override;
+	void tabCompletion(vector<string>& tokens) const override;
+private:
+	Reactor& reactor;
+};
+
 class GetClipboardCommand final : public Command
 {
 public:
@@ -264,6 +287,8 @@ void Reactor::init()
 		*globalCommandController, *this);
 	restoreMachineCommand = make_unique<RestoreMachineCommand>(
 		*globalCommandController, *this);
+	batchRunCommand = make_unique<BatchRunCommand>(
+		*globalCommandController, *this);
 	getClipboardCommand = make_unique<GetClipboardCommand>(
 		*globalCommandController, *this);
 	setClipboardCommand = make_unique<SetClipboardCommand>(
@@ -409,14 +434,27 @@ void Reactor::createMachineSetting()
 MSXMotherBoard* Reactor::getMotherBoard() const
 {
 	assert(Thread::isMainThread());
-	return activeBoard.get();
+	return commandBoard ? commandBoard : activeBoard.get();
 }
 
 string_view Reactor::getMachineID() const
 {
+	if (commandBoard) return commandBoard->getMachineID();
 	return activeBoard ? activeBoard->getMachineID() : string_view{};
 }
 
+Reactor::ScopedCommandBoard::ScopedCommandBoard(Reactor& reactor_, MSXMotherBoard& board)
+	: reactor(reactor_)
+	, prevBoard(std::exchange(reactor.commandBoard, &board))
+{
+	assert(Thread::isMainThread());
+}
+
+Reactor::ScopedCommandBoard::~ScopedCommandBoard()
+{
+	reactor.commandBoard = prevBoard;
+}
+
 Reactor::Board Reactor::getMachine(string_view machineID) const
 {
 	if (auto it = ranges::find(boards, machineID, &MSXMotherBoard::getMachineID);
@@ -433,7 +471,7 @@ Reactor::Board Reactor::createEmptyMotherBoard()
 
 void Reactor::replaceBoard(MSXMotherBoard& oldBoard_, Board newBoard)
 {
-	assert(Thread::isMainThread());
+	assert(Thread::isRealMainThread());
 
 	// Add new board.
 	boards.push_back(newBoard);
@@ -465,7 +503,7 @@ void Reactor::switchMachine(const string& machine)
 	// switch to new machine
 	// delete old active machine
 
-	assert(Thread::isMainThread());
+	assert(Thread::isRealMainThread());
 	// Note: loadMachine can throw an exception and in that case the
 	//       motherboard must be considered as not created at all.
 	auto newBoard = createEmptyMotherBoard();
@@ -479,7 +517,7 @@ void Reactor::switchMachine(const string& machine)
 
 void Reactor::switchBoard(Board newBoard)
 {
-	assert(Thread::isMainThread());
+	assert(Thread::isRealMainThread());
 	assert(!newBoard || contains(boards, newBoard));
 	assert(!activeBoard || contains(boards, activeBoard));
 	if (activeBoard) {
@@ -506,7 +544,7 @@ void Reactor::deleteBoard(Board board)
 	// 'activeBoard' member variable, so the 'board' parameter would change
 	// if it were passed by reference to this method (AFAICS this only
 	// happens in ~Reactor()).
-	assert(Thread::isMainThread());
+	assert(Thread::isRealMainThread());
 	if (!board) return;
 
 	if (board == activeBoard) {
@@ -520,7 +558,7 @@ void Reactor::deleteBoard(Board board)
 void Reactor::enterMainLoop()
 {
 	// Note: this method can get called from different threads
-	if (Thread::isMainThread()) {
+	if (Thread::isRealMainThread()) {
 		// Don't take lock in main thread to avoid recursive locking.
 		if (activeBoard) {
 			activeBoard->exitCPULoopSync();
@@ -840,7 +878,13 @@ void DeleteMachineCommand::execute(std::span<const TclObject> tokens,
                                    TclObject& /*result*/)
 {
 	checkNumArgs(tokens, 2, "id");
-	reactor.deleteBoard(reactor.getMachine(tokens[1].getString()));
+	auto board = reactor.getMachine(tokens[1].getString());
+	if (board.get() == reactor.commandBoard) {
+		throw CommandException(
+			"Can't delete machine ", board->getMachineID(),
+			" from its own breakpoint.");
+	}
+	reactor.deleteBoard(board);
 }
 
 string DeleteMachineCommand::help(std::span<const TclObject> /*tokens*/) const
@@ -922,22 +966,38 @@ StoreMachineCommand::StoreMachineCommand(
 
 void StoreMachineCommand::execute(std::span<const TclObject> tokens, TclObject& result)
 {
-	checkNumArgs(tokens, 3, Prefix{1}, "id filename");
-	const auto& machineID = tokens[1].getString();
-	const auto& filename = tokens[2].getString();
+	bool binary = false;
+	std::array info = {flagArg("-binary", binary)};
+	auto args = parseTclArgs(getInterpreter(), tokens.subspan(1), info);
+	if (args.size() != 2) throw SyntaxError();
+	const auto& machineID = args[0].getString();
+	const auto& filename = args[1].getString();
 
 	const auto& board = *reactor.getMachine(machineID);
 
-	XmlOutputArchive out(filename);
-	out.serialize("machine", board);
-	out.close();
+	if (binary) {
+		LastDeltaBlocks lastDeltaBlocks;
+		std::vector<std::shared_ptr<DeltaBlock>> deltaBlocks;
+		MemOutputArchive out(lastDeltaBlocks, deltaBlocks, false);
+		out.serialize("machine", board);
+		size_t size;
+		auto buf = out.releaseBuffer(size);
+		BinarySavestate::save(string(filename), std::span{buf.data(), size}, deltaBlocks);
+	} else {
+		XmlOutputArchive out(filename);
+		out.serialize("machine", board);
+		out.close();
+	}
 	result = filename;
 }
 
 string StoreMachineCommand::help(std::span<const TclObject> /*tokens*/) const
 {
 	return
-		"store_machine machineID <filename>  Save state of machine \"machineID\" to indicated file\n"
+		"store_machine [-binary] machineID <filename>  Save state of machine \"machineID\" to indicated file\n"
+		"\n"
+		"With -binary the state is stored in a binary format that loads a lot\n"
+		"faster, but that can only be loaded by this exact build of openMSX.\n"
 		"\n"
 		"This is a low-level command, the 'savestate' script is easier to use.";
 }
@@ -966,8 +1026,15 @@ void RestoreMachineCommand::execute(std::span<const TclObject> tokens,
 	const auto filename = FileOperations::expandTilde(string(tokens[1].getString()));
 
 	try {
-		XmlInputArchive in(filename);
-		in.serialize("machine", *newBoard);
+		if (BinarySavestate::isBinarySavestate(filename)) {
+			BinarySavestate state(filename);
+			auto savestate = state.getSavestate();
+			MemInputArchive in(savestate.data(), savestate.size(), state.getBlocks());
+			in.serialize("machine", *newBoard);
+		} else {
+			XmlInputArchive in(filename);
+			in.serialize("machine", *newBoard);
+		}
 	} catch (XMLException& e) {
 		throw CommandException("Cannot load state, bad file format: ",
 		                       e.getMessage());
@@ -998,6 +1065,166 @@ void RestoreMachineCommand::tabCompletion(vector<string>& tokens) const
 }
 
 
+// class BatchRunCommand
+
+BatchRunCommand::BatchRunCommand(
+	CommandController& commandController_, Reactor& reactor_)
+	: Command(commandController_, "batch_run")
+	, reactor(reactor_)
+{
+}
+
+void BatchRunCommand::execute(std::span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{2}, "?-threads <n>? ?-stop-on-halt? ?-debug? duration ?id ...?");
+	int numThreads = int(std::thread::hardware_concurrency());
+	bool stopOnHalt = false;
+	bool debug = false;
+	std::array info = {
+		valueArg("-threads", numThreads),
+		flagArg("-stop-on-halt", stopOnHalt),
+		flagArg("-debug", debug),
+	};
+	auto arguments = parseTclArgs(getInterpreter(), tokens.subspan(1), info);
+	if (arguments.empty()) throw SyntaxError();
+	double duration = arguments[0].getDouble(getInterpreter());
+	if (duration <= 0.0) {
+		throw CommandException("Duration must be positive.");
+	}
+	// Breakpoints and conditions can execute Tcl commands, so with -debug
+	// everything runs on the main thread.
+	numThreads = debug ? 1 : std::max(numThreads, 1);
+
+	// Collect the machines, by default all but the active machine.
+	vector<Reactor::Board> boards;
+	if (arguments.size() > 1) {
+		for (const auto& id : view::drop(arguments, 1)) {
+			auto board = reactor.getMachine(id.getString());
+			if (contains(boards, board)) {
+				throw CommandException("Machine ", id.getString(), " is given twice.");
+			}
+			boards.push_back(std::move(board));
+		}
+	} else {
+		ranges::copy_if(reactor.boards, back_inserter(boards),
+		                [&](const auto& b) { return b != reactor.activeBoard; });
+	}
+	for (const auto& board : boards) {
+		if (board == reactor.activeBoard) {
+			throw CommandException(
+				"Can't batch-run the active machine (", board->getMachineID(),
+				"), activate another machine first.");
+		}
+		if (!board->isPowered()) {
+			throw CommandException("Machine ", board->getMachineID(), " is not powered on.");
+		}
+	}
+
+	// Machines don't share any emulation state, so they can run in
+	// parallel. Everything that can't be done from another thread is
+	// disabled (real-time sync, sound output) or deferred (messages)
+	// till all threads are done. The main thread itself blocks, so no
+	// Tcl commands or events can interfere.
+	for (const auto& board : boards) {
+		board->getRealTime().disable();
+		board->getMSXMixer().mute();
+		board->getMSXCliComm().setDeferred(true);
+	}
+
+	vector<EmuTime> startTimes;
+	startTimes.reserve(boards.size());
+	for (const auto& board : boards) {
+		startTimes.push_back(board->getCurrentTime());
+	}
+	vector<char> halted(boards.size(), false); // not vector<bool>, written from different threads
+	vector<uint64_t> realTimes(boards.size()); // in us
+	vector<string> errors(boards.size());
+	auto runOne = [&](size_t i) {
+		auto start = Timer::getTime();
+		try {
+			halted[i] = boards[i]->batchRun(
+				startTimes[i] + EmuDuration(duration), stopOnHalt, debug);
+		} catch (MSXException& e) {
+			errors[i] = e.getMessage();
+		} catch (std::exception& e) {
+			// e.g. std::bad_alloc, must not escape the thread
+			errors[i] = e.what();
+		}
+		realTimes[i] = Timer::getTime() - start;
+	};
+	auto n = std::min(size_t(numThreads), boards.size());
+	if (n <= 1) {
+		// Run on the main thread itself.
+		for (auto i : xrange(boards.size())) runOne(i);
+	} else {
+		std::atomic<size_t> next = 0;
+		vector<std::thread> threads;
+		threads.reserve(n);
+		repeat(n, [&] {
+			threads.emplace_back([&] {
+				Thread::ScopedMainThreadRole role;
+				for (auto i = next++; i < boards.size(); i = next++) {
+					runOne(i);
+				}
+			});
+		});
+		for (auto& t : threads) t.join();
+	}
+
+	for (const auto& board : boards) {
+		board->getMSXCliComm().setDeferred(false);
+		board->getMSXMixer().unmute();
+		board->getRealTime().enable();
+	}
+	reactor.getGlobalSettings().getThrottleManager().updateStatus();
+
+	for (auto i : xrange(boards.size())) {
+		auto now = boards[i]->getCurrentTime();
+		// emulated seconds per real second
+		double speed = (now - startTimes[i]).toDouble() /
+		               std::max(double(realTimes[i]) * 1e-6, 1e-6);
+		auto status = makeTclDict(
+			"time", (now - EmuTime::zero()).toDouble(),
+			"halted", bool(halted[i]),
+			"speed", speed);
+		if (!errors[i].empty()) status.addDictKeyValue("error", errors[i]);
+		result.addDictKeyValue(boards[i]->getMachineID(), status);
+	}
+}
+
+string BatchRunCommand::help(std::span<const TclObject> /*tokens*/) const
+{
+	return
+		"batch_run ?-threads <n>? ?-stop-on-halt? ?-debug? <duration> ?<id> ...?\n"
+		"Run the given machines (default: all but the active machine) for "
+		"<duration> (emulated) seconds, as fast as possible and in "
+		"parallel, one machine per thread (default: one thread per core). "
+		"This is meant for headless (renderer none) automated test runs: "
+		"create the machines with 'create_machine' and "
+		"'<id>::load_machine', insert the software, run them with this "
+		"command and afterwards collect the results with e.g. "
+		"'<id>::debug read_block' or 'store_machine'.\n"
+		"With -stop-on-halt a machine stops early when its CPU executes "
+		"'di ; halt'.\n"
+		"While running no Tcl commands are executed and breakpoints, "
+		"watchpoints and conditions don't trigger. Messages from the "
+		"machines are shown afterwards.\n"
+		"With -debug breakpoints, watchpoints and conditions are checked "
+		"(and executed) as during normal emulation, and the run stops "
+		"when one of them breaks. This runs all machines one after the "
+		"other on the main thread, and is much slower.\n"
+		"Returns a dictionary with for each machine the emulated time, "
+		"whether it halted, the achieved speed (emulated seconds per "
+		"real second) and possibly an error message.\n"
+		"Combine with 'set turbo on' to also skip the sound synthesis.";
+}
+
+void BatchRunCommand::tabCompletion(vector<string>& tokens) const
+{
+	completeString(tokens, reactor.getMachineIDs());
+}
+
+
 // class GetClipboardCommand
 
 GetClipboardCommand::GetClipboardCommand(
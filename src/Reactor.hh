@@ -19,6 +19,7 @@ namespace openmsx {
 class ActivateMachineCommand;
 class AfterCommand;
 class AviRecorder;
+class BatchRunCommand;
 class CliComm;
 class CommandController;
 class CommandLineParser;
@@ -106,6 +107,28 @@ public:
 	void switchMachine(const std::string& machine);
 	[[nodiscard]] MSXMotherBoard* getMotherBoard() const;
 
+	/** While an object of this class exists, getMotherBoard() returns the
+	  * given machine instead of the active machine. So the machine
+	  * commands that are executed without a machine prefix (e.g. 'reg' or
+	  * 'peek' in a breakpoint condition) refer to that machine. This is
+	  * used to execute the condition and the command of a breakpoint in
+	  * the (possibly inactive, see batch_run -debug) machine that
+	  * triggered it.
+	  */
+	class ScopedCommandBoard
+	{
+	public:
+		ScopedCommandBoard(Reactor& reactor, MSXMotherBoard& board);
+		~ScopedCommandBoard();
+		ScopedCommandBoard(const ScopedCommandBoard&) = delete;
+		ScopedCommandBoard(ScopedCommandBoard&&) = delete;
+		ScopedCommandBoard& operator=(const ScopedCommandBoard&) = delete;
+		ScopedCommandBoard& operator=(ScopedCommandBoard&&) = delete;
+	private:
+		Reactor& reactor;
+		MSXMotherBoard* prevBoard;
+	};
+
 	[[nodiscard]] static std::vector<std::string> getHwConfigs(std::string_view type);
 
 	[[nodiscard]] const MsxChar2Unicode& getMsxChar2Unicode() const;
@@ -182,6 +205,7 @@ private:
 	std::unique_ptr<ActivateMachineCommand> activateMachineCommand;
 	std::unique_ptr<StoreMachineCommand> storeMachineCommand;
 	std::unique_ptr<RestoreMachineCommand> restoreMachineCommand;
+	std::unique_ptr<BatchRunCommand> batchRunCommand;
 	std::unique_ptr<GetClipboardCommand> getClipboardCommand;
 	std::unique_ptr<SetClipboardCommand> setClipboardCommand;
 	std::unique_ptr<AviRecorder> aviRecordCommand;
@@ -200,6 +224,7 @@ private:
 	//    the mbMutex lock
 	std::vector<Board> boards; // unordered
 	Board activeBoard; // either nullptr or a board inside 'boards'
+	MSXMotherBoard* commandBoard = nullptr; // see ScopedCommandBoard
 
 	int blockedCounter = 0;
 	bool paused = false;
@@ -222,6 +247,7 @@ private:
 	friend class ActivateMachineCommand;
 	friend class StoreMachineCommand;
 	friend class RestoreMachineCommand;
+	friend class BatchRunCommand;
 };
 
 } // namespace openmsx
@@ -0,0 +1,271 @@
+#include "ReplaySnapshotCache.hh"
+
+#include "DeltaBlock.hh"
+#include "File.hh"
+#include "FileOperations.hh"
+#include "MSXException.hh"
+#include "Version.hh"
+
+#include "endian.hh"
+#include "enumerate.hh"
+#include "narrow.hh"
+#include "ranges.hh"
+#include "sha1.hh"
+#include "strCat.hh"
+
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <utility>
+
+namespace openmsx {
+
+// File layout (all values little endian):
+//   Header
+//   savestate and block data (in the order they're listed in the tables)
+//   SnapshotEntry table (8-byte aligned)
+//   BlockEntry table    (8-byte aligned)
+// The header is written last, so an interrupted write results in an invalid
+// file (wrong magic) instead of a corrupt one. The file is first written
+// under a temporary name and then renamed, an existing cache file may still
+// be memory mapped (also by another openMSX process), truncating it would
+// make accesses to that mapping crash (SIGBUS).
+
+static constexpr std::array<char, 8> MAGIC = {'o', 'M', 'S', 'X', 'r', 's', 'n', 'c'};
+static constexpr uint32_t VERSION = 1;
+static constexpr size_t KEY_SIZE = 128;
+static constexpr uint32_t NO_REF = uint32_t(-1);
+
+// Every N-th snapshot stores all its blocks in full, the other snapshots
+// store (most of) their blocks as a delta relative to that keyframe. A
+// larger value makes the file smaller (consecutive snapshots often differ
+// very little), but the deltas grow the further we get from the keyframe.
+static constexpr size_t KEYFRAME_INTERVAL = 16;
+
+struct Header {
+	std::array<char, 8> magic;
+	Endian::L32 version;
+	Endian::L32 numSnapshots;
+	Endian::L32 numBlocks;
+	Endian::L32 reserved;
+	Endian::L64 snapshotTableOffset;
+	Endian::L64 blockTableOffset;
+	std::array<char, KEY_SIZE> key; // zero-padded
+};
+static_assert(sizeof(Header) == 168);
+
+struct SnapshotEntry {
+	Endian::L64 time; // EmuTime ticks
+	Endian::L64 savestateOffset;
+	Endian::L32 savestateSize;
+	Endian::L32 eventCount;
+	Endian::L32 firstBlock;
+	Endian::L32 numBlocks;
+};
+static_assert(sizeof(SnapshotEntry) == 32);
+
+struct BlockEntry {
+	Endian::L64 offset;
+	Endian::L32 size;      // size in the file
+	Endian::L32 blockSize; // size after applying the delta
+	Endian::L32 ref;       // NO_REF for a full block, else index of a full block
+	Endian::L32 reserved;
+};
+static_assert(sizeof(BlockEntry) == 24);
+
+[[nodiscard]] static bool inRange(std::span<const uint8_t> data, uint64_t offset, uint64_t size)
+{
+	return (offset <= data.size()) && (size <= (data.size() - offset));
+}
+
+template<typename T>
+static void readTable(std::span<const uint8_t> data, uint64_t offset, std::vector<T>& table)
+{
+	if (!inRange(data, offset, table.size() * sizeof(T))) {
+		throw MSXException("Invalid snapshot cache: truncated file");
+	}
+	memcpy(table.data(), data.data() + offset, table.size() * sizeof(T));
+}
+
+ReplaySnapshotCache::ReplaySnapshotCache(const std::string& filename, std::string_view key)
+	: file(std::make_shared<File>(filename))
+{
+	auto data = file->mmap();
+
+	Header header;
+	if (!inRange(data, 0, sizeof(header))) {
+		throw MSXException("Invalid snapshot cache: truncated file");
+	}
+	memcpy(&header, data.data(), sizeof(header));
+	if (header.magic != MAGIC) {
+		throw MSXException("Invalid snapshot cache: bad magic");
+	}
+	if (header.version != VERSION) {
+		throw MSXException("Unsupported snapshot cache version: ", header.version);
+	}
+	std::string_view storedKey(header.key.data(), header.key.size());
+	storedKey = storedKey.substr(0, storedKey.find('\0'));
+	if (storedKey != key) {
+		throw MSXException("Snapshot cache belongs to a different replay or openMSX version");
+	}
+
+	std::vector<SnapshotEntry> snapshotTable(header.numSnapshots);
+	std::vector<BlockEntry> blockTable(header.numBlocks);
+	readTable(data, header.snapshotTableOffset, snapshotTable);
+	readTable(data, header.blockTableOffset, blockTable);
+
+	// The owner keeps the mapping alive for as long as the blocks are used
+	// (possibly longer than this object).
+	std::shared_ptr<const void> owner = file;
+	std::vector<std::shared_ptr<DeltaBlockMapped>> blocks;
+	blocks.reserve(blockTable.size());
+	for (const auto& [i, b] : enumerate(blockTable)) {
+		if (!inRange(data, b.offset, b.size)) {
+			throw MSXException("Invalid snapshot cache: block out of range");
+		}
+		auto blockData = data.subspan(b.offset, b.size);
+		if (b.ref == NO_REF) {
+			if (b.size != b.blockSize) {
+				throw MSXException("Invalid snapshot cache: bad block size");
+			}
+			blocks.push_back(std::make_shared<DeltaBlockMapped>(owner, blockData));
+		} else {
+			if ((b.ref >= i) || blocks[b.ref]->isDelta() ||
+			    (blocks[b.ref]->getSize() != b.blockSize) ||
+			    !isValidBlockDelta(blockData, b.blockSize)) {
+				throw MSXException("Invalid snapshot cache: bad delta block");
+			}
+			blocks.push_back(std::make_shared<DeltaBlockMapped>(owner, blocks[b.ref], blockData));
+		}
+	}
+
+	snapshots.reserve(snapshotTable.size());
+	for (const auto& s : snapshotTable) {
+		if (!inRange(data, s.savestateOffset, s.savestateSize) ||
+		    (uint64_t(s.firstBlock) + s.numBlocks > blocks.size())) {
+			throw MSXException("Invalid snapshot cache: snapshot out of range");
+		}
+		auto& snapshot = snapshots.emplace_back();
+		snapshot.time = EmuTime::makeEmuTime(s.time);
+		snapshot.eventCount = s.eventCount;
+		snapshot.savestate = data.subspan(s.savestateOffset, s.savestateSize);
+		snapshot.deltaBlocks.assign(blocks.begin() + s.firstBlock,
+		                            blocks.begin() + s.firstBlock + s.numBlocks);
+		if ((snapshots.size() > 1) && (snapshot.time < snapshots[snapshots.size() - 2].time)) {
+			throw MSXException("Invalid snapshot cache: snapshots not sorted");
+		}
+	}
+}
+
+ReplaySnapshotCache::~ReplaySnapshotCache() = default;
+
+void ReplaySnapshotCache::save(const std::string& filename, std::string_view key,
+                               std::span<const Snapshot> snapshots)
+{
+	if (key.size() > KEY_SIZE) {
+		throw MSXException("Snapshot cache key too long");
+	}
+	auto tmpFilename = strCat(filename, ".tmp");
+	try {
+		writeFile(tmpFilename, key, snapshots);
+	} catch (MSXException&) {
+		FileOperations::unlink(tmpFilename);
+		throw;
+	}
+	if (FileOperations::rename(tmpFilename, filename) != 0) {
+		FileOperations::unlink(tmpFilename);
+		throw MSXException("Couldn't rename ", tmpFilename, " to ", filename);
+	}
+}
+
+void ReplaySnapshotCache::writeFile(const std::string& filename, std::string_view key,
+                                    std::span<const Snapshot> snapshots)
+{
+	Header header = {};
+	File file(filename, File::OpenMode::TRUNCATE);
+	file.write(std::span{&header, 1}); // placeholder, rewritten at the end
+	uint64_t pos = sizeof(header);
+	auto write = [&](std::span<const uint8_t> buf) {
+		auto offset = pos;
+		file.write(buf);
+		pos += buf.size();
+		return offset;
+	};
+	auto align = [&] {
+		static constexpr std::array<uint8_t, 8> zeros = {};
+		write(std::span{zeros}.first((8 - (pos & 7)) & 7));
+	};
+
+	std::vector<SnapshotEntry> snapshotTable;
+	std::vector<BlockEntry> blockTable;
+	snapshotTable.reserve(snapshots.size());
+
+	// The blocks of the last keyframe: index in 'blockTable' and content.
+	std::vector<std::pair<uint32_t, std::vector<uint8_t>>> keyBlocks;
+	for (const auto& [i, snapshot] : enumerate(snapshots)) {
+		assert((i == 0) || (snapshots[i - 1].time <= snapshot.time));
+		bool keyFrame = (i % KEYFRAME_INTERVAL) == 0;
+		if (keyFrame) keyBlocks.clear();
+
+		auto& s = snapshotTable.emplace_back();
+		s.time = (snapshot.time - EmuTime::zero()).length();
+		s.savestateOffset = write(snapshot.savestate);
+		s.savestateSize = narrow<uint32_t>(snapshot.savestate.size());
+		s.eventCount = snapshot.eventCount;
+		s.firstBlock = narrow<uint32_t>(blockTable.size());
+		s.numBlocks = narrow<uint32_t>(snapshot.deltaBlocks.size());
+
+		for (const auto& [j, block] : enumerate(snapshot.deltaBlocks)) {
+			std::vector<uint8_t> buf(block->getSize());
+			block->apply(buf);
+
+			auto& b = blockTable.emplace_back();
+			b.blockSize = narrow<uint32_t>(buf.size());
+			b.ref = NO_REF;
+			b.reserved = 0;
+			if (!keyFrame && (j < keyBlocks.size()) &&
+			    (keyBlocks[j].second.size() == buf.size())) {
+				auto delta = calcBlockDelta(keyBlocks[j].second, buf);
+				if (delta.size() < buf.size()) {
+					b.offset = write(delta);
+					b.size = narrow<uint32_t>(delta.size());
+					b.ref = keyBlocks[j].first;
+				}
+			}
+			if (b.ref == NO_REF) {
+				b.offset = write(buf);
+				b.size = b.blockSize;
+			}
+			if (keyFrame) {
+				keyBlocks.emplace_back(narrow<uint32_t>(blockTable.size() - 1), std::move(buf));
+			}
+		}
+	}
+
+	align();
+	header.snapshotTableOffset = write(std::span{
+		std::bit_cast<const uint8_t*>(snapshotTable.data()),
+		snapshotTable.size() * sizeof(SnapshotEntry)});
+	align();
+	header.blockTableOffset = write(std::span{
+		std::bit_cast<const uint8_t*>(blockTable.data()),
+		blockTable.size() * sizeof(BlockEntry)});
+
+	header.magic = MAGIC;
+	header.version = VERSION;
+	header.numSnapshots = narrow<uint32_t>(snapshotTable.size());
+	header.numBlocks = narrow<uint32_t>(blockTable.size());
+	header.reserved = 0;
+	ranges::copy(key, header.key.begin());
+	file.seek(0);
+	file.write(std::span{&header, 1});
+}
+
+std::string ReplaySnapshotCache::calcKey(const std::string& replayFilename)
+{
+	File file(replayFilename);
+	auto sum = SHA1::calc(file.mmap());
+	return strCat(sum.toString(), ' ', Version::full());
+}
+
+} // namespace openmsx
@@ -0,0 +1,85 @@
+#ifndef REPLAYSNAPSHOTCACHE_HH
+#define REPLAYSNAPSHOTCACHE_HH
+
+#include "EmuTime.hh"
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace openmsx {
+
+class DeltaBlock;
+class File;
+
+/** On-disk cache of (many) snapshots of a replay, stored next to the replay
+  * file. A replay itself only contains a handful of snapshots, so jumping to
+  * an arbitrary moment requires (fast) emulating from the nearest one, which
+  * can take a long time. With a cache containing a snapshot every few
+  * seconds, every seek is bounded.
+  *
+  * The file is memory mapped when loading, the snapshot blocks are only
+  * touched when a snapshot is actually used. Most blocks are stored as a
+  * delta relative to the corresponding block of the nearest preceding
+  * 'keyframe' snapshot (same delta format as DeltaBlockDiff).
+  *
+  * The cache is tied to a specific replay file (via a hash of its content)
+  * and openMSX version (the savestate format may change between versions).
+  */
+class ReplaySnapshotCache
+{
+public:
+	static constexpr std::string_view EXTENSION = ".cache";
+
+	struct Snapshot {
+		EmuTime time = EmuTime::zero();
+		unsigned eventCount = 0;
+		std::span<const uint8_t> savestate;
+		std::vector<std::shared_ptr<DeltaBlock>> deltaBlocks;
+	};
+
+	/** Load the cache from the given file.
+	  * @param filename The cache file.
+	  * @param key Must match the key that was used when saving, see calcKey().
+	  * @throws MSXException When the file doesn't exist, is invalid or
+	  *         belongs to a different replay.
+	  */
+	ReplaySnapshotCache(const std::string& filename, std::string_view key);
+	~ReplaySnapshotCache();
+
+	/** The snapshots are sorted on time. The 'savestate' spans point into
+	  * the mapped file, they remain valid for as long as this object or
+	  * the result of getMapping() is alive. The deltaBlocks remain valid
+	  * for as long as they're referenced.
+	  */
+	[[nodiscard]] std::span<const Snapshot> getSnapshots() const { return snapshots; }
+	[[nodiscard]] std::shared_ptr<const void> getMapping() const { return file; }
+
+	/** Write a new cache file. An existing file is replaced (via a
+	  * temporary file and rename), so it may still be mapped.
+	  * @throws MSXException
+	  */
+	static void save(const std::string& filename, std::string_view key,
+	                 std::span<const Snapshot> snapshots);
+
+	/** The key for the given replay file: a hash of its content combined
+	  * with the openMSX version.
+	  * @throws MSXException
+	  */
+	[[nodiscard]] static std::string calcKey(const std::string& replayFilename);
+
+private:
+	static void writeFile(const std::string& filename, std::string_view key,
+	                      std::span<const Snapshot> snapshots);
+
+private:
+	std::shared_ptr<File> file; // mapped, shared with the deltaBlocks
+	std::vector<Snapshot> snapshots;
+};
+
+} // namespace openmsx
+
+#endif
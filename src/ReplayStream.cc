@@ -0,0 +1,301 @@
+#include "ReplayStream.hh"
+
+#include "FileException.hh"
+#include "MSXException.hh"
+#include "StateChange.hh"
+
+#include "endian.hh"
+#include "narrow.hh"
+#include "xrange.hh"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <utility>
+#include <zlib.h>
+
+namespace openmsx {
+
+static constexpr std::array<char, 8> MAGIC = {'o', 'M', 'S', 'X', 'r', 'p', 'l', 's'};
+static constexpr uint32_t VERSION = 1;
+
+enum RecordType : uint32_t { SEGMENT = 1, INDEX = 2 };
+
+struct FileHeader {
+	std::array<char, 8> magic;
+	Endian::L32 version;
+	Endian::L32 reserved;
+};
+static_assert(sizeof(FileHeader) == 16);
+
+struct RecordHeader {
+	Endian::L32 type;
+	Endian::L32 reserved;
+	Endian::L64 size; // size of the payload (0 while it's being written)
+};
+static_assert(sizeof(RecordHeader) == 16);
+
+// The last part of the INDEX record (and thus of the file).
+struct IndexTrailer {
+	Endian::L64 indexOffset;
+	std::array<char, 8> magic;
+};
+static_assert(sizeof(IndexTrailer) == 16);
+
+template<typename T>
+[[nodiscard]] static std::span<const uint8_t> asBytes(const T& t)
+{
+	return {std::bit_cast<const uint8_t*>(&t), sizeof(T)};
+}
+
+
+// class ReplayStreamWriter
+
+ReplayStreamWriter::ReplayStreamWriter(std::string filename_)
+	: filename(std::move(filename_))
+	, file(FileOperations::openFile(filename, "wb"))
+{
+	if (!file) {
+		throw FileException("Couldn't create replay file: ", filename);
+	}
+	FileHeader header;
+	header.magic = MAGIC;
+	header.version = VERSION;
+	header.reserved = 0;
+	write(asBytes(header));
+	if (fflush(file.get()) != 0) {
+		throw FileException("Error writing replay file: ", filename);
+	}
+}
+
+void ReplayStreamWriter::write(std::span<const uint8_t> buf)
+{
+	if (fwrite(buf.data(), 1, buf.size(), file.get()) != buf.size()) {
+		throw FileException("Error writing replay file: ", filename);
+	}
+}
+
+uint64_t ReplayStreamWriter::seekEnd()
+{
+	// Also needed to resync the FILE buffer after data was written via a
+	// different file descriptor (see beginSegment()).
+#ifdef _WIN32
+	int ret = _fseeki64(file.get(), 0, SEEK_END);
+	auto pos = ret ? -1 : _ftelli64(file.get());
+#else
+	int ret = fseeko(file.get(), 0, SEEK_END);
+	auto pos = ret ? -1 : ftello(file.get());
+#endif
+	if (pos < 0) {
+		throw FileException("Error seeking in replay file: ", filename);
+	}
+	return uint64_t(pos);
+}
+
+void ReplayStreamWriter::writeRecordHeader(uint32_t type, uint64_t size)
+{
+	RecordHeader header;
+	header.type = type;
+	header.reserved = 0;
+	header.size = size;
+	write(asBytes(header));
+}
+
+FILE* ReplayStreamWriter::beginSegment()
+{
+	recordStart = seekEnd();
+	writeRecordHeader(SEGMENT, 0); // size is filled in by endSegment()
+	if (fflush(file.get()) != 0) {
+		throw FileException("Error writing replay file: ", filename);
+	}
+	return file.get();
+}
+
+void ReplayStreamWriter::endSegment()
+{
+	auto end = seekEnd();
+	assert(end >= recordStart + sizeof(RecordHeader));
+#ifdef _WIN32
+	int ret = _fseeki64(file.get(), recordStart, SEEK_SET);
+#else
+	int ret = fseeko(file.get(), narrow_cast<off_t>(recordStart), SEEK_SET);
+#endif
+	if (ret != 0) {
+		throw FileException("Error seeking in replay file: ", filename);
+	}
+	writeRecordHeader(SEGMENT, end - recordStart - sizeof(RecordHeader));
+	segments.push_back(recordStart);
+
+	auto indexStart = seekEnd();
+	writeRecordHeader(INDEX, segments.size() * sizeof(Endian::L64) + sizeof(IndexTrailer));
+	for (auto offset : segments) {
+		write(asBytes(Endian::L64(offset)));
+	}
+	IndexTrailer trailer;
+	trailer.indexOffset = indexStart;
+	trailer.magic = MAGIC;
+	write(asBytes(trailer));
+	if (fflush(file.get()) != 0) {
+		throw FileException("Error writing replay file: ", filename);
+	}
+}
+
+
+// class ReplayStreamPosition
+
+bool ReplayStreamPosition::isPrefixOf(
+	const Events& events, size_t numEvents_, std::span<const EmuTime> snapshotTimes) const
+{
+	if (snapshotTimes.empty() || (snapshotTimes.front() != firstSnapshotTime)) {
+		return false;
+	}
+	if (lastSnapshotTime && !std::ranges::binary_search(snapshotTimes, *lastSnapshotTime)) {
+		return false; // e.g. removed by 'reverse goto' + new input
+	}
+	if (numEvents > numEvents_) return false;
+	if (numEvents != 0) {
+		const auto* last = events[numEvents - 1].get();
+		if ((last != lastEvent) || (last->getTime() != lastEventTime)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void ReplayStreamPosition::update(
+	const Events& events, size_t numEvents_, std::optional<EmuTime> lastSnapshotTime_)
+{
+	numEvents = numEvents_;
+	lastEvent = numEvents ? events[numEvents - 1].get() : nullptr;
+	lastEventTime = numEvents ? lastEvent->getTime() : EmuTime::zero();
+	lastSnapshotTime = lastSnapshotTime_;
+}
+
+
+// class ReplayStreamReader
+
+template<typename T>
+[[nodiscard]] static bool read(std::span<const uint8_t> data, uint64_t offset, T& t)
+{
+	if ((offset > data.size()) || (sizeof(T) > (data.size() - offset))) return false;
+	memcpy(&t, data.data() + offset, sizeof(T));
+	return true;
+}
+
+// Locate the segments via the index at the end of the file.
+[[nodiscard]] static bool readIndex(std::span<const uint8_t> data,
+                                    std::vector<std::span<const uint8_t>>& segments)
+{
+	IndexTrailer trailer;
+	if ((data.size() < sizeof(trailer)) ||
+	    !read(data, data.size() - sizeof(trailer), trailer) ||
+	    (trailer.magic != MAGIC)) {
+		return false;
+	}
+	RecordHeader index;
+	if (!read(data, trailer.indexOffset, index) || (index.type != INDEX) ||
+	    (trailer.indexOffset + sizeof(index) + index.size != data.size()) ||
+	    (index.size < sizeof(trailer)) ||
+	    (((index.size - sizeof(trailer)) % sizeof(Endian::L64)) != 0)) {
+		return false;
+	}
+	auto num = (index.size - sizeof(trailer)) / sizeof(Endian::L64);
+	for (auto i : xrange(num)) {
+		Endian::L64 offset;
+		RecordHeader segment;
+		if (!read(data, trailer.indexOffset + sizeof(index) + i * sizeof(offset), offset) ||
+		    !read(data, offset, segment) || (segment.type != SEGMENT) ||
+		    (segment.size == 0) ||
+		    (segment.size > (data.size() - offset - sizeof(segment)))) {
+			return false;
+		}
+		segments.push_back(data.subspan(offset + sizeof(segment), segment.size));
+	}
+	return true;
+}
+
+// Locate the segments by walking over all records, this also works when the
+// last write was interrupted.
+static void scanRecords(std::span<const uint8_t> data,
+                        std::vector<std::span<const uint8_t>>& segments)
+{
+	uint64_t pos = sizeof(FileHeader);
+	RecordHeader record;
+	while (read(data, pos, record)) {
+		pos += sizeof(record);
+		if ((record.size == 0) || (record.size > (data.size() - pos))) break;
+		if (record.type == SEGMENT) {
+			segments.push_back(data.subspan(pos, record.size));
+		}
+		pos += record.size;
+	}
+}
+
+bool ReplayStreamReader::isReplayStream(const std::string& filename)
+{
+	try {
+		File f(filename);
+		FileHeader header;
+		if (f.getSize() < sizeof(header)) return false;
+		f.read(std::span{&header, 1});
+		return header.magic == MAGIC;
+	} catch (MSXException&) {
+		return false;
+	}
+}
+
+ReplayStreamReader::ReplayStreamReader(const std::string& filename)
+	: file(filename)
+{
+	auto data = file.mmap();
+	FileHeader header;
+	if (!read(data, 0, header) || (header.magic != MAGIC)) {
+		throw MSXException("Not a replay stream: ", filename);
+	}
+	if (header.version != VERSION) {
+		throw MSXException("Unsupported replay stream version: ", header.version);
+	}
+	if (!readIndex(data, segments)) {
+		segments.clear();
+		scanRecords(data, segments);
+	}
+	if (segments.empty()) {
+		throw MSXException("Replay stream doesn't contain any data: ", filename);
+	}
+}
+
+std::vector<char> ReplayStreamReader::getSegment(size_t i) const
+{
+	auto input = segments[i];
+	z_stream s = {};
+	if (inflateInit2(&s, 16 + MAX_WBITS) != Z_OK) { // 16: expect gzip header
+		throw MSXException("Error initializing inflate struct");
+	}
+	s.next_in = const_cast<uint8_t*>(input.data());
+	s.avail_in = narrow<uInt>(input.size());
+
+	std::vector<char> result(4 * input.size() + 4096);
+	size_t done = 0;
+	while (true) {
+		s.next_out = std::bit_cast<Bytef*>(result.data() + done);
+		s.avail_out = narrow<uInt>(result.size() - done);
+		int ret = inflate(&s, Z_NO_FLUSH);
+		done = result.size() - s.avail_out;
+		if (ret == Z_STREAM_END) break;
+		if ((ret != Z_OK) && (ret != Z_BUF_ERROR)) {
+			inflateEnd(&s);
+			throw MSXException("Error decompressing replay segment");
+		}
+		if (s.avail_out != 0) { // input exhausted before end of stream
+			inflateEnd(&s);
+			throw MSXException("Truncated replay segment");
+		}
+		result.resize(2 * result.size());
+	}
+	inflateEnd(&s);
+	result.resize(done);
+	return result;
+}
+
+} // namespace openmsx
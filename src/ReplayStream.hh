@@ -0,0 +1,128 @@
+#ifndef REPLAYSTREAM_HH
+#define REPLAYSTREAM_HH
+
+#include "EmuTime.hh"
+#include "File.hh"
+#include "FileOperations.hh"
+
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+class StateChange;
+
+/** A replay file that can grow incrementally. Instead of one big XML
+  * document (which has to be completely rewritten on each save), the file
+  * is a sequence of 'segments', each segment is a (gzip compressed) XML
+  * replay document that only contains the snapshots and events that were
+  * added since the previous segment.
+  *
+  * File layout (all values little endian):
+  *   header:  magic "oMSXrpls", version
+  *   records: type, payload size, payload
+  *     SEGMENT: gzip compressed XML document
+  *     INDEX:   offsets of all SEGMENT records written so far, followed by
+  *              the offset of this INDEX record itself and the magic
+  * Each append writes a SEGMENT followed by a new INDEX record. So the last
+  * bytes of the file allow to locate all segments without reading the whole
+  * file. Existing data is never modified (except for the size field of the
+  * record that is being written), so when writing gets interrupted (e.g. a
+  * crash) all previously written segments can still be recovered by
+  * scanning the records from the start.
+  */
+class ReplayStreamWriter
+{
+public:
+	/** Create a new (empty) stream, overwrites an existing file.
+	  * @throws MSXException
+	  */
+	explicit ReplayStreamWriter(std::string filename);
+
+	[[nodiscard]] const std::string& getFilename() const { return filename; }
+	[[nodiscard]] size_t getNumSegments() const { return segments.size(); }
+
+	/** Start a new segment. The caller should write the compressed
+	  * segment data to the returned file, starting at the current
+	  * position, and then call endSegment().
+	  * @throws MSXException
+	  */
+	[[nodiscard]] FILE* beginSegment();
+	/** Finish the current segment and write a new index.
+	  * @throws MSXException
+	  */
+	void endSegment();
+
+private:
+	void write(std::span<const uint8_t> buf);
+	[[nodiscard]] uint64_t seekEnd();
+	void writeRecordHeader(uint32_t type, uint64_t size);
+
+private:
+	std::string filename;
+	FileOperations::FILE_t file;
+	std::vector<uint64_t> segments; // file offsets of the SEGMENT records
+	uint64_t recordStart = 0; // offset of the record being written
+};
+
+/** What was already written to a replay stream, so that the next save only
+  * has to append the new snapshots and events. In between, the history may
+  * have been changed (e.g. 'reverse goto' followed by new input), then the
+  * written data is no longer a prefix of the history, and the file must be
+  * rewritten from scratch.
+  */
+struct ReplayStreamPosition
+{
+	using Events = std::deque<std::unique_ptr<StateChange>>;
+
+	/** Is the written data still the start of the given history?
+	  * @param events The event log.
+	  * @param numEvents The number of events in the log that will be
+	  *                  written (so excluding a trailing EndLogEvent).
+	  * @param snapshotTimes The times of all snapshots, sorted.
+	  */
+	[[nodiscard]] bool isPrefixOf(const Events& events, size_t numEvents,
+	                              std::span<const EmuTime> snapshotTimes) const;
+
+	/** Remember what was written (see isPrefixOf() for the parameters). */
+	void update(const Events& events, size_t numEvents_,
+	            std::optional<EmuTime> lastSnapshotTime_);
+
+	size_t numEvents = 0; // number of written events
+	// The last written event. A pointer can be reused by a new event
+	// (after the old one got deleted), so also check the time.
+	const StateChange* lastEvent = nullptr;
+	EmuTime lastEventTime = EmuTime::zero();
+	std::optional<EmuTime> firstSnapshotTime;
+	std::optional<EmuTime> lastSnapshotTime; // last written snapshot
+};
+
+class ReplayStreamReader
+{
+public:
+	/** Is the given file a replay stream (as opposed to a normal replay)? */
+	[[nodiscard]] static bool isReplayStream(const std::string& filename);
+
+	/** @throws MSXException */
+	explicit ReplayStreamReader(const std::string& filename);
+
+	[[nodiscard]] size_t getNumSegments() const { return segments.size(); }
+	/** Returns the decompressed XML document of the i-th segment.
+	  * @throws MSXException
+	  */
+	[[nodiscard]] std::vector<char> getSegment(size_t i) const;
+
+private:
+	File file;
+	std::vector<std::span<const uint8_t>> segments;
+};
+
+} // namespace openmsx
+
+#endif
@@ -14,6 +14,8 @@
 #include "MSXMixer.hh"
 #include "MSXMotherBoard.hh"
 #include "Reactor.hh"
+#include "ReplaySnapshotCache.hh"
+#include "ReplayStream.hh"
 #include "StateChange.hh"
 #include "StateChangeDistributor.hh"
 #include "TclArgParser.hh"
@@ -24,10 +26,14 @@
 #include "serialize_meta.hh"
 
 #include "MemBuffer.hh"
+#include "hash_set.hh"
+#include "enumerate.hh"
 #include "narrow.hh"
 #include "one_of.hh"
 #include "ranges.hh"
+#include "scope_exit.hh"
 #include "view.hh"
+#include "xrange.hh"
 
 #include <array>
 #include <cassert>
@@ -48,6 +54,9 @@ static constexpr auto MIN_PARTITION_LENGTH = EmuDuration(60.0);
 // Max distance of one before last snapshot before the end time in replay file (in seconds)
 static constexpr auto MAX_DIST_1_BEFORE_LAST_SNAPSHOT = EmuDuration(30.0);
 
+// Time between two snapshots in a replay snapshot cache (in seconds)
+static constexpr double CACHE_SNAPSHOT_PERIOD = 5.0;
+
 // A replay is a struct that contains a vector of motherboards and an MSX event
 // log. Those combined are a replay, because you can replay the events from an
 // existing motherboard state: the vector has to have at least one motherboard
@@ -62,7 +71,8 @@ struct Replay
 
 	Reactor& reactor;
 
-	ReverseManager::Events* events;
+	using Events = ReverseManager::Events;
+	Events* events;
 	std::vector<Reactor::Board> motherBoards;
 	EmuTime currentTime = EmuTime::dummy();
 	// this is the amount of times the reverse goto command was used, which
@@ -142,6 +152,7 @@ ReverseManager::ReverseManager(MSXMotherBoard& motherBoard_)
 	, reverseCmd(motherBoard.getCommandController())
 {
 	eventDistributor.registerEventListener(EventType::TAKE_REVERSE_SNAPSHOT, *this);
+	history.lastDeltaBlocks.setCompressor(&compressor);
 
 	assert(!isCollecting());
 	assert(!isReplaying());
@@ -252,15 +263,28 @@ void ReverseManager::debugInfo(TclObject& result) const
 	// information means nothing. We should remove this later.
 	std::string res;
 	size_t totalSize = 0;
+	size_t totalBlockSize = 0;
+	hash_set<const DeltaBlock*> seenBlocks; // blocks can be shared between snapshots
 	for (const auto& [idx, chunk] : history.chunks) {
+		// only count the blocks that weren't already used by an earlier snapshot
+		size_t blockSize = 0;
+		for (const auto& block : chunk.deltaBlocks) {
+			if (seenBlocks.insert(block.get()).second) {
+				blockSize += block->getStorageSize();
+			}
+		}
 		strAppend(res, idx, ' ',
 		          (chunk.time - EmuTime::zero()).toDouble(), ' ',
 		          ((chunk.time - EmuTime::zero()).toDouble() / (getCurrentTime() - EmuTime::zero()).toDouble()) * 100, "%"
 		          " (", chunk.size, ")"
+		          " (blocks: ", blockSize, ")"
+		          " (capture: ", chunk.captureTime, "us)"
 		          " (next event index: ", chunk.eventCount, ")\n");
 		totalSize += chunk.size;
+		totalBlockSize += blockSize;
 	}
-	strAppend(res, "total size: ", totalSize, '\n');
+	strAppend(res, "total size: ", totalSize, '\n',
+	               "total block size: ", totalBlockSize, '\n');
 	result = res;
 }
 
@@ -405,7 +429,7 @@ void ReverseManager::goTo(
 			// suppress messages we'd get by deserializing (and
 			// thus instantiating the parts of) the new board
 			newBoard->getMSXCliComm().setSuppressMessages(true);
-			MemInputArchive in(chunk.savestate.data(),
+			MemInputArchive in(chunk.getSavestate(),
 					   chunk.size,
 					   chunk.deltaBlocks);
 			in.serialize("machine", *newBoard);
@@ -534,6 +558,9 @@ void ReverseManager::transferState(MSXMotherBoard& newBoard)
 	// copy rerecord count
 	newManager.reRecordCount = reRecordCount;
 
+	// continue 'savereplay -stream' (the event log is transferred as well)
+	newManager.replayStream = std::move(replayStream);
+
 	// transfer settings
 	const auto& oldController = motherBoard.getMSXCommandController();
 	newBoard.getMSXCommandController().transferSettings(oldController);
@@ -549,7 +576,11 @@ void ReverseManager::saveReplay(
 
 	std::string_view filenameArg;
 	int maxNofExtraSnapshots = MAX_NOF_SNAPSHOTS;
-	std::array info = {valueArg("-maxnofextrasnapshots", maxNofExtraSnapshots)};
+	bool stream = false;
+	std::array info = {
+		valueArg("-maxnofextrasnapshots", maxNofExtraSnapshots),
+		flagArg("-stream", stream),
+	};
 	auto args = parseTclArgs(interp, tokens.subspan(2), info);
 	switch (args.size()) {
 		case 0: break; // nothing
@@ -563,6 +594,12 @@ void ReverseManager::saveReplay(
 	auto filename = FileOperations::parseCommandFileArgument(
 		filenameArg, REPLAY_DIR, "openmsx", REPLAY_EXTENSION);
 
+	if (stream) {
+		saveReplayStream(filename);
+		result = tmpStrCat("Saved replay to ", filename);
+		return;
+	}
+
 	auto& reactor = motherBoard.getReactor();
 	Replay replay(reactor);
 	replay.reRecordCount = reRecordCount;
@@ -573,7 +610,7 @@ void ReverseManager::saveReplay(
 
 	// restore first snapshot to be able to serialize it to a file
 	auto initialBoard = reactor.createEmptyMotherBoard();
-	MemInputArchive in(begin(chunks)->second.savestate.data(),
+	MemInputArchive in(begin(chunks)->second.getSavestate(),
 	                   begin(chunks)->second.size,
 			   begin(chunks)->second.deltaBlocks);
 	in.serialize("machine", *initialBoard);
@@ -602,7 +639,7 @@ void ReverseManager::saveReplay(
 				if (it != lastAddedIt) {
 					// this is a new one, add it to the list of snapshots
 					Reactor::Board board = reactor.createEmptyMotherBoard();
-					MemInputArchive in2(it->second.savestate.data(),
+					MemInputArchive in2(it->second.getSavestate(),
 							    it->second.size,
 							    it->second.deltaBlocks);
 					in2.serialize("machine", *board);
@@ -649,68 +686,157 @@ void ReverseManager::saveReplay(
 	result = tmpStrCat("Saved replay to ", filename);
 }
 
-void ReverseManager::loadReplay(
-	Interpreter& interp, std::span<const TclObject> tokens, TclObject& result)
+// Only write what changed since the previous call (for the same file): the
+// new events and a new snapshot every MIN_PARTITION_LENGTH seconds. When the
+// history was changed in the meantime (e.g. the replay was truncated) the file
+// is rewritten from scratch.
+void ReverseManager::saveReplayStream(const std::string& filename)
 {
-	bool enableViewOnly = false;
-	std::optional<TclObject> where;
-	std::array info = {
-		flagArg("-viewonly", enableViewOnly),
-		valueArg("-goto", where),
+	const auto& chunks = history.chunks;
+	auto& events = history.events;
+	assert(!chunks.empty());
+
+	// number of events, not counting a trailing EndLogEvent
+	auto numEvents = events.size();
+	if (numEvents && dynamic_cast<const EndLogEvent*>(events.back().get())) {
+		--numEvents;
+	}
+
+	auto& stream = replayStream;
+	auto& pos = stream.position;
+	auto snapshotTimes = to_vector(view::transform(chunks, [](const auto& p) {
+		return p.second.time;
+	}));
+	bool canAppend = stream.writer &&
+		(stream.writer->getFilename() == filename) &&
+		pos.isPrefixOf(events, numEvents, snapshotTimes);
+	if (!canAppend) {
+		stream = ReplayStream{};
+		stream.writer = std::make_unique<ReplayStreamWriter>(filename);
+		pos.firstSnapshotTime = snapshotTimes.front();
+	}
+
+	auto& reactor = motherBoard.getReactor();
+	Replay replay(reactor);
+	replay.reRecordCount = reRecordCount;
+	replay.currentTime = getCurrentTime();
+
+	auto lastSnapshotTime = pos.lastSnapshotTime;
+	for (const auto& [seqNum, chunk] : chunks) {
+		if (lastSnapshotTime &&
+		    (chunk.time < (*lastSnapshotTime + MIN_PARTITION_LENGTH))) {
+			continue;
+		}
+		auto board = reactor.createEmptyMotherBoard();
+		MemInputArchive in(chunk.getSavestate(), chunk.size,
+		                   chunk.deltaBlocks);
+		in.serialize("machine", *board);
+		replay.motherBoards.push_back(std::move(board));
+		lastSnapshotTime = chunk.time;
+	}
+
+	// Temporarily move the new events to the replay (and terminate them
+	// with an EndLogEvent). When loading, the EndLogEvents of all but the
+	// last segment are dropped.
+	Events newEvents;
+	for (auto i : xrange(pos.numEvents, events.size())) {
+		newEvents.push_back(std::move(events[i]));
+	}
+	bool addSentinel = newEvents.empty() ||
+		!dynamic_cast<const EndLogEvent*>(newEvents.back().get());
+	if (addSentinel) {
+		newEvents.push_back(std::make_unique<EndLogEvent>(getCurrentTime()));
+	}
+	auto restoreEvents = [&] {
+		if (addSentinel) newEvents.pop_back();
+		for (auto [i, event] : enumerate(newEvents)) {
+			events[pos.numEvents + i] = std::move(event);
+		}
 	};
-	auto arguments = parseTclArgs(interp, tokens.subspan(2), info);
-	if (arguments.size() != 1) throw SyntaxError();
+	replay.events = &newEvents;
+	try {
+		auto* f = stream.writer->beginSegment();
+		XmlOutputArchive out(f, filename);
+		out.serialize("replay", replay);
+		out.close();
+		stream.writer->endSegment();
+	} catch (MSXException&) {
+		restoreEvents();
+		stream = ReplayStream{}; // start a new file on the next save
+		throw;
+	}
+	restoreEvents();
+
+	pos.update(events, numEvents, lastSnapshotTime);
+}
+
+// Concatenate all segments of a replay stream, see saveReplayStream().
+static void loadReplayStream(const std::string& filename, Replay& replay)
+{
+	ReplayStreamReader reader(filename);
+	auto& events = *replay.events;
+	for (auto i : xrange(reader.getNumSegments())) {
+		if (!events.empty() &&
+		    dynamic_cast<const EndLogEvent*>(events.back().get())) {
+			events.pop_back();
+		}
+		Replay segment(replay.reactor);
+		Replay::Events segmentEvents;
+		segment.events = &segmentEvents;
+		auto xml = reader.getSegment(i);
+		XmlInputArchive in(filename, xml);
+		in.serialize("replay", segment);
+
+		std::ranges::move(segment.motherBoards, std::back_inserter(replay.motherBoards));
+		std::ranges::move(segmentEvents, std::back_inserter(events));
+		replay.currentTime = segment.currentTime;
+		replay.reRecordCount = segment.reRecordCount;
+	}
+	if (replay.motherBoards.empty()) {
+		throw MSXException("no snapshot in replay");
+	}
+}
 
-	// resolve the filename
-	auto context = userDataFileContext(REPLAY_DIR);
-	std::string fileNameArg(arguments[0].getString());
-	std::string filename;
+static std::string resolveReplayFilename(std::string_view fileNameArg)
+{
+	auto context = userDataFileContext(ReverseManager::REPLAY_DIR);
 	try {
 		// Try filename as typed by user.
-		filename = context.resolve(fileNameArg);
+		return context.resolve(fileNameArg);
 	} catch (MSXException& /*e1*/) { try {
 		// Not found, try adding the normal extension
-		filename = context.resolve(tmpStrCat(fileNameArg, REPLAY_EXTENSION));
+		return context.resolve(tmpStrCat(fileNameArg, ReverseManager::REPLAY_EXTENSION));
 	} catch (MSXException& e2) { try {
 		// Again not found, try adding '.gz'.
 		// (this is for backwards compatibility).
-		filename = context.resolve(tmpStrCat(fileNameArg, ".gz"));
+		return context.resolve(tmpStrCat(fileNameArg, ".gz"));
 	} catch (MSXException& /*e3*/) {
 		// Show error message that includes the default extension.
 		throw e2;
 	}}}
+}
 
-	// restore replay
-	auto& reactor = motherBoard.getReactor();
-	Replay replay(reactor);
+// Load the replay file into 'replay' and convert its snapshots and event log
+// into the history of the ReverseManager of the first snapshot. This doesn't
+// change anything to this ReverseManager/MSXMotherBoard.
+ReverseManager& ReverseManager::readReplay(const std::string& filename, Replay& replay)
+{
 	Events events;
 	replay.events = &events;
 	try {
-		XmlInputArchive in(filename);
-		in.serialize("replay", replay);
+		if (ReplayStreamReader::isReplayStream(filename)) {
+			loadReplayStream(filename, replay);
+		} else {
+			XmlInputArchive in(filename);
+			in.serialize("replay", replay);
+		}
 	} catch (XMLException& e) {
 		throw CommandException("Cannot load replay, bad file format: ",
 		                       e.getMessage());
 	} catch (MSXException& e) {
 		throw CommandException("Cannot load replay: ", e.getMessage());
 	}
-
-	// get destination time index
-	auto destination = EmuTime::zero();
-	if (!where || (*where == "begin")) {
-		destination = EmuTime::zero();
-	} else if (*where == "end") {
-		destination = EmuTime::infinity();
-	} else if (*where == "savetime") {
-		destination = replay.currentTime;
-	} else {
-		destination += EmuDuration(where->getDouble(interp));
-	}
-
-	// OK, we are going to be actually changing states now
-
-	// now we can change the view only mode
-	motherBoard.getStateChangeDistributor().setViewOnlyMode(enableViewOnly);
+	replay.events = nullptr;
 
 	assert(!replay.motherBoards.empty());
 	auto& newReverseManager = replay.motherBoards[0]->getReverseManager();
@@ -737,7 +863,9 @@ void ReverseManager::loadReplay(
 		MemOutputArchive out(newHistory.lastDeltaBlocks,
 		                     newChunk.deltaBlocks, false);
 		out.serialize("machine", *m);
-		newChunk.savestate = out.releaseBuffer(newChunk.size);
+		size_t size;
+		auto savestate = out.releaseBuffer(size);
+		newChunk.setSavestate(std::move(savestate), size);
 
 		// update replayIdx
 		// TODO: should we use <= instead??
@@ -750,6 +878,50 @@ void ReverseManager::loadReplay(
 		newHistory.chunks[newHistory.getNextSeqNum(newChunk.time)] =
 			std::move(newChunk);
 	}
+	return newReverseManager;
+}
+
+void ReverseManager::loadReplay(
+	Interpreter& interp, std::span<const TclObject> tokens, TclObject& result)
+{
+	bool enableViewOnly = false;
+	bool useCache = false;
+	std::optional<TclObject> where;
+	std::array info = {
+		flagArg("-viewonly", enableViewOnly),
+		flagArg("-cache", useCache),
+		valueArg("-goto", where),
+	};
+	auto arguments = parseTclArgs(interp, tokens.subspan(2), info);
+	if (arguments.size() != 1) throw SyntaxError();
+
+	auto filename = resolveReplayFilename(arguments[0].getString());
+
+	// restore replay
+	Replay replay(motherBoard.getReactor());
+	auto& newReverseManager = readReplay(filename, replay);
+	auto& newHistory = newReverseManager.history;
+
+	// get destination time index
+	auto destination = EmuTime::zero();
+	if (!where || (*where == "begin")) {
+		destination = EmuTime::zero();
+	} else if (*where == "end") {
+		destination = EmuTime::infinity();
+	} else if (*where == "savetime") {
+		destination = replay.currentTime;
+	} else {
+		destination += EmuDuration(where->getDouble(interp));
+	}
+
+	if (useCache) {
+		useSnapshotCache(filename, newHistory);
+	}
+
+	// OK, we are going to be actually changing states now
+
+	// now we can change the view only mode
+	motherBoard.getStateChangeDistributor().setViewOnlyMode(enableViewOnly);
 
 	// Note: until this point we didn't make any changes to the current
 	// ReverseManager/MSXMotherBoard yet
@@ -760,6 +932,140 @@ void ReverseManager::loadReplay(
 	result = tmpStrCat("Loaded replay from ", filename);
 }
 
+// Emulate the whole replay and store the snapshot cache for it, see
+// ReplaySnapshotCache. This is a separate command (instead of building the
+// cache in 'loadreplay -cache' when there's none yet) because it blocks:
+// it only returns (and the GUI only reacts again) when the whole replay has
+// been emulated, only the progress indicator is updated meanwhile. Building
+// it in the background would require merging the result into a history that
+// may have changed in the meantime. This doesn't change the state of this
+// machine.
+void ReverseManager::buildCache(std::span<const TclObject> tokens, TclObject& result)
+{
+	if (tokens.size() != 3) throw SyntaxError();
+	auto filename = resolveReplayFilename(tokens[2].getString());
+
+	Replay replay(motherBoard.getReactor());
+	auto& newHistory = readReplay(filename, replay).history;
+	// That ReverseManager isn't collecting, so it can't keep this history
+	// (unlike in loadReplay(), where goTo() takes it over).
+	scope_exit e([&]{ newHistory.clear(); });
+
+	std::string key;
+	try {
+		key = ReplaySnapshotCache::calcKey(filename);
+	} catch (MSXException& e) {
+		throw CommandException("Cannot read replay: ", e.getMessage());
+	}
+
+	// See goTo() for why we mute.
+	auto& mixer = motherBoard.getMSXMixer();
+	mixer.mute();
+	try {
+		buildSnapshotCache(newHistory);
+	} catch (MSXException&) {
+		mixer.unmute();
+		throw;
+	}
+	mixer.unmute();
+
+	auto cacheFilename = strCat(filename, ReplaySnapshotCache::EXTENSION);
+	try {
+		auto snapshots = to_vector(view::transform(newHistory.chunks, [](const auto& p) {
+			const auto& chunk = p.second;
+			return ReplaySnapshotCache::Snapshot{
+				chunk.time, chunk.eventCount,
+				std::span{chunk.getSavestate(), chunk.size},
+				chunk.deltaBlocks};
+		}));
+		ReplaySnapshotCache::save(cacheFilename, key, snapshots);
+	} catch (MSXException& e) {
+		throw CommandException("Couldn't save replay snapshot cache: ",
+		                       e.getMessage());
+	}
+	result = tmpStrCat("Saved replay snapshot cache to ", cacheFilename);
+}
+
+void ReverseManager::useSnapshotCache(
+	const std::string& replayFilename, ReverseHistory& hist)
+{
+	auto cacheFilename = strCat(replayFilename, ReplaySnapshotCache::EXTENSION);
+	try {
+		auto key = ReplaySnapshotCache::calcKey(replayFilename);
+		ReplaySnapshotCache cache(cacheFilename, key);
+		// The cache contains (at least) all snapshots of the replay file.
+		// The savestates are used directly from the mapped file.
+		hist.chunks.clear();
+		auto mapping = cache.getMapping();
+		for (const auto& snapshot : cache.getSnapshots()) {
+			ReverseChunk newChunk;
+			newChunk.time = snapshot.time;
+			newChunk.deltaBlocks = snapshot.deltaBlocks;
+			newChunk.setMappedSavestate(mapping, snapshot.savestate);
+			newChunk.eventCount = snapshot.eventCount;
+			hist.chunks[hist.getNextSeqNum(newChunk.time)] =
+				std::move(newChunk);
+		}
+	} catch (MSXException& e) {
+		// Not fatal, the replay works as well without the cache.
+		motherBoard.getMSXCliComm().printWarning(
+			"No (valid) snapshot cache for this replay (", e.getMessage(),
+			"), create one with 'reverse build_cache'.");
+	}
+}
+
+// Emulate the replay in 'hist' from its first snapshot till the end, and add
+// a snapshot every CACHE_SNAPSHOT_PERIOD seconds.
+void ReverseManager::buildSnapshotCache(ReverseHistory& hist)
+{
+	// Stop a bit before the EndLogEvent, when that event is executed the
+	// replay stops (and it gets removed from the log).
+	assert(!hist.chunks.empty());
+	const auto* endEvent = hist.events.empty() ? nullptr
+		: dynamic_cast<const EndLogEvent*>(hist.events.back().get());
+	if (!endEvent) return;
+	auto endTime = endEvent->getTime();
+
+	auto& reactor = motherBoard.getReactor();
+	auto board = reactor.createEmptyMotherBoard();
+	board->getMSXCliComm().setSuppressMessages(true);
+	const auto& first = begin(hist.chunks)->second;
+	MemInputArchive in(first.getSavestate(), first.size, first.deltaBlocks);
+	in.serialize("machine", *board);
+
+	auto& rm = board->getReverseManager();
+	rm.transferHistory(hist, first.eventCount);
+	rm.syncNewSnapshot.removeSyncPoint(); // we take the snapshots ourselves
+	try {
+		auto startTime = board->getCurrentTime();
+		auto lastProgress = Timer::getTime();
+		bool everShowedProgress = false;
+		auto showProgress = [&](float fraction) {
+			everShowedProgress = true;
+			reactor.getCliComm().printProgress("Building replay snapshot cache...", fraction);
+			reactor.getDisplay().repaint();
+		};
+		auto target = startTime;
+		while (true) {
+			target += EmuDuration(CACHE_SNAPSHOT_PERIOD);
+			if ((target + EmuDuration::sec(1)) >= endTime) break;
+			board->fastForward(target, true);
+			rm.takeSnapshot(board->getCurrentTime(), false);
+
+			if (auto now = Timer::getTime(); (now - lastProgress) > 1000000) {
+				lastProgress = now;
+				showProgress(float((target - startTime).toDouble() /
+				                   (endTime - startTime).toDouble()));
+			}
+		}
+		if (everShowedProgress) showProgress(1.0f);
+	} catch (MSXException&) {
+		hist.swap(rm.history);
+		throw;
+	}
+	hist.swap(rm.history);
+}
+
 void ReverseManager::transferHistory(ReverseHistory& oldHistory,
                                      unsigned oldEventCount)
 {
@@ -861,13 +1167,13 @@ unsigned ReverseManager::ReverseHistory::getNextSeqNum(EmuTime::param time) cons
 	return narrow<unsigned>(lrint(duration / SNAPSHOT_PERIOD));
 }
 
-void ReverseManager::takeSnapshot(EmuTime::param time)
+void ReverseManager::takeSnapshot(EmuTime::param time, bool dropOld)
 {
 	// (possibly) drop old snapshots
 	// TODO does snapshot pruning still happen correctly (often enough)
 	//      when going back/forward in time?
 	unsigned seqNum = history.getNextSeqNum(time);
-	dropOldSnapshots<25>(seqNum);
+	if (dropOld) dropOldSnapshots<25>(seqNum);
 
 	// During replay we might already have a snapshot with the current
 	// sequence number, though this snapshot does not necessarily have the
@@ -875,13 +1181,20 @@ void ReverseManager::takeSnapshot(EmuTime::param time)
 	// the same moment in time).
 
 	// actually create new snapshot
+	// Only the serialization and delta calculation happens here, the
+	// compression of (no longer used) reference blocks is done by
+	// 'compressor' in the background.
+	auto startTime = Timer::getTime();
 	ReverseChunk& newChunk = history.chunks[seqNum];
 	newChunk.deltaBlocks.clear();
 	MemOutputArchive out(history.lastDeltaBlocks, newChunk.deltaBlocks, true);
 	out.serialize("machine", motherBoard);
 	newChunk.time = time;
-	newChunk.savestate = out.releaseBuffer(newChunk.size);
+	size_t size;
+	auto savestate = out.releaseBuffer(size);
+	newChunk.setSavestate(std::move(savestate), size);
 	newChunk.eventCount = replayIndex;
+	newChunk.captureTime = Timer::getTime() - startTime;
 }
 
 void ReverseManager::replayNextEvent()
@@ -971,6 +1284,7 @@ void ReverseManager::ReverseCmd::execute(std::span<const TclObject> tokens, TclO
 		"goto",       [&]{ manager.goTo(tokens); },
 		"savereplay", [&]{ manager.saveReplay(interp, tokens, result); },
 		"loadreplay", [&]{ manager.loadReplay(interp, tokens, result); },
+		"build_cache", [&]{ manager.buildCache(tokens, result); },
 		"viewonlymode", [&]{
 			auto& distributor = manager.motherBoard.getStateChangeDistributor();
 			switch (tokens.size()) {
@@ -998,8 +1312,9 @@ std::string ReverseManager::ReverseCmd::help(std::span<const TclObject> /*tokens
 	       "goto <time>         go to an absolute moment in time\n"
 	       "viewonlymode <bool> switch viewonly mode on or off\n"
 	       "truncatereplay      stop replaying and remove all 'future' data\n"
-	       "savereplay [<name>] save the first snapshot and all replay data as a 'replay' (with optional name)\n"
-	       "loadreplay [-goto <begin|end|savetime|<n>>] [-viewonly] <name>   load a replay (snapshot and replay data) with given name and start replaying\n";
+	       "savereplay [-stream] [<name>] save the first snapshot and all replay data as a 'replay' (with optional name)\n"
+	       "loadreplay [-goto <begin|end|savetime|<n>>] [-viewonly] [-cache] <name>   load a replay (snapshot and replay data) with given name and start replaying\n"
+	       "build_cache <name>  emulate the replay with given name and store a snapshot cache for it (used by 'loadreplay -cache')\n";
 }
 
 void ReverseManager::ReverseCmd::tabCompletion(std::vector<std::string>& tokens) const
@@ -1009,14 +1324,18 @@ void ReverseManager::ReverseCmd::tabCompletion(std::vector<std::string>& tokens)
 		static constexpr std::array subCommands = {
 			"start"sv, "stop"sv, "status"sv, "goback"sv, "goto"sv,
 			"savereplay"sv, "loadreplay"sv, "viewonlymode"sv,
-			"truncatereplay"sv,
+			"truncatereplay"sv, "build_cache"sv,
 		};
 		completeString(tokens, subCommands);
 	} else if ((tokens.size() == 3) || (tokens[1] == "loadreplay")) {
-		if (tokens[1] == one_of("loadreplay", "savereplay")) {
-			static constexpr std::array cmds = {"-goto"sv, "-viewonly"sv};
+		if (tokens[1] == "build_cache") {
+			completeFileName(tokens, userDataFileContext(REPLAY_DIR));
+		} else if (tokens[1] == one_of("loadreplay", "savereplay")) {
+			static constexpr std::array loadCmds = {"-goto"sv, "-viewonly"sv, "-cache"sv};
+			static constexpr std::array saveCmds = {"-stream"sv};
 			completeFileName(tokens, userDataFileContext(REPLAY_DIR),
-				(tokens[1] == "loadreplay") ? cmds : std::span<const std::string_view>{});
+				(tokens[1] == "loadreplay") ? std::span<const std::string_view>{loadCmds}
+				                            : std::span<const std::string_view>{saveCmds});
 		} else if (tokens[1] == "viewonlymode") {
 			static constexpr std::array options = {"true"sv, "false"sv};
 			completeString(tokens, options);
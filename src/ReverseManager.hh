@@ -5,6 +5,7 @@
 #include "EventListener.hh"
 #include "Command.hh"
 #include "EmuTime.hh"
+#include "ReplayStream.hh"
 
 #include "MemBuffer.hh"
 #include "DeltaBlock.hh"
@@ -16,7 +17,10 @@
 #include <span>
 #include <map>
 #include <memory>
+#include <optional>
+#include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 namespace openmsx {
@@ -25,6 +29,7 @@ class EventDelay;
 class EventDistributor;
 class Interpreter;
 class MSXMotherBoard;
+struct Replay;
 class StateChange;
 class TclObject;
 
@@ -79,6 +84,31 @@ private:
 		std::vector<std::shared_ptr<DeltaBlock>> deltaBlocks;
 		MemBuffer<uint8_t> savestate;
 		size_t size;
+		// Alternatively the savestate can live in a memory mapped
+		// file (see ReplaySnapshotCache), then 'savestate' is empty
+		// and 'mapping' keeps the mapping alive.
+		std::shared_ptr<const void> mapping;
+		const uint8_t* mappedSavestate = nullptr;
+		[[nodiscard]] const uint8_t* getSavestate() const {
+			return mappedSavestate ? mappedSavestate : savestate.data();
+		}
+		// Use these setters (instead of assigning the members above),
+		// a chunk can get reused (e.g. takeSnapshot() during replay)
+		// and then a previous mapping must be dropped.
+		void setSavestate(MemBuffer<uint8_t> buffer, size_t size_) {
+			savestate = std::move(buffer);
+			size = size_;
+			mapping.reset();
+			mappedSavestate = nullptr;
+		}
+		void setMappedSavestate(std::shared_ptr<const void> mapping_,
+		                        std::span<const uint8_t> data) {
+			savestate = MemBuffer<uint8_t>();
+			size = data.size();
+			mapping = std::move(mapping_);
+			mappedSavestate = data.data();
+		}
+		uint64_t captureTime = 0; // host time (in us) to create this snapshot
 
 		// Number of recorded events (or replay index) when this
 		// snapshot was created. So when going back replay should
@@ -106,8 +136,13 @@ private:
 	void goTo(std::span<const TclObject> tokens);
 	void saveReplay(Interpreter& interp,
 	                std::span<const TclObject> tokens, TclObject& result);
+	void saveReplayStream(const std::string& filename);
 	void loadReplay(Interpreter& interp,
 	                std::span<const TclObject> tokens, TclObject& result);
+	void buildCache(std::span<const TclObject> tokens, TclObject& result);
+	ReverseManager& readReplay(const std::string& filename, Replay& replay);
+	void useSnapshotCache(const std::string& replayFilename, ReverseHistory& hist);
+	void buildSnapshotCache(ReverseHistory& hist);
 
 	void signalStopReplay(EmuTime::param time);
 	[[nodiscard]] EmuTime::param getEndTime(const ReverseHistory& history) const;
@@ -117,7 +152,7 @@ private:
 	void transferHistory(ReverseHistory& oldHistory,
 	                     unsigned oldEventCount);
 	void transferState(MSXMotherBoard& newBoard);
-	void takeSnapshot(EmuTime::param time);
+	void takeSnapshot(EmuTime::param time, bool dropOld = true);
 	void schedule(EmuTime::param time);
 	void replayNextEvent();
 	template<unsigned N> void dropOldSnapshots(unsigned count);
@@ -159,6 +194,9 @@ private:
 	} reverseCmd;
 
 	EventDelay* eventDelay = nullptr;
+	// compresses snapshot blocks in the background (declared before
+	// 'history' because that one refers to it)
+	DeltaBlockCompressor compressor;
 	ReverseHistory history;
 	unsigned replayIndex = 0;
 	bool collecting = false;
@@ -166,6 +204,12 @@ private:
 
 	unsigned reRecordCount = 0;
 
+	// State of 'savereplay -stream': what was already written to the file.
+	struct ReplayStream {
+		std::unique_ptr<ReplayStreamWriter> writer;
+		ReplayStreamPosition position;
+	} replayStream;
+
 	friend struct Replay;
 };
 
@@ -1,6 +1,7 @@
 #ifndef SCHEDULABLE_HH
 #define SCHEDULABLE_HH
 
+#include "DeviceProfiler.hh"
 #include "EmuTime.hh"
 #include "serialize.hh"
 #include "serialize_meta.hh"
@@ -100,7 +101,9 @@ protected:
 	[[nodiscard]] bool pendingSyncPoint(EmuTime& result) const;
 
 private:
+	friend class Scheduler;
 	Scheduler& scheduler;
+	DeviceProfiler::Id profileId = DeviceProfiler::INVALID_ID; // assigned on first use
 };
 REGISTER_BASE_CLASS(Schedulable, "Schedulable");
 
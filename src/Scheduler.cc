@@ -7,6 +7,7 @@
 #include "stl.hh"
 #include <cassert>
 #include <iterator> // for back_inserter
+#include <typeinfo>
 
 namespace openmsx {
 
@@ -98,7 +99,11 @@ void Scheduler::scheduleHelper(EmuTime::param limit, EmuTime next)
 
 		queue.remove_front();
 
-		device->executeUntil(next);
+		if (deviceProfiler.isActive()) [[unlikely]] {
+			executeProfiled(*device, next);
+		} else {
+			device->executeUntil(next);
+		}
 
 		next = getNext();
 		if (next > limit) [[likely]] break;
@@ -108,6 +113,16 @@ void Scheduler::scheduleHelper(EmuTime::param limit, EmuTime next)
 	cpu->setNextSyncPoint(next);
 }
 
+void Scheduler::executeProfiled(Schedulable& device, EmuTime::param time)
+{
+	if (device.profileId == DeviceProfiler::INVALID_ID) {
+		device.profileId = deviceProfiler.getId(
+			DeviceProfiler::Category::SYNC_POINT, typeid(device));
+	}
+	DeviceProfiler::Scope scope(deviceProfiler, device.profileId);
+	device.executeUntil(time);
+}
+
 
 template<typename Archive>
 void SynchronizationPoint::serialize(Archive& ar, unsigned /*version*/)
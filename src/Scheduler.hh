@@ -1,6 +1,7 @@
 #ifndef SCHEDULER_HH
 #define SCHEDULER_HH
 
+#include "DeviceProfiler.hh"
 #include "EmuTime.hh"
 #include "SchedulerQueue.hh"
 #include <vector>
@@ -47,6 +48,9 @@ public:
 	 */
 	[[nodiscard]] EmuTime::param getCurrentTime() const;
 
+	/** Host time spent per device, for this machine. */
+	[[nodiscard]] DeviceProfiler& getDeviceProfiler() { return deviceProfiler; }
+
 	/**
 	 * TODO
 	 */
@@ -105,12 +109,14 @@ private: // -> intended for Schedulable
 
 private:
 	void scheduleHelper(EmuTime::param limit, EmuTime next);
+	void executeProfiled(Schedulable& device, EmuTime::param time);
 
 private:
 	/** Vector used as heap, not a priority queue because that
 	  * doesn't allow removal of non-top element.
 	  */
 	SchedulerQueue<SynchronizationPoint> queue;
+	DeviceProfiler deviceProfiler;
 	EmuTime scheduleTime = EmuTime::zero();
 	MSXCPU* cpu = nullptr;
 	bool scheduleInProgress = false;
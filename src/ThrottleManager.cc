@@ -1,4 +1,5 @@
 #include "ThrottleManager.hh"
+#include "Thread.hh"
 
 namespace openmsx {
 
@@ -11,23 +12,31 @@ ThrottleManager::ThrottleManager(CommandController& commandController)
 	, fullSpeedLoadingSetting(
 		commandController, "fullspeedwhenloading",
 		"sets openMSX to full speed when the MSX is loading", false)
+	, turboSetting(
+		commandController, "turbo",
+		"run as fast as possible without rendering video or generating sound",
+		false, Setting::Save::NO)
 {
 	throttleSetting        .attach(*this);
 	fullSpeedLoadingSetting.attach(*this);
+	turboSetting           .attach(*this);
 }
 
 ThrottleManager::~ThrottleManager()
 {
+	turboSetting           .detach(*this);
 	throttleSetting        .detach(*this);
 	fullSpeedLoadingSetting.detach(*this);
 }
 
 void ThrottleManager::updateStatus()
 {
-	bool newThrottle = throttleSetting.getBoolean() &&
+	bool newTurbo = turboSetting.getBoolean();
+	bool newThrottle = !newTurbo && throttleSetting.getBoolean() &&
 	                   (!loading || !fullSpeedLoadingSetting.getBoolean());
-	if (throttle != newThrottle) {
+	if (throttle != newThrottle || turbo != newTurbo) {
 		throttle = newThrottle;
+		turbo = newTurbo;
 		notify();
 	}
 }
@@ -40,7 +49,9 @@ void ThrottleManager::indicateLoadingState(bool state)
 		--loading;
 	}
 	assert(loading >= 0);
-	updateStatus();
+	if (Thread::isRealMainThread()) {
+		updateStatus();
+	}
 }
 
 void ThrottleManager::update(const Setting& /*setting*/) noexcept
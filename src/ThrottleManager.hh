@@ -3,6 +3,7 @@
 
 #include "Subject.hh"
 #include "BooleanSetting.hh"
+#include <atomic>
 
 namespace openmsx {
 
@@ -28,8 +29,23 @@ public:
 	 */
 	[[nodiscard]] bool isThrottled() const { return throttle; }
 
+	/**
+	 * Ask if turbo mode is enabled. In this mode the emulation runs
+	 * unthrottled and without producing any output: the VDPs don't
+	 * render and the sound devices don't synthesize samples. Only the
+	 * state that's visible to the emulated software is kept up-to-date.
+	 */
+	[[nodiscard]] bool isTurbo() const { return turbo; }
+
 	[[nodiscard]] auto& getFullSpeedLoadingSetting() { return fullSpeedLoadingSetting; }
 
+	/**
+	 * Recalculate the throttle state. The loading state of machines in a
+	 * batch run changes on other threads, those don't notify the
+	 * observers, so this must be called afterwards.
+	 */
+	void updateStatus();
+
 private:
 	friend class LoadingIndicator;
 
@@ -42,16 +58,16 @@ private:
 	 */
 	void indicateLoadingState(bool state);
 
-	void updateStatus();
-
 	// Observer<Setting>
 	void update(const Setting& setting) noexcept override;
 
 private:
 	BooleanSetting throttleSetting;
 	BooleanSetting fullSpeedLoadingSetting;
-	int loading = 0;
+	BooleanSetting turboSetting;
+	std::atomic<int> loading = 0;
 	bool throttle = true;
+	bool turbo = false;
 };
 
 /**
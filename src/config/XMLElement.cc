@@ -8,6 +8,7 @@
 #include "XMLException.hh"
 #include "XMLOutputStream.hh"
 #include "rapidsax.hh"
+#include "ranges.hh"
 #include "serialize.hh"
 #include "serialize_meta.hh"
 #include "serialize_stl.hh"
@@ -330,23 +331,37 @@ void XMLDocument::load(const std::string& filename, std::string_view systemID)
 	} catch (FileException& e) {
 		throw XMLException(filename, ": failed to read: ", e.getMessage());
 	}
+	parse(filename, systemID);
+}
+
+void XMLDocument::load(std::string_view name, std::span<const char> data, std::string_view systemID)
+{
+	assert(!root);
 
+	buf.resize(data.size() + rapidsax::EXTRA_BUFFER_SPACE);
+	ranges::copy(data, buf.data());
+	buf[data.size()] = 0;
+	parse(name, systemID);
+}
+
+void XMLDocument::parse(std::string_view name, std::string_view systemID)
+{
 	XMLDocumentHandler handler(*this);
 	try {
 		rapidsax::parse<rapidsax::zeroTerminateStrings>(handler, buf.data());
 	} catch (rapidsax::ParseError& e) {
-		throw XMLException(filename, ": Document parsing failed: ", e.what());
+		throw XMLException(name, ": Document parsing failed: ", e.what());
 	}
 	if (!root) {
-		throw XMLException(filename,
+		throw XMLException(name,
 			": Document doesn't contain mandatory root Element");
 	}
 	if (handler.getSystemID().empty()) {
-		throw XMLException(filename, ": Missing systemID.\n"
+		throw XMLException(name, ": Missing systemID.\n"
 			"You're probably using an old incompatible file format.");
 	}
 	if (handler.getSystemID() != systemID) {
-		throw XMLException(filename, ": systemID doesn't match "
+		throw XMLException(name, ": systemID doesn't match "
 			"(expected ", systemID, ", got ", handler.getSystemID(), ")\n"
 			"You're probably using an old incompatible file format.");
 	}
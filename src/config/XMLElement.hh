@@ -10,6 +10,7 @@
 #include <cstddef>
 #include <iterator>
 //#include <memory_resource>
+#include <span>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -286,6 +287,8 @@ public:
 
 	// Load/parse an xml file. Requires that the document is still empty.
 	void load(const std::string& filename, std::string_view systemID);
+	// Same, but parse from a memory buffer ('name' is used in error messages).
+	void load(std::string_view name, std::span<const char> data, std::string_view systemID);
 
 	[[nodiscard]] const XMLElement* getRoot() const { return root; }
 	void setRoot(XMLElement* root_) { assert(!root); root = root_; }
@@ -319,6 +322,7 @@ public:
 	void serialize(XmlOutputArchive& ar, unsigned version) const;
 
 private:
+	void parse(std::string_view name, std::string_view systemID);
 	XMLElement* loadElement(MemInputArchive& ar);
 	XMLElement* clone(const XMLElement& inElem);
 	XMLElement* clone(const OldXMLElement& elem);
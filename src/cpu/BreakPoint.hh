@@ -17,6 +17,12 @@ public:
 		: BreakPointBase(std::move(command_), std::move(condition_), once_)
 		, id(++lastId)
 		, address(address_) {}
+	/** See BreakPointBase, shares 'compiled_' between breakpoints. */
+	BreakPoint(word address_, TclObject command_, TclObject condition_,
+	           std::shared_ptr<const CompiledCondition> compiled_, bool once_)
+		: BreakPointBase(std::move(command_), std::move(condition_), std::move(compiled_), once_)
+		, id(++lastId)
+		, address(address_) {}
 
 	[[nodiscard]] word getAddress() const { return address; }
 	[[nodiscard]] unsigned getId() const { return id; }
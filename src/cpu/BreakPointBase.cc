@@ -1,16 +1,62 @@
 #include "BreakPointBase.hh"
 #include "CommandException.hh"
 #include "GlobalCliComm.hh"
+#include "MSXCPU.hh"
+#include "MSXCPUInterface.hh"
+#include "MSXMotherBoard.hh"
+#include "Reactor.hh"
 #include "ScopedAssign.hh"
+#include "narrow.hh"
 
 namespace openmsx {
 
-bool BreakPointBase::isTrue(GlobalCliComm& cliComm, Interpreter& interp) const
+namespace {
+
+// Gives CompiledCondition the same view on the machine as the 'CPU regs'
+// and 'memory' debuggables give to the Tcl procs.
+struct MachineAccess
+{
+	MSXMotherBoard& motherBoard;
+
+	[[nodiscard]] unsigned readReg(unsigned index) {
+		return motherBoard.getCPU().peekRegister(index);
+	}
+	[[nodiscard]] unsigned peek(unsigned address) {
+		return motherBoard.getCPUInterface().peekMem(
+			narrow_cast<word>(address), motherBoard.getCurrentTime());
+	}
+	[[nodiscard]] std::pair<int, int> getSelectedSlot(int page) {
+		const auto& cpuInterface = motherBoard.getCPUInterface();
+		int ps = cpuInterface.getPrimarySlot(page);
+		int ss = cpuInterface.isExpanded(ps) ? cpuInterface.getSecondarySlot(page) : -1;
+		return {ps, ss};
+	}
+};
+
+} // namespace
+
+bool BreakPointBase::isFalse(MSXMotherBoard& motherBoard) const
+{
+	if (!compiled) return false;
+	MachineAccess machine{motherBoard};
+	auto result = compiled->evaluate(machine);
+	return result && !*result;
+}
+
+bool BreakPointBase::isTrue(GlobalCliComm& cliComm, Interpreter& interp,
+                            MSXMotherBoard& motherBoard) const
 {
 	if (condition.getString().empty()) {
 		// unconditional bp
 		return true;
 	}
+	if (compiled) {
+		MachineAccess machine{motherBoard};
+		if (auto result = compiled->evaluate(machine)) {
+			return *result;
+		}
+		// else evaluate in Tcl, to get the same error message
+	}
 	try {
 		return condition.evalBool(interp);
 	} catch (CommandException& e) {
@@ -19,14 +65,18 @@ bool BreakPointBase::isTrue(GlobalCliComm& cliComm, Interpreter& interp) const
 	}
 }
 
-bool BreakPointBase::checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp)
+bool BreakPointBase::checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp,
+                                     MSXMotherBoard& motherBoard)
 {
 	if (executing) {
 		// no recursive execution
 		return false;
 	}
 	ScopedAssign sa(executing, true);
-	if (isTrue(cliComm, interp)) {
+	// The Tcl condition and command refer to the machine that triggered
+	// this breakpoint, also when that's not the active machine.
+	Reactor::ScopedCommandBoard scb(motherBoard.getReactor(), motherBoard);
+	if (isTrue(cliComm, interp, motherBoard)) {
 		try {
 			command.executeCommand(interp, true); // compile command
 		} catch (CommandException& e) {
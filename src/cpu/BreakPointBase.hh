@@ -1,13 +1,16 @@
 #ifndef BREAKPOINTBASE_HH
 #define BREAKPOINTBASE_HH
 
+#include "CompiledCondition.hh"
 #include "TclObject.hh"
+#include <memory>
 #include <string_view>
 
 namespace openmsx {
 
 class Interpreter;
 class GlobalCliComm;
+class MSXMotherBoard;
 
 /** Base class for CPU break and watch points.
  */
@@ -20,7 +23,14 @@ public:
 	[[nodiscard]] TclObject getCommandObj()   const { return command; }
 	[[nodiscard]] bool onlyOnce() const { return once; }
 
-	bool checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp);
+	/** Cheap check that doesn't involve the Tcl interpreter. Returns true
+	  * when the condition is compiled (see CompiledCondition) and currently
+	  * false, so that calling checkAndExecute() would have no effect.
+	  */
+	[[nodiscard]] bool isFalse(MSXMotherBoard& motherBoard) const;
+
+	bool checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp,
+	                     MSXMotherBoard& motherBoard);
 
 protected:
 	// Note: we require GlobalCliComm here because breakpoint objects can
@@ -29,14 +39,25 @@ protected:
 	BreakPointBase(TclObject command_, TclObject condition_, bool once_)
 		: command(std::move(command_))
 		, condition(std::move(condition_))
+		, compiled(CompiledCondition::compile(condition.getString()))
+		, once(once_) {}
+	// For many breakpoints with the same condition: 'compiled_' must be
+	// the result of CompiledCondition::compile(condition_).
+	BreakPointBase(TclObject command_, TclObject condition_,
+	               std::shared_ptr<const CompiledCondition> compiled_, bool once_)
+		: command(std::move(command_))
+		, condition(std::move(condition_))
+		, compiled(std::move(compiled_))
 		, once(once_) {}
 
 private:
-	[[nodiscard]] bool isTrue(GlobalCliComm& cliComm, Interpreter& interp) const;
+	[[nodiscard]] bool isTrue(GlobalCliComm& cliComm, Interpreter& interp,
+	                          MSXMotherBoard& motherBoard) const;
 
 private:
 	TclObject command;
 	TclObject condition;
+	std::shared_ptr<const CompiledCondition> compiled; // can be nullptr
 	bool once;
 	bool executing = false;
 };
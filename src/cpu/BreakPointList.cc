@@ -0,0 +1,84 @@
+#include "BreakPointList.hh"
+
+#include "ranges.hh"
+#include "stl.hh"
+
+#include <algorithm>
+#include <iterator>
+
+namespace openmsx {
+
+BreakPointList::Range BreakPointList::find(word address) const
+{
+	if (!addresses[address]) return {breakPoints.cend(), breakPoints.cend()};
+	return ranges::equal_range(breakPoints, address, {}, &BreakPoint::getAddress);
+}
+
+void BreakPointList::insert(BreakPoint bp)
+{
+	addresses[bp.getAddress()] = true;
+	auto it = ranges::upper_bound(breakPoints, bp.getAddress(), {}, &BreakPoint::getAddress);
+	breakPoints.insert(it, std::move(bp));
+}
+
+void BreakPointList::insert(std::vector<BreakPoint> bps)
+{
+	for (const auto& bp : bps) {
+		addresses[bp.getAddress()] = true;
+	}
+	// Same order as inserting one by one: new breakpoints go after the
+	// existing ones with the same address.
+	ranges::stable_sort(bps, {}, &BreakPoint::getAddress);
+	auto middle = breakPoints.size();
+	breakPoints.insert(breakPoints.end(),
+	                   std::move_iterator(bps.begin()), std::move_iterator(bps.end()));
+	std::inplace_merge(breakPoints.begin(), breakPoints.begin() + middle, breakPoints.end(),
+	                   [](const BreakPoint& x, const BreakPoint& y) {
+	                           return x.getAddress() < y.getAddress(); });
+}
+
+void BreakPointList::remove(const BreakPoint& bp)
+{
+	auto address = bp.getAddress();
+	auto [first, last] = ranges::equal_range(breakPoints, address, {}, &BreakPoint::getAddress);
+	breakPoints.erase(find_unguarded(first, last, &bp,
+	                                 [](const BreakPoint& i) { return &i; }));
+	updateAddress(address);
+}
+
+bool BreakPointList::remove(unsigned id)
+{
+	auto it = ranges::find(breakPoints, id, &BreakPoint::getId);
+	if (it == breakPoints.end()) return false;
+	auto address = it->getAddress();
+	breakPoints.erase(it);
+	updateAddress(address);
+	return true;
+}
+
+void BreakPointList::remove(std::span<const unsigned> ids)
+{
+	std::vector<unsigned> sortedIds(ids.begin(), ids.end());
+	ranges::sort(sortedIds);
+	std::erase_if(breakPoints, [&](const BreakPoint& bp) {
+		return ranges::binary_search(sortedIds, bp.getId());
+	});
+	addresses.reset();
+	for (const auto& bp : breakPoints) {
+		addresses[bp.getAddress()] = true;
+	}
+}
+
+void BreakPointList::clear()
+{
+	breakPoints.clear();
+	addresses.reset();
+}
+
+void BreakPointList::updateAddress(word address)
+{
+	addresses[address] =
+		std::ranges::binary_search(breakPoints, address, {}, &BreakPoint::getAddress);
+}
+
+} // namespace openmsx
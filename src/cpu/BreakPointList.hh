@@ -0,0 +1,60 @@
+#ifndef BREAKPOINTLIST_HH
+#define BREAKPOINTLIST_HH
+
+#include "BreakPoint.hh"
+
+#include <bitset>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace openmsx {
+
+/** The CPU breakpoints, sorted on address, plus a bitmap of the addresses
+  * that have at least one breakpoint.
+  *
+  * The bitmap makes the check after each instruction cheap: only when the
+  * bit for the current PC is set, the breakpoints on that address are
+  * searched. Note that CPUCore still has to use its (slower) one
+  * instruction at a time loop while there are any breakpoints at all,
+  * this only speeds up the check itself.
+  *
+  * Breakpoints on the same address stay in insertion order.
+  */
+class BreakPointList
+{
+public:
+	using BreakPoints = std::vector<BreakPoint>;
+	using Range = std::pair<BreakPoints::const_iterator, BreakPoints::const_iterator>;
+
+	[[nodiscard]] const BreakPoints& getBreakPoints() const { return breakPoints; }
+	[[nodiscard]] bool empty() const { return breakPoints.empty(); }
+
+	[[nodiscard]] bool hasAddress(word address) const { return addresses[address]; }
+	[[nodiscard]] Range find(word address) const;
+
+	void insert(BreakPoint bp);
+	/** Same result as inserting them one by one (in the given order), but
+	  * only one merge instead of one vector insert per breakpoint. */
+	void insert(std::vector<BreakPoint> bps);
+
+	/** Remove the given breakpoint object (must be in this list). */
+	void remove(const BreakPoint& bp);
+	/** @return false when there is no breakpoint with this id. */
+	bool remove(unsigned id);
+	/** Ids that are not in the list are ignored. */
+	void remove(std::span<const unsigned> ids);
+
+	void clear();
+
+private:
+	void updateAddress(word address);
+
+private:
+	BreakPoints breakPoints; // sorted on address
+	std::bitset<0x10000> addresses; // is there a bp on this address?
+};
+
+} // namespace openmsx
+
+#endif
@@ -4,6 +4,7 @@
 #include "DynamicClock.hh"
 #include "Scheduler.hh"
 #include "narrow.hh"
+#include <algorithm>
 #include <cassert>
 
 namespace openmsx {
@@ -114,6 +115,25 @@ protected:
 		return remaining < 0;
 	}
 
+	/** Used to skip idle loops (see CPUCore::checkIdleLoop()). The
+	  * difference between two calls of getRemaining() is the number of
+	  * ticks that were added in between. Only meaningful when the limit
+	  * is enabled and didn't change in between.
+	  */
+	[[nodiscard]] int getRemaining() const { return remaining; }
+
+	/** Skip as many iterations of 'ticks' cycles as possible without
+	  * reaching the limit, but at most 'maxIterations'. Returns the
+	  * number of skipped iterations.
+	  */
+	unsigned skipIterations(unsigned ticks, unsigned maxIterations) {
+		assert(ticks > 0);
+		if (remaining < 0) return 0; // limit disabled or already reached
+		unsigned n = std::min(unsigned(remaining) / ticks, maxIterations);
+		remaining -= narrow_cast<int>(n * ticks);
+		return n;
+	}
+
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
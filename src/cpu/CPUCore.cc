@@ -160,6 +160,10 @@
 
 #include "CPUCore.hh"
 
+#include "CPUProfiler.hh"
+#include "IdleLoop.hh"
+#include "InstructionTrace.hh"
+#include "MSXCPU.hh"
 #include "MSXCPUInterface.hh"
 #include "Scheduler.hh"
 #include "MSXMotherBoard.hh"
@@ -176,6 +180,7 @@
 #include "unreachable.hh"
 #include "xrange.hh"
 
+#include <algorithm>
 #include <array>
 #include <bit>
 #include <cassert>
@@ -281,6 +286,9 @@ static constexpr Table table = initTables();
 // the (logical) lifetime of this variable cannot overlap between execution
 // of two MSX machines.
 static word start_pc;
+static uint64_t start_time; // for the profiler and the instruction trace
+static std::array<byte, 4> start_opcode; // for the instruction trace
+static unsigned start_opcode_len;
 
 // conditions
 struct CondC  { bool operator()(byte f) const { return  (f & C_FLAG) != 0; } };
@@ -295,13 +303,16 @@ struct CondTrue { bool operator()(byte /*f*/) const { return true; } };
 
 template<typename T> CPUCore<T>::CPUCore(
 		MSXMotherBoard& motherboard_, const std::string& name,
-		const BooleanSetting& traceSetting_,
+		const BooleanSetting& traceSetting_, CPUProfiler& profiler_,
+		InstructionTrace& instructionTrace_,
 		TclCallback& diHaltCallback_, EmuTime::param time)
 	: CPURegs(T::IS_R800)
 	, T(time, motherboard_.getScheduler())
 	, motherboard(motherboard_)
 	, scheduler(motherboard.getScheduler())
 	, traceSetting(traceSetting_)
+	, profiler(profiler_)
+	, instructionTrace(instructionTrace_)
 	, diHaltCallback(diHaltCallback_)
 	, IRQStatus(motherboard.getDebugger(), name + ".pendingIRQ",
 	            "Non-zero if there are pending IRQs (thus CPU would enter "
@@ -820,10 +831,78 @@ template<typename T> inline void CPUCore<T>::irq2()
 	T::add(T::CC_IRQ2);
 }
 
+// Idle loop detection
+//
+// A lot of MSX software waits in a tight loop till some memory location
+// changes, typically a variable that gets updated by the interrupt routine:
+//    loop: ld a,(nn) ; or a ; jr z,loop
+// or it simply waits in a 'jr $' loop for the next interrupt. Such a loop
+// only reads from (cacheable) memory, so its outcome can't change before the
+// next sync point: interrupts and device updates only happen at sync points,
+// and until then only the CPU itself can write to memory. So instead of
+// executing all iterations one by one, we directly advance the time by a
+// whole number of iterations, similar to what is done for the HALT
+// instruction. The timing and the R register remain exact, so this is not
+// noticeable by the MSX program.
+//
+// The duration of one iteration is measured: the loop body is straight line
+// code, so between two consecutive times the backwards jump is taken exactly
+// one iteration was executed. A 'djnz' loop (e.g. 'djnz $') is handled the
+// same way, except that each skipped iteration also decrements B, and the
+// last iteration (where B becomes zero) is always executed normally.
+//
+// The loop body is checked by analyzeIdleLoop() (see IdleLoop.hh).
+//
+// This is only done for the Z80. The R800 inserts refresh cycles at regular
+// time intervals, so there not all iterations take equally long.
+template<typename T>
+ALWAYS_INLINE unsigned CPUCore<T>::checkIdleLoop(
+	unsigned begin, unsigned branchPC, unsigned branchLen, unsigned maxIterations)
+{
+	if (idleLoop.branchPC != int(branchPC)) {
+		idleLoop.branchPC = int(branchPC);
+		idleLoop.remaining = T::getRemaining();
+		idleLoop.status = IdleLoop::Status::UNCHECKED;
+		return 0;
+	} else if (idleLoop.status != IdleLoop::Status::REJECTED) {
+		return skipIdleLoop(begin, branchPC, branchLen, maxIterations);
+	}
+	return 0;
+}
+
+template<typename T>
+NEVER_INLINE unsigned CPUCore<T>::skipIdleLoop(
+	unsigned begin, unsigned branchPC, unsigned branchLen, unsigned maxIterations)
+{
+	if (idleLoop.status == IdleLoop::Status::UNCHECKED) {
+		idleLoop.rIncrement = analyzeIdleLoop(
+			begin, branchPC, branchLen, getHL(),
+			[&](unsigned addr) {
+				return uintptr_t(readCacheLine[addr >> CacheLine::BITS]) > 1;
+			},
+			[&](unsigned addr) {
+				return readCacheLine[addr >> CacheLine::BITS][addr];
+			});
+		if (idleLoop.rIncrement == 0) {
+			idleLoop.status = IdleLoop::Status::REJECTED;
+			return 0;
+		}
+		idleLoop.status = IdleLoop::Status::ACCEPTED;
+	}
+	unsigned n = 0;
+	if (int ticks = idleLoop.remaining - T::getRemaining(); ticks > 0) {
+		n = T::skipIterations(unsigned(ticks), maxIterations);
+		incR(narrow_cast<byte>(n * idleLoop.rIncrement));
+	}
+	idleLoop.remaining = T::getRemaining();
+	return n;
+}
+
 template<typename T>
 void CPUCore<T>::executeInstructions()
 {
 	checkNoCurrentFlags();
+	idleLoop.branchPC = -1; // there may have been an IRQ since the last call
 #ifdef USE_COMPUTED_GOTO
 	// Addresses of all main-opcode routines,
 	// Note that 40/49/53/5B/64/6D/7F is replaced by 00 (ld r,r == nop)
@@ -2433,18 +2512,66 @@ xx_cb: {
 	}
 }
 
+// Is any debug feature active that needs a callback after each instruction?
+template<typename T> inline bool CPUCore<T>::anyInstructionHooks() const
+{
+	return tracingEnabled || profiler.isActive() || instructionTrace.isActive() ||
+	       interface->getAccessStats().isActive();
+}
 template<typename T> inline void CPUCore<T>::cpuTracePre()
 {
 	start_pc = getPC();
+	start_time = (T::getTimeFast() - EmuTime::zero()).length();
+	if (instructionTrace.isActive()) [[unlikely]] {
+		cpuTracePre_slow();
+	}
+}
+template<typename T> void CPUCore<T>::cpuTracePre_slow()
+{
+	// Fetch the opcode before executing it: the instruction itself could
+	// e.g. switch slots.
+	unsigned address = getPC();
+	const byte* line = readCacheLine[address >> CacheLine::BITS];
+	if ((uintptr_t(line) > 1) && ((address & CacheLine::LOW) <= (CacheLine::SIZE - 4))) [[likely]] {
+		std::copy_n(&line[address], 4, start_opcode.begin());
+		start_opcode_len = *instructionLength(start_opcode);
+	} else {
+		start_opcode_len = narrow<unsigned>(
+			fetchInstruction(*interface, word(address), start_opcode, T::getTimeFast()).size());
+	}
 }
 template<typename T> inline void CPUCore<T>::cpuTracePost()
 {
-	if (tracingEnabled) [[unlikely]] {
+	if (anyInstructionHooks()) [[unlikely]] {
 		cpuTracePost_slow();
 	}
 }
 template<typename T> void CPUCore<T>::cpuTracePost_slow()
 {
+	if (!interface->isFastForward()) {
+		if (profiler.isActive()) {
+			// We execute one instruction at a time, so the elapsed
+			// CPU time are the cycles of this instruction, including
+			// the time it was stalled in wait() (e.g. for I/O).
+			auto now = (T::getTimeFast() - EmuTime::zero()).length();
+			auto ticks = EmuDuration(now - start_time).getTicksAt(T::getFreq());
+			motherboard.getCPU().recordProfile(start_pc, ticks);
+		}
+		if (instructionTrace.isActive()) {
+			InstructionTrace::Regs regs = {
+				getAF(), getBC(), getDE(), getHL(), getIX(), getIY(), getSP(),
+				getAF2(), getBC2(), getDE2(), getHL2(),
+				word((getI() << 8) | (getIM() << 2) | (getIFF2() << 1) | getIFF1()),
+			};
+			instructionTrace.record(start_pc, std::span{start_opcode}.first(start_opcode_len),
+			                        regs, start_time);
+		}
+		if (interface->getAccessStats().isActive()) {
+			interface->countExecute(start_pc);
+		}
+	}
+	if (!tracingEnabled) return;
+
 	std::array<byte, 4> opBuf;
 	std::string dasmOutput;
 	dasm(*interface, start_pc, opBuf, dasmOutput, T::getTimeFast());
@@ -2544,11 +2671,35 @@ template<typename T> void CPUCore<T>::execute(bool fastForward)
 	assert(fastForward || !interface->isBreaked());
 	if (fastForward) {
 		interface->setFastForward(true);
+		if (anyInstructionHooks()) [[unlikely]] {
+			warnSkippedInstructions();
+		}
 	}
 	execute2(fastForward);
 	interface->setFastForward(false);
 }
 
+// The per-instruction debug features don't see the instructions that are
+// executed in fast-forward mode (e.g. reverse goto, batch_run).
+template<typename T> void CPUCore<T>::warnSkippedInstructions()
+{
+	if (profiler.needFastForwardWarning()) {
+		motherboard.getMSXCliComm().printWarning(
+			"The CPU profile doesn't include the instructions that are "
+			"executed in fast-forward mode (e.g. reverse goto, batch_run).");
+	}
+	if (instructionTrace.needFastForwardWarning()) {
+		motherboard.getMSXCliComm().printWarning(
+			"The instruction trace doesn't include the instructions that "
+			"are executed in fast-forward mode (e.g. reverse goto, batch_run).");
+	}
+	if (interface->needAccessStatsFastForwardWarning()) {
+		motherboard.getMSXCliComm().printWarning(
+			"The memory access statistics don't include the accesses in "
+			"fast-forward mode (e.g. reverse goto, batch_run).");
+	}
+}
+
 template<typename T> void CPUCore<T>::execute2(bool fastForward)
 {
 	// note: Don't use getTimeFast() here, because 'once in a while' we
@@ -2562,8 +2713,8 @@ template<typename T> void CPUCore<T>::execute2(bool fastForward)
 	// deciding between executeFast() and executeSlow() (because a
 	// SyncPoint could set an IRQ and then we must choose executeSlow())
 	if (fastForward ||
-	    (!interface->anyBreakPoints() && !tracingEnabled)) {
-		// fast path, no breakpoints, no tracing
+	    (!interface->anyBreakPoints() && !anyInstructionHooks())) {
+		// fast path, no breakpoints, no tracing, no profiling
 		do {
 			if (slowInstructions) {
 				--slowInstructions;
@@ -3928,6 +4079,9 @@ template<typename T> template<typename COND> II CPUCore<T>::jp(COND cond) {
 	word addr = RD_WORD_PC<1>(T::CC_JP_1);
 	T::setMemPtr(addr);
 	if (cond(getF())) {
+		if constexpr (!T::IS_R800) {
+			if (addr <= getPC()) checkIdleLoop(addr, getPC(), 3);
+		}
 		setPC(addr);
 		T::R800ForcePageBreak();
 		return {0/*3*/, T::CC_JP_A};
@@ -3970,7 +4124,11 @@ template<typename T> template<typename COND> II CPUCore<T>::jr(COND cond) {
 			// See doc/r800-djnz.txt for more details.
 			T::R800ForcePageBreak();
 		}
-		setPC(narrow_cast<word>(getPC() + 2 + ofst));
+		auto addr = narrow_cast<word>(getPC() + 2 + ofst);
+		if constexpr (!T::IS_R800) {
+			if (addr <= getPC()) checkIdleLoop(addr, getPC(), 2);
+		}
+		setPC(addr);
 		T::setMemPtr(getPC());
 		return {0/*2*/, T::CC_JR_A};
 	} else {
@@ -3988,7 +4146,14 @@ template<typename T> II CPUCore<T>::djnz() {
 			// See comment in jr()
 			T::R800ForcePageBreak();
 		}
-		setPC(narrow_cast<word>(getPC() + 2 + ofst));
+		auto addr = narrow_cast<word>(getPC() + 2 + ofst);
+		if constexpr (!T::IS_R800) {
+			if (addr <= getPC()) {
+				b -= narrow_cast<byte>(checkIdleLoop(addr, getPC(), 2, b - 1));
+				setB(b);
+			}
+		}
+		setPC(addr);
 		T::setMemPtr(getPC());
 		return {0/*2*/, T::CC_JR_A + T::EE_DJNZ};
 	} else {
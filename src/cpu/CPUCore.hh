@@ -12,11 +12,14 @@
 
 #include <array>
 #include <atomic>
+#include <cstdint>
 #include <span>
 #include <string>
 
 namespace openmsx {
 
+class CPUProfiler;
+class InstructionTrace;
 class MSXCPUInterface;
 class Scheduler;
 class MSXMotherBoard;
@@ -55,7 +58,8 @@ class CPUCore final : public CPUBase, public CPURegs, public CPU_POLICY
 {
 public:
 	CPUCore(MSXMotherBoard& motherboard, const std::string& name,
-	        const BooleanSetting& traceSetting,
+	        const BooleanSetting& traceSetting, CPUProfiler& profiler,
+	        InstructionTrace& instructionTrace,
 	        TclCallback& diHaltCallback, EmuTime::param time);
 
 	void setInterface(MSXCPUInterface* interface_) { interface = interface_; }
@@ -143,6 +147,8 @@ private:
 	MSXCPUInterface* interface = nullptr;
 
 	const BooleanSetting& traceSetting;
+	CPUProfiler& profiler;
+	InstructionTrace& instructionTrace;
 	TclCallback& diHaltCallback;
 
 	Probe<int> IRQStatus;
@@ -169,13 +175,25 @@ private:
 	/** In sync with traceSetting.getBoolean(). */
 	bool tracingEnabled;
 
+	/** State of the idle loop detection, see checkIdleLoop(). */
+	struct IdleLoop {
+		enum class Status : uint8_t { UNCHECKED, REJECTED, ACCEPTED };
+		int branchPC = -1; // address of the last taken backwards jump
+		int remaining = 0; // CPUClock::getRemaining() at that jump
+		Status status = Status::UNCHECKED;
+		byte rIncrement = 0; // R register increment per iteration
+	} idleLoop;
+
 	/** An NMOS Z80 and a CMOS Z80 behave slightly differently */
 	const bool isCMOS;
 
 private:
+	[[nodiscard]] inline bool anyInstructionHooks() const;
 	inline void cpuTracePre();
+	void cpuTracePre_slow();
 	inline void cpuTracePost();
 	void cpuTracePost_slow();
+	void warnSkippedInstructions();
 
 	inline byte READ_PORT(word port, unsigned cc);
 	inline void WRITE_PORT(word port, byte value, unsigned cc);
@@ -219,6 +237,10 @@ private:
 	inline void WR_WORD_rev (unsigned address, word value, unsigned cc);
 
 	void executeInstructions();
+	inline unsigned checkIdleLoop(unsigned begin, unsigned branchPC, unsigned branchLen,
+	                              unsigned maxIterations = unsigned(-1));
+	unsigned skipIdleLoop(unsigned begin, unsigned branchPC, unsigned branchLen,
+	                      unsigned maxIterations);
 	inline void nmi();
 	inline void irq0();
 	inline void irq1();
@@ -0,0 +1,109 @@
+#include "CPUProfiler.hh"
+
+#include "SymbolManager.hh"
+
+#include "ranges.hh"
+#include "xrange.hh"
+
+#include <cstdint>
+#include <tuple>
+
+namespace openmsx {
+
+void CPUProfiler::reset()
+{
+	pages.clear();
+	lastKey = uint32_t(-1);
+	lastPage = nullptr;
+}
+
+CPUProfiler::Page& CPUProfiler::getPage(uint32_t key)
+{
+	auto& page = pages[key];
+	if (!page) page = std::make_unique<Page>();
+	return *page;
+}
+
+std::vector<CPUProfiler::Entry> CPUProfiler::getEntries() const
+{
+	std::vector<Entry> result;
+	for (const auto& [key, page] : pages) {
+		auto slot    = uint8_t (key >> 24);
+		auto segment = uint16_t(key >> 8);
+		auto base    = uint16_t(key << 8);
+		for (auto i : xrange(uint16_t(256))) {
+			const auto& c = (*page)[i];
+			if (c.count) {
+				result.push_back(Entry{slot, segment, uint16_t(base + i), c});
+			}
+		}
+	}
+	ranges::sort(result, {}, [](const Entry& e) {
+		return std::tuple(e.slot, e.segment, e.address);
+	});
+	return result;
+}
+
+std::vector<CPUProfiler::ReportLine> CPUProfiler::getReport(std::span<const SymbolFile> files) const
+{
+	// Group the symbols on (slot, segment), where -1 means not specified
+	// in the symbol file, and sort on value within each group. Then each
+	// lookup is a binary search in (at most) 4 groups.
+	struct SortedSymbol {
+		int slot;
+		int segment;
+		uint16_t value;
+		size_t order; // on equal value, the later symbol wins
+		const Symbol* symbol;
+	};
+	auto sortKey = [](const SortedSymbol& s) { return std::tuple(s.slot, s.segment, s.value, s.order); };
+	std::vector<SortedSymbol> symbols;
+	for (const auto& file : files) {
+		for (const auto& sym : file.symbols) {
+			symbols.push_back(SortedSymbol{
+				sym.slot ? int(*sym.slot) : -1, sym.segment ? int(*sym.segment) : -1,
+				sym.value, symbols.size(), &sym});
+		}
+	}
+	ranges::sort(symbols, {}, sortKey);
+
+	auto findSymbol = [&](const Entry& e) -> const Symbol* {
+		const SortedSymbol* best = nullptr;
+		for (int slot : {-1, int(e.slot)}) {
+			for (int segment : {-1, int(e.segment)}) {
+				// last symbol in this group with value <= address
+				auto it = ranges::upper_bound(symbols, std::tuple(slot, segment, e.address, SIZE_MAX), {}, sortKey);
+				if (it == symbols.begin()) continue;
+				--it;
+				if ((it->slot != slot) || (it->segment != segment)) continue;
+				if (!best || (std::tuple(it->value, it->order) > std::tuple(best->value, best->order))) {
+					best = &*it;
+				}
+			}
+		}
+		return best ? best->symbol : nullptr;
+	};
+
+	// Addresses without a symbol are grouped per page of 256 bytes.
+	std::vector<ReportLine> result;
+	hash_map<const Symbol*, size_t> symbolLines;
+	hash_map<uint32_t, size_t> unknownLines;
+	auto getLine = [&](auto& map, const auto& key, const ReportLine& newLine) -> ReportLine& {
+		auto [it, inserted] = map.try_emplace(key, result.size());
+		if (inserted) result.push_back(newLine);
+		return result[it->second];
+	};
+	for (const auto& e : getEntries()) {
+		const auto* sym = findSymbol(e);
+		auto& line = sym
+			? getLine(symbolLines, sym, ReportLine{sym->name, sym->value, {}})
+			: getLine(unknownLines, (uint32_t(e.slot) << 24) | (uint32_t(e.segment) << 8) | (e.address >> 8),
+			          ReportLine{{}, e.address, {}});
+		line.counter.count += e.counter.count;
+		line.counter.ticks += e.counter.ticks;
+	}
+	ranges::stable_sort(result, std::greater<>{}, [](const ReportLine& l) { return l.counter.ticks; });
+	return result;
+}
+
+} // namespace openmsx
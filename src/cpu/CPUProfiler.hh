@@ -0,0 +1,99 @@
+#ifndef CPUPROFILER_HH
+#define CPUPROFILER_HH
+
+#include "hash_map.hh"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace openmsx {
+
+struct SymbolFile;
+
+/** Code coverage and execution profile of the emulated CPU.
+  *
+  * While active, CPUCore reports every executed instruction (see
+  * MSXCPU::recordProfile()). For that it has to execute one instruction at
+  * a time, which makes the emulation a lot slower. Instructions executed
+  * in fast-forward mode (reverse goto, batch_run) are not recorded. For each (slot, segment, address) this counts
+  * the number of executed instructions and the number of CPU cycles spent
+  * in those instructions.
+  *
+  * The counters are stored in pages of 256 addresses, which are only
+  * allocated once an instruction in that page (in that slot and segment)
+  * is executed. Consecutive instructions are typically in the same page,
+  * so recording an instruction is usually only a compare and two additions.
+  */
+class CPUProfiler
+{
+public:
+	static constexpr uint16_t NO_SEGMENT = 0xFFFF;
+
+	struct Counter {
+		uint64_t count = 0; // number of executed instructions
+		uint64_t ticks = 0; // number of CPU cycles
+	};
+	struct Entry {
+		uint8_t slot;     // primary + 4 * secondary (like in 'Symbol')
+		uint16_t segment; // or NO_SEGMENT
+		uint16_t address;
+		Counter counter;
+	};
+	struct ReportLine {
+		std::string_view name; // symbol name, or empty when no symbol found
+		uint16_t address;      // symbol value, or lowest executed address
+		Counter counter;
+	};
+
+	void setActive(bool active_) { active = active_; warnedFastForward = false; }
+	[[nodiscard]] bool isActive() const { return active; }
+	/** Instructions executed in fast-forward mode are not recorded. This
+	  * returns true (once per activation) when that happens, so that the
+	  * user can be warned. */
+	[[nodiscard]] bool needFastForwardWarning() {
+		return active && !std::exchange(warnedFastForward, true);
+	}
+	void reset();
+
+	void record(uint8_t slot, uint16_t segment, uint16_t address, unsigned ticks) {
+		auto key = (uint32_t(slot) << 24) | (uint32_t(segment) << 8) | (address >> 8);
+		if (key != lastKey) [[unlikely]] {
+			lastPage = &getPage(key);
+			lastKey = key;
+		}
+		auto& c = (*lastPage)[address & 0xFF];
+		c.count += 1;
+		c.ticks += ticks;
+	}
+
+	/** All addresses with a non-zero count, sorted on (slot, segment, address). */
+	[[nodiscard]] std::vector<Entry> getEntries() const;
+
+	/** Accumulate the counters per routine. Each address is attributed to
+	  * the symbol with the highest value not above the address (only
+	  * considering symbols with a matching slot and segment, when those
+	  * are specified in the symbol file).
+	  * @result sorted on descending number of cycles.
+	  */
+	[[nodiscard]] std::vector<ReportLine> getReport(std::span<const SymbolFile> files) const;
+
+private:
+	using Page = std::array<Counter, 256>;
+	Page& getPage(uint32_t key);
+
+private:
+	hash_map<uint32_t, std::unique_ptr<Page>> pages;
+	uint32_t lastKey = uint32_t(-1); // slot < 16, so never a valid key
+	Page* lastPage = nullptr;
+	bool active = false;
+	bool warnedFastForward = false;
+};
+
+} // namespace openmsx
+
+#endif
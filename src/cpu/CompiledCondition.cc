@@ -0,0 +1,286 @@
+#include "CompiledCondition.hh"
+
+#include "StringOp.hh"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <limits>
+
+namespace openmsx {
+
+namespace {
+
+struct Unsupported {};
+
+using Op = CompiledCondition::Op;
+using Node = CompiledCondition::Node;
+
+// Same names and indices as the 'reg' proc in _cpuregs.tcl (which reads
+// them from the 'CPU regs' debuggable).
+struct RegInfo {
+	std::string_view name;
+	uint8_t index;
+	bool word;
+};
+constexpr std::array regInfos = {
+	RegInfo{"A",    0, false}, RegInfo{"F",    1, false}, RegInfo{"B",    2, false}, RegInfo{"C",    3, false},
+	RegInfo{"D",    4, false}, RegInfo{"E",    5, false}, RegInfo{"H",    6, false}, RegInfo{"L",    7, false},
+	RegInfo{"A2",   8, false}, RegInfo{"F2",   9, false}, RegInfo{"B2",  10, false}, RegInfo{"C2",  11, false},
+	RegInfo{"D2",  12, false}, RegInfo{"E2",  13, false}, RegInfo{"H2",  14, false}, RegInfo{"L2",  15, false},
+	RegInfo{"IXH", 16, false}, RegInfo{"IXL", 17, false}, RegInfo{"IYH", 18, false}, RegInfo{"IYL", 19, false},
+	RegInfo{"PCH", 20, false}, RegInfo{"PCL", 21, false}, RegInfo{"SPH", 22, false}, RegInfo{"SPL", 23, false},
+	RegInfo{"I",   24, false}, RegInfo{"R",   25, false}, RegInfo{"IM",  26, false}, RegInfo{"IFF", 27, false},
+	RegInfo{"AF",   0, true }, RegInfo{"BC",   2, true }, RegInfo{"DE",   4, true }, RegInfo{"HL",   6, true },
+	RegInfo{"AF2",  8, true }, RegInfo{"BC2", 10, true }, RegInfo{"DE2", 12, true }, RegInfo{"HL2", 14, true },
+	RegInfo{"IX",  16, true }, RegInfo{"IY",  18, true }, RegInfo{"PC",  20, true }, RegInfo{"SP",  22, true },
+};
+
+// Recursive descent parser for (the supported subset of) Tcl expressions.
+class Parser
+{
+public:
+	explicit Parser(std::string_view str_) : str(str_) {}
+
+	std::vector<Node> parse() {
+		parseExpr();
+		skipSpace();
+		if (pos != str.size()) throw Unsupported();
+		return std::move(nodes);
+	}
+
+private:
+	unsigned add(Node node) {
+		if (nodes.size() >= std::numeric_limits<uint16_t>::max()) throw Unsupported();
+		nodes.push_back(node);
+		return unsigned(nodes.size() - 1);
+	}
+	unsigned add(Op op, unsigned lhs, unsigned rhs = 0) {
+		return add(Node{op, uint16_t(lhs), uint16_t(rhs), 0});
+	}
+
+	void skipSpace() {
+		while ((pos < str.size()) && isspace(static_cast<unsigned char>(str[pos]))) ++pos;
+	}
+	[[nodiscard]] char peekChar() const {
+		return (pos < str.size()) ? str[pos] : '\0';
+	}
+	// Check for (and consume) the given operator. Don't match a prefix of a
+	// longer operator (e.g. '<' in '<<', '&' in '&&').
+	bool accept(std::string_view op, std::string_view notFollowedBy = {}) {
+		skipSpace();
+		if (!str.substr(pos).starts_with(op)) return false;
+		auto next = pos + op.size();
+		if ((next < str.size()) && (notFollowedBy.find(str[next]) != std::string_view::npos)) {
+			return false;
+		}
+		pos = next;
+		return true;
+	}
+
+	// Binary operators, from lowest to highest precedence.
+	unsigned parseExpr() {
+		auto lhs = parseAnd();
+		while (accept("||")) lhs = add(Op::OR, lhs, parseAnd());
+		return lhs;
+	}
+	unsigned parseAnd() {
+		auto lhs = parseBitOr();
+		while (accept("&&")) lhs = add(Op::AND, lhs, parseBitOr());
+		return lhs;
+	}
+	unsigned parseBitOr() {
+		auto lhs = parseBitXor();
+		while (accept("|", "|")) lhs = add(Op::BIT_OR, lhs, parseBitXor());
+		return lhs;
+	}
+	unsigned parseBitXor() {
+		auto lhs = parseBitAnd();
+		while (accept("^")) lhs = add(Op::BIT_XOR, lhs, parseBitAnd());
+		return lhs;
+	}
+	unsigned parseBitAnd() {
+		auto lhs = parseEquality();
+		while (accept("&", "&")) lhs = add(Op::BIT_AND, lhs, parseEquality());
+		return lhs;
+	}
+	unsigned parseEquality() {
+		auto lhs = parseRelational();
+		while (true) {
+			if      (accept("==")) lhs = add(Op::EQ, lhs, parseRelational());
+			else if (accept("!=")) lhs = add(Op::NE, lhs, parseRelational());
+			else return lhs;
+		}
+	}
+	unsigned parseRelational() {
+		auto lhs = parseShift();
+		while (true) {
+			if      (accept("<=")) lhs = add(Op::LE, lhs, parseShift());
+			else if (accept(">=")) lhs = add(Op::GE, lhs, parseShift());
+			else if (accept("<", "<")) lhs = add(Op::LT, lhs, parseShift());
+			else if (accept(">", ">")) lhs = add(Op::GT, lhs, parseShift());
+			else return lhs;
+		}
+	}
+	unsigned parseShift() {
+		auto lhs = parseAdditive();
+		while (true) {
+			if      (accept("<<")) lhs = add(Op::SHL, lhs, parseAdditive());
+			else if (accept(">>")) lhs = add(Op::SHR, lhs, parseAdditive());
+			else return lhs;
+		}
+	}
+	unsigned parseAdditive() {
+		auto lhs = parseMultiplicative();
+		while (true) {
+			if      (accept("+")) lhs = add(Op::ADD, lhs, parseMultiplicative());
+			else if (accept("-")) lhs = add(Op::SUB, lhs, parseMultiplicative());
+			else return lhs;
+		}
+	}
+	unsigned parseMultiplicative() {
+		auto lhs = parseUnary();
+		while (true) {
+			// '/' and '%' round differently in Tcl and c++, '**' is not supported
+			if (accept("*", "*")) lhs = add(Op::MUL, lhs, parseUnary());
+			else if (accept("/") || accept("%") || accept("**")) throw Unsupported();
+			else return lhs;
+		}
+	}
+	unsigned parseUnary() {
+		if (accept("-")) return add(Op::NEG, parseUnary());
+		if (accept("+")) return parseUnary();
+		if (accept("~")) return add(Op::BIT_NOT, parseUnary());
+		if (accept("!", "=")) return add(Op::NOT, parseUnary());
+		return parsePrimary();
+	}
+	unsigned parsePrimary() {
+		skipSpace();
+		if (accept("(")) {
+			auto result = parseExpr();
+			if (!accept(")")) throw Unsupported();
+			return result;
+		}
+		if (peekChar() == '[') {
+			return parseCommand();
+		}
+		return add(Node{Op::LITERAL, 0, 0, parseNumber(readWord())});
+	}
+
+	// A word of a command, or an operand. Stops at whitespace and at any
+	// character that can't be part of a number or a name.
+	std::string_view readWord() {
+		skipSpace();
+		auto start = pos;
+		while ((pos < str.size()) &&
+		       (isalnum(static_cast<unsigned char>(str[pos])) || (str[pos] == '_'))) {
+			++pos;
+		}
+		if (start == pos) throw Unsupported();
+		return str.substr(start, pos - start);
+	}
+
+	// Integer literal, as accepted by Tcl. Numbers with a leading zero are
+	// octal in Tcl 8, better not to depend on that.
+	static int64_t parseNumber(std::string_view s) {
+		auto result = [&] {
+			if ((s.size() > 2) && (s[0] == '0')) {
+				auto prefix = char(tolower(static_cast<unsigned char>(s[1])));
+				s.remove_prefix(2);
+				switch (prefix) {
+				case 'x': return StringOp::stringToBase<16, uint64_t>(s);
+				case 'b': return StringOp::stringToBase< 2, uint64_t>(s);
+				case 'o': return StringOp::stringToBase< 8, uint64_t>(s);
+				default: throw Unsupported();
+				}
+			}
+			if ((s.size() > 1) && (s[0] == '0')) throw Unsupported();
+			return StringOp::stringToBase<10, uint64_t>(s);
+		}();
+		// also keeps the arithmetic in the 64-bit range, see evaluate()
+		if (!result || (*result >= (uint64_t(1) << 32))) throw Unsupported();
+		return int64_t(*result);
+	}
+
+	// An argument of a command: a literal or again a (supported) command.
+	unsigned parseArgument() {
+		skipSpace();
+		if (peekChar() == '[') return parseCommand();
+		return add(Node{Op::LITERAL, 0, 0, parseNumber(readWord())});
+	}
+
+	// Slot number for pc_in_slot: 0-3 or X (4).
+	uint16_t parseSlot() {
+		auto w = readWord();
+		if (w == "X") return 4;
+		auto n = parseNumber(w);
+		if (n > 3) throw Unsupported();
+		return uint16_t(n);
+	}
+
+	// '[' command ']'
+	unsigned parseCommand() {
+		++pos; // '['
+		auto name = readWord();
+		unsigned result = 0;
+		if (name == "reg") {
+			auto regName = readWord();
+			auto it = std::ranges::find_if(regInfos, [&](const RegInfo& r) {
+				return StringOp::casecmp()(r.name, regName);
+			});
+			if (it == regInfos.end()) throw Unsupported();
+			result = add(Node{it->word ? Op::REG16 : Op::REG8, 0, 0, it->index});
+		} else if (name == "peek" || name == "peek8" || name == "peek_u8") {
+			result = add(Op::PEEK, parseArgument());
+		} else if (name == "peek_s8") {
+			result = add(Op::PEEK_S8, parseArgument());
+		} else if (name == "peek16" || name == "peek16_LE") {
+			result = add(Op::PEEK16, parseArgument());
+		} else if (name == "peek16_BE") {
+			result = add(Op::PEEK16_BE, parseArgument());
+		} else if (name == "debug") {
+			if (readWord() != "read") throw Unsupported();
+			skipSpace();
+			if (accept("\"memory\"")) {
+				// ok
+			} else if (readWord() != "memory") {
+				throw Unsupported();
+			}
+			result = add(Op::PEEK, parseArgument());
+		} else if (name == "pc_in_slot") {
+			auto ps = parseSlot();
+			uint16_t ss = 4;
+			skipSpace();
+			if (peekChar() != ']') ss = parseSlot();
+			skipSpace();
+			if (peekChar() != ']') {
+				if (readWord() != "X") throw Unsupported(); // mapper segment
+			}
+			result = add(Node{Op::PC_IN_SLOT, ps, ss, 0});
+		} else {
+			throw Unsupported();
+		}
+		skipSpace();
+		if (peekChar() != ']') throw Unsupported();
+		++pos;
+		return result;
+	}
+
+private:
+	std::string_view str;
+	size_t pos = 0;
+	std::vector<Node> nodes;
+};
+
+} // namespace
+
+std::unique_ptr<CompiledCondition> CompiledCondition::compile(std::string_view expression)
+{
+	try {
+		return std::make_unique<CompiledCondition>(Parser(expression).parse());
+	} catch (Unsupported&) {
+		return nullptr;
+	}
+}
+
+} // namespace openmsx
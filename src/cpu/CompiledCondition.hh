@@ -0,0 +1,179 @@
+#ifndef COMPILEDCONDITION_HH
+#define COMPILEDCONDITION_HH
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace openmsx {
+
+/** Native version of a (breakpoint or debug-) condition.
+  *
+  * Evaluating the condition via the Tcl interpreter on every instruction is
+  * very slow. Most conditions only use a small subset of Tcl, e.g.
+  *     [reg A] == 0x12 && [peek 0xC000] != 0
+  * Such expressions are compiled to a small expression tree that can be
+  * evaluated without involving Tcl at all.
+  *
+  * The supported subset is:
+  *  - integer literals (decimal, 0x.., 0b.., 0o..)
+  *  - the operators  ( )  - ~ !  *  + -  << >>  < > <= >=  == !=  &  ^  |
+  *    && ||  with the same precedence as in Tcl
+  *  - the commands (from the standard scripts)
+  *      reg <name>
+  *      peek <addr>, peek8, peek_u8, peek_s8, peek16, peek16_LE, peek16_BE
+  *        (only on 'memory', the optional debuggable argument is not supported)
+  *      debug read memory <addr>
+  *      pc_in_slot <ps> ?<ss>?   (not the optional mapper-segment argument)
+  *    where the arguments are literals or again a supported command.
+  * For anything else compile() fails, and the caller keeps using Tcl.
+  *
+  * Corner cases where the Tcl version would give an error (e.g. peek16 on
+  * address 0xFFFF) or where the result doesn't fit in 64-bit, are not
+  * handled natively either: evaluate() then returns 'nullopt' and the
+  * caller should fall back to Tcl, so that the error message is the same.
+  */
+class CompiledCondition
+{
+public:
+	[[nodiscard]] static std::unique_ptr<CompiledCondition> compile(std::string_view expression);
+
+	/** Evaluate the condition on the given machine.
+	  * 'Machine' must provide:
+	  *   unsigned readReg(unsigned index); // byte from the 'CPU regs' debuggable
+	  *   unsigned peek(unsigned address);  // byte from the 'memory' debuggable
+	  *   std::pair<int, int> getSelectedSlot(int page); // secondary is -1 when not expanded
+	  * @return The result, or nullopt when it can't be evaluated natively.
+	  */
+	template<typename Machine>
+	[[nodiscard]] std::optional<bool> evaluate(Machine& machine) const {
+		bool ok = true;
+		auto result = eval(unsigned(nodes.size() - 1), machine, ok);
+		if (!ok) return {};
+		return result != 0;
+	}
+
+public: // for the implementation
+	enum class Op : uint8_t {
+		LITERAL, REG8, REG16, PEEK, PEEK_S8, PEEK16, PEEK16_BE, PC_IN_SLOT,
+		NEG, BIT_NOT, NOT,
+		MUL, ADD, SUB, SHL, SHR, LT, GT, LE, GE, EQ, NE,
+		BIT_AND, BIT_XOR, BIT_OR, AND, OR,
+	};
+	struct Node {
+		Op op;
+		uint16_t lhs = 0; // operand index (slot: primary, 4 = any)
+		uint16_t rhs = 0; // operand index (slot: secondary, 4 = any)
+		int64_t value = 0; // constant or register index
+	};
+	explicit CompiledCondition(std::vector<Node> nodes_)
+		: nodes(std::move(nodes_)) {}
+
+private:
+	// Limits to keep all arithmetic exact in 64 bit (Tcl has arbitrary
+	// precision integers).
+	[[nodiscard]] static bool fits(int64_t x, int64_t limit) {
+		return (-limit < x) && (x < limit);
+	}
+
+	template<typename Machine>
+	[[nodiscard]] int64_t eval(unsigned idx, Machine& m, bool& ok) const {
+		const auto& n = nodes[idx];
+		auto peekAddr = [&](unsigned len) -> unsigned {
+			auto addr = eval(n.lhs, m, ok);
+			if ((addr < 0) || ((addr + len) > 0x10000)) {
+				ok = false;
+				return 0;
+			}
+			return unsigned(addr);
+		};
+		switch (n.op) {
+		case Op::LITERAL:
+			return n.value;
+		case Op::REG8:
+			return m.readReg(unsigned(n.value));
+		case Op::REG16:
+			return 256 * m.readReg(unsigned(n.value)) + m.readReg(unsigned(n.value + 1));
+		case Op::PEEK: {
+			auto addr = peekAddr(1);
+			return ok ? m.peek(addr) : 0;
+		}
+		case Op::PEEK_S8: {
+			auto addr = peekAddr(1);
+			if (!ok) return 0;
+			auto b = int64_t(m.peek(addr));
+			return (b < 128) ? b : (b - 256);
+		}
+		case Op::PEEK16: {
+			auto addr = peekAddr(2);
+			return ok ? (m.peek(addr) + 256 * m.peek(addr + 1)) : 0;
+		}
+		case Op::PEEK16_BE: {
+			auto addr = peekAddr(2);
+			return ok ? (256 * m.peek(addr) + m.peek(addr + 1)) : 0;
+		}
+		case Op::PC_IN_SLOT: {
+			int page = int(m.readReg(20) >> 6); // PCh
+			auto [ps, ss] = m.getSelectedSlot(page);
+			if ((n.lhs != 4) && (ps != n.lhs)) return 0;
+			if ((n.rhs != 4) && (ss != -1) && (ss != n.rhs)) return 0;
+			return 1;
+		}
+		case Op::NEG:
+			return -eval(n.lhs, m, ok);
+		case Op::BIT_NOT:
+			return ~eval(n.lhs, m, ok);
+		case Op::NOT:
+			return eval(n.lhs, m, ok) == 0;
+		case Op::AND:
+			return (eval(n.lhs, m, ok) != 0) && (eval(n.rhs, m, ok) != 0);
+		case Op::OR:
+			return (eval(n.lhs, m, ok) != 0) || (eval(n.rhs, m, ok) != 0);
+		default:
+			break;
+		}
+
+		auto a = eval(n.lhs, m, ok);
+		auto b = eval(n.rhs, m, ok);
+		switch (n.op) {
+		case Op::MUL:
+			if (!fits(a, int64_t(1) << 31) || !fits(b, int64_t(1) << 31)) ok = false;
+			return ok ? (a * b) : 0;
+		case Op::ADD:
+			if (!fits(a, int64_t(1) << 62) || !fits(b, int64_t(1) << 62)) ok = false;
+			return ok ? (a + b) : 0;
+		case Op::SUB:
+			if (!fits(a, int64_t(1) << 62) || !fits(b, int64_t(1) << 62)) ok = false;
+			return ok ? (a - b) : 0;
+		case Op::SHL:
+			if (!fits(a, int64_t(1) << 31) || (b < 0) || (b > 31)) ok = false;
+			return ok ? (a * (int64_t(1) << b)) : 0;
+		case Op::SHR:
+			if (b < 0) ok = false;
+			return ok ? (a >> std::min<int64_t>(b, 63)) : 0;
+		case Op::LT: return a <  b;
+		case Op::GT: return a >  b;
+		case Op::LE: return a <= b;
+		case Op::GE: return a >= b;
+		case Op::EQ: return a == b;
+		case Op::NE: return a != b;
+		case Op::BIT_AND: return a & b;
+		case Op::BIT_XOR: return a ^ b;
+		case Op::BIT_OR:  return a | b;
+		default:
+			ok = false;
+			return 0;
+		}
+	}
+
+private:
+	std::vector<Node> nodes; // the root is the last element
+};
+
+} // namespace openmsx
+
+#endif
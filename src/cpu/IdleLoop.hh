@@ -0,0 +1,80 @@
+#ifndef IDLELOOP_HH
+#define IDLELOOP_HH
+
+#include <cstdint>
+
+namespace openmsx {
+
+/** Checks whether the loop [begin .. branchPC] is an idle loop, see
+  * CPUCore::checkIdleLoop() for the details.
+  *
+  * @param begin Address of the first instruction of the loop.
+  * @param branchPC Address of the backwards jump (jr, jp or djnz).
+  * @param branchLen Length of that jump instruction (in bytes).
+  * @param hl Current value of the HL register.
+  * @param isCached Tells whether an address can be read without side effects
+  *                 (it's in a cached read line).
+  * @param peek Reads an address for which 'isCached' returned true.
+  * @result The increment of the R register for one iteration of the loop, or
+  *         zero if it's not an idle loop.
+  */
+template<typename IsCached, typename Peek>
+[[nodiscard]] uint8_t analyzeIdleLoop(
+	unsigned begin, unsigned branchPC, unsigned branchLen, unsigned hl,
+	IsCached isCached, Peek peek)
+{
+	// All opcode bytes must be in cacheable memory (no side effects).
+	for (unsigned addr = begin; addr < branchPC + branchLen; ++addr) {
+		if (!isCached(addr & 0xFFFF)) return 0;
+	}
+	auto read = [&](unsigned addr) -> unsigned { return peek(addr & 0xFFFF); };
+
+	uint8_t rIncrement = 1; // the jump itself
+	unsigned pc = begin;
+	if (pc == branchPC) return rIncrement; // jr $   or   djnz $
+
+	// load A from memory
+	switch (read(pc)) {
+	case 0x3A: // ld a,(nn)
+		if (!isCached(read(pc + 1) | (read(pc + 2) << 8))) return 0;
+		pc += 3;
+		break;
+	case 0x7E: // ld a,(hl)
+		if (!isCached(hl & 0xFFFF)) return 0;
+		pc += 1;
+		break;
+	default:
+		return 0;
+	}
+	++rIncrement;
+
+	// optionally test A
+	if (pc != branchPC) {
+		switch (read(pc)) {
+		case 0xA7: // and a
+		case 0xB7: // or a
+			pc += 1;
+			++rIncrement;
+			break;
+		case 0xE6: // and n
+		case 0xEE: // xor n
+		case 0xF6: // or n
+		case 0xFE: // cp n
+			pc += 2;
+			++rIncrement;
+			break;
+		case 0xCB: // bit b,a
+			if ((read(pc + 1) & 0xC7) != 0x47) return 0;
+			pc += 2;
+			rIncrement += 2;
+			break;
+		default:
+			return 0;
+		}
+	}
+	return (pc == branchPC) ? rIncrement : 0;
+}
+
+} // namespace openmsx
+
+#endif
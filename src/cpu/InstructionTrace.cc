@@ -0,0 +1,214 @@
+#include "InstructionTrace.hh"
+
+#include "MSXException.hh"
+#include "endian.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace openmsx {
+
+// Binary file format, see exportBinary().
+static constexpr std::array<char, 8> MAGIC = {'o', 'M', 'S', 'X', 't', 'r', 'c', 'e'};
+static constexpr uint32_t VERSION = 1;
+struct FileHeader {
+	std::array<char, 8> magic;
+	Endian::L32 version;
+	Endian::L32 numChunks;
+};
+struct FileChunkHeader {
+	Endian::L64 startTime;
+	Endian::L32 count;
+	Endian::L32 numBytes;
+};
+static_assert(sizeof(FileHeader) == 16);
+static_assert(sizeof(FileChunkHeader) == 16);
+
+InstructionTrace::InstructionTrace(size_t maxBytes)
+{
+	setMaxSize(maxBytes);
+}
+
+void InstructionTrace::setMaxSize(size_t maxBytes)
+{
+	auto num = std::max<size_t>(2, maxBytes / CHUNK_SIZE);
+	while (chunks.size() > num) chunks.pop_front(); // keep the newest
+	chunks.set_capacity(num);
+}
+
+void InstructionTrace::clear()
+{
+	chunks.clear();
+}
+
+void InstructionTrace::startChunk(uint64_t time)
+{
+	// reuse the buffer of the oldest chunk when possible
+	auto data = [&] {
+		if (!chunks.full()) return MemBuffer<uint8_t>(CHUNK_SIZE);
+		auto result = std::move(chunks.front().data);
+		chunks.pop_front();
+		return result;
+	}();
+	chunks.push_back(Chunk{std::move(data), 0, 0, time});
+	prevRegs = {};
+	prevTime = time;
+}
+
+size_t InstructionTrace::size() const
+{
+	size_t result = 0;
+	for (const auto& chunk : chunks) result += chunk.count;
+	return result;
+}
+
+// Decode all records in one chunk. Recorded data is always valid, but this is
+// also used to check imported data, so all reads are bounds checked.
+template<typename Callback>
+static void decodeChunk(std::span<const uint8_t> data, uint64_t startTime, Callback callback)
+{
+	InstructionTrace::Regs regs = {};
+	uint64_t time = startTime;
+	const uint8_t* p = data.data();
+	const uint8_t* end = p + data.size();
+	auto need = [&](size_t n) {
+		if (size_t(end - p) < n) throw MSXException("Truncated record.");
+	};
+	auto read16 = [&] {
+		need(2);
+		auto result = uint16_t(p[0] | (p[1] << 8));
+		p += 2;
+		return result;
+	};
+	while (p < end) {
+		InstructionTrace::Entry e;
+		uint8_t header = *p++;
+		e.opcodeLen = header & 7;
+		if ((e.opcodeLen < 1) || (e.opcodeLen > 4) || (header & ~15)) {
+			throw MSXException("Invalid record header.");
+		}
+		e.pc = read16();
+		need(e.opcodeLen);
+		e.opcode = {};
+		std::memcpy(e.opcode.data(), p, e.opcodeLen); p += e.opcodeLen;
+		if (header & 8) {
+			unsigned mask = read16();
+			for (unsigned i = 0; i < InstructionTrace::NUM_REGS; ++i) {
+				if (mask & (1 << i)) regs[i] = read16();
+			}
+		}
+		uint64_t delta = 0;
+		for (unsigned shift = 0; true; shift += 7) {
+			need(1);
+			if (shift >= 64) throw MSXException("Invalid time delta.");
+			uint8_t b = *p++;
+			delta |= uint64_t(b & 0x7F) << shift;
+			if (!(b & 0x80)) break;
+		}
+		time += delta;
+		e.regs = regs;
+		e.time = time;
+		callback(e);
+	}
+}
+
+std::vector<InstructionTrace::Entry> InstructionTrace::getLast(size_t n) const
+{
+	// only decode the chunks that are needed
+	size_t first = chunks.size();
+	size_t total = 0;
+	while ((first > 0) && (total < n)) {
+		--first;
+		total += chunks[first].count;
+	}
+	std::vector<Entry> result;
+	result.reserve(total);
+	for (size_t i = first; i < chunks.size(); ++i) {
+		const auto& chunk = chunks[i];
+		decodeChunk(std::span{chunk.data.data(), chunk.used}, chunk.startTime,
+		            [&](const Entry& e) { result.push_back(e); });
+	}
+	if (result.size() > n) {
+		result.erase(result.begin(), result.end() - n);
+	}
+	return result;
+}
+
+std::vector<uint8_t> InstructionTrace::exportBinary() const
+{
+	std::vector<uint8_t> result;
+	auto append = [&](const void* p, size_t size) {
+		auto* b = static_cast<const uint8_t*>(p);
+		result.insert(result.end(), b, b + size);
+	};
+	FileHeader header{MAGIC, Endian::L32(VERSION), Endian::L32(uint32_t(chunks.size()))};
+
+	size_t total = sizeof(FileHeader);
+	for (const auto& chunk : chunks) total += sizeof(FileChunkHeader) + chunk.used;
+	result.reserve(total);
+
+	append(&header, sizeof(header));
+	for (const auto& chunk : chunks) {
+		FileChunkHeader ch{Endian::L64(chunk.startTime), Endian::L32(chunk.count),
+		               Endian::L32(uint32_t(chunk.used))};
+		append(&ch, sizeof(ch));
+		append(chunk.data.data(), chunk.used);
+	}
+	return result;
+}
+
+void InstructionTrace::importBinary(std::span<const uint8_t> data)
+{
+	auto read = [&]<typename H>(H& h) {
+		if (data.size() < sizeof(H)) throw MSXException("Truncated file.");
+		std::memcpy(&h, data.data(), sizeof(H));
+		data = data.subspan(sizeof(H));
+	};
+	FileHeader header;
+	read(header);
+	if (header.magic != MAGIC) throw MSXException("Not an openMSX instruction trace.");
+	if (header.version != VERSION) {
+		throw MSXException("Unsupported version: ", uint32_t(header.version));
+	}
+
+	// Decode everything before touching the current recording.
+	circular_buffer<Chunk> newChunks(chunks.capacity());
+	Regs lastRegs = {};
+	uint64_t lastTime = 0;
+	for (uint32_t i = 0; i < header.numChunks; ++i) {
+		FileChunkHeader ch;
+		read(ch);
+		uint32_t numBytes = ch.numBytes;
+		if ((numBytes > CHUNK_SIZE) || (numBytes > data.size())) {
+			throw MSXException("Invalid chunk size.");
+		}
+		auto chunkData = data.first(numBytes);
+		data = data.subspan(numBytes);
+
+		uint32_t count = 0;
+		uint64_t time = ch.startTime;
+		Regs regs = {};
+		decodeChunk(chunkData, ch.startTime, [&](const Entry& e) {
+			++count;
+			regs = e.regs;
+			time = e.time;
+		});
+		if (count != ch.count) throw MSXException("Invalid record count.");
+		lastRegs = regs;
+		lastTime = time;
+
+		if (newChunks.full()) newChunks.pop_front(); // keep the newest
+		MemBuffer<uint8_t> buf(CHUNK_SIZE);
+		std::ranges::copy(chunkData, buf.data());
+		newChunks.push_back(Chunk{std::move(buf), numBytes, count, ch.startTime});
+	}
+	if (!data.empty()) throw MSXException("Unexpected data at end of file.");
+
+	chunks = std::move(newChunks);
+	// new records are delta-encoded relative to the last imported one
+	prevRegs = lastRegs;
+	prevTime = lastTime;
+}
+
+} // namespace openmsx
@@ -0,0 +1,162 @@
+#ifndef INSTRUCTIONTRACE_HH
+#define INSTRUCTIONTRACE_HH
+
+#include "MemBuffer.hh"
+#include "circular_buffer.hh"
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace openmsx {
+
+/** Records the last executed instructions of the emulated CPU.
+  *
+  * Unlike the 'cputrace' setting (which prints every instruction) this
+  * only stores the instructions in memory, in a compact form. So it can
+  * run for a long time, and afterwards (e.g. after a crash) the last few
+  * million instructions can be inspected. Note that while recording,
+  * CPUCore executes one instruction at a time (like with breakpoints), so
+  * emulation is slower than normal. On top of that, record() takes about
+  * 35ns per instruction on a current desktop CPU (see the benchmark in
+  * InstructionTrace_test.cc), a few percent of a host core for a Z80 at
+  * normal speed.
+  * Instructions executed in fast-forward mode (e.g. reverse goto) are not
+  * recorded.
+  *
+  * The instructions are stored in chunks of CHUNK_SIZE bytes. When the
+  * maximum number of chunks is reached, the oldest chunk is dropped. Each
+  * record is delta-encoded relative to the previous record in the same
+  * chunk (at the start of a chunk all registers are zero and the time is
+  * the chunk start time). Record format:
+  *   byte      header: bits 0-2: opcode length (1-4)
+  *                     bit  3:   registers-changed mask present
+  *   2 bytes   PC (little endian)
+  *   1-4 bytes opcode
+  *   (only if bit 3 is set)
+  *     2 bytes mask, bit N set when register N changed
+  *     2 bytes for each set bit: the new register value
+  *   varint    EmuTime ticks since the previous record (7 bits per byte,
+  *             least significant first, bit 7 set when more bytes follow)
+  * The registers are the values _after_ the instruction was executed, in
+  * the order of the Reg enum. The R register is not recorded (it changes
+  * on every instruction).
+  */
+class InstructionTrace
+{
+public:
+	enum Reg { AF, BC, DE, HL, IX, IY, SP, AF2, BC2, DE2, HL2, IFF_IM_I, NUM_REGS };
+	using Regs = std::array<uint16_t, NUM_REGS>;
+
+	static constexpr size_t CHUNK_SIZE = 64 * 1024;
+	static constexpr size_t MAX_RECORD_SIZE = 1 + 2 + 4 + 2 + 2 * NUM_REGS + 10;
+
+	struct Entry {
+		uint16_t pc;
+		uint8_t opcodeLen;
+		std::array<uint8_t, 4> opcode;
+		Regs regs;
+		uint64_t time; // EmuTime ticks
+		[[nodiscard]] std::span<const uint8_t> getOpcode() const {
+			return std::span{opcode}.first(opcodeLen);
+		}
+	};
+
+	explicit InstructionTrace(size_t maxBytes = 64 * 1024 * 1024);
+
+	void setActive(bool active_) { active = active_; warnedFastForward = false; }
+	[[nodiscard]] bool isActive() const { return active; }
+
+	/** Returns true (only once per activation) when recording and the
+	  * user should be warned that the instructions executed in
+	  * fast-forward mode are missing from the trace. */
+	[[nodiscard]] bool needFastForwardWarning() {
+		return active && !std::exchange(warnedFastForward, true);
+	}
+
+	/** Set the maximum memory usage. Existing data is kept when possible. */
+	void setMaxSize(size_t maxBytes);
+	[[nodiscard]] size_t getMaxSize() const { return chunks.capacity() * CHUNK_SIZE; }
+	void clear();
+
+	void record(uint16_t pc, std::span<const uint8_t> opcode, const Regs& regs, uint64_t time) {
+		if (chunks.empty() || (chunks.back().used + MAX_RECORD_SIZE > CHUNK_SIZE)) [[unlikely]] {
+			startChunk(time);
+		}
+		auto& chunk = chunks.back();
+		uint8_t* p = chunk.data.data() + chunk.used;
+		uint8_t* start = p;
+
+		unsigned mask = 0;
+		for (unsigned i = 0; i < NUM_REGS; ++i) {
+			if (regs[i] != prevRegs[i]) mask |= 1 << i;
+		}
+		*p++ = uint8_t(opcode.size() | (mask ? 8 : 0));
+		p = write16(p, pc);
+		for (auto b : opcode) *p++ = b;
+		if (mask) {
+			p = write16(p, uint16_t(mask));
+			for (unsigned i = 0; i < NUM_REGS; ++i) {
+				if (mask & (1 << i)) p = write16(p, regs[i]);
+			}
+		}
+		for (auto delta = time - prevTime; true; delta >>= 7) {
+			if (delta < 0x80) { *p++ = uint8_t(delta); break; }
+			*p++ = uint8_t(delta | 0x80);
+		}
+
+		chunk.used += p - start;
+		++chunk.count;
+		prevRegs = regs;
+		prevTime = time;
+	}
+
+	/** Number of recorded instructions. */
+	[[nodiscard]] size_t size() const;
+
+	/** Decode (at most) the last 'n' recorded instructions, oldest first. */
+	[[nodiscard]] std::vector<Entry> getLast(size_t n) const;
+
+	/** Binary export: a header ('oMSXtrce', version 1, number of chunks,
+	  * all little endian), followed by each chunk (oldest first): start
+	  * time (8 bytes), number of records (4 bytes), number of bytes (4
+	  * bytes) and the records (see class comment).
+	  */
+	[[nodiscard]] std::vector<uint8_t> exportBinary() const;
+
+	/** Replace the recorded instructions by the content of a file created
+	  * with exportBinary(). When the file contains more chunks than fit in
+	  * the buffer, only the newest chunks are kept. When recording
+	  * continues afterwards, the new instructions are appended.
+	  * @throws MSXException when the data is not a valid trace (the
+	  *         current recording is then left unchanged).
+	  */
+	void importBinary(std::span<const uint8_t> data);
+
+private:
+	struct Chunk {
+		MemBuffer<uint8_t> data;
+		size_t used = 0;
+		uint32_t count = 0;
+		uint64_t startTime = 0;
+	};
+	void startChunk(uint64_t time);
+	static uint8_t* write16(uint8_t* p, uint16_t value) {
+		p[0] = uint8_t(value >> 0);
+		p[1] = uint8_t(value >> 8);
+		return p + 2;
+	}
+
+private:
+	circular_buffer<Chunk> chunks;
+	Regs prevRegs = {};
+	uint64_t prevTime = 0;
+	bool active = false;
+	bool warnedFastForward = false;
+};
+
+} // namespace openmsx
+
+#endif
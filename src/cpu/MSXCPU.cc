@@ -6,6 +6,7 @@
 #include "Z80.hh"
 
 #include "MSXMotherBoard.hh"
+#include "MSXMemoryMapperBase.hh"
 #include "Debugger.hh"
 #include "Scheduler.hh"
 #include "IntegerSetting.hh"
@@ -33,11 +34,11 @@ MSXCPU::MSXCPU(MSXMotherBoard& motherboard_)
 		"default_di_halt_callback",
 		Setting::Save::YES) // user must be able to override
 	, z80(std::make_unique<CPUCore<Z80TYPE>>(
-		motherboard, "z80", traceSetting,
+		motherboard, "z80", traceSetting, profiler, instructionTrace,
 		diHaltCallback, EmuTime::zero()))
 	, r800(motherboard.isTurboR()
 		? std::make_unique<CPUCore<R800TYPE>>(
-			motherboard, "r800", traceSetting,
+			motherboard, "r800", traceSetting, profiler, instructionTrace,
 			diHaltCallback, EmuTime::zero())
 		: nullptr)
 	, timeInfo(motherboard.getMachineInfoCommand())
@@ -127,6 +128,26 @@ void MSXCPU::execute(bool fastForward)
 	          : r800->execute(fastForward);
 }
 
+void MSXCPU::recordProfile(word pc, unsigned ticks)
+{
+	int page = pc >> 14;
+	auto& p = profilePages[page];
+	if (!p.valid) [[unlikely]] {
+		// same as in the ImGui debugger: memory mapper segment or ROM block
+		const auto* device = interface->getVisibleMSXDevice(page);
+		p.mapper = dynamic_cast<const MSXMemoryMapperBase*>(device);
+		p.romBlocks = p.mapper ? nullptr
+		            : motherboard.getDebugger().findDebuggable(device->getName() + " romblocks");
+		p.valid = true;
+	}
+	uint16_t segment = p.mapper    ? p.mapper->getSelectedSegment(narrow<byte>(page))
+	                 : p.romBlocks ? p.romBlocks->read(pc)
+	                 : CPUProfiler::NO_SEGMENT;
+	int ps = interface->getPrimarySlot(page);
+	int ss = interface->isExpanded(ps) ? interface->getSecondarySlot(page) : 0;
+	profiler.record(narrow<uint8_t>(ps + 4 * ss), segment, pc, ticks);
+}
+
 void MSXCPU::exitCPULoopSync()
 {
 	z80Active ? z80 ->exitCPULoopSync()
@@ -169,6 +190,7 @@ void MSXCPU::updateVisiblePage(byte page, byte primarySlot, byte secondarySlot)
 	byte from = slots[page];
 	byte to = narrow<byte>(4 * primarySlot + secondarySlot);
 	slots[page] = to;
+	profilePages[page] = {};
 
 	auto [cpuReadLines, cpuWriteLines] = z80Active ? z80->getCacheLines() : r800->getCacheLines();
 
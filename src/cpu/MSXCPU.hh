@@ -1,7 +1,9 @@
 #ifndef MSXCPU_HH
 #define MSXCPU_HH
 
+#include "CPUProfiler.hh"
 #include "InfoTopic.hh"
+#include "InstructionTrace.hh"
 #include "SimpleDebuggable.hh"
 #include "Observer.hh"
 #include "BooleanSetting.hh"
@@ -19,6 +21,8 @@ namespace openmsx {
 
 class MSXMotherBoard;
 class MSXCPUInterface;
+class MSXMemoryMapperBase;
+class Debuggable;
 class CPUClock;
 class CPURegs;
 class Z80TYPE;
@@ -148,7 +152,14 @@ public:
 
 	[[nodiscard]] CPURegs& getRegisters();
 
+	/** Read a register like the 'CPU regs' debuggable does. */
+	[[nodiscard]] byte peekRegister(unsigned index) { return debuggable.read(index); }
+
 	[[nodiscard]] auto* getZ80() { return z80.get(); }
+	[[nodiscard]] CPUProfiler& getProfiler() { return profiler; }
+	/** Only for CPUCore: count an executed instruction in the profiler. */
+	void recordProfile(word pc, unsigned ticks);
+	[[nodiscard]] InstructionTrace& getInstructionTrace() { return instructionTrace; }
 	[[nodiscard]] auto* getR800() { return r800.get(); }
 
 	template<typename Archive>
@@ -178,6 +189,8 @@ private:
 private:
 	MSXMotherBoard& motherboard;
 	BooleanSetting traceSetting;
+	CPUProfiler profiler;
+	InstructionTrace instructionTrace;
 	TclCallback diHaltCallback;
 	const std::unique_ptr<CPUCore<Z80TYPE>> z80;
 	const std::unique_ptr<CPUCore<R800TYPE>> r800; // can be nullptr
@@ -186,6 +199,15 @@ private:
 	std::array<std::array<      byte*, CacheLine::NUM>, 16> slotWriteLines;
 	std::array<byte, 4> slots; // active slot for page (= 4 * primSlot + secSlot)
 
+	// For recordProfile(): how to get the selected segment in each page.
+	// Reset when the visible device changes (see updateVisiblePage()).
+	struct ProfilePage {
+		const MSXMemoryMapperBase* mapper = nullptr;
+		Debuggable* romBlocks = nullptr;
+		bool valid = false;
+	};
+	std::array<ProfilePage, 4> profilePages;
+
 	struct TimeInfoTopic final : InfoTopic {
 		explicit TimeInfoTopic(InfoCommand& machineInfoCommand);
 		void execute(std::span<const TclObject> tokens,
@@ -50,6 +50,7 @@ static unsigned breakedSettingCount = 0;
 static constexpr byte SECONDARY_SLOT_BIT = 0x01;
 static constexpr byte MEMORY_WATCH_BIT   = 0x02;
 static constexpr byte GLOBAL_RW_BIT      = 0x04;
+static constexpr byte ACCESS_STATS_BIT   = 0x08;
 
 std::ostream& operator<<(std::ostream& os, EnumTypeName<CacheLineCounters>)
 {
@@ -201,6 +202,9 @@ byte MSXCPUInterface::readMemSlow(word address, EmuTime::param time)
 				g.device->globalRead(address, time);
 			}
 		}
+		if (accessStats.isActive() && !isFastForward()) {
+			accessStats.count(MemoryAccessStats::Type::READ, address);
+		}
 		// execute read watches before actual read
 		if (readWatchSet[address >> CacheLine::BITS]
 		                [address &  CacheLine::LOW]) {
@@ -227,6 +231,9 @@ void MSXCPUInterface::writeMemSlow(word address, byte value, EmuTime::param time
 	}
 	// something special in this region?
 	if (disallowWriteCache[address >> CacheLine::BITS]) [[unlikely]] {
+		if (accessStats.isActive() && !isFastForward()) {
+			accessStats.count(MemoryAccessStats::Type::WRITE, address);
+		}
 		// slot-select-ignore writes (Super Lode Runner)
 		for (auto& g : globalWrites) {
 			// very primitive address selection mechanism,
@@ -794,47 +801,65 @@ void MSXCPUInterface::writeSlottedMem(unsigned address, byte value,
 void MSXCPUInterface::insertBreakPoint(BreakPoint bp)
 {
 	cliComm.update(CliComm::UpdateType::DEBUG_UPDT, tmpStrCat("bp#", bp.getId()), "add");
-	auto it = ranges::upper_bound(breakPoints, bp.getAddress(), {}, &BreakPoint::getAddress);
-	breakPoints.insert(it, std::move(bp));
+	breakPoints.insert(std::move(bp));
+}
+
+void MSXCPUInterface::insertBreakPoints(std::vector<BreakPoint> bps)
+{
+	for (const auto& bp : bps) {
+		cliComm.update(CliComm::UpdateType::DEBUG_UPDT, tmpStrCat("bp#", bp.getId()), "add");
+	}
+	breakPoints.insert(std::move(bps));
 }
 
 void MSXCPUInterface::removeBreakPoint(const BreakPoint& bp)
 {
 	cliComm.update(CliComm::UpdateType::DEBUG_UPDT, tmpStrCat("bp#", bp.getId()), "remove");
-	auto [first, last] = ranges::equal_range(breakPoints, bp.getAddress(), {}, &BreakPoint::getAddress);
-	breakPoints.erase(find_unguarded(first, last, &bp,
-	                                 [](const BreakPoint& i) { return &i; }));
+	breakPoints.remove(bp);
 }
 void MSXCPUInterface::removeBreakPoint(unsigned id)
 {
-	if (auto it = ranges::find(breakPoints, id, &BreakPoint::getId);
-	    // could be ==end for a breakpoint that removes itself AND has the -once flag set
-	    it != breakPoints.end()) {
-		cliComm.update(CliComm::UpdateType::DEBUG_UPDT, tmpStrCat("bp#", it->getId()), "remove");
-		breakPoints.erase(it);
+	// could be not found for a breakpoint that removes itself AND has the -once flag set
+	if (breakPoints.remove(id)) {
+		cliComm.update(CliComm::UpdateType::DEBUG_UPDT, tmpStrCat("bp#", id), "remove");
 	}
 }
 
-void MSXCPUInterface::checkBreakPoints(
-	std::pair<BreakPoints::const_iterator,
-	          BreakPoints::const_iterator> range)
+void MSXCPUInterface::removeBreakPoints(std::span<const unsigned> ids)
+{
+	for (auto id : ids) {
+		cliComm.update(CliComm::UpdateType::DEBUG_UPDT, tmpStrCat("bp#", id), "remove");
+	}
+	breakPoints.remove(ids);
+}
+
+void MSXCPUInterface::checkBreakPoints(BreakPointList::Range range)
 {
-	// create copy for the case that breakpoint/condition removes itself
-	//  - keeps object alive by holding a shared_ptr to it
-	//  - avoids iterating over a changing collection
-	BreakPoints bpCopy(range.first, range.second);
 	auto& globalCliComm = motherBoard.getReactor().getGlobalCliComm();
 	auto& interp        = motherBoard.getReactor().getInterpreter();
 	auto scopedBlock = motherBoard.getStateChangeDistributor().tempBlockNewEventsDuringReplay();
-	for (auto& p : bpCopy) {
-		bool remove = p.checkAndExecute(globalCliComm, interp);
-		if (remove) {
-			removeBreakPoint(p.getId());
+	// No need for a copy when all breakpoints on this address have a
+	// compiled condition that is false (e.g. 'pc_in_slot' for another slot).
+	if (!std::all_of(range.first, range.second, [&](const auto& bp) { return bp.isFalse(motherBoard); })) {
+		// create copy for the case that breakpoint/condition removes itself
+		//  - keeps object alive by holding a shared_ptr to it
+		//  - avoids iterating over a changing collection
+		BreakPoints bpCopy(range.first, range.second);
+		for (auto& p : bpCopy) {
+			bool remove = p.checkAndExecute(globalCliComm, interp, motherBoard);
+			if (remove) {
+				removeBreakPoint(p.getId());
+			}
 		}
 	}
+	// Typically all conditions are compiled and false, then there's no
+	// need for a copy (evaluating compiled conditions has no side effects).
+	if (ranges::all_of(conditions, [&](const auto& c) { return c.isFalse(motherBoard); })) {
+		return;
+	}
 	auto condCopy = conditions;
 	for (auto& c : condCopy) {
-		bool remove = c.checkAndExecute(globalCliComm, interp);
+		bool remove = c.checkAndExecute(globalCliComm, interp, motherBoard);
 		if (remove) {
 			removeCondition(c.getId());
 		}
@@ -989,6 +1014,23 @@ void MSXCPUInterface::updateMemWatch(WatchPoint::Type type)
 	msxcpu.invalidateAllSlotsRWCache(0x0000, 0x10000);
 }
 
+void MSXCPUInterface::setAccessStatsActive(bool active)
+{
+	if (active == accessStats.isActive()) return;
+	accessStats.setActive(active);
+	// route all memory accesses via readMemSlow() / writeMemSlow()
+	for (auto i : xrange(CacheLine::NUM)) {
+		if (active) {
+			disallowReadCache [i] |=  ACCESS_STATS_BIT;
+			disallowWriteCache[i] |=  ACCESS_STATS_BIT;
+		} else {
+			disallowReadCache [i] &= ~ACCESS_STATS_BIT;
+			disallowWriteCache[i] &= ~ACCESS_STATS_BIT;
+		}
+	}
+	msxcpu.invalidateAllSlotsRWCache(0x0000, 0x10000);
+}
+
 void MSXCPUInterface::executeMemWatch(WatchPoint::Type type,
                                       unsigned address, unsigned value)
 {
@@ -1009,7 +1051,7 @@ void MSXCPUInterface::executeMemWatch(WatchPoint::Type type,
 		if ((w->getBeginAddress() <= address) &&
 		    (w->getEndAddress()   >= address) &&
 		    (w->getType()         == type)) {
-			bool remove = w->checkAndExecute(globalCliComm, interp);
+			bool remove = w->checkAndExecute(globalCliComm, interp, motherBoard);
 			if (remove) {
 				removeWatchPoint(w);
 			}
@@ -2,8 +2,10 @@
 #define MSXCPUINTERFACE_HH
 
 #include "BreakPoint.hh"
+#include "BreakPointList.hh"
 #include "CacheLine.hh"
 #include "DebugCondition.hh"
+#include "MemoryAccessStats.hh"
 #include "WatchPoint.hh"
 
 #include "SimpleDebuggable.hh"
@@ -19,6 +21,7 @@
 #include <bitset>
 #include <concepts>
 #include <memory>
+#include <span>
 #include <vector>
 
 namespace openmsx {
@@ -251,8 +254,14 @@ public:
 	void insertBreakPoint(BreakPoint bp);
 	void removeBreakPoint(const BreakPoint& bp);
 	void removeBreakPoint(unsigned id);
-	using BreakPoints = std::vector<BreakPoint>;
-	[[nodiscard]] static const BreakPoints& getBreakPoints() { return breakPoints; }
+	/** Insert/remove many breakpoints at once. Much faster than repeatedly
+	  * calling insertBreakPoint() / removeBreakPoint() (e.g. when setting a
+	  * breakpoint on every symbol of a program).
+	  */
+	void insertBreakPoints(std::vector<BreakPoint> bps);
+	void removeBreakPoints(std::span<const unsigned> ids);
+	using BreakPoints = BreakPointList::BreakPoints;
+	[[nodiscard]] static const BreakPoints& getBreakPoints() { return breakPoints.getBreakPoints(); }
 
 	void setWatchPoint(const std::shared_ptr<WatchPoint>& watchPoint);
 	void removeWatchPoint(std::shared_ptr<WatchPoint> watchPoint);
@@ -273,19 +282,24 @@ public:
 	void doContinue();
 
 	// breakpoint methods used by CPUCore
+	/** While this returns true, CPUCore executes one instruction at a
+	  * time and calls checkBreakPoints() after each of them. This holds
+	  * for any breakpoint, also one on an address that is never executed:
+	  * the fast path can't filter on address, it executes many
+	  * instructions in one go.
+	  */
 	[[nodiscard]] static bool anyBreakPoints()
 	{
 		return !breakPoints.empty() || !conditions.empty();
 	}
 	[[nodiscard]] bool checkBreakPoints(unsigned pc)
 	{
-		auto range = ranges::equal_range(breakPoints, pc, {}, &BreakPoint::getAddress);
-		if (conditions.empty() && (range.first == range.second)) {
+		bool bpHit = breakPoints.hasAddress(word(pc));
+		if (!bpHit && conditions.empty()) {
 			return false;
 		}
-
 		// slow path non-inlined
-		checkBreakPoints(range);
+		checkBreakPoints(breakPoints.find(word(pc)));
 		return isBreaked();
 	}
 
@@ -297,6 +311,17 @@ public:
 	void setFastForward(bool fastForward_) { fastForward = fastForward_; }
 	[[nodiscard]] bool isFastForward() const { return fastForward; }
 
+	/** Native memory access statistics, see MemoryAccessStats. */
+	[[nodiscard]] const MemoryAccessStats& getAccessStats() const { return accessStats; }
+	void setAccessStatsActive(bool active);
+	void resetAccessStats() { accessStats.reset(); }
+	void countExecute(word address) {
+		accessStats.count(MemoryAccessStats::Type::EXECUTE, address);
+	}
+	[[nodiscard]] bool needAccessStatsFastForwardWarning() {
+		return accessStats.needFastForwardWarning();
+	}
+
 	[[nodiscard]] MSXDevice* getMSXDevice(int ps, int ss, int page);
 	[[nodiscard]] MSXDevice* getVisibleMSXDevice(int page) { return visibleDevices[page]; }
 
@@ -320,8 +345,7 @@ private:
 	                    int ps, int ss, unsigned base, unsigned size);
 
 
-	void checkBreakPoints(std::pair<BreakPoints::const_iterator,
-	                                BreakPoints::const_iterator> range);
+	void checkBreakPoints(BreakPointList::Range range);
 
 	void removeAllWatchPoints();
 	void updateMemWatch(WatchPoint::Type type);
@@ -410,6 +434,7 @@ private:
 	std::array<byte, CacheLine::NUM> disallowWriteCache;
 	std::array<std::bitset<CacheLine::SIZE>, CacheLine::NUM> readWatchSet;
 	std::array<std::bitset<CacheLine::SIZE>, CacheLine::NUM> writeWatchSet;
+	MemoryAccessStats accessStats;
 
 	struct GlobalRwInfo {
 		MSXDevice* device;
@@ -432,7 +457,7 @@ private:
 	bool fastForward = false; // no need to serialize
 
 	//  All CPUs (Z80 and R800) of all MSX machines share this state.
-	static inline BreakPoints breakPoints; // sorted on address
+	static inline BreakPointList breakPoints;
 	WatchPoints watchPoints; // ordered in creation order,  TODO must also be static
 	static inline Conditions conditions; // ordered in creation order
 	static inline bool breaked = false;
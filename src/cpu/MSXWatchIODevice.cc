@@ -49,7 +49,7 @@ void WatchIO::doReadCallback(unsigned port)
 	// this watchpoint deletes itself in checkAndExecute()
 	auto keepAlive = shared_from_this();
 	auto scopedBlock = motherboard.getStateChangeDistributor().tempBlockNewEventsDuringReplay();
-	if (bool remove = checkAndExecute(cliComm, interp); remove) {
+	if (bool remove = checkAndExecute(cliComm, interp, motherboard); remove) {
 		cpuInterface.removeWatchPoint(keepAlive);
 	}
 
@@ -69,7 +69,7 @@ void WatchIO::doWriteCallback(unsigned port, unsigned value)
 	// see comment in doReadCallback() above
 	auto keepAlive = shared_from_this();
 	auto scopedBlock = motherboard.getStateChangeDistributor().tempBlockNewEventsDuringReplay();
-	if (bool remove = checkAndExecute(cliComm, interp); remove) {
+	if (bool remove = checkAndExecute(cliComm, interp, motherboard); remove) {
 		cpuInterface.removeWatchPoint(keepAlive);
 	}
 
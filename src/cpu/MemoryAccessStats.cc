@@ -0,0 +1,52 @@
+#include "MemoryAccessStats.hh"
+
+#include "ranges.hh"
+#include "xrange.hh"
+
+#include <algorithm>
+
+namespace openmsx {
+
+std::optional<MemoryAccessStats::Type> MemoryAccessStats::parseType(std::string_view str)
+{
+	for (auto i : xrange(NUM_TYPES)) {
+		if (str == typeNames[i]) return Type(i);
+	}
+	return {};
+}
+
+void MemoryAccessStats::setActive(bool active_)
+{
+	if (active_ && !counters) {
+		counters = std::make_unique<Counters>(); // zero-initialized
+	}
+	active = active_;
+	warnedFastForward = false;
+}
+
+void MemoryAccessStats::reset()
+{
+	if (!counters) return;
+	for (auto& c : *counters) ranges::fill(c, 0);
+}
+
+MemoryAccessStats::PageTotals MemoryAccessStats::getPageTotals(Type type) const
+{
+	PageTotals result = {};
+	if (!counters) return result;
+	const auto& c = (*counters)[size_t(type)];
+	for (auto page : xrange(CacheLine::NUM)) {
+		for (auto i : xrange(CacheLine::SIZE)) {
+			result[page] += c[page * CacheLine::SIZE + i];
+		}
+	}
+	return result;
+}
+
+uint64_t MemoryAccessStats::getMax(Type type) const
+{
+	if (!counters) return 0;
+	return std::ranges::max((*counters)[size_t(type)]);
+}
+
+} // namespace openmsx
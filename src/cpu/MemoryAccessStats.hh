@@ -0,0 +1,79 @@
+#ifndef MEMORYACCESSSTATS_HH
+#define MEMORYACCESSSTATS_HH
+
+#include "CacheLine.hh"
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+namespace openmsx {
+
+/** Counts the memory accesses of the emulated CPU, per (CPU visible) address.
+  *
+  * This is a lightweight alternative for memory watchpoints when only
+  * statistics are needed (e.g. to find hot memory regions): no Tcl
+  * callbacks are executed, only a counter is incremented.
+  *
+  * While active, MSXCPUInterface disables the read/write cache lines, so
+  * that all reads and writes go via its slow path, where they are counted.
+  * Note that opcode fetches are also counted as reads (like on the real
+  * bus). In addition, CPUCore counts the start address of each executed
+  * instruction, for that it has to execute one instruction at a time (like
+  * with breakpoints), so emulation is slower while counting. Accesses in
+  * fast-forward mode (e.g. reverse goto) are not counted.
+  *
+  * The counters are only allocated when collecting is started for the
+  * first time.
+  */
+class MemoryAccessStats
+{
+public:
+	enum class Type : uint8_t { READ, WRITE, EXECUTE, NUM };
+	static constexpr auto NUM_TYPES = size_t(Type::NUM);
+	static constexpr std::array<std::string_view, NUM_TYPES> typeNames = {
+		"read", "write", "execute",
+	};
+	[[nodiscard]] static std::optional<Type> parseType(std::string_view str);
+
+	using PageTotals = std::array<uint64_t, CacheLine::NUM>;
+
+	/** Only for MSXCPUInterface, it must also (re)enable the cache lines. */
+	void setActive(bool active_);
+	[[nodiscard]] bool isActive() const { return active; }
+	void reset();
+
+	/** Returns true (only once per activation) when counting and the user
+	  * should be warned that the accesses in fast-forward mode are missing
+	  * from the statistics. */
+	[[nodiscard]] bool needFastForwardWarning() {
+		return active && !std::exchange(warnedFastForward, true);
+	}
+
+	void count(Type type, uint16_t address) {
+		assert(counters);
+		++(*counters)[size_t(type)][address];
+	}
+
+	[[nodiscard]] uint64_t get(Type type, uint16_t address) const {
+		return counters ? (*counters)[size_t(type)][address] : 0;
+	}
+	/** Sum of the counters per 256-byte page (CacheLine). */
+	[[nodiscard]] PageTotals getPageTotals(Type type) const;
+	/** Highest counter (of the given type) over all addresses. */
+	[[nodiscard]] uint64_t getMax(Type type) const;
+
+private:
+	using Counters = std::array<std::array<uint64_t, 0x10000>, NUM_TYPES>;
+	std::unique_ptr<Counters> counters; // allocated on first use
+	bool active = false;
+	bool warnedFastForward = false;
+};
+
+} // namespace openmsx
+
+#endif
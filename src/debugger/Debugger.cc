@@ -6,6 +6,10 @@
 #include "Dasm.hh"
 #include "DebugCondition.hh"
 #include "Debuggable.hh"
+#include "File.hh"
+#include "FileException.hh"
+#include "FileOperations.hh"
+#include "InstructionTrace.hh"
 #include "MSXCPU.hh"
 #include "MSXCPUInterface.hh"
 #include "MSXCliComm.hh"
@@ -13,12 +17,14 @@
 #include "MSXWatchIODevice.hh"
 #include "ProbeBreakPoint.hh"
 #include "Reactor.hh"
+#include "Scheduler.hh"
 #include "SymbolManager.hh"
 #include "TclArgParser.hh"
 #include "TclObject.hh"
 
 #include "MemBuffer.hh"
 #include "StringOp.hh"
+#include "endian.hh"
 #include "narrow.hh"
 #include "one_of.hh"
 #include "ranges.hh"
@@ -29,6 +35,7 @@
 
 #include <array>
 #include <cassert>
+#include <functional>
 #include <memory>
 
 using std::string;
@@ -249,6 +256,8 @@ void Debugger::Cmd::execute(
 		"set_bp",            [&]{ setBreakPoint(tokens, result); },
 		"remove_bp",         [&]{ removeBreakPoint(tokens, result); },
 		"list_bp",           [&]{ listBreakPoints(tokens, result); },
+		"set_bps",           [&]{ setBreakPoints(tokens, result); },
+		"remove_bps",        [&]{ removeBreakPoints(tokens, result); },
 		"set_watchpoint",    [&]{ setWatchPoint(tokens, result); },
 		"remove_watchpoint", [&]{ removeWatchPoint(tokens, result); },
 		"list_watchpoints",  [&]{ listWatchPoints(tokens, result); },
@@ -256,7 +265,11 @@ void Debugger::Cmd::execute(
 		"remove_condition",  [&]{ removeCondition(tokens, result); },
 		"list_conditions",   [&]{ listConditions(tokens, result); },
 		"probe",             [&]{ probe(tokens, result); },
-		"symbols",           [&]{ symbols(tokens, result); });
+		"symbols",           [&]{ symbols(tokens, result); },
+		"profile",           [&]{ profile(tokens, result); },
+		"trace",             [&]{ trace(tokens, result); },
+		"access_stats",      [&]{ accessStats(tokens, result); },
+		"device_profile",    [&]{ deviceProfile(tokens, result); });
 }
 
 void Debugger::Cmd::list(TclObject& result)
@@ -464,6 +477,64 @@ void Debugger::Cmd::removeBreakPoint(
 	}
 }
 
+void Debugger::Cmd::setBreakPoints(std::span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{3}, "addresses ?-once? ?condition? ?command?");
+	TclObject command("debug break");
+	TclObject condition;
+	bool once = false;
+
+	std::array info = {flagArg("-once", once)};
+	auto arguments = parseTclArgs(getInterpreter(), tokens.subspan(2), info);
+	if ((arguments.size() < 1) || (arguments.size() > 3)) {
+		throw SyntaxError();
+	}
+	if (arguments.size() >= 3) command   = arguments[2];
+	if (arguments.size() >= 2) condition = arguments[1];
+
+	// first check all addresses, so that on error nothing is inserted
+	auto& interp = getInterpreter();
+	auto num = arguments[0].getListLength(interp);
+	std::shared_ptr<const CompiledCondition> compiled =
+		CompiledCondition::compile(condition.getString()); // only once
+	std::vector<BreakPoint> bps;
+	bps.reserve(num);
+	for (auto i : xrange(num)) {
+		word addr = getAddress(interp, arguments[0].getListIndex(interp, i));
+		bps.emplace_back(addr, command, condition, compiled, once);
+	}
+	result.addListElements(view::transform(bps,
+		[](auto& bp) { return strCat("bp#", bp.getId()); }));
+	debugger().motherBoard.getCPUInterface().insertBreakPoints(std::move(bps));
+}
+
+void Debugger::Cmd::removeBreakPoints(
+	std::span<const TclObject> tokens, TclObject& /*result*/)
+{
+	checkNumArgs(tokens, 3, "ids");
+	auto& interp = getInterpreter();
+	const auto& breakPoints = MSXCPUInterface::getBreakPoints();
+
+	// first check all ids, so that on error nothing is removed
+	auto existing = to_vector(view::transform(breakPoints, &BreakPoint::getId));
+	ranges::sort(existing);
+	auto num = tokens[2].getListLength(interp);
+	std::vector<unsigned> ids;
+	ids.reserve(num);
+	for (auto i : xrange(num)) {
+		auto idObj = tokens[2].getListIndex(interp, i);
+		string_view tmp = idObj.getString();
+		auto id = tmp.starts_with("bp#")
+		        ? StringOp::stringToBase<10, unsigned>(tmp.substr(3))
+		        : std::nullopt;
+		if (!id || !ranges::binary_search(existing, *id)) {
+			throw CommandException("No such breakpoint: ", tmp);
+		}
+		ids.push_back(*id);
+	}
+	debugger().motherBoard.getCPUInterface().removeBreakPoints(ids);
+}
+
 void Debugger::Cmd::listBreakPoints(std::span<const TclObject> /*tokens*/, TclObject& result) const
 {
 	string res;
@@ -749,6 +820,228 @@ void Debugger::Cmd::probeListBreakPoints(
 	result = res;
 }
 
+void Debugger::Cmd::profile(std::span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{3}, "subcommand ?arg ...?");
+	auto& profiler = debugger().motherBoard.getCPU().getProfiler();
+	executeSubCommand(tokens[2].getString(),
+		"start",  [&]{ checkNumArgs(tokens, 3, ""); profiler.setActive(true); },
+		"stop",   [&]{ checkNumArgs(tokens, 3, ""); profiler.setActive(false); },
+		"reset",  [&]{ checkNumArgs(tokens, 3, ""); profiler.reset(); },
+		"active", [&]{ checkNumArgs(tokens, 3, ""); result = profiler.isActive(); },
+		"report", [&]{ profileReport(tokens, result); },
+		"save",   [&]{ profileSave(tokens, result); });
+}
+void Debugger::Cmd::profileReport(std::span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, Between{3, 4}, "?max?");
+	auto report = debugger().motherBoard.getCPU().getProfiler().getReport(
+		getSymbolManager().getFiles());
+	if (tokens.size() == 4) {
+		auto max = tokens[3].getInt(getInterpreter());
+		if (max < 0) throw CommandException("Invalid max: ", max);
+		if (report.size() > size_t(max)) report.resize(max);
+	}
+	string res;
+	for (const auto& line : report) {
+		TclObject tclLine = makeTclList(
+			line.name.empty() ? std::string_view("-") : line.name,
+			tmpStrCat("0x", hex_string<4>(line.address)),
+			strCat(line.counter.count), // 64-bit, TclObject has no overload
+			strCat(line.counter.ticks));
+		strAppend(res, tclLine.getString(), '\n');
+	}
+	result = res;
+}
+void Debugger::Cmd::profileSave(std::span<const TclObject> tokens, TclObject& /*result*/)
+{
+	checkNumArgs(tokens, 4, "filename");
+	// All values are little endian, one record per executed address.
+	struct Header {
+		std::array<char, 8> magic;
+		Endian::L32 version;
+		Endian::L32 numRecords;
+	};
+	struct Record {
+		Endian::L16 address;
+		Endian::L16 segment; // 0xFFFF if unknown
+		uint8_t slot;        // primary + 4 * secondary
+		std::array<uint8_t, 3> padding;
+		Endian::L64 count;
+		Endian::L64 ticks;
+	};
+	static_assert(sizeof(Header) == 16);
+	static_assert(sizeof(Record) == 24);
+
+	auto entries = debugger().motherBoard.getCPU().getProfiler().getEntries();
+	auto records = to_vector(view::transform(entries, [](const auto& e) {
+		return Record{Endian::L16(e.address), Endian::L16(e.segment), e.slot, {},
+		              Endian::L64(e.counter.count), Endian::L64(e.counter.ticks)};
+	}));
+	Header header{{'o', 'M', 'S', 'X', 'p', 'r', 'o', 'f'},
+	              Endian::L32(1), Endian::L32(narrow<uint32_t>(records.size()))};
+	try {
+		File file(FileOperations::expandTilde(string(tokens[3].getString())),
+		          File::OpenMode::TRUNCATE);
+		file.write(std::span{&header, 1});
+		file.write(std::span{records});
+	} catch (FileException& e) {
+		throw CommandException("Couldn't save profile: ", e.getMessage());
+	}
+}
+
+void Debugger::Cmd::trace(std::span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{3}, "subcommand ?arg ...?");
+	auto& instrTrace = debugger().motherBoard.getCPU().getInstructionTrace();
+	executeSubCommand(tokens[2].getString(),
+		"start",  [&]{ checkNumArgs(tokens, 3, ""); instrTrace.setActive(true); },
+		"stop",   [&]{ checkNumArgs(tokens, 3, ""); instrTrace.setActive(false); },
+		"clear",  [&]{ checkNumArgs(tokens, 3, ""); instrTrace.clear(); },
+		"active", [&]{ checkNumArgs(tokens, 3, ""); result = instrTrace.isActive(); },
+		"count",  [&]{ checkNumArgs(tokens, 3, ""); result = strCat(instrTrace.size()); },
+		"size",   [&]{ traceSize(tokens, result); },
+		"show",   [&]{ traceShow(tokens, result); },
+		"save",   [&]{ traceSave(tokens, result); },
+		"load",   [&]{ traceLoad(tokens, result); });
+}
+void Debugger::Cmd::traceSize(std::span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, Between{3, 4}, "?kilobytes?");
+	auto& instrTrace = debugger().motherBoard.getCPU().getInstructionTrace();
+	if (tokens.size() == 4) {
+		auto kb = tokens[3].getInt(getInterpreter());
+		if (kb <= 0) throw CommandException("Invalid size: ", kb);
+		instrTrace.setMaxSize(size_t(kb) * 1024);
+	}
+	result = narrow<int>(instrTrace.getMaxSize() / 1024);
+}
+void Debugger::Cmd::traceShow(std::span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, Between{3, 4}, "?num?");
+	size_t num = 20;
+	if (tokens.size() == 4) {
+		auto n = tokens[3].getInt(getInterpreter());
+		if (n < 0) throw CommandException("Invalid number: ", n);
+		num = n;
+	}
+	using enum InstructionTrace::Reg;
+	string res;
+	string dasmOutput;
+	for (const auto& e : debugger().motherBoard.getCPU().getInstructionTrace().getLast(num)) {
+		dasmOutput.clear();
+		dasm(e.getOpcode(), e.pc, dasmOutput);
+		dasmOutput.resize(19, ' ');
+		strAppend(res, hex_string<4>(e.pc), " : ", dasmOutput,
+		          " AF=", hex_string<4>(e.regs[AF]),
+		          " BC=", hex_string<4>(e.regs[BC]),
+		          " DE=", hex_string<4>(e.regs[DE]),
+		          " HL=", hex_string<4>(e.regs[HL]),
+		          " IX=", hex_string<4>(e.regs[IX]),
+		          " IY=", hex_string<4>(e.regs[IY]),
+		          " SP=", hex_string<4>(e.regs[SP]),
+		          " T=", EmuDuration(e.time).toDouble(), '\n');
+	}
+	result = res;
+}
+void Debugger::Cmd::traceSave(std::span<const TclObject> tokens, TclObject& /*result*/)
+{
+	checkNumArgs(tokens, 4, "filename");
+	auto data = debugger().motherBoard.getCPU().getInstructionTrace().exportBinary();
+	try {
+		File file(FileOperations::expandTilde(string(tokens[3].getString())),
+		          File::OpenMode::TRUNCATE);
+		file.write(std::span{data});
+	} catch (FileException& e) {
+		throw CommandException("Couldn't save trace: ", e.getMessage());
+	}
+}
+void Debugger::Cmd::traceLoad(std::span<const TclObject> tokens, TclObject& /*result*/)
+{
+	checkNumArgs(tokens, 4, "filename");
+	try {
+		File file(FileOperations::expandTilde(string(tokens[3].getString())));
+		debugger().motherBoard.getCPU().getInstructionTrace().importBinary(file.mmap());
+	} catch (MSXException& e) {
+		throw CommandException("Couldn't load trace: ", e.getMessage());
+	}
+}
+
+static MemoryAccessStats::Type parseAccessType(const TclObject& token)
+{
+	auto str = token.getString();
+	if (auto type = MemoryAccessStats::parseType(str)) return *type;
+	throw CommandException("Invalid access type: ", str,
+	                       " (must be 'read', 'write' or 'execute')");
+}
+void Debugger::Cmd::accessStats(std::span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{3}, "subcommand ?arg ...?");
+	auto& interface = debugger().motherBoard.getCPUInterface();
+	executeSubCommand(tokens[2].getString(),
+		"start",  [&]{ checkNumArgs(tokens, 3, ""); interface.setAccessStatsActive(true); },
+		"stop",   [&]{ checkNumArgs(tokens, 3, ""); interface.setAccessStatsActive(false); },
+		"reset",  [&]{ checkNumArgs(tokens, 3, ""); interface.resetAccessStats(); },
+		"active", [&]{ checkNumArgs(tokens, 3, ""); result = interface.getAccessStats().isActive(); },
+		"pages",  [&]{ accessStatsPages(tokens, result); },
+		"get",    [&]{ accessStatsGet(tokens, result); });
+}
+void Debugger::Cmd::accessStatsPages(std::span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, 4, "type");
+	auto type = parseAccessType(tokens[3]);
+	auto totals = debugger().motherBoard.getCPUInterface().getAccessStats().getPageTotals(type);
+	result.addListElements(view::transform(totals, [](uint64_t t) {
+		return TclObject(strCat(t)); // 64-bit, TclObject has no overload
+	}));
+}
+void Debugger::Cmd::accessStatsGet(std::span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, Between{5, 6}, "type address ?size?");
+	auto& interp = getInterpreter();
+	auto type = parseAccessType(tokens[3]);
+	unsigned addr = tokens[4].getInt(interp);
+	unsigned num = (tokens.size() == 6) ? tokens[5].getInt(interp) : 1;
+	if ((addr >= 0x10000) || (num > (0x10000 - addr))) {
+		throw CommandException("Invalid address range");
+	}
+	const auto& stats = debugger().motherBoard.getCPUInterface().getAccessStats();
+	result.addListElements(view::transform(xrange(addr, addr + num), [&](unsigned a) {
+		return TclObject(strCat(stats.get(type, narrow_cast<uint16_t>(a))));
+	}));
+}
+
+void Debugger::Cmd::deviceProfile(std::span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{3}, "subcommand ?arg ...?");
+	auto& motherBoard = debugger().motherBoard;
+	auto& profiler = motherBoard.getScheduler().getDeviceProfiler();
+	auto time = motherBoard.getCurrentTime();
+	executeSubCommand(tokens[2].getString(),
+		"start",   [&]{ checkNumArgs(tokens, 3, ""); profiler.setActive(true, time); },
+		"stop",    [&]{ checkNumArgs(tokens, 3, ""); profiler.setActive(false, time); },
+		"reset",   [&]{ checkNumArgs(tokens, 3, ""); profiler.reset(time); },
+		"active",  [&]{ checkNumArgs(tokens, 3, ""); result = profiler.isActive(); },
+		"emutime", [&]{ checkNumArgs(tokens, 3, ""); result = profiler.getEmulatedTime(time).toDouble(); },
+		"report",  [&]{ deviceProfileReport(tokens, result); });
+}
+void Debugger::Cmd::deviceProfileReport(std::span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, 3, "");
+	auto entries = to_vector(debugger().motherBoard.getScheduler().getDeviceProfiler().getEntries());
+	std::erase_if(entries, [](const auto& e) { return e.calls == 0; });
+	ranges::sort(entries, std::greater{}, &DeviceProfiler::Entry::selfTime);
+	string res;
+	for (const auto& e : entries) {
+		TclObject line = makeTclList(
+			e.name, DeviceProfiler::categoryNames[size_t(e.category)],
+			strCat(e.calls), // 64-bit, TclObject has no overload
+			strCat(e.totalTime), strCat(e.selfTime));
+		strAppend(res, line.getString(), '\n');
+	}
+	result = res;
+}
+
 SymbolManager& Debugger::Cmd::getSymbolManager()
 {
 	return debugger().getMotherBoard().getReactor().getSymbolManager();
@@ -846,6 +1139,8 @@ string Debugger::Cmd::help(std::span<const TclObject> tokens) const
 		"    set_bp            insert a new breakpoint\n"
 		"    remove_bp         remove a certain breakpoint\n"
 		"    list_bp           list the active breakpoints\n"
+		"    set_bps           insert many breakpoints at once\n"
+		"    remove_bps        remove many breakpoints at once\n"
 		"    set_watchpoint    insert a new watchpoint\n"
 		"    remove_watchpoint remove a certain watchpoint\n"
 		"    list_watchpoints  list the active watchpoints\n"
@@ -860,6 +1155,10 @@ string Debugger::Cmd::help(std::span<const TclObject> tokens) const
 		"    disasm            disassemble instructions\n"
 		"    disasm_blob       disassemble a instruction in Tcl binary string\n"
 		"    symbols           manage debug symbols\n"
+		"    profile           code coverage and execution profile\n"
+		"    trace             record the last executed instructions\n"
+		"    access_stats      count memory accesses per address\n"
+		"    device_profile    measure the host time spent per device\n"
 		"  The arguments are specific for each subcommand.\n"
 		"  Type 'help debug <subcommand>' for help about a specific subcommand.\n";
 
@@ -935,6 +1234,25 @@ string Debugger::Cmd::help(std::span<const TclObject> tokens) const
 		"second one has the address. The third has the condition "
 		"(default condition is empty). And the last column contains "
 		"the command that will be executed (default is 'debug break').\n";
+	auto setBpsHelp =
+		"debug set_bps [-once] <addrs> [<cond>] [<cmd>]\n"
+		"  Insert a breakpoint on each address in the list <addrs>, all "
+		"with the same (optional) -once flag, condition and command. See "
+		"the 'set_bp' subcommand for details about these. This is a lot "
+		"faster than many invocations of 'set_bp' (e.g. to set a "
+		"breakpoint on every symbol of a program). To only break in a "
+		"specific slot use a condition like {[pc_in_slot 3 1]}. Note "
+		"that while there is any breakpoint, the emulation checks for "
+		"breakpoints after every instruction, which makes it a lot "
+		"slower (independent of the number of breakpoints).\n"
+		"  The result is a list of breakpoint IDs, in the same order as "
+		"the addresses. When one of the addresses is invalid, no "
+		"breakpoint is inserted.\n";
+	auto removeBpsHelp =
+		"debug remove_bps <ids>\n"
+		"  Remove all breakpoints in the given list of IDs (e.g. the "
+		"result of 'set_bps'). When one of the IDs is invalid, no "
+		"breakpoint is removed.\n";
 	auto setWatchPointHelp =
 		"debug set_watchpoint [-once] <type> <region> [<cond>] [<cmd>]\n"
 		"  Insert a new watchpoint of given type on the given region, "
@@ -1042,6 +1360,98 @@ string Debugger::Cmd::help(std::span<const TclObject> tokens) const
 		"           and/or with an optionally given value\n"
 		"  Note: an easier syntax to lookup a symbol value based on the name is:\n"
 		"        $sym(<name>)\n";
+	auto profileHelp =
+		"debug profile <subcommand> [<arguments>]\n"
+		"  Collect the number of executed instructions and CPU cycles for "
+		"each executed address (per slot and memory mapper/ROM segment). "
+		"This is evaluated natively and is much faster than using "
+		"breakpoints for the same purpose. Possible subcommands are:\n"
+		"    start              start collecting\n"
+		"    stop               stop collecting (but keep the results)\n"
+		"    reset              clear the results\n"
+		"    active             returns '1' when collecting, '0' otherwise\n"
+		"    report [<max>]     returns the results per routine (using the\n"
+		"                       loaded debug symbols), most cycles first\n"
+		"    save <filename>    save the results per address in a binary file\n"
+		"  The report has one line per routine with 4 columns: the symbol "
+		"name ('-' for addresses without symbol, grouped per 256 bytes), "
+		"the address, the number of executed instructions and the number of "
+		"CPU cycles.\n"
+		"  The binary file has a 16-byte header ('oMSXprof', version and "
+		"number of records, all little endian), followed by a 24-byte record "
+		"per address: address (16-bit), segment (16-bit, 0xFFFF if none), "
+		"slot (8-bit, primary + 4 * secondary), 3 padding bytes, "
+		"instructions (64-bit) and cycles (64-bit).\n"
+		"  Note: while collecting, the CPU is emulated one instruction at a "
+		"time, like when breakpoints are set. Instructions executed in "
+		"fast-forward mode (reverse goto, batch_run) are not counted, a "
+		"warning is printed when that happens.\n";
+	auto traceHelp =
+		"debug trace <subcommand> [<arguments>]\n"
+		"  Record the last executed instructions in memory, together with "
+		"the register values after each instruction and the EmuTime it "
+		"started. Unlike the 'cputrace' setting, nothing is printed while "
+		"recording, so this can run for a long time (e.g. until a crash). "
+		"When the buffer is full, the oldest instructions are dropped. "
+		"Possible subcommands are:\n"
+		"    start              start recording\n"
+		"    stop               stop recording (but keep the results)\n"
+		"    clear              drop all recorded instructions\n"
+		"    active             returns '1' when recording, '0' otherwise\n"
+		"    count              returns the number of recorded instructions\n"
+		"    size [<kB>]        query or set the buffer size in kilobytes\n"
+		"                       (minimum 128)\n"
+		"    show [<num>]       disassemble the last <num> (default 20)\n"
+		"                       recorded instructions, oldest first\n"
+		"    save <filename>    save the raw recording in a binary file\n"
+		"    load <filename>    replace the recording by the content of a\n"
+		"                       file created with 'save', e.g. to inspect\n"
+		"                       it later with 'show'\n"
+		"  The binary file format is documented in InstructionTrace.hh.\n"
+		"  Note: while recording, the CPU is emulated one instruction at a "
+		"time (like when breakpoints are set), so emulation is slower than "
+		"normal. Instructions that are executed in fast-forward mode (e.g. "
+		"reverse goto, batch_run) are not recorded.\n";
+	auto accessStatsHelp =
+		"debug access_stats <subcommand> [<arguments>]\n"
+		"  Count the memory reads and writes and the executed instructions "
+		"for each (CPU visible) address. This is a lot faster than using "
+		"watchpoints for the same purpose, because no Tcl callbacks are "
+		"executed. Opcode fetches are also counted as reads. Possible "
+		"subcommands are:\n"
+		"    start                      start counting\n"
+		"    stop                       stop counting (but keep the results)\n"
+		"    reset                      clear the counters\n"
+		"    active                     returns '1' when counting, '0' otherwise\n"
+		"    pages <type>               returns a list of 256 totals, one per\n"
+		"                               256-byte page\n"
+		"    get <type> <addr> [<size>] returns a list of counters for the\n"
+		"                               given address range (default 1 byte)\n"
+		"  Where <type> is one of 'read', 'write' or 'execute'.\n"
+		"  Note: while counting, memory accesses can't use the fast path "
+		"and, to count the executed instructions, the CPU is emulated one "
+		"instruction at a time (like when breakpoints are set), so "
+		"emulation is slower than normal. Accesses in fast-forward mode "
+		"(e.g. reverse goto, batch_run) are not counted.\n";
+	auto deviceProfileHelp =
+		"debug device_profile <subcommand>\n"
+		"  Measure how much host time is spent in the emulation of each "
+		"device, to find out which devices are the most expensive to "
+		"emulate. Possible subcommands are:\n"
+		"    start    start measuring\n"
+		"    stop     stop measuring (but keep the results)\n"
+		"    reset    clear the results\n"
+		"    active   returns '1' when measuring, '0' otherwise\n"
+		"    emutime  returns the emulated time (in seconds) that was\n"
+		"             measured, e.g. to calculate the cost per emulated second\n"
+		"    report   returns one line per device with: name, category,\n"
+		"             number of calls, total host time and self host time\n"
+		"             (both in nanoseconds), sorted on self time\n"
+		"  The category is one of 'sync_point' (a device handling a "
+		"scheduled event), 'sound' (generating sound samples), 'render' "
+		"(rendering VDP output) or 'vdp_command' (executing VDP commands). "
+		"Sections can be nested (e.g. a VDP sync point that renders some "
+		"lines), the self time excludes the time of nested sections.\n";
 	auto unknownHelp =
 		"Unknown subcommand, use 'help debug' to see a list of valid "
 		"subcommands.\n";
@@ -1068,6 +1478,10 @@ string Debugger::Cmd::help(std::span<const TclObject> tokens) const
 		return removeBpHelp;
 	} else if (tokens[1] == "list_bp") {
 		return listBpHelp;
+	} else if (tokens[1] == "set_bps") {
+		return setBpsHelp;
+	} else if (tokens[1] == "remove_bps") {
+		return removeBpsHelp;
 	} else if (tokens[1] == "set_watchpoint") {
 		return setWatchPointHelp;
 	} else if (tokens[1] == "remove_watchpoint") {
@@ -1096,6 +1510,14 @@ string Debugger::Cmd::help(std::span<const TclObject> tokens) const
 		return disasmBlobHelp;
 	} else if (tokens[1] == "symbols") {
 		return symbolsHelp;
+	} else if (tokens[1] == "profile") {
+		return profileHelp;
+	} else if (tokens[1] == "trace") {
+		return traceHelp;
+	} else if (tokens[1] == "access_stats") {
+		return accessStatsHelp;
+	} else if (tokens[1] == "device_profile") {
+		return deviceProfileHelp;
 	} else {
 		return unknownHelp;
 	}
@@ -1132,9 +1554,10 @@ void Debugger::Cmd::tabCompletion(std::vector<string>& tokens) const
 		"write"sv, "write_block"sv,
 	};
 	static constexpr std::array otherCmds = {
-		"disasm"sv, "disasm_blob"sv, "set_bp"sv, "remove_bp"sv, "set_watchpoint"sv,
+		"disasm"sv, "disasm_blob"sv, "set_bp"sv, "remove_bp"sv, "set_bps"sv, "remove_bps"sv, "set_watchpoint"sv,
 		"remove_watchpoint"sv, "set_condition"sv, "remove_condition"sv,
-		"probe"sv, "symbols"sv,
+		"probe"sv, "symbols"sv, "profile"sv, "trace"sv,
+		"access_stats"sv, "device_profile"sv,
 	};
 	switch (tokens.size()) {
 	case 2: {
@@ -1174,6 +1597,31 @@ void Debugger::Cmd::tabCompletion(std::vector<string>& tokens) const
 					"files"sv, "lookup"sv,
 				};
 				completeString(tokens, subCmds);
+			} else if (tokens[1] == "profile") {
+				static constexpr std::array subCmds = {
+					"start"sv, "stop"sv, "reset"sv,
+					"active"sv, "report"sv, "save"sv,
+				};
+				completeString(tokens, subCmds);
+			} else if (tokens[1] == "trace") {
+				static constexpr std::array subCmds = {
+					"start"sv, "stop"sv, "clear"sv, "active"sv,
+					"count"sv, "size"sv, "show"sv, "save"sv,
+					"load"sv,
+				};
+				completeString(tokens, subCmds);
+			} else if (tokens[1] == "access_stats") {
+				static constexpr std::array subCmds = {
+					"start"sv, "stop"sv, "reset"sv,
+					"active"sv, "pages"sv, "get"sv,
+				};
+				completeString(tokens, subCmds);
+			} else if (tokens[1] == "device_profile") {
+				static constexpr std::array subCmds = {
+					"start"sv, "stop"sv, "reset"sv,
+					"active"sv, "emutime"sv, "report"sv,
+				};
+				completeString(tokens, subCmds);
 			}
 		}
 		break;
@@ -1183,6 +1631,9 @@ void Debugger::Cmd::tabCompletion(std::vector<string>& tokens) const
 			completeString(tokens, view::transform(
 				debugger().probes,
 				[](auto* p) -> std::string_view { return p->getName(); }));
+		} else if ((tokens[1] == "access_stats") &&
+		           (tokens[2] == one_of("pages", "get"))) {
+			completeString(tokens, MemoryAccessStats::typeNames);
 		}
 		break;
 	}
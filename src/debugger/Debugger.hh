@@ -91,6 +91,8 @@ private:
 		void setBreakPoint(std::span<const TclObject> tokens, TclObject& result);
 		void removeBreakPoint(std::span<const TclObject> tokens, TclObject& result);
 		void listBreakPoints(std::span<const TclObject> tokens, TclObject& result) const;
+		void setBreakPoints(std::span<const TclObject> tokens, TclObject& result);
+		void removeBreakPoints(std::span<const TclObject> tokens, TclObject& result);
 		[[nodiscard]] std::vector<std::string> getBreakPointIds() const;
 		[[nodiscard]] std::vector<std::string> getWatchPointIds() const;
 		[[nodiscard]] std::vector<std::string> getConditionIds() const;
@@ -113,6 +115,19 @@ private:
 		void symbolsRemove(std::span<const TclObject> tokens, TclObject& result);
 		void symbolsFiles(std::span<const TclObject> tokens, TclObject& result);
 		void symbolsLookup(std::span<const TclObject> tokens, TclObject& result);
+		void profile(std::span<const TclObject> tokens, TclObject& result);
+		void profileReport(std::span<const TclObject> tokens, TclObject& result);
+		void profileSave(std::span<const TclObject> tokens, TclObject& result);
+		void trace(std::span<const TclObject> tokens, TclObject& result);
+		void traceSize(std::span<const TclObject> tokens, TclObject& result);
+		void traceShow(std::span<const TclObject> tokens, TclObject& result);
+		void traceSave(std::span<const TclObject> tokens, TclObject& result);
+		void traceLoad(std::span<const TclObject> tokens, TclObject& result);
+		void accessStats(std::span<const TclObject> tokens, TclObject& result);
+		void accessStatsPages(std::span<const TclObject> tokens, TclObject& result);
+		void accessStatsGet(std::span<const TclObject> tokens, TclObject& result);
+		void deviceProfile(std::span<const TclObject> tokens, TclObject& result);
+		void deviceProfileReport(std::span<const TclObject> tokens, TclObject& result);
 	} cmd;
 
 	struct NameFromProbe {
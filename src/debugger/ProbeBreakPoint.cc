@@ -37,7 +37,7 @@ void ProbeBreakPoint::update(const ProbeBase& /*subject*/) noexcept
 	auto& reactor = motherBoard.getReactor();
 	auto& cliComm = reactor.getGlobalCliComm();
 	auto& interp  = reactor.getInterpreter();
-	bool remove = checkAndExecute(cliComm, interp);
+	bool remove = checkAndExecute(cliComm, interp, motherBoard);
 	if (remove) {
 		debugger.removeProbeBreakPoint(*this);
 	}
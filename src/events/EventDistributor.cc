@@ -69,7 +69,7 @@ void EventDistributor::deliverEvents()
 	static PriorityMap priorityMapCopy; // static to preserve capacity
 	static EventQueue eventsCopy;       // static to preserve capacity
 
-	assert(Thread::isMainThread());
+	assert(Thread::isRealMainThread());
 
 	reactor.getInputEventGenerator().poll();
 	reactor.getInterpreter().poll();
@@ -12,7 +12,7 @@ namespace openmsx {
 
 GlobalCliComm::~GlobalCliComm()
 {
-	assert(Thread::isMainThread());
+	assert(Thread::isRealMainThread());
 	assert(!delivering);
 }
 
@@ -54,7 +54,7 @@ void GlobalCliComm::setAllowExternalCommands()
 
 void GlobalCliComm::log(LogLevel level, std::string_view message, float fraction)
 {
-	assert(Thread::isMainThread());
+	assert(Thread::isRealMainThread());
 
 	if (delivering) {
 		// Don't allow recursive calls, this would hang while trying to
@@ -105,7 +105,7 @@ void GlobalCliComm::updateFiltered(UpdateType type, std::string_view name, std::
 void GlobalCliComm::updateHelper(UpdateType type, std::string_view machine,
                                  std::string_view name, std::string_view value)
 {
-	assert(Thread::isMainThread());
+	assert(Thread::isRealMainThread());
 	std::scoped_lock lock(mutex);
 	for (const auto& l : listeners) {
 		l->update(type, machine, name, value);
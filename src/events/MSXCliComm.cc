@@ -13,13 +13,20 @@ MSXCliComm::MSXCliComm(MSXMotherBoard& motherBoard_, GlobalCliComm& cliComm_)
 
 void MSXCliComm::log(LogLevel level, std::string_view message, float fraction)
 {
-	if (!suppressMessages) {
-		cliComm.log(level, message, fraction);
+	if (suppressMessages) return;
+	if (deferred) {
+		deferredMessages.emplace_back(DeferredLog{level, std::string(message), fraction});
+		return;
 	}
+	cliComm.log(level, message, fraction);
 }
 
 void MSXCliComm::update(UpdateType type, std::string_view name, std::string_view value)
 {
+	if (deferred) {
+		deferredMessages.emplace_back(DeferredUpdate{type, std::string(name), std::string(value)});
+		return;
+	}
 	cliComm.updateHelper(type, motherBoard.getMachineID(), name, value);
 }
 
@@ -33,7 +40,7 @@ void MSXCliComm::updateFiltered(UpdateType type, std::string_view name, std::str
 			it->second = value; // .. but with a different value
 		}
 	}
-	cliComm.updateHelper(type, motherBoard.getMachineID(), name, value);
+	update(type, name, value);
 }
 
 void MSXCliComm::setSuppressMessages(bool enable)
@@ -41,5 +48,23 @@ void MSXCliComm::setSuppressMessages(bool enable)
 	suppressMessages = enable;
 }
 
+void MSXCliComm::setDeferred(bool enable)
+{
+	deferred = enable;
+	if (deferred) return;
+
+	for (const auto& m : deferredMessages) {
+		std::visit(overloaded{
+			[&](const DeferredLog& l) {
+				cliComm.log(l.level, l.message, l.fraction);
+			},
+			[&](const DeferredUpdate& u) {
+				cliComm.updateHelper(u.type, motherBoard.getMachineID(), u.name, u.value);
+			}
+		}, m);
+	}
+	deferredMessages.clear();
+}
+
 
 } // namespace openmsx
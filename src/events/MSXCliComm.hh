@@ -8,6 +8,9 @@
 #include "xxhash.hh"
 
 #include <array>
+#include <string>
+#include <variant>
+#include <vector>
 
 namespace openmsx {
 
@@ -28,11 +31,29 @@ public:
 	// enable/disable message suppression
 	void setSuppressMessages(bool enable);
 
+	// While deferred, messages are buffered instead of being passed to
+	// the GlobalCliComm (which may only be used from the main thread).
+	// They are delivered (from the main thread) when deferring stops.
+	void setDeferred(bool enable);
+
 private:
+	struct DeferredLog {
+		LogLevel level;
+		std::string message;
+		float fraction;
+	};
+	struct DeferredUpdate {
+		UpdateType type;
+		std::string name;
+		std::string value;
+	};
+
 	MSXMotherBoard& motherBoard;
 	GlobalCliComm& cliComm;
 	array_with_enum_index<CliComm::UpdateType, hash_map<std::string, std::string, XXHasher>> prevValues;
+	std::vector<std::variant<DeferredLog, DeferredUpdate>> deferredMessages;
 	bool suppressMessages = false;
+	bool deferred = false;
 };
 
 } // namespace openmsx
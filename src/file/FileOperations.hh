@@ -65,6 +65,12 @@ namespace openmsx::FileOperations {
 	 */
 	int unlink(zstring_view path);
 
+	/**
+	 * Call rename() in a platform-independent manner. An existing file
+	 * 'newPath' is replaced (atomically on POSIX systems).
+	 */
+	int rename(zstring_view oldPath, zstring_view newPath);
+
 	/**
 	 * Call rmdir() in a platform-independent manner
 	 */
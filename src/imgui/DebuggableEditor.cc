@@ -10,6 +10,7 @@
 #include "Debuggable.hh"
 #include "Debugger.hh"
 #include "Interpreter.hh"
+#include "MSXCPUInterface.hh"
 #include "MSXMotherBoard.hh"
 #include "SymbolManager.hh"
 #include "TclObject.hh"
@@ -24,6 +25,7 @@
 #include <array>
 #include <bit>
 #include <cassert>
+#include <cmath>
 #include <cstdint>
 #include <cstdio>
 #include <span>
@@ -108,7 +110,8 @@ void DebuggableEditor::paint(MSXMotherBoard* motherBoard)
 		    ImGui::IsMouseReleased(ImGuiMouseButton_Right)) {
 			ImGui::OpenPopup("context");
 		}
-		drawContents(s, *debuggable, memSize);
+		auto* cpuInterface = (getDebuggableName() == "memory") ? &motherBoard->getCPUInterface() : nullptr;
+		drawContents(s, *debuggable, memSize, cpuInterface);
 	});
 }
 
@@ -205,7 +208,8 @@ void DebuggableEditor::scrollAddr(const Sizes& s, Debuggable& debuggable, unsign
 	}
 }
 
-void DebuggableEditor::drawContents(const Sizes& s, Debuggable& debuggable, unsigned memSize)
+void DebuggableEditor::drawContents(const Sizes& s, Debuggable& debuggable, unsigned memSize,
+                                    MSXCPUInterface* cpuInterface)
 {
 	const auto& style = ImGui::GetStyle();
 	if (updateAddr) {
@@ -329,6 +333,30 @@ void DebuggableEditor::drawContents(const Sizes& s, Debuggable& debuggable, unsi
 		}
 	};
 
+	// Heatmap: red for writes, green for reads, blue for executed
+	// instructions. Logarithmic scale, relative to the highest counter.
+	const MemoryAccessStats* accessStats = (cpuInterface && showAccessHeatmap)
+		? &cpuInterface->getAccessStats() : nullptr;
+	std::array<float, MemoryAccessStats::NUM_TYPES> heatScale = {};
+	if (accessStats) {
+		for (auto [i, scale] : enumerate(heatScale)) {
+			auto max = accessStats->getMax(MemoryAccessStats::Type(i));
+			scale = max ? 255.0f / std::log2(float(max) + 1.0f) : 0.0f;
+		}
+	}
+	auto heatColor = [&](unsigned a) -> std::optional<ImU32> {
+		using enum MemoryAccessStats::Type;
+		auto intensity = [&](MemoryAccessStats::Type type) {
+			auto count = accessStats->get(type, narrow_cast<uint16_t>(a));
+			return int(std::log2(float(count) + 1.0f) * heatScale[size_t(type)]);
+		};
+		int r = intensity(WRITE);
+		int g = intensity(READ);
+		int b = intensity(EXECUTE);
+		if ((r | g | b) == 0) return {};
+		return IM_COL32(r, g, b, 160);
+	};
+
 	const auto totalLineCount = int((memSize + columns - 1) / columns);
 	im::ListClipper(totalLineCount, -1, s.lineHeight, [&](int line) {
 		auto addr = unsigned(line) * columns;
@@ -367,6 +395,14 @@ void DebuggableEditor::drawContents(const Sizes& s, Debuggable& debuggable, unsi
 					+ float(macroColumn) * s.spacingBetweenMidCols;
 			ImGui::SameLine(bytePosX);
 
+			// Draw access heatmap
+			if (accessStats) {
+				if (auto color = heatColor(addr)) {
+					ImVec2 pos = ImGui::GetCursorScreenPos();
+					drawList->AddRectFilled(pos, ImVec2(pos.x + s.glyphWidth * 2, pos.y + s.lineHeight), *color);
+				}
+			}
+
 			// Draw highlight
 			if (highLight(addr)) {
 				ImVec2 pos = ImGui::GetCursorScreenPos();
@@ -411,6 +447,15 @@ void DebuggableEditor::drawContents(const Sizes& s, Debuggable& debuggable, unsi
 					dataEditingTakeFocus = true;
 					nextAddr = addr;
 				}
+				if (accessStats) {
+					simpleToolTip([&]{
+						using enum MemoryAccessStats::Type;
+						auto a = narrow_cast<uint16_t>(addr);
+						return strCat("reads: ", accessStats->get(READ, a),
+						              "\nwrites: ", accessStats->get(WRITE, a),
+						              "\nexecuted: ", accessStats->get(EXECUTE, a));
+					});
+				}
 			}
 		}
 
@@ -558,6 +603,22 @@ void DebuggableEditor::drawContents(const Sizes& s, Debuggable& debuggable, unsi
 		ImGui::Checkbox("Show Ascii", &showAscii);
 		ImGui::Checkbox("Show Symbol info", &showSymbolInfo);
 		ImGui::Checkbox("Grey out zeroes", &greyOutZeroes);
+		if (cpuInterface) {
+			ImGui::Separator();
+			ImGui::Checkbox("Show access heatmap", &showAccessHeatmap);
+			simpleToolTip("Color the bytes by the number of writes (red), reads (green) "
+			              "and executed instructions (blue), see 'help debug access_stats'.");
+			im::Disabled(!showAccessHeatmap, [&]{
+				bool active = cpuInterface->getAccessStats().isActive();
+				if (ImGui::Checkbox("Count accesses", &active)) {
+					cpuInterface->setAccessStatsActive(active);
+				}
+				ImGui::SameLine();
+				if (ImGui::Button("Reset")) {
+					cpuInterface->resetAccessStats();
+				}
+			});
+		}
 	});
 	im::Popup("NotFound", [&]{
 		ImGui::TextUnformatted("Not found");
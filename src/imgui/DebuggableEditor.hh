@@ -21,6 +21,7 @@ namespace openmsx {
 
 class Debuggable;
 class ImGuiManager;
+class MSXCPUInterface;
 class SymbolManager;
 
 class DebuggableEditor final : public ImGuiPart
@@ -58,7 +59,8 @@ private:
 	bool setAddr(const Sizes& s, Debuggable& debuggable, unsigned memSize, unsigned addr);
 	void scrollAddr(const Sizes& s, Debuggable& debuggable, unsigned memSize, unsigned addr, bool forceScroll);
 
-	void drawContents(const Sizes& s, Debuggable& debuggable, unsigned memSize);
+	void drawContents(const Sizes& s, Debuggable& debuggable, unsigned memSize,
+	                  MSXCPUInterface* cpuInterface);
 	void drawSearch(const Sizes& s, Debuggable& debuggable, unsigned memSize);
 	void parseSearchString(std::string_view str);
 	void search(const Sizes& s, Debuggable& debuggable, unsigned memSize);
@@ -85,6 +87,7 @@ private:
 	bool showDataPreview = false; // display a footer previewing the decimal/binary/hex/float representation of the currently selected bytes.
 	bool showSymbolInfo = false;  // display symbol information and highlight known symbols in hex view
 	bool greyOutZeroes = true;    // display null/zero bytes using the TextDisabled color.
+	bool showAccessHeatmap = false; // color the bytes by their access counts (only for the 'memory' debuggable)
 	std::string addrExpr;
 	std::string searchString;
 	unsigned currentAddr = 0;
@@ -104,6 +107,7 @@ private:
 		PersistentElement   {"showDataPreview",  &DebuggableEditor::showDataPreview},
 		PersistentElement   {"showSymbolInfo",   &DebuggableEditor::showSymbolInfo},
 		PersistentElement   {"greyOutZeroes",    &DebuggableEditor::greyOutZeroes},
+		PersistentElement   {"showAccessHeatmap", &DebuggableEditor::showAccessHeatmap},
 		PersistentElement   {"addrExpr",         &DebuggableEditor::addrExpr},
 		PersistentElement   {"searchString",     &DebuggableEditor::searchString},
 		PersistentElement   {"currentAddr",      &DebuggableEditor::currentAddr},
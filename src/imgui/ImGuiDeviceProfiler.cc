@@ -0,0 +1,142 @@
+#include "ImGuiDeviceProfiler.hh"
+
+#include "ImGuiCpp.hh"
+#include "ImGuiUtils.hh"
+
+#include "DeviceProfiler.hh"
+#include "MSXMotherBoard.hh"
+#include "Scheduler.hh"
+
+#include "ranges.hh"
+#include "strCat.hh"
+#include "unreachable.hh"
+
+#include "imgui.h"
+
+#include <cassert>
+#include <vector>
+
+namespace openmsx {
+
+void ImGuiDeviceProfiler::save(ImGuiTextBuffer& buf)
+{
+	savePersistent(buf, *this, persistentElements);
+}
+
+void ImGuiDeviceProfiler::loadLine(std::string_view name, zstring_view value)
+{
+	loadOnePersistent(name, value, *this, persistentElements);
+}
+
+void ImGuiDeviceProfiler::paint(MSXMotherBoard* motherBoard)
+{
+	if (!show || !motherBoard) return;
+
+	ImGui::SetNextWindowSize(gl::vec2{40, 20} * ImGui::GetFontSize(), ImGuiCond_FirstUseEver);
+	im::Window("Device profiler", &show, [&]{
+		auto& profiler = motherBoard->getScheduler().getDeviceProfiler();
+		auto time = motherBoard->getCurrentTime();
+
+		bool active = profiler.isActive();
+		if (ImGui::Checkbox("Measure", &active)) {
+			profiler.setActive(active, time);
+		}
+		simpleToolTip("Measure the host time spent in the emulation of each device.");
+		ImGui::SameLine();
+		if (ImGui::Button("Reset")) {
+			profiler.reset(time);
+		}
+		auto emuSeconds = profiler.getEmulatedTime(time).toDouble();
+		ImGui::SameLine();
+		ImGui::Text("Emulated time: %.2fs", emuSeconds);
+
+		// All values are expressed per emulated second.
+		struct Row {
+			const DeviceProfiler::Entry* entry;
+			double calls;
+			double total; // milliseconds
+			double self;  // milliseconds
+		};
+		std::vector<Row> rows;
+		double sumSelf = 0.0;
+		if (emuSeconds > 0.0) {
+			for (const auto& e : profiler.getEntries()) {
+				if (e.calls == 0) continue;
+				auto& row = rows.emplace_back(Row{&e,
+					double(e.calls) / emuSeconds,
+					double(e.totalTime) * 1e-6 / emuSeconds,
+					double(e.selfTime) * 1e-6 / emuSeconds});
+				sumSelf += row.self;
+			}
+		}
+
+		int flags = ImGuiTableFlags_RowBg |
+			ImGuiTableFlags_BordersV |
+			ImGuiTableFlags_BordersOuter |
+			ImGuiTableFlags_Resizable |
+			ImGuiTableFlags_Sortable |
+			ImGuiTableFlags_Hideable |
+			ImGuiTableFlags_Reorderable |
+			ImGuiTableFlags_ContextMenuInBody |
+			ImGuiTableFlags_ScrollY |
+			ImGuiTableFlags_SizingStretchProp;
+		im::Table("devices", 6, flags, [&]{
+			ImGui::TableSetupScrollFreeze(0, 1); // Make top row always visible
+			ImGui::TableSetupColumn("Device", ImGuiTableColumnFlags_NoHide);
+			ImGui::TableSetupColumn("Category");
+			ImGui::TableSetupColumn("Calls/s", ImGuiTableColumnFlags_PreferSortDescending);
+			ImGui::TableSetupColumn("Total ms/s", ImGuiTableColumnFlags_PreferSortDescending);
+			ImGui::TableSetupColumn("Self ms/s", ImGuiTableColumnFlags_PreferSortDescending | ImGuiTableColumnFlags_DefaultSort);
+			ImGui::TableSetupColumn("Self %", ImGuiTableColumnFlags_NoSort);
+			ImGui::TableHeadersRow();
+
+			// The values change every frame, so always sort.
+			auto* sortSpecs = ImGui::TableGetSortSpecs();
+			assert(sortSpecs->SpecsCount == 1);
+			switch (sortSpecs->Specs->ColumnIndex) {
+			case 0: // device
+				sortUpDown_String(rows, sortSpecs, [](const Row& r) { return r.entry->name; });
+				break;
+			case 1: // category
+				sortUpDown_T(rows, sortSpecs, [](const Row& r) { return r.entry->category; });
+				break;
+			case 2: // calls
+				sortUpDown_T(rows, sortSpecs, &Row::calls);
+				break;
+			case 3: // total
+				sortUpDown_T(rows, sortSpecs, &Row::total);
+				break;
+			case 4: // self
+				sortUpDown_T(rows, sortSpecs, &Row::self);
+				break;
+			default:
+				UNREACHABLE;
+			}
+
+			for (const auto& row : rows) {
+				if (ImGui::TableNextColumn()) {
+					ImGui::TextUnformatted(row.entry->name);
+				}
+				if (ImGui::TableNextColumn()) {
+					ImGui::TextUnformatted(DeviceProfiler::categoryNames[size_t(row.entry->category)]);
+				}
+				if (ImGui::TableNextColumn()) {
+					ImGui::Text("%.0f", row.calls);
+				}
+				if (ImGui::TableNextColumn()) {
+					ImGui::Text("%.3f", row.total);
+				}
+				if (ImGui::TableNextColumn()) {
+					ImGui::Text("%.3f", row.self);
+				}
+				if (ImGui::TableNextColumn()) {
+					auto fraction = (sumSelf > 0.0) ? float(row.self / sumSelf) : 0.0f;
+					ImGui::ProgressBar(fraction, {-FLT_MIN, 0},
+						tmpStrCat(int(100.0f * fraction + 0.5f), '%').c_str());
+				}
+			}
+		});
+	});
+}
+
+} // namespace openmsx
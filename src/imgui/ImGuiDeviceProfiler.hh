@@ -0,0 +1,29 @@
+#ifndef IMGUI_DEVICEPROFILER_HH
+#define IMGUI_DEVICEPROFILER_HH
+
+#include "ImGuiPart.hh"
+
+namespace openmsx {
+
+class ImGuiDeviceProfiler final : public ImGuiPart
+{
+public:
+	using ImGuiPart::ImGuiPart;
+
+	[[nodiscard]] zstring_view iniName() const override { return "device-profiler"; }
+	void save(ImGuiTextBuffer& buf) override;
+	void loadLine(std::string_view name, zstring_view value) override;
+	void paint(MSXMotherBoard* motherBoard) override;
+
+public:
+	bool show = false;
+
+private:
+	static constexpr auto persistentElements = std::tuple{
+		PersistentElement{"show", &ImGuiDeviceProfiler::show}
+	};
+};
+
+} // namespace openmsx
+
+#endif
@@ -6,6 +6,7 @@
 #include "ImGuiConsole.hh"
 #include "ImGuiCpp.hh"
 #include "ImGuiDebugger.hh"
+#include "ImGuiDeviceProfiler.hh"
 #include "ImGuiDiskManipulator.hh"
 #include "ImGuiHelp.hh"
 #include "ImGuiKeyboard.hh"
@@ -185,6 +186,7 @@ ImGuiManager::ImGuiManager(Reactor& reactor_)
 	cheatFinder = std::make_unique<ImGuiCheatFinder>(*this);
 	sccViewer = std::make_unique<ImGuiSCCViewer>(*this);
 	waveViewer = std::make_unique<ImGuiWaveViewer>(*this);
+	deviceProfiler = std::make_unique<ImGuiDeviceProfiler>(*this);
 	diskManipulator = std::make_unique<ImGuiDiskManipulator>(*this);
 	soundChip = std::make_unique<ImGuiSoundChip>(*this);
 	keyboard = std::make_unique<ImGuiKeyboard>(*this);
@@ -33,6 +33,7 @@ class ImGuiCheatFinder;
 class ImGuiConnector;
 class ImGuiConsole;
 class ImGuiDebugger;
+class ImGuiDeviceProfiler;
 class ImGuiDiskManipulator;
 class ImGuiHelp;
 class ImGuiKeyboard;
@@ -150,6 +151,7 @@ public:
 	std::unique_ptr<ImGuiTrainer> trainer;
 	std::unique_ptr<ImGuiSCCViewer> sccViewer;
 	std::unique_ptr<ImGuiWaveViewer> waveViewer;
+	std::unique_ptr<ImGuiDeviceProfiler> deviceProfiler;
 	std::unique_ptr<ImGuiCheatFinder> cheatFinder;
 	std::unique_ptr<ImGuiDiskManipulator> diskManipulator;
 	std::unique_ptr<ImGuiSettings> settings;
@@ -3,6 +3,7 @@
 #include "ImGuiCheatFinder.hh"
 #include "ImGuiConsole.hh"
 #include "ImGuiCpp.hh"
+#include "ImGuiDeviceProfiler.hh"
 #include "ImGuiDiskManipulator.hh"
 #include "ImGuiKeyboard.hh"
 #include "ImGuiManager.hh"
@@ -134,6 +135,10 @@ void ImGuiTools::showMenu(MSXMotherBoard* motherBoard)
 		ImGui::MenuItem("Audio channel viewer ...", nullptr, &manager.waveViewer->show);
 		ImGui::Separator();
 
+		ImGui::MenuItem("Device profiler ...", nullptr, &manager.deviceProfiler->show);
+		simpleToolTip("Shows the host time spent in the emulation of each device.");
+		ImGui::Separator();
+
 		im::Menu("Toys", [&]{
 			const auto& toys = getAllToyScripts(manager);
 			for (const auto& toy : toys) {
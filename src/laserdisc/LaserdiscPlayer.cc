@@ -776,6 +776,12 @@ bool LaserdiscPlayer::updateBuffer(size_t length, float* buffer,
 	return result;
 }
 
+void LaserdiscPlayer::skipBuffer(size_t length, EmuTime::param time)
+{
+	ResampledSoundDevice::skipBuffer(length, time);
+	start = time;
+}
+
 void LaserdiscPlayer::setMuting(bool left, bool right, EmuTime::param time)
 {
 	updateStream(time);
@@ -117,6 +117,7 @@ private:
 	void generateChannels(std::span<float*> buffers, unsigned num) override;
 	bool updateBuffer(size_t length, float* buffer,
 	                  EmuTime::param time) override;
+	void skipBuffer(size_t length, EmuTime::param time) override;
 	[[nodiscard]] float getAmplificationFactorImpl() const override;
 
 	// Schedulable
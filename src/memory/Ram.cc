@@ -1,6 +1,7 @@
 #include "Ram.hh"
 
 #include "DeviceConfig.hh"
+#include "DirtyPages.hh"
 #include "XMLElement.hh"
 #include "MSXException.hh"
 
@@ -101,6 +102,7 @@ byte RamDebuggable::read(unsigned address)
 void RamDebuggable::write(unsigned address, byte value)
 {
 	ram[address] = value;
+	if (auto* dirty = ram.getDirtyPages()) dirty->mark(address);
 }
 
 
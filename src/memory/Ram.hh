@@ -12,6 +12,7 @@ namespace openmsx {
 
 class XMLElement;
 class DeviceConfig;
+class DirtyPages;
 class Ram;
 
 class RamDebuggable final : public SimpleDebuggable
@@ -52,6 +53,13 @@ public:
 	[[nodiscard]] const std::string& getName() const;
 	void clear(byte c = 0xff);
 
+	/** Writes via the debuggable are reported to this object (can be
+	  * nullptr). All other writes must be tracked by the user of this
+	  * class, see TrackedRam.
+	  */
+	void setDirtyPages(DirtyPages* dirty) { dirtyPages = dirty; }
+	[[nodiscard]] DirtyPages* getDirtyPages() const { return dirtyPages; }
+
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
@@ -59,6 +67,7 @@ private:
 	const XMLElement& xml;
 	MemBuffer<byte> ram;
 	size_t sz; // must come before debuggable
+	DirtyPages* dirtyPages = nullptr;
 	const std::optional<RamDebuggable> debuggable; // can be nullopt
 };
 
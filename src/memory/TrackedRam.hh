@@ -2,6 +2,7 @@
 #define TRACKED_RAM_HH
 
 #include "Ram.hh"
+#include "DirtyPages.hh"
 
 namespace openmsx {
 
@@ -12,10 +13,21 @@ public:
 	// Most methods simply delegate to the internal 'ram' object.
 	TrackedRam(const DeviceConfig& config, const std::string& name,
 	           static_string_view description, size_t size)
-		: ram(config, name, description, size) {}
+		: ram(config, name, description, size), dirty(size)
+	{
+		ram.setDirtyPages(&dirty);
+	}
 
 	TrackedRam(const XMLElement& xml, size_t size)
-		: ram(xml, size) {}
+		: ram(xml, size), dirty(size)
+	{
+		ram.setDirtyPages(&dirty);
+	}
+
+	TrackedRam(const TrackedRam&) = delete;
+	TrackedRam(TrackedRam&&) = delete;
+	TrackedRam& operator=(const TrackedRam&) = delete;
+	TrackedRam& operator=(TrackedRam&&) = delete;
 
 	[[nodiscard]] size_t size() const {
 		return ram.size();
@@ -39,21 +51,21 @@ public:
 
 	// Only allow write/clear via an explicit method.
 	void write(size_t addr, byte value) {
-		writeSinceLastReverseSnapshot = true;
+		dirty.mark(addr);
 		ram[addr] = value;
 	}
 
 	void clear(byte c = 0xff) {
-		writeSinceLastReverseSnapshot = true;
+		dirty.markAll();
 		ram.clear(c);
 	}
 
 	// Some write operations are more efficient in bulk. For those this
-	// method can be used. It will mark the ram as dirty on each
+	// method can be used. It will mark the whole ram as dirty on each
 	// invocation, so the resulting pointer (although the same each time)
 	// should not be reused for multiple (distinct) bulk write operations.
 	[[nodiscard]] std::span<byte> getWriteBackdoor() {
-		writeSinceLastReverseSnapshot = true;
+		dirty.markAll();
 		return {ram.data(), size()};
 	}
 
@@ -62,7 +74,7 @@ public:
 
 private:
 	Ram ram;
-	bool writeSinceLastReverseSnapshot = true;
+	DirtyPages dirty; // pages written since the last reverse snapshot
 };
 
 } // namespace openmsx
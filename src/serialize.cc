@@ -5,6 +5,7 @@
 #include "XMLElement.hh"
 #include "XMLException.hh"
 #include "DeltaBlock.hh"
+#include "DirtyPages.hh"
 #include "MemBuffer.hh"
 #include "FileOperations.hh"
 #include "Version.hh"
@@ -168,6 +169,14 @@ void InputArchiveBase<Derived>::serialize_blob(
 	}
 }
 
+template<typename Derived>
+void InputArchiveBase<Derived>::serialize_blob(
+	const char* tag, std::span<uint8_t> data, DirtyPages& dirty)
+{
+	this->self().serialize_blob(tag, data);
+	dirty.markAll();
+}
+
 template class InputArchiveBase<MemInputArchive>;
 template class InputArchiveBase<XmlInputArchive>;
 
@@ -231,6 +240,26 @@ void MemOutputArchive::serialize_blob(const char* /*tag*/, std::span<const uint8
 	}
 }
 
+void MemOutputArchive::serialize_blob(const char* tag, std::span<const uint8_t> data,
+                                      DirtyPages& dirty)
+{
+	if (!reverseSnapshot) {
+		serialize_blob(tag, data);
+		return;
+	}
+	if (data.size() > SMALL_SIZE) {
+		auto deltaBlockIdx = unsigned(deltaBlocks.size());
+		save(deltaBlockIdx); // see comment below in MemInputArchive
+		deltaBlocks.push_back(dirty.any()
+			? lastDeltaBlocks.createNew(data.data(), data, &dirty)
+			: lastDeltaBlocks.createNullDiff(data.data(), data));
+	} else {
+		auto buf = buffer.allocate(data.size());
+		ranges::copy(data, buf);
+	}
+	dirty.clear();
+}
+
 void MemInputArchive::serialize_blob(const char* /*tag*/, std::span<uint8_t> data,
                                      bool /*diff*/)
 {
@@ -251,24 +280,43 @@ void MemInputArchive::serialize_blob(const char* /*tag*/, std::span<uint8_t> dat
 	}
 }
 
+void MemInputArchive::serialize_blob(const char* tag, std::span<uint8_t> data,
+                                     DirtyPages& dirty)
+{
+	serialize_blob(tag, data);
+	dirty.markAll();
+}
+
 ////
 
 XmlOutputArchive::XmlOutputArchive(zstring_view filename_)
 	: filename(filename_)
 	, writer(*this)
 {
-	{
-		auto f = FileOperations::openFile(filename, "wb");
-		if (!f) error();
-		int duped_fd = dup(fileno(f.get()));
-		if (duped_fd == -1) error();
-		file = gzdopen(duped_fd, "wb9");
-		if (!file) {
-			::close(duped_fd);
-			error();
-		}
-		// on scope-exit 'f' is closed, and 'file'
-		// uses the dup()'ed file descriptor.
+	auto f = FileOperations::openFile(filename, "wb");
+	if (!f) error();
+	open(f.get());
+	// on scope-exit 'f' is closed, and 'file'
+	// uses the dup()'ed file descriptor.
+}
+
+XmlOutputArchive::XmlOutputArchive(FILE* f, zstring_view name)
+	: filename(name)
+	, writer(*this)
+{
+	// the dup()'ed file descriptor shares the file position with 'f'
+	if (fflush(f) != 0) error();
+	open(f);
+}
+
+void XmlOutputArchive::open(FILE* f)
+{
+	int duped_fd = dup(fileno(f));
+	if (duped_fd == -1) error();
+	file = gzdopen(duped_fd, "wb9");
+	if (!file) {
+		::close(duped_fd);
+		error();
 	}
 
 	static constexpr std::string_view header =
@@ -399,6 +447,13 @@ XmlInputArchive::XmlInputArchive(const string& filename)
 	elems.emplace_back(root, root->getFirstChild());
 }
 
+XmlInputArchive::XmlInputArchive(std::string_view name, std::span<const char> xml)
+{
+	xmlDoc.load(name, xml, "openmsx-serialize.dtd");
+	const auto* root = xmlDoc.getRoot();
+	elems.emplace_back(root, root->getFirstChild());
+}
+
 string_view XmlInputArchive::loadStr() const
 {
 	if (currentElement()->hasChildren()) {
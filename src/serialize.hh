@@ -15,6 +15,7 @@
 #include <zlib.h>
 #include <array>
 #include <cassert>
+#include <cstdio>
 #include <memory>
 #include <optional>
 #include <span>
@@ -28,6 +29,7 @@ namespace openmsx {
 
 class LastDeltaBlocks;
 class DeltaBlock;
+class DirtyPages;
 
 // TODO move somewhere in utils once we use this more often
 struct HashPair {
@@ -148,6 +150,13 @@ public:
 	//   cannot know whether a byte-array should be serialized as a blob
 	//   or as a collection of bytes (IOW we cannot decide it based on the
 	//   type).
+	//
+	// void serialize_blob(const char* tag, std::span<uint8_t> data, DirtyPages& dirty)
+	//
+	//   Same as above, but 'dirty' tells which parts of the blob were
+	//   written since the previous reverse snapshot. Reverse snapshots
+	//   only compare those parts and then clear 'dirty'. Loading marks
+	//   the whole blob dirty. All other archives ignore 'dirty'.
 
 	template<typename T>
 	void serialize_blob(const char* tag, std::span<T> data, bool diff = true)
@@ -477,6 +486,11 @@ public:
 	// the resulting string. But memory archives will memcpy the blob.
 	void serialize_blob(const char* tag, std::span<const uint8_t> data,
 	                    bool diff = true);
+	void serialize_blob(const char* tag, std::span<const uint8_t> data,
+	                    DirtyPages& /*dirty*/)
+	{
+		this->self().serialize_blob(tag, data);
+	}
 
 	template<typename T> void serialize(const char* tag, const T& t)
 	{
@@ -572,6 +586,8 @@ public:
 	}
 	void serialize_blob(const char* tag, std::span<uint8_t> data,
 	                    bool diff = true);
+	void serialize_blob(const char* tag, std::span<uint8_t> data,
+	                    DirtyPages& dirty);
 
 	template<typename T>
 	void serialize(const char* tag, T& t)
@@ -683,6 +699,8 @@ public:
 	void save(std::string_view s);
 	void serialize_blob(const char* tag, std::span<const uint8_t> data,
 	                    bool diff = true);
+	void serialize_blob(const char* tag, std::span<const uint8_t> data,
+	                    DirtyPages& dirty);
 
 	using OutputArchiveBase<MemOutputArchive>::serialize;
 	template<typename T, typename ...Args>
@@ -788,6 +806,8 @@ public:
 	[[nodiscard]] std::string_view loadStr();
 	void serialize_blob(const char* tag, std::span<uint8_t> data,
 	                    bool diff = true);
+	void serialize_blob(const char* tag, std::span<uint8_t> data,
+	                    DirtyPages& dirty);
 
 	using InputArchiveBase<MemInputArchive>::serialize;
 	template<typename T, typename ...Args>
@@ -844,6 +864,11 @@ class XmlOutputArchive final : public OutputArchiveBase<XmlOutputArchive>
 {
 public:
 	explicit XmlOutputArchive(zstring_view filename);
+	/** Write the (compressed) document to an already opened file, starting
+	  * at the current position. 'name' is only used in error messages.
+	  * The file itself isn't closed by this archive.
+	  */
+	XmlOutputArchive(FILE* f, zstring_view name);
 	void close();
 	~XmlOutputArchive();
 
@@ -909,6 +934,9 @@ public:
 	void check(bool condition) const;
 	[[noreturn]] void error();
 
+private:
+	void open(FILE* f);
+
 private:
 	zstring_view filename;
 	gzFile file = nullptr;
@@ -919,6 +947,8 @@ class XmlInputArchive final : public InputArchiveBase<XmlInputArchive>
 {
 public:
 	explicit XmlInputArchive(const std::string& filename);
+	/** Parse an (uncompressed) document from memory. */
+	XmlInputArchive(std::string_view name, std::span<const char> xml);
 
 	[[nodiscard]] inline bool versionAtLeast(unsigned actual, unsigned required) const
 	{
@@ -15,6 +15,7 @@
 #include "Filename.hh"
 #include "FileOperations.hh"
 #include "MSXCliComm.hh"
+#include "Scheduler.hh"
 
 #include "stl.hh"
 #include "aligned.hh"
@@ -55,6 +56,7 @@ MSXMixer::MSXMixer(Mixer& mixer_, MSXMotherBoard& motherBoard_,
 	masterVolume.attach(*this);
 	speedManager.attach(*this);
 	throttleManager.attach(*this);
+	updateSkipSynthesis();
 }
 
 MSXMixer::~MSXMixer()
@@ -84,6 +86,8 @@ void MSXMixer::registerSound(SoundDevice& device, float volume,
 	SoundDeviceInfo info(numChannels);
 	info.device = &device;
 	info.defaultVolume = volume;
+	info.profileId = getScheduler().getDeviceProfiler().getId(
+		DeviceProfiler::Category::SOUND, name);
 	info.volumeSetting = std::make_unique<IntegerSetting>(
 		commandController, tmpStrCat(name, "_volume"),
 		"the volume of this sound chip", 75, 0, 100);
@@ -145,6 +149,23 @@ void MSXMixer::setSynchronousMode(bool synchronous)
 			setMixerParams(fragmentSize, hostSampleRate);
 		}
 	}
+	updateSkipSynthesis();
+}
+
+void MSXMixer::updateSkipSynthesis()
+{
+	// While recording we do need the sound, even in turbo mode.
+	bool newSkip = throttleManager.isTurbo() && (synchronousCounter == 0);
+	if (newSkip == skipSynthesis) return;
+	skipSynthesis = newSkip;
+	if (skipSynthesis) {
+		mute();
+	} else {
+		// The resamplers didn't advance while skipping, restart
+		// them from the current time.
+		setMixerParams(fragmentSize, hostSampleRate);
+		unmute();
+	}
 }
 
 double MSXMixer::getEffectiveSpeed() const
@@ -156,6 +177,19 @@ void MSXMixer::updateStream(EmuTime::param time)
 {
 	unsigned count = prevTime.getTicksTill(time);
 	assert(count <= 8192);
+	if (skipSynthesis) {
+		// Turbo mode: the devices must still advance their state (see
+		// SoundDevice::skipBuffer()), but there's no need to resample,
+		// mix or upload their output.
+		auto& profiler = getScheduler().getDeviceProfiler();
+		for (auto& info : infos) {
+			profiler.measure(info.profileId, [&] {
+				info.device->skipBuffer(count, time);
+			});
+		}
+		prevTime += count;
+		return;
+	}
 	inplace_buffer<StereoFloat, 8192> mixBuffer(uninitialized_tag{}, count);
 
 	// call generate() even if count==0 and even if muted
@@ -445,10 +479,20 @@ void MSXMixer::generate(std::span<StereoFloat> output, EmuTime::param time)
 	// (handling this as a special case allows to simplify the code below).
 	auto samples = output.size(); // per channel
 	assert(samples <= 8192);
+
+	// Same as 'device.updateBuffer()', but measured when the device
+	// profiler is active.
+	auto& profiler = getScheduler().getDeviceProfiler();
+	auto updateBuffer = [&](const SoundDeviceInfo& info, float* buffer) {
+		return profiler.measure(info.profileId, [&] {
+			return info.device->updateBuffer(samples, buffer, time);
+		});
+	};
+
 	if (samples == 0) {
 		ALIGNAS_SSE std::array<float, 4> dummyBuf;
 		for (auto& info : infos) {
-			bool ignore = info.device->updateBuffer(0, dummyBuf.data(), time);
+			bool ignore = updateBuffer(info, dummyBuf.data());
 			(void)ignore;
 		}
 		return;
@@ -484,14 +528,14 @@ void MSXMixer::generate(std::span<StereoFloat> output, EmuTime::param time)
 				if (!(usedBuffers & HAS_MONO_FLAG)) {
 					// generate in 'monoBuf' (because it was still empty)
 					// then multiply in-place
-					if (device.updateBuffer(samples, monoBufPtr, time)) {
+					if (updateBuffer(info, monoBufPtr)) {
 						usedBuffers |= HAS_MONO_FLAG;
 						mul(monoBuf, l1);
 					}
 				} else {
 					// generate in 'tmpBuf' (as mono data)
 					// then multiply-accumulate into 'monoBuf'
-					if (device.updateBuffer(samples, tmpBufPtr, time)) {
+					if (updateBuffer(info, tmpBufPtr)) {
 						mulAcc(monoBuf, tmpBufMono, l1);
 					}
 				}
@@ -500,14 +544,14 @@ void MSXMixer::generate(std::span<StereoFloat> output, EmuTime::param time)
 				if (!(usedBuffers & HAS_STEREO_FLAG)) {
 					// 'stereoBuf' (which is still empty) is first filled with mono-data,
 					// then in-place expanded to stereo-data
-					if (device.updateBuffer(samples, stereoBufPtr, time)) {
+					if (updateBuffer(info, stereoBufPtr)) {
 						usedBuffers |= HAS_STEREO_FLAG;
 						mulExpand(stereoBuf, l1, r1);
 					}
 				} else {
 					// 'tmpBuf' is first filled with mono-data,
 					// then expanded to stereo and mul-acc into 'stereoBuf'
-					if (device.updateBuffer(samples, tmpBufPtr, time)) {
+					if (updateBuffer(info, tmpBufPtr)) {
 						mulExpandAcc(stereoBuf, tmpBufMono, l1, r1);
 					}
 				}
@@ -523,14 +567,14 @@ void MSXMixer::generate(std::span<StereoFloat> output, EmuTime::param time)
 				if (!(usedBuffers & HAS_STEREO_FLAG)) {
 					// generate in 'stereoBuf' (because it was still empty)
 					// then multiply in-place
-					if (device.updateBuffer(samples, stereoBufPtr, time)) {
+					if (updateBuffer(info, stereoBufPtr)) {
 						usedBuffers |= HAS_STEREO_FLAG;
 						mul(stereoBuf, l1);
 					}
 				} else {
 					// generate in 'tmpBuf' (as stereo data)
 					// then multiply-accumulate into 'stereoBuf'
-					if (device.updateBuffer(samples, tmpBufPtr, time)) {
+					if (updateBuffer(info, tmpBufPtr)) {
 						mulAcc(stereoBuf, tmpBufStereo, l1);
 					}
 				}
@@ -540,14 +584,14 @@ void MSXMixer::generate(std::span<StereoFloat> output, EmuTime::param time)
 				if (!(usedBuffers & HAS_STEREO_FLAG)) {
 					// generate in 'stereoBuf' (because it was still empty)
 					// then mix in-place
-					if (device.updateBuffer(samples, stereoBufPtr, time)) {
+					if (updateBuffer(info, stereoBufPtr)) {
 						usedBuffers |= HAS_STEREO_FLAG;
 						mulMix2(stereoBuf, l1, l2, r1, r2);
 					}
 				} else {
 					// 'tmpBuf' is first filled with stereo-data,
 					// then mixed into stereoBuf
-					if (device.updateBuffer(samples, tmpBufPtr, time)) {
+					if (updateBuffer(info, tmpBufPtr)) {
 						mulMix2Acc(stereoBuf, tmpBufStereo, l1, l2, r1, r2);
 					}
 				}
@@ -723,8 +767,7 @@ void MSXMixer::update(const SpeedManager& /*speedManager*/) noexcept
 
 void MSXMixer::update(const ThrottleManager& /*throttleManager*/) noexcept
 {
-	//reInit();
-	// TODO Should this be removed?
+	updateSkipSynthesis();
 }
 
 void MSXMixer::updateVolumeParams(SoundDeviceInfo& info) const
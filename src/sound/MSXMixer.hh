@@ -1,6 +1,7 @@
 #ifndef MSXMIXER_HH
 #define MSXMIXER_HH
 
+#include "DeviceProfiler.hh"
 #include "DynamicClock.hh"
 #include "EmuTime.hh"
 #include "InfoTopic.hh"
@@ -51,6 +52,7 @@ public:
 		dynarray<ChannelSettings> channelSettings;
 		float defaultVolume = 0.f;
 		float left1 = 0.f, right1 = 0.f, left2 = 0.f, right2 = 0.f;
+		DeviceProfiler::Id profileId = DeviceProfiler::INVALID_ID;
 	};
 
 public:
@@ -141,6 +143,7 @@ public:
 	[[nodiscard]] const auto& getDeviceInfos() const { return infos; }
 
 	void reInit();
+	void updateSkipSynthesis();
 
 private:
 	void updateVolumeParams(SoundDeviceInfo& info) const;
@@ -191,6 +194,7 @@ private:
 	unsigned synchronousCounter = 0;
 
 	unsigned muteCount = 1; // start muted
+	bool skipSynthesis = false; // turbo mode, see ThrottleManager::isTurbo()
 	float tl0, tr0; // internal DC-filter state
 };
 
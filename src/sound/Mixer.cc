@@ -7,8 +7,11 @@
 #include "CliComm.hh"
 #include "CommandController.hh"
 #include "MSXException.hh"
+#include "Reactor.hh"
+#include "TclObject.hh"
 
 #include "one_of.hh"
+#include "outer.hh"
 #include "stl.hh"
 #include "unreachable.hh"
 
@@ -50,6 +53,7 @@ Mixer::Mixer(Reactor& reactor_, CommandController& commandController_)
 	, samplesSetting(
 		commandController, "samples",
 		"mixer samples", defaultSamples, 64, 8192)
+	, soundBufferInfo(reactor.getOpenMSXInfoCommand())
 {
 	muteSetting       .attach(*this);
 	frequencySetting  .attach(*this);
@@ -174,4 +178,37 @@ void Mixer::update(const Setting& setting) noexcept
 	}
 }
 
+
+// class SoundBufferInfoTopic
+
+Mixer::SoundBufferInfoTopic::SoundBufferInfoTopic(InfoCommand& openMSXInfoCommand)
+	: InfoTopic(openMSXInfoCommand, "sound_buffer")
+{
+}
+
+void Mixer::SoundBufferInfoTopic::execute(std::span<const TclObject> /*tokens*/,
+                                          TclObject& result) const
+{
+	auto& mixer = OUTER(Mixer, soundBufferInfo);
+	if (!mixer.driver) return;
+	auto stats = mixer.driver->getStats();
+	auto toMs = [&](unsigned samples) {
+		return 1000.0 * samples / mixer.driver->getFrequency();
+	};
+	result.addDictKeyValues("underruns",      stats.underruns,
+	                        "overruns",       stats.overruns,
+	                        "latency",        toMs(stats.latency),
+	                        "target_latency", toMs(stats.targetLatency));
+}
+
+std::string Mixer::SoundBufferInfoTopic::help(std::span<const TclObject> /*tokens*/) const
+{
+	return "Returns statistics about the buffer between the emulation and the "
+	       "sound output: the number of underruns (output ran dry, audible as "
+	       "a crackle) and overruns (samples dropped), and the currently "
+	       "buffered and the aimed for latency in milliseconds. The latency "
+	       "target adapts itself: it grows on underruns and slowly shrinks "
+	       "again when the output is stable.";
+}
+
 } // namespace openmsx
@@ -5,6 +5,7 @@
 #include "EnumSetting.hh"
 #include "IntegerSetting.hh"
 
+#include "InfoTopic.hh"
 #include "Observer.hh"
 
 #include <vector>
@@ -77,6 +78,13 @@ private:
 	IntegerSetting frequencySetting;
 	IntegerSetting samplesSetting;
 
+	struct SoundBufferInfoTopic final : InfoTopic {
+		explicit SoundBufferInfoTopic(InfoCommand& openMSXInfoCommand);
+		void execute(std::span<const TclObject> tokens,
+			     TclObject& result) const override;
+		[[nodiscard]] std::string help(std::span<const TclObject> tokens) const override;
+	} soundBufferInfo;
+
 	int muteCount = 0;
 };
 
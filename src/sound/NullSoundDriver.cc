@@ -24,4 +24,9 @@ void NullSoundDriver::uploadBuffer(std::span<const StereoFloat> /*buffer*/)
 {
 }
 
+SoundDriver::Stats NullSoundDriver::getStats() const
+{
+	return {};
+}
+
 } // namespace openmsx
@@ -15,6 +15,8 @@ public:
 	[[nodiscard]] unsigned getSamples() const override;
 
 	void uploadBuffer(std::span<const StereoFloat> buffer) override;
+
+	[[nodiscard]] Stats getStats() const override;
 };
 
 } // namespace openmsx
@@ -0,0 +1,303 @@
+#ifndef RESAMPLEHQKERNELS_HH
+#define RESAMPLEHQKERNELS_HH
+
+// The inner loop of ResampleHQ: the dot product of 'len' filter coefficients
+// with 'len' (mono or interleaved stereo) input samples. This takes the bulk
+// of the time of all resampled sound devices.
+//
+// 'tab' points to a row of the filter table. When REVERSE is true the row is
+// used back-to-front: coefficient 'i' is at 'tab[-i - 1]'.
+//
+// There's a plain c++ version (calcScalar) and SIMD versions for SSE2, AVX2
+// (+FMA) and (64-bit) NEON. calc() selects the best version that the
+// compiler is allowed to use. The SIMD versions sum in a different order
+// (and the AVX2/NEON versions use fused multiply-add), so the result is not
+// bit-exact with calcScalar(), but the difference is in the order of the
+// float rounding error (see ResampleHQKernels_test.cc).
+
+#include "one_of.hh"
+#include "xrange.hh"
+
+#include <cassert>
+#include <cstddef>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#define RESAMPLE_HQ_AVX2 1
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define RESAMPLE_HQ_NEON 1 // (32-bit ARM lacks vfmaq_f32 and vaddvq_f32)
+#endif
+
+namespace openmsx::ResampleHQKernels {
+
+template<unsigned CHANNELS, bool REVERSE>
+inline void calcScalar(const float* buf, const float* tab, size_t len, float* out)
+{
+	assert((len % 4) == 0);
+	for (auto ch : xrange(CHANNELS)) {
+		float r0 = 0.0f;
+		float r1 = 0.0f;
+		float r2 = 0.0f;
+		float r3 = 0.0f;
+		for (size_t i = 0; i < len; i += 4) {
+			if constexpr (REVERSE) {
+				r0 += tab[-ptrdiff_t(i) - 1] * buf[CHANNELS * (i + 0)];
+				r1 += tab[-ptrdiff_t(i) - 2] * buf[CHANNELS * (i + 1)];
+				r2 += tab[-ptrdiff_t(i) - 3] * buf[CHANNELS * (i + 2)];
+				r3 += tab[-ptrdiff_t(i) - 4] * buf[CHANNELS * (i + 3)];
+			} else {
+				r0 += tab[i + 0] * buf[CHANNELS * (i + 0)];
+				r1 += tab[i + 1] * buf[CHANNELS * (i + 1)];
+				r2 += tab[i + 2] * buf[CHANNELS * (i + 2)];
+				r3 += tab[i + 3] * buf[CHANNELS * (i + 3)];
+			}
+		}
+		out[ch] = r0 + r1 + r2 + r3;
+		++buf;
+	}
+}
+
+#ifdef __SSE2__
+
+inline __m128 reverse(__m128 x)
+{
+	return _mm_shuffle_ps(x, x, _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+// Load the 4 coefficients for taps [i .. i+3].
+template<bool REVERSE>
+inline __m128 loadTab4(const float* tab, size_t i)
+{
+	if constexpr (REVERSE) {
+		return reverse(_mm_loadu_ps(tab - i - 4));
+	} else {
+		return _mm_loadu_ps(tab + i);
+	}
+}
+
+template<int N> inline __m128 shuffle(__m128 x)
+{
+	return _mm_castsi128_ps(_mm_shuffle_epi32(_mm_castps_si128(x), N));
+}
+
+template<bool REVERSE>
+inline void calcSseMono(const float* buf, const float* tab, size_t len, float* out)
+{
+	assert((len % 4) == 0);
+
+	__m128 a0 = _mm_setzero_ps();
+	__m128 a1 = _mm_setzero_ps();
+	size_t i = 0;
+	for (; (i + 8) <= len; i += 8) {
+		a0 = _mm_add_ps(a0, _mm_mul_ps(_mm_loadu_ps(buf + i + 0), loadTab4<REVERSE>(tab, i + 0)));
+		a1 = _mm_add_ps(a1, _mm_mul_ps(_mm_loadu_ps(buf + i + 4), loadTab4<REVERSE>(tab, i + 4)));
+	}
+	if (i < len) {
+		a0 = _mm_add_ps(a0, _mm_mul_ps(_mm_loadu_ps(buf + i), loadTab4<REVERSE>(tab, i)));
+	}
+
+	__m128 a = _mm_add_ps(a0, a1);
+	// The following can be _slightly_ faster by using the SSE3 _mm_hadd_ps()
+	// intrinsic, but not worth the trouble.
+	__m128 t = _mm_add_ps(a, _mm_movehl_ps(a, a));
+	__m128 s = _mm_add_ss(t, _mm_shuffle_ps(t, t, 1));
+	_mm_store_ss(out, s);
+}
+
+template<bool REVERSE>
+inline void calcSseStereo(const float* buf, const float* tab, size_t len, float* out)
+{
+	assert((len % 4) == 0);
+
+	__m128 a0 = _mm_setzero_ps();
+	__m128 a1 = _mm_setzero_ps();
+	__m128 a2 = _mm_setzero_ps();
+	__m128 a3 = _mm_setzero_ps();
+	size_t i = 0;
+	for (; (i + 8) <= len; i += 8) {
+		__m128 ta = loadTab4<REVERSE>(tab, i + 0);
+		__m128 tb = loadTab4<REVERSE>(tab, i + 4);
+		a0 = _mm_add_ps(a0, _mm_mul_ps(_mm_loadu_ps(buf + 2 * i +  0), shuffle<0x50>(ta)));
+		a1 = _mm_add_ps(a1, _mm_mul_ps(_mm_loadu_ps(buf + 2 * i +  4), shuffle<0xFA>(ta)));
+		a2 = _mm_add_ps(a2, _mm_mul_ps(_mm_loadu_ps(buf + 2 * i +  8), shuffle<0x50>(tb)));
+		a3 = _mm_add_ps(a3, _mm_mul_ps(_mm_loadu_ps(buf + 2 * i + 12), shuffle<0xFA>(tb)));
+	}
+	if (i < len) {
+		__m128 ta = loadTab4<REVERSE>(tab, i);
+		a0 = _mm_add_ps(a0, _mm_mul_ps(_mm_loadu_ps(buf + 2 * i + 0), shuffle<0x50>(ta)));
+		a1 = _mm_add_ps(a1, _mm_mul_ps(_mm_loadu_ps(buf + 2 * i + 4), shuffle<0xFA>(ta)));
+	}
+
+	__m128 a01 = _mm_add_ps(a0, a1);
+	__m128 a23 = _mm_add_ps(a2, a3);
+	__m128 a   = _mm_add_ps(a01, a23);
+	// Can faster with SSE3, but (like above) not worth the trouble.
+	__m128 s = _mm_add_ps(a, _mm_movehl_ps(a, a));
+	_mm_store_ss(&out[0], s);
+	_mm_store_ss(&out[1], shuffle<0x55>(s));
+}
+
+#endif // __SSE2__
+
+#ifdef RESAMPLE_HQ_AVX2
+
+// Load the 8 coefficients for taps [i .. i+7].
+template<bool REVERSE>
+inline __m256 loadTab8(const float* tab, size_t i)
+{
+	if constexpr (REVERSE) {
+		return _mm256_permutevar8x32_ps(_mm256_loadu_ps(tab - i - 8),
+		                                _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+	} else {
+		return _mm256_loadu_ps(tab + i);
+	}
+}
+
+// Load the 4 coefficients for taps [i .. i+3], each one duplicated (to
+// multiply with interleaved stereo samples).
+template<bool REVERSE>
+inline __m256 loadTab4x2(const float* tab, size_t i)
+{
+	__m256 t = _mm256_castps128_ps256(_mm_loadu_ps(REVERSE ? (tab - i - 4) : (tab + i)));
+	auto idx = REVERSE ? _mm256_setr_epi32(3, 3, 2, 2, 1, 1, 0, 0)
+	                   : _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+	return _mm256_permutevar8x32_ps(t, idx);
+}
+
+template<bool REVERSE>
+inline void calcAvxMono(const float* buf, const float* tab, size_t len, float* out)
+{
+	assert((len % 4) == 0);
+
+	__m256 a0 = _mm256_setzero_ps();
+	__m256 a1 = _mm256_setzero_ps();
+	size_t i = 0;
+	for (; (i + 16) <= len; i += 16) {
+		a0 = _mm256_fmadd_ps(_mm256_loadu_ps(buf + i + 0), loadTab8<REVERSE>(tab, i + 0), a0);
+		a1 = _mm256_fmadd_ps(_mm256_loadu_ps(buf + i + 8), loadTab8<REVERSE>(tab, i + 8), a1);
+	}
+	if ((i + 8) <= len) {
+		a0 = _mm256_fmadd_ps(_mm256_loadu_ps(buf + i), loadTab8<REVERSE>(tab, i), a0);
+		i += 8;
+	}
+	__m256 a = _mm256_add_ps(a0, a1);
+	__m128 s = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+	if (i < len) {
+		s = _mm_fmadd_ps(_mm_loadu_ps(buf + i), loadTab4<REVERSE>(tab, i), s);
+	}
+
+	__m128 t = _mm_add_ps(s, _mm_movehl_ps(s, s));
+	_mm_store_ss(out, _mm_add_ss(t, _mm_shuffle_ps(t, t, 1)));
+}
+
+template<bool REVERSE>
+inline void calcAvxStereo(const float* buf, const float* tab, size_t len, float* out)
+{
+	assert((len % 4) == 0);
+
+	__m256 a0 = _mm256_setzero_ps();
+	__m256 a1 = _mm256_setzero_ps();
+	size_t i = 0;
+	for (; (i + 8) <= len; i += 8) {
+		a0 = _mm256_fmadd_ps(_mm256_loadu_ps(buf + 2 * i + 0), loadTab4x2<REVERSE>(tab, i + 0), a0);
+		a1 = _mm256_fmadd_ps(_mm256_loadu_ps(buf + 2 * i + 8), loadTab4x2<REVERSE>(tab, i + 4), a1);
+	}
+	if (i < len) {
+		a0 = _mm256_fmadd_ps(_mm256_loadu_ps(buf + 2 * i), loadTab4x2<REVERSE>(tab, i), a0);
+	}
+
+	// lanes are: left right left right ...
+	__m256 a = _mm256_add_ps(a0, a1);
+	__m128 s = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+	s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+	_mm_store_ss(&out[0], s);
+	_mm_store_ss(&out[1], shuffle<0x55>(s));
+}
+
+#endif // RESAMPLE_HQ_AVX2
+
+#ifdef RESAMPLE_HQ_NEON
+
+// Load the 4 coefficients for taps [i .. i+3].
+template<bool REVERSE>
+inline float32x4_t loadTab4(const float* tab, size_t i)
+{
+	if constexpr (REVERSE) {
+		float32x4_t t = vrev64q_f32(vld1q_f32(tab - i - 4));
+		return vextq_f32(t, t, 2);
+	} else {
+		return vld1q_f32(tab + i);
+	}
+}
+
+template<bool REVERSE>
+inline void calcNeonMono(const float* buf, const float* tab, size_t len, float* out)
+{
+	assert((len % 4) == 0);
+
+	float32x4_t a0 = vdupq_n_f32(0.0f);
+	float32x4_t a1 = vdupq_n_f32(0.0f);
+	size_t i = 0;
+	for (; (i + 8) <= len; i += 8) {
+		a0 = vfmaq_f32(a0, vld1q_f32(buf + i + 0), loadTab4<REVERSE>(tab, i + 0));
+		a1 = vfmaq_f32(a1, vld1q_f32(buf + i + 4), loadTab4<REVERSE>(tab, i + 4));
+	}
+	if (i < len) {
+		a0 = vfmaq_f32(a0, vld1q_f32(buf + i), loadTab4<REVERSE>(tab, i));
+	}
+	*out = vaddvq_f32(vaddq_f32(a0, a1));
+}
+
+template<bool REVERSE>
+inline void calcNeonStereo(const float* buf, const float* tab, size_t len, float* out)
+{
+	assert((len % 4) == 0);
+
+	float32x4_t a0 = vdupq_n_f32(0.0f);
+	float32x4_t a1 = vdupq_n_f32(0.0f);
+	for (size_t i = 0; i < len; i += 4) {
+		float32x4_t t = loadTab4<REVERSE>(tab, i);
+		a0 = vfmaq_f32(a0, vld1q_f32(buf + 2 * i + 0), vzip1q_f32(t, t));
+		a1 = vfmaq_f32(a1, vld1q_f32(buf + 2 * i + 4), vzip2q_f32(t, t));
+	}
+	// lanes are: left right left right
+	float32x4_t a = vaddq_f32(a0, a1);
+	vst1_f32(out, vadd_f32(vget_low_f32(a), vget_high_f32(a)));
+}
+
+#endif // RESAMPLE_HQ_NEON
+
+template<unsigned CHANNELS, bool REVERSE>
+inline void calc(const float* buf, const float* tab, size_t len, float* out)
+{
+	static_assert(CHANNELS == one_of(1u, 2u));
+#if defined(RESAMPLE_HQ_AVX2)
+	if constexpr (CHANNELS == 1) {
+		calcAvxMono   <REVERSE>(buf, tab, len, out);
+	} else {
+		calcAvxStereo <REVERSE>(buf, tab, len, out);
+	}
+#elif defined(__SSE2__)
+	if constexpr (CHANNELS == 1) {
+		calcSseMono   <REVERSE>(buf, tab, len, out);
+	} else {
+		calcSseStereo <REVERSE>(buf, tab, len, out);
+	}
+#elif defined(RESAMPLE_HQ_NEON)
+	if constexpr (CHANNELS == 1) {
+		calcNeonMono  <REVERSE>(buf, tab, len, out);
+	} else {
+		calcNeonStereo<REVERSE>(buf, tab, len, out);
+	}
+#else
+	calcScalar<CHANNELS, REVERSE>(buf, tab, len, out);
+#endif
+}
+
+} // namespace openmsx::ResampleHQKernels
+
+#endif
@@ -9,8 +9,11 @@
 #include "MSXMotherBoard.hh"
 #include "Reactor.hh"
 
+#include "aligned.hh"
 #include "unreachable.hh"
 
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <memory>
 
@@ -43,6 +46,22 @@ bool ResampledSoundDevice::updateBuffer(size_t length, float* buffer,
 	return algo->generateOutput(buffer, length, time);
 }
 
+void ResampledSoundDevice::skipBuffer(size_t /*length*/, EmuTime::param time)
+{
+	// Only generate the input samples (this advances the emulated chip),
+	// there's no need to resample them. The resampler is recreated (see
+	// createResampler()) before the output is used again.
+	unsigned emuNum = emuClock.getTicksTill(time);
+	ALIGNAS_SSE std::array<float, 2 * 1024 + 3> buf; // stereo, +3 see generateInput()
+	while (emuNum > 0) {
+		unsigned num = std::min(emuNum, 1024u);
+		bool ignore = generateInput(buf.data(), num);
+		(void)ignore;
+		emuClock += num;
+		emuNum -= num;
+	}
+}
+
 bool ResampledSoundDevice::generateInput(float* buffer, size_t num)
 {
 	return mixChannels(buffer, num);
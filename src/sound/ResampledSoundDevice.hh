@@ -39,6 +39,7 @@ protected:
 	void setOutputRate(unsigned hostSampleRate, double speed) override;
 	bool updateBuffer(size_t length, float* buffer,
 	                  EmuTime::param time) override;
+	void skipBuffer(size_t length, EmuTime::param time) override;
 
 	// Observer<Setting>
 	void update(const Setting& setting) noexcept override;
@@ -40,8 +40,13 @@ SDLSoundDriver::SDLSoundDriver(Reactor& reactor_,
 	frequency = obtained.freq;
 	fragmentSize = obtained.samples;
 
-	mixBufferSize = narrow<unsigned>(3 * (obtained.size / sizeof(StereoFloat)) + 1);
-	mixBuffer.resize(mixBufferSize);
+	// Initially aim for the same latency as a fixed buffer of 3 fragments,
+	// but allow to go a bit lower when that turns out to be stable, and a
+	// lot higher when the output runs dry.
+	minTarget = 2 * fragmentSize;
+	maxTarget = 8 * fragmentSize;
+	targetFill = 3 * fragmentSize;
+	mixBuffer.resize(maxTarget);
 	reInit();
 }
 
@@ -52,9 +57,11 @@ SDLSoundDriver::~SDLSoundDriver()
 
 void SDLSoundDriver::reInit()
 {
+	// Only called while the audio device is paused, the lock is just to be
+	// sure the callback isn't still running.
 	SDL_LockAudioDevice(deviceID);
-	readIdx  = 0;
-	writeIdx = 0;
+	mixBuffer.clear();
+	started = false;
 	SDL_UnlockAudioDevice(deviceID);
 }
 
@@ -93,81 +100,78 @@ void SDLSoundDriver::audioCallbackHelper(void* userdata, uint8_t* strm, int len)
 		                        len / (2 * sizeof(float))});
 }
 
-unsigned SDLSoundDriver::getBufferFilled() const
-{
-	int result = narrow_cast<int>(writeIdx - readIdx);
-	if (result < 0) result += narrow<int>(mixBufferSize);
-	assert((0 <= result) && (narrow<unsigned>(result) < mixBufferSize));
-	return result;
-}
-
-unsigned SDLSoundDriver::getBufferFree() const
+void SDLSoundDriver::audioCallback(std::span<StereoFloat> stream)
 {
-	// we can't distinguish completely filled from completely empty
-	// (in both cases readIx would be equal to writeIdx), so instead
-	// we define full as '(writeIdx + 1) == readIdx'.
-	unsigned result = mixBufferSize - 1 - getBufferFilled();
-	assert(narrow_cast<int>(result) >= 0);
-	assert(result < mixBufferSize);
-	return result;
+	// Runs on the SDL audio thread: no locks, no waiting.
+	auto num = mixBuffer.pop(stream);
+	if (num < stream.size()) {
+		// buffer underrun
+		if (started.load(std::memory_order_relaxed)) {
+			underruns.fetch_add(1, std::memory_order_relaxed);
+		}
+		ranges::fill(stream.subspan(num), StereoFloat{});
+	}
 }
 
-void SDLSoundDriver::audioCallback(std::span<StereoFloat> stream)
+// Grow the target fill level as soon as an underrun is observed, shrink it
+// slowly again after a long stretch without underruns. So on a host that
+// can't keep up with a low latency setting we trade latency for glitch-free
+// output, but we don't keep a high latency forever because of a single
+// hiccup (e.g. loading a big file).
+void SDLSoundDriver::adaptLatency(size_t newSamples)
 {
-	auto len = stream.size();
+	static constexpr unsigned STABLE_SECONDS = 10;
 
-	size_t available = getBufferFilled();
-	auto num = narrow<unsigned>(std::min(len, available));
-	if ((readIdx + num) < mixBufferSize) {
-		ranges::copy(std::span{&mixBuffer[readIdx], num}, stream);
-		readIdx += num;
+	auto u = underruns.load(std::memory_order_relaxed);
+	if (u != seenUnderruns) {
+		seenUnderruns = u;
+		targetFill = std::min(targetFill + fragmentSize, maxTarget);
+		stableSamples = 0;
 	} else {
-		unsigned len1 = mixBufferSize - readIdx;
-		ranges::copy(std::span{&mixBuffer[readIdx], len1}, stream);
-		unsigned len2 = num - len1;
-		ranges::copy(std::span{&mixBuffer[0], len2}, stream.subspan(len1));
-		readIdx = len2;
-	}
-	auto missing = narrow_cast<ptrdiff_t>(len - available);
-	if (missing > 0) {
-		// buffer underrun
-		ranges::fill(subspan(stream, available, missing), StereoFloat{});
+		stableSamples += newSamples;
+		if (stableSamples >= uint64_t(STABLE_SECONDS) * frequency) {
+			stableSamples = 0;
+			targetFill = std::max(targetFill - fragmentSize / 8, minTarget);
+		}
 	}
 }
 
 void SDLSoundDriver::uploadBuffer(std::span<const StereoFloat> buffer)
 {
-	SDL_LockAudioDevice(deviceID);
-	unsigned free = getBufferFree();
-	if (buffer.size() > free) {
+	adaptLatency(buffer.size());
+	if (buffer.size() > maxTarget) {
+		// can't ever fit, keep the most recent samples
+		++overruns;
+		buffer = buffer.last(maxTarget);
+	}
+	auto limit = std::max<size_t>(buffer.size(), targetFill);
+	if (mixBuffer.size() + buffer.size() > limit) {
 		auto* board = reactor.getMotherBoard();
 		if (board && !board->getMSXMixer().isSynchronousMode() && // when not recording
 		    reactor.getGlobalSettings().getThrottleManager().isThrottled()) {
 			do {
-				SDL_UnlockAudioDevice(deviceID);
 				Timer::sleep(5000); // 5ms
-				SDL_LockAudioDevice(deviceID);
 				board->getRealTime().resync();
-				free = getBufferFree();
-			} while (buffer.size() > free);
+			} while (mixBuffer.size() + buffer.size() > limit);
 		} else {
 			// drop excess samples
-			buffer = buffer.subspan(0, free);
+			++overruns;
+			buffer = buffer.first(limit - std::min(limit, mixBuffer.size()));
 		}
 	}
-	assert(buffer.size() <= free);
-	if ((writeIdx + buffer.size()) < mixBufferSize) {
-		ranges::copy(buffer, &mixBuffer[writeIdx]);
-		writeIdx += narrow<unsigned>(buffer.size());
-	} else {
-		unsigned len1 = mixBufferSize - writeIdx;
-		ranges::copy(buffer.subspan(0, len1), &mixBuffer[writeIdx]);
-		unsigned len2 = narrow<unsigned>(buffer.size()) - len1;
-		ranges::copy(buffer.subspan(len1, len2), &mixBuffer[0]);
-		writeIdx = len2;
-	}
+	[[maybe_unused]] auto num = mixBuffer.push(buffer);
+	assert(num == buffer.size());
+	started.store(true, std::memory_order_relaxed);
+}
 
-	SDL_UnlockAudioDevice(deviceID);
+SoundDriver::Stats SDLSoundDriver::getStats() const
+{
+	return {
+		.underruns = underruns.load(std::memory_order_relaxed),
+		.overruns = overruns,
+		.latency = narrow<unsigned>(mixBuffer.size()),
+		.targetLatency = targetFill,
+	};
 }
 
 } // namespace openmsx
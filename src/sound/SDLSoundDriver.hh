@@ -5,9 +5,11 @@
 
 #include "SDLSurfacePtr.hh"
 
-#include "MemBuffer.hh"
+#include "SPSCRingBuffer.hh"
 
 #include <SDL.h>
+#include <atomic>
+#include <cstdint>
 
 namespace openmsx {
 
@@ -31,21 +33,40 @@ public:
 
 	void uploadBuffer(std::span<const StereoFloat> buffer) override;
 
+	[[nodiscard]] Stats getStats() const override;
+
 private:
 	void reInit();
-	[[nodiscard]] unsigned getBufferFilled() const;
-	[[nodiscard]] unsigned getBufferFree() const;
+	void adaptLatency(size_t newSamples);
 	static void audioCallbackHelper(void* userdata, uint8_t* strm, int len);
 	void audioCallback(std::span<StereoFloat> stream);
 
 private:
 	Reactor& reactor;
 	SDL_AudioDeviceID deviceID;
-	MemBuffer<StereoFloat> mixBuffer;
-	unsigned mixBufferSize;
 	unsigned frequency;
 	unsigned fragmentSize;
-	unsigned readIdx, writeIdx;
+
+	// Samples from the emulation thread to the SDL audio thread. The
+	// ring buffer itself is lock-free, so neither side ever has to wait
+	// for the other.
+	SPSCRingBuffer<StereoFloat> mixBuffer;
+
+	// Adaptive latency (only accessed from the emulation thread): the
+	// amount of buffered samples we aim for, see adaptLatency().
+	unsigned minTarget;
+	unsigned maxTarget;
+	unsigned targetFill;
+	unsigned seenUnderruns = 0;
+	uint64_t stableSamples = 0;
+	unsigned overruns = 0;
+
+	// Written by the audio thread.
+	std::atomic<unsigned> underruns = 0;
+	// Set when the first samples after reInit() are uploaded, before that
+	// an empty buffer is not an underrun.
+	std::atomic<bool> started = false;
+
 	bool muted = true;
 	[[no_unique_address]] SDLSubSystemInitializer<SDL_INIT_AUDIO> audioInitializer;
 };
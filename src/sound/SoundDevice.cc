@@ -184,6 +184,16 @@ std::span<const float> SoundDevice::getLastBuffer(unsigned channel)
 	return {&buf.buffer[buf.stopIdx - requestedSize], requestedSize};
 }
 
+void SoundDevice::skipBuffer(size_t length, EmuTime::param time)
+{
+	// Room for stereo output, +3 to allow processing samples in groups
+	// of 4 (see updateBuffer()).
+	assert(length <= 8192);
+	inplace_buffer<float, 2 * (8192 + 3)> buf(uninitialized_tag{}, 2 * (length + 3));
+	bool ignore = updateBuffer(length, buf.data(), time);
+	(void)ignore;
+}
+
 bool SoundDevice::mixChannels(float* dataOut, size_t samples)
 {
 #ifdef __SSE2__
@@ -195,6 +195,18 @@ public: // Will be called by Mixer:
 	[[nodiscard]] virtual bool updateBuffer(size_t length, float* buffer,
 	                                        EmuTime::param time) = 0;
 
+	/** Advance the device till the given time without producing output.
+	  * @param length The number of samples that are skipped
+	  * @param time current time
+	  *
+	  * This is called by the Mixer instead of updateBuffer() while sound
+	  * synthesis is skipped (turbo mode). The emulated state of the device
+	  * must still advance (e.g. VLM5030 depends on this to update its BSY
+	  * pin), only the output can be dropped. The default implementation
+	  * calls updateBuffer() and ignores the result.
+	  */
+	virtual void skipBuffer(size_t length, EmuTime::param time);
+
 protected:
 	/** Adds a number of samples that all have the same value.
 	  * Can be used to synthesize segments of a square wave.
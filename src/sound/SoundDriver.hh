@@ -31,6 +31,17 @@ public:
 
 	virtual void uploadBuffer(std::span<const StereoFloat> buffer) = 0;
 
+	struct Stats {
+		unsigned underruns = 0; // number of times the output ran dry
+		unsigned overruns = 0;  // number of times samples were dropped
+		unsigned latency = 0;       // currently buffered samples
+		unsigned targetLatency = 0; // aimed for buffered samples
+	};
+	/** Statistics about the output buffer, for the 'sound_buffer' info
+	  * topic. Counters are cumulative over the lifetime of the driver.
+	  */
+	[[nodiscard]] virtual Stats getStats() const = 0;
+
 protected:
 	SoundDriver() = default;
 };
@@ -5,6 +5,7 @@
 namespace openmsx::Thread {
 
 static std::thread::id mainThreadId;
+static thread_local bool mainThreadRole = false;
 
 void setMainThread()
 {
@@ -13,9 +14,25 @@ void setMainThread()
 }
 
 bool isMainThread()
+{
+	return isRealMainThread() || mainThreadRole;
+}
+
+bool isRealMainThread()
 {
 	assert(mainThreadId != std::thread::id());
 	return mainThreadId == std::this_thread::get_id();
 }
 
+ScopedMainThreadRole::ScopedMainThreadRole()
+{
+	assert(!isMainThread());
+	mainThreadRole = true;
+}
+
+ScopedMainThreadRole::~ScopedMainThreadRole()
+{
+	mainThreadRole = false;
+}
+
 } // namespace openmsx::Thread
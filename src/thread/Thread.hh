@@ -9,10 +9,40 @@ namespace openmsx::Thread {
 	  */
 	void setMainThread();
 
-	/** Returns true when called from the main thread.
+	/** Returns true when called from the main thread, or from a thread
+	  * that temporarily acts as the main thread (see ScopedMainThreadRole).
+	  * Use this for state that belongs to a single machine (Scheduler,
+	  * CPU loop), and for global state that is only read and that the
+	  * (blocked) real main thread can't change (the active machine).
 	  */
 	[[nodiscard]] bool isMainThread();
 
+	/** Like isMainThread(), but doesn't count ScopedMainThreadRole.
+	  * Use this for global state that gets modified (switching machines,
+	  * event delivery, GlobalCliComm).
+	  */
+	[[nodiscard]] bool isRealMainThread();
+
+	/** While an object of this class exists, the current thread counts as
+	  * the main thread, but only for the state of the machine it runs
+	  * (see isMainThread() vs isRealMainThread()). This is only allowed
+	  * while the real main thread is blocked waiting for this thread, and
+	  * only for one machine per thread that doesn't touch anything outside
+	  * that machine. ATM the only user is MSXMotherBoard::batchRun() (see
+	  * BatchRunCommand), which requires real-time sync disabled, the mixer
+	  * muted and the machine's CliComm deferred.
+	  */
+	class ScopedMainThreadRole
+	{
+	public:
+		ScopedMainThreadRole();
+		~ScopedMainThreadRole();
+		ScopedMainThreadRole(const ScopedMainThreadRole&) = delete;
+		ScopedMainThreadRole(ScopedMainThreadRole&&) = delete;
+		ScopedMainThreadRole& operator=(const ScopedMainThreadRole&) = delete;
+		ScopedMainThreadRole& operator=(ScopedMainThreadRole&&) = delete;
+	};
+
 } // namespace openmsx::Thread
 
 #endif
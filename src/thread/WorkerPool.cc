@@ -0,0 +1,81 @@
+#include "WorkerPool.hh"
+
+#include "xrange.hh"
+
+#include <algorithm>
+#include <cassert>
+
+namespace openmsx {
+
+WorkerPool::WorkerPool(unsigned numThreads)
+{
+	setNumThreads(numThreads);
+}
+
+WorkerPool::~WorkerPool()
+{
+	stopThreads();
+}
+
+void WorkerPool::setNumThreads(unsigned numThreads)
+{
+	numThreads = std::max(numThreads, 1u);
+	if (numThreads == getNumThreads()) return;
+
+	stopThreads();
+	for (auto part : xrange(1u, numThreads)) {
+		threads.emplace_back([this, part, g = generation]() { workerLoop(part, g); });
+	}
+}
+
+void WorkerPool::stopThreads()
+{
+	{
+		std::lock_guard lock(mutex);
+		stopping = true;
+	}
+	workAvailable.notify_all();
+	for (auto& t : threads) t.join();
+	threads.clear();
+	stopping = false;
+}
+
+void WorkerPool::workerLoop(unsigned part, unsigned seenGeneration)
+{
+	std::unique_lock lock(mutex);
+	while (true) {
+		workAvailable.wait(lock, [&] { return stopping || (generation != seenGeneration); });
+		if (stopping) break;
+		seenGeneration = generation;
+		if (part >= currentParts) continue; // not needed for this job
+		lock.unlock();
+		(*currentJob)(part); // doesn't change while 'pending != 0'
+		lock.lock();
+		if (--pending == 0) workDone.notify_one();
+	}
+}
+
+void WorkerPool::run(unsigned numParts, const std::function<void(unsigned)>& job)
+{
+	assert(1 <= numParts);
+	assert(numParts <= getNumThreads());
+	if (numParts == 1) {
+		job(0);
+		return;
+	}
+	{
+		std::lock_guard lock(mutex);
+		currentJob = &job;
+		currentParts = numParts;
+		pending = numParts - 1;
+		++generation;
+	}
+	workAvailable.notify_all();
+	job(0);
+
+	std::unique_lock lock(mutex);
+	workDone.wait(lock, [&] { return pending == 0; });
+	currentJob = nullptr;
+}
+
+} // namespace openmsx
@@ -0,0 +1,58 @@
+#ifndef WORKERPOOL_HH
+#define WORKERPOOL_HH
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace openmsx {
+
+/** A small set of helper threads to split a (CPU-bound) job in a few parts
+  * that are executed in parallel, e.g. horizontal bands of an image. The
+  * threads are kept alive between jobs, so that starting a job is cheap.
+  */
+class WorkerPool
+{
+public:
+	/** @param numThreads Number of threads that can execute a job, this
+	  *                   includes the calling thread (so 1 means no helper
+	  *                   threads are created).
+	  */
+	explicit WorkerPool(unsigned numThreads = 1);
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool(WorkerPool&&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+	WorkerPool& operator=(WorkerPool&&) = delete;
+	~WorkerPool();
+
+	void setNumThreads(unsigned numThreads);
+	[[nodiscard]] unsigned getNumThreads() const { return unsigned(threads.size()) + 1; }
+
+	/** Calls 'job(i)' for each 'i' in [0, numParts), each on a different
+	  * thread. 'job(0)' is executed on the calling thread. Returns when
+	  * all parts are done.
+	  * @pre 1 <= numParts <= getNumThreads()
+	  */
+	void run(unsigned numParts, const std::function<void(unsigned)>& job);
+
+private:
+	void stopThreads();
+	void workerLoop(unsigned part, unsigned seenGeneration);
+
+private:
+	std::vector<std::thread> threads;
+	std::mutex mutex; // protects the members below
+	std::condition_variable workAvailable;
+	std::condition_variable workDone;
+	const std::function<void(unsigned)>* currentJob = nullptr;
+	unsigned currentParts = 0;
+	unsigned generation = 0; // incremented for each new job
+	unsigned pending = 0; // number of helper threads still working on the job
+	bool stopping = false;
+};
+
+} // namespace openmsx
+
+#endif
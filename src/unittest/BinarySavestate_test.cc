@@ -0,0 +1,198 @@
+#include "catch.hpp"
+
+#include "BinarySavestate.hh"
+#include "DeltaBlock.hh"
+#include "File.hh"
+#include "FileOperations.hh"
+#include "MSXException.hh"
+#include "serialize.hh"
+
+#include "ranges.hh"
+#include "xrange.hh"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace openmsx;
+
+// Somewhat realistic memory content: partly compressible, partly not.
+static std::vector<uint8_t> makeData(size_t size, uint32_t seed)
+{
+	std::vector<uint8_t> result(size);
+	for (auto i : xrange(size)) {
+		seed = seed * 1664525 + 1013904223;
+		result[i] = ((i / 1024) % 4 == 0) ? uint8_t(seed >> 24) : uint8_t(i / 64);
+	}
+	return result;
+}
+
+static std::vector<uint8_t> readFile(const std::string& filename)
+{
+	File file(filename);
+	auto content = file.mmap();
+	return {content.begin(), content.end()};
+}
+
+static std::string getTempFile(const char* name)
+{
+	auto tmp = FileOperations::getTempDir() + "/binarysavestate_unittest";
+	FileOperations::mkdirp(tmp);
+	return tmp + '/' + name;
+}
+
+TEST_CASE("BinarySavestate")
+{
+	auto filename = getTempFile("test.oms");
+
+	auto state = makeData(1000, 1);
+	std::vector<std::vector<uint8_t>> data = {
+		makeData(0x10000, 2),
+		std::vector<uint8_t>(0x4000, 0xff), // very compressible
+		makeData(100, 3),
+	};
+	for (auto& b : data[2]) b = uint8_t(b * 73); // not compressible
+
+	LastDeltaBlocks lastDeltaBlocks;
+	std::vector<std::shared_ptr<DeltaBlock>> blocks;
+	for (const auto& d : data) {
+		blocks.push_back(lastDeltaBlocks.createNew(&d, d));
+	}
+	BinarySavestate::save(filename, state, blocks);
+	CHECK(BinarySavestate::isBinarySavestate(filename));
+
+	{
+		BinarySavestate loaded(filename);
+		CHECK(std::ranges::equal(loaded.getSavestate(), state));
+		REQUIRE(loaded.getBlocks().size() == data.size());
+		for (auto i : xrange(data.size())) {
+			const auto& block = loaded.getBlocks()[i];
+			std::vector<uint8_t> buf(data[i].size());
+			CHECK(block->getSize() == buf.size());
+			block->apply(buf);
+			CHECK(buf == data[i]);
+		}
+	}
+
+	SECTION("corrupt block data") {
+		auto copy = readFile(filename);
+		copy[copy.size() - 50] ^= 1; // in the last block
+		File(filename, File::OpenMode::TRUNCATE).write(copy);
+		// only detected when that block is used
+		BinarySavestate loaded(filename);
+		const auto& blocks2 = loaded.getBlocks();
+		std::vector<uint8_t> buf(data[0].size());
+		blocks2[0]->apply(buf);
+		CHECK(buf == data[0]);
+		buf.resize(data[2].size());
+		CHECK_THROWS_AS(blocks2[2]->apply(buf), MSXException);
+	}
+	SECTION("blocks that are already compressed") {
+		// Their lz4 data is written as-is, the result must be the same.
+		LastDeltaBlocks lastDeltaBlocks2;
+		std::vector<std::shared_ptr<DeltaBlock>> blocks2;
+		for (const auto& d : data) {
+			auto block = lastDeltaBlocks2.createNew(&d, d);
+			if (auto* copy = dynamic_cast<DeltaBlockCopy*>(block.get())) {
+				copy->compress(d.size());
+			}
+			blocks2.push_back(block);
+		}
+		auto filename2 = getTempFile("test2.oms");
+		BinarySavestate::save(filename2, state, blocks2);
+		CHECK(readFile(filename2) == readFile(filename));
+		FileOperations::unlink(filename2);
+	}
+	SECTION("truncated") {
+		auto copy = readFile(filename);
+		copy.resize(copy.size() / 2);
+		File(filename, File::OpenMode::TRUNCATE).write(copy);
+		CHECK_THROWS_AS(BinarySavestate(filename), MSXException);
+	}
+	SECTION("not a binary savestate") {
+		File(filename, File::OpenMode::TRUNCATE).write(std::span{state}.first(100));
+		CHECK(!BinarySavestate::isBinarySavestate(filename));
+		CHECK_THROWS_AS(BinarySavestate(filename), MSXException);
+	}
+
+	FileOperations::unlink(filename);
+}
+
+namespace {
+	// Something that looks like (a part of) a machine: a few small members
+	// and some large blobs, which end up in separate sections.
+	struct Machine {
+		uint32_t counter = 0;
+		std::vector<uint8_t> ram = std::vector<uint8_t>(0x10000);
+		std::vector<uint8_t> vram = std::vector<uint8_t>(0x4000);
+
+		template<typename Archive>
+		void serialize(Archive& ar, unsigned /*version*/)
+		{
+			ar.serialize("counter", counter);
+			ar.serialize_blob("ram", std::span{ram});
+			ar.serialize_blob("vram", std::span{vram});
+		}
+	};
+}
+
+TEST_CASE("BinarySavestate: round trip")
+{
+	auto filename = getTempFile("roundtrip.oms");
+
+	Machine m1;
+	m1.counter = 12345;
+	m1.ram = makeData(m1.ram.size(), 4);
+	m1.vram = makeData(m1.vram.size(), 5);
+	{
+		// same as 'store_machine -binary'
+		LastDeltaBlocks lastDeltaBlocks;
+		std::vector<std::shared_ptr<DeltaBlock>> deltaBlocks;
+		MemOutputArchive out(lastDeltaBlocks, deltaBlocks, false);
+		out.serialize("machine", m1);
+		size_t size;
+		auto buf = out.releaseBuffer(size);
+		BinarySavestate::save(filename, std::span{buf.data(), size}, deltaBlocks);
+	}
+	// same as 'restore_machine'
+	auto restore = [&](Machine& m) {
+		BinarySavestate state(filename);
+		auto savestate = state.getSavestate();
+		MemInputArchive in(savestate.data(), savestate.size(), state.getBlocks());
+		in.serialize("machine", m);
+	};
+
+	SECTION("intact") {
+		Machine m2;
+		restore(m2);
+		CHECK(m2.counter == m1.counter);
+		CHECK(m2.ram == m1.ram);
+		CHECK(m2.vram == m1.vram);
+	}
+	SECTION("corrupt section") {
+		// Corrupt the vram section (the last one in the file). Opening
+		// the file doesn't check it, it's reported when it's used.
+		auto copy = readFile(filename);
+		copy[copy.size() - 100] ^= 0x40;
+		File(filename, File::OpenMode::TRUNCATE).write(copy);
+
+		BinarySavestate state(filename);
+		REQUIRE(state.getBlocks().size() == 2);
+		std::vector<uint8_t> buf(m1.ram.size());
+		state.getBlocks()[0]->apply(buf);
+		CHECK(buf == m1.ram);
+
+		Machine m2;
+		try {
+			restore(m2);
+			FAIL("corrupt section not detected");
+		} catch (MSXException& e) {
+			CHECK(e.getMessage() == "Invalid binary savestate: corrupt data");
+		}
+		// everything before the corrupt section was restored
+		CHECK(m2.counter == m1.counter);
+		CHECK(m2.ram == m1.ram);
+	}
+
+	FileOperations::unlink(filename);
+}
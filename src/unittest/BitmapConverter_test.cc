@@ -0,0 +1,244 @@
+#include "catch.hpp"
+#include "BitmapConverter.hh"
+
+#include "narrow.hh"
+#include "ranges.hh"
+#include "xrange.hh"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+using Pixel = BitmapConverter::Pixel;
+
+namespace {
+
+struct Palettes
+{
+	explicit Palettes(unsigned seed)
+	{
+		std::minstd_rand gen(seed);
+		auto fill = [&](auto& pal) { for (auto& p : pal) p = Pixel(gen()) ^ Pixel(gen() << 16); };
+		fill(palette16);
+		fill(palette256);
+		fill(palette32768);
+	}
+
+	std::array<Pixel, 16 * 2> palette16;
+	std::array<Pixel, 256> palette256;
+	std::vector<Pixel> palette32768 = std::vector<Pixel>(32768);
+
+	[[nodiscard]] BitmapConverter createConverter() const
+	{
+		return {palette16, palette256, std::span<const Pixel, 32768>(palette32768)};
+	}
+};
+
+struct VramLine
+{
+	explicit VramLine(unsigned seed)
+	{
+		std::minstd_rand gen(seed);
+		for (auto& b : plane0) b = byte(gen());
+		for (auto& b : plane1) b = byte(gen());
+	}
+	std::array<byte, 128> plane0;
+	std::array<byte, 128> plane1;
+};
+
+// Same formulas as the plain c++ versions in BitmapConverter.cc, but written
+// per pixel, without any tricks.
+std::vector<Pixel> referenceGraphic4(const Palettes& p, const VramLine& v)
+{
+	std::vector<Pixel> result;
+	for (auto b : v.plane0) {
+		result.push_back(p.palette16[b >> 4]);
+		result.push_back(p.palette16[b & 15]);
+	}
+	return result;
+}
+
+std::vector<Pixel> referenceGraphic5(const Palettes& p, const VramLine& v)
+{
+	std::vector<Pixel> result;
+	for (auto b : v.plane0) {
+		result.push_back(p.palette16[ 0 + ((b >> 6) & 3)]);
+		result.push_back(p.palette16[16 + ((b >> 4) & 3)]);
+		result.push_back(p.palette16[ 0 + ((b >> 2) & 3)]);
+		result.push_back(p.palette16[16 + ((b >> 0) & 3)]);
+	}
+	return result;
+}
+
+std::vector<Pixel> referenceGraphic6(const Palettes& p, const VramLine& v)
+{
+	std::vector<Pixel> result;
+	for (auto i : xrange(128)) {
+		result.push_back(p.palette16[v.plane0[i] >> 4]);
+		result.push_back(p.palette16[v.plane0[i] & 15]);
+		result.push_back(p.palette16[v.plane1[i] >> 4]);
+		result.push_back(p.palette16[v.plane1[i] & 15]);
+	}
+	return result;
+}
+
+std::vector<Pixel> referenceGraphic7(const Palettes& p, const VramLine& v)
+{
+	std::vector<Pixel> result;
+	for (auto i : xrange(128)) {
+		result.push_back(p.palette256[v.plane0[i]]);
+		result.push_back(p.palette256[v.plane1[i]]);
+	}
+	return result;
+}
+
+std::vector<Pixel> referenceYJK(const Palettes& p, const VramLine& v, bool yae)
+{
+	std::vector<Pixel> result;
+	for (auto i : xrange(64)) {
+		std::array<int, 4> d = {
+			v.plane0[2 * i + 0], v.plane1[2 * i + 0],
+			v.plane0[2 * i + 1], v.plane1[2 * i + 1],
+		};
+		// 6-bit two's complement
+		auto get6 = [](int lo, int hi) {
+			int x = (lo & 7) | ((hi & 7) << 3);
+			return (x >= 32) ? (x - 64) : x;
+		};
+		int k = get6(d[0], d[1]);
+		int j = get6(d[2], d[3]);
+		for (auto n : xrange(4)) {
+			if (yae && (d[n] & 8)) {
+				result.push_back(p.palette16[d[n] >> 4]);
+			} else {
+				int y = d[n] >> 3;
+				int r = std::clamp(y + j, 0, 31);
+				int g = std::clamp(y + k, 0, 31);
+				int b = std::clamp((5 * y - 2 * j - k + 2) / 4, 0, 31);
+				result.push_back(p.palette32768[(r << 10) + (g << 5) + b]);
+			}
+		}
+	}
+	return result;
+}
+
+struct Mode
+{
+	const char* name;
+	DisplayMode mode;
+	bool planar;
+	unsigned width;
+};
+
+// reg0, reg1, reg25
+const std::array modes = {
+	Mode{"Graphic 4", DisplayMode(0x06, 0, 0x00), false, 256},
+	Mode{"Graphic 5", DisplayMode(0x08, 0, 0x00), false, 512},
+	Mode{"Graphic 6", DisplayMode(0x0A, 0, 0x00), true,  512},
+	Mode{"Graphic 7", DisplayMode(0x0E, 0, 0x00), true,  256},
+	Mode{"YJK",       DisplayMode(0x0E, 0, 0x08), true,  256},
+	Mode{"YJK+YAE",   DisplayMode(0x0E, 0, 0x18), true,  256},
+};
+
+std::vector<Pixel> reference(const Mode& m, const Palettes& p, const VramLine& v)
+{
+	switch (m.mode.getByte()) {
+	case DisplayMode::GRAPHIC4: return referenceGraphic4(p, v);
+	case DisplayMode::GRAPHIC5: return referenceGraphic5(p, v);
+	case DisplayMode::GRAPHIC6: return referenceGraphic6(p, v);
+	case DisplayMode::GRAPHIC7: return referenceGraphic7(p, v);
+	case DisplayMode::GRAPHIC7 | DisplayMode::YJK: return referenceYJK(p, v, false);
+	default: return referenceYJK(p, v, true);
+	}
+}
+
+void convert(BitmapConverter& converter, const Mode& m, const VramLine& v, std::span<Pixel> buf)
+{
+	if (m.planar) {
+		converter.convertLinePlanar(buf, v.plane0, v.plane1);
+	} else {
+		converter.convertLine(buf, v.plane0);
+	}
+}
+
+} // namespace
+
+TEST_CASE("BitmapConverter")
+{
+	for (auto seed : xrange(20u)) {
+		Palettes palettes(seed);
+		auto converter = palettes.createConverter();
+		VramLine vram(seed + 1000);
+		if (seed == 0) {
+			// all bits set resp. cleared, extremes for YJK
+			ranges::fill(vram.plane0, byte(0xFF));
+			ranges::fill(vram.plane1, byte(0x00));
+		}
+		for (const auto& m : modes) {
+			INFO(m.name << " seed=" << seed);
+			converter.setDisplayMode(m.mode);
+			// one extra pixel, to check it's not overwritten
+			std::vector<Pixel> buf(m.width + 1, 0x12345678);
+			convert(converter, m, vram, buf);
+			auto expected = reference(m, palettes, vram);
+			CHECK(std::equal(expected.begin(), expected.end(), buf.begin()));
+			CHECK(buf[m.width] == 0x12345678);
+		}
+
+		// A change in palette16 is picked up after palette16Changed().
+		palettes.palette16[3] ^= 0xFFFF;
+		palettes.palette16[16 + 2] ^= 0xFF00FF;
+		converter.palette16Changed();
+		for (const auto& m : modes) {
+			INFO(m.name << " seed=" << seed << " (palette changed)");
+			converter.setDisplayMode(m.mode);
+			std::vector<Pixel> buf(m.width);
+			convert(converter, m, vram, buf);
+			CHECK(buf == reference(m, palettes, vram));
+		}
+	}
+}
+
+// Not run by default, select it explicitly with:
+//   unittest "[benchmark]"
+TEST_CASE("BitmapConverter benchmark", "[.][benchmark]")
+{
+	std::cout << "BitmapConverter, compiled for: "
+#if defined(__AVX2__)
+	          << "AVX2"
+#elif defined(__SSSE3__)
+	          << "SSSE3"
+#elif defined(__SSE2__)
+	          << "SSE2 (only YJK/YAE are vectorized)"
+#else
+	          << "plain c++"
+#endif
+	          << '\n';
+
+	using Clock = std::chrono::steady_clock;
+
+	Palettes palettes(1);
+	auto converter = palettes.createConverter();
+	std::vector<VramLine> vram;
+	for (auto i : xrange(212u)) vram.emplace_back(i);
+	std::vector<Pixel> buf(512);
+
+	for (const auto& m : modes) {
+		converter.setDisplayMode(m.mode);
+		unsigned lines = 0;
+		auto start = Clock::now();
+		auto end = start + std::chrono::milliseconds(500);
+		Clock::time_point now;
+		do {
+			for (const auto& v : vram) convert(converter, m, v, buf);
+			lines += narrow<unsigned>(vram.size());
+			now = Clock::now();
+		} while (now < end);
+		auto secs = std::chrono::duration<double>(now - start).count();
+		std::cout << m.name << ": " << unsigned(lines / secs) << " lines/sec\n";
+	}
+}
@@ -0,0 +1,113 @@
+#include "catch.hpp"
+#include "BreakPointList.hh"
+
+#include "Interpreter.hh"
+#include "ranges.hh"
+#include "stl.hh"
+#include "view.hh"
+
+#include <vector>
+
+using namespace openmsx;
+
+static BreakPoint makeBp(word address)
+{
+	return {address, TclObject("debug break"), TclObject(), false};
+}
+
+// Ids of the breakpoints on the given address, in list order.
+static std::vector<unsigned> idsAt(const BreakPointList& list, word address)
+{
+	auto [first, last] = list.find(address);
+	return to_vector(view::transform(std::ranges::subrange(first, last), &BreakPoint::getId));
+}
+
+static bool isSorted(const BreakPointList& list)
+{
+	return ranges::is_sorted(list.getBreakPoints(), {}, &BreakPoint::getAddress);
+}
+
+TEST_CASE("BreakPointList: insert and find")
+{
+	Interpreter interp;
+	BreakPointList list;
+	CHECK(list.empty());
+	CHECK(!list.hasAddress(0x1234));
+	CHECK(idsAt(list, 0x1234).empty());
+
+	auto a = makeBp(0x1234); auto idA = a.getId();
+	auto b = makeBp(0x0010); auto idB = b.getId();
+	auto c = makeBp(0x1234); auto idC = c.getId();
+	list.insert(std::move(a));
+	list.insert(std::move(b));
+	list.insert(std::move(c));
+	CHECK(!list.empty());
+	CHECK(isSorted(list));
+	CHECK(list.hasAddress(0x1234));
+	CHECK(list.hasAddress(0x0010));
+	CHECK(!list.hasAddress(0x1235));
+	CHECK(idsAt(list, 0x1234) == std::vector{idA, idC}); // insertion order
+	CHECK(idsAt(list, 0x0010) == std::vector{idB});
+	CHECK(idsAt(list, 0xFFFF).empty());
+
+	// bulk insert gives the same order as inserting one by one
+	std::vector<BreakPoint> bps;
+	bps.push_back(makeBp(0x1234)); auto idD = bps.back().getId();
+	bps.push_back(makeBp(0xFFFF)); auto idE = bps.back().getId();
+	bps.push_back(makeBp(0x0000)); auto idF = bps.back().getId();
+	bps.push_back(makeBp(0x1234)); auto idG = bps.back().getId();
+	list.insert(std::move(bps));
+	CHECK(list.getBreakPoints().size() == 7);
+	CHECK(isSorted(list));
+	CHECK(idsAt(list, 0x1234) == std::vector{idA, idC, idD, idG});
+	CHECK(idsAt(list, 0xFFFF) == std::vector{idE});
+	CHECK(idsAt(list, 0x0000) == std::vector{idF});
+	CHECK(list.hasAddress(0x0000));
+	CHECK(list.hasAddress(0xFFFF));
+
+	list.clear();
+	CHECK(list.empty());
+	CHECK(!list.hasAddress(0x1234));
+	CHECK(!list.hasAddress(0xFFFF));
+}
+
+TEST_CASE("BreakPointList: remove")
+{
+	Interpreter interp;
+	BreakPointList list;
+	std::vector<unsigned> ids;
+	std::vector<BreakPoint> bps;
+	for (word addr : {0x100, 0x200, 0x200, 0x300, 0x400}) {
+		bps.push_back(makeBp(addr));
+		ids.push_back(bps.back().getId());
+	}
+	list.insert(std::move(bps));
+
+	SECTION("by id") {
+		CHECK(list.remove(ids[1]));
+		CHECK(!list.remove(ids[1])); // already removed
+		CHECK(list.hasAddress(0x200)); // still one left
+		CHECK(idsAt(list, 0x200) == std::vector{ids[2]});
+		CHECK(list.remove(ids[2]));
+		CHECK(!list.hasAddress(0x200));
+		CHECK(list.getBreakPoints().size() == 3);
+	}
+	SECTION("by object") {
+		auto [first, last] = list.find(0x300);
+		REQUIRE(first != last);
+		list.remove(*first);
+		CHECK(!list.hasAddress(0x300));
+		CHECK(list.getBreakPoints().size() == 4);
+	}
+	SECTION("many") {
+		std::vector<unsigned> remove = {ids[4], ids[0], ids[1], 12345}; // unsorted, unknown id
+		list.remove(remove);
+		CHECK(list.getBreakPoints().size() == 2);
+		CHECK(isSorted(list));
+		CHECK(!list.hasAddress(0x100));
+		CHECK(list.hasAddress(0x200));
+		CHECK(list.hasAddress(0x300));
+		CHECK(!list.hasAddress(0x400));
+		CHECK(idsAt(list, 0x200) == std::vector{ids[2]});
+	}
+}
@@ -0,0 +1,117 @@
+#include "catch.hpp"
+#include "CPUProfiler.hh"
+
+#include "SymbolManager.hh"
+#include "strCat.hh"
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+using namespace openmsx;
+
+TEST_CASE("CPUProfiler: entries")
+{
+	CPUProfiler profiler;
+	CHECK(profiler.getEntries().empty());
+
+	profiler.record(0, CPUProfiler::NO_SEGMENT, 0x0038, 12);
+	profiler.record(0, CPUProfiler::NO_SEGMENT, 0x0038, 12);
+	profiler.record(0, CPUProfiler::NO_SEGMENT, 0x0100, 5);  // other page
+	profiler.record(3 + 4 * 2, 7, 0x8000, 8);               // other slot/segment
+	profiler.record(3 + 4 * 2, 6, 0x8000, 8);
+	profiler.record(0, CPUProfiler::NO_SEGMENT, 0x0039, 5); // back to first page
+
+	auto entries = profiler.getEntries();
+	REQUIRE(entries.size() == 5);
+	CHECK(entries[0].address == 0x0038);
+	CHECK(entries[0].counter.count == 2);
+	CHECK(entries[0].counter.ticks == 24);
+	CHECK(entries[1].address == 0x0039);
+	CHECK(entries[2].address == 0x0100);
+	CHECK(entries[3].slot == 11);
+	CHECK(entries[3].segment == 6);
+	CHECK(entries[4].segment == 7);
+	CHECK(entries[4].counter.ticks == 8);
+
+	profiler.reset();
+	CHECK(profiler.getEntries().empty());
+	profiler.record(0, CPUProfiler::NO_SEGMENT, 0x0038, 12);
+	CHECK(profiler.getEntries().size() == 1);
+}
+
+TEST_CASE("CPUProfiler: report")
+{
+	SymbolFile file;
+	file.symbols.emplace_back("main",    uint16_t(0x4000), std::nullopt, std::nullopt);
+	file.symbols.emplace_back("loop",    uint16_t(0x4010), std::nullopt, std::nullopt);
+	file.symbols.emplace_back("bank1",   uint16_t(0x8000), uint8_t(1), uint16_t(1));
+	file.symbols.emplace_back("bank2",   uint16_t(0x8000), uint8_t(1), uint16_t(2));
+	std::vector<SymbolFile> files;
+	files.push_back(std::move(file));
+
+	CPUProfiler profiler;
+	profiler.record(1, CPUProfiler::NO_SEGMENT, 0x4000, 4);
+	profiler.record(1, CPUProfiler::NO_SEGMENT, 0x4003, 4);
+	for (int i = 0; i < 10; ++i) {
+		profiler.record(1, CPUProfiler::NO_SEGMENT, 0x4010, 5);
+		profiler.record(1, CPUProfiler::NO_SEGMENT, 0x4012, 13);
+	}
+	profiler.record(1, 2, 0x8005, 7);
+	profiler.record(1, 1, 0x8000, 1);
+	profiler.record(0, 2, 0x8000, 3); // other slot: falls back to 'loop'
+	profiler.record(0, CPUProfiler::NO_SEGMENT, 0x0038, 11); // no symbol
+
+	auto report = profiler.getReport(files);
+	REQUIRE(report.size() == 5);
+	CHECK(report[0].name == "loop");
+	CHECK(report[0].counter.count == 21);
+	CHECK(report[0].counter.ticks == 183);
+	CHECK(report[1].name.empty());
+	CHECK(report[1].address == 0x0038);
+	CHECK(report[2].name == "main");
+	CHECK(report[2].counter.count == 2);
+	CHECK(report[3].name == "bank2");
+	CHECK(report[3].address == 0x8000);
+	CHECK(report[4].name == "bank1");
+}
+
+TEST_CASE("CPUProfiler: report symbol lookup")
+{
+	// Compare with a straightforward search over all symbols.
+	SymbolFile file;
+	uint32_t seed = 12345;
+	auto random = [&](uint32_t n) { seed = seed * 1103515245 + 12345; return (seed >> 16) % n; };
+	for (int i = 0; i < 200; ++i) {
+		std::optional<uint8_t> slot;
+		std::optional<uint16_t> segment;
+		if (random(3) == 0) slot = uint8_t(random(4));
+		if (random(3) == 0) segment = uint16_t(random(4));
+		file.symbols.emplace_back(strCat("sym", i), uint16_t(random(0x100) * 0x40), slot, segment);
+	}
+	std::vector<SymbolFile> files;
+	files.push_back(std::move(file));
+
+	for (int i = 0; i < 500; ++i) {
+		auto slot = uint8_t(random(4));
+		auto segment = random(2) ? CPUProfiler::NO_SEGMENT : uint16_t(random(4));
+		auto address = uint16_t(random(0x10000));
+
+		const Symbol* expected = nullptr;
+		for (const auto& sym : files[0].symbols) {
+			if ((sym.value <= address) &&
+			    (!sym.slot    || (*sym.slot    == slot)) &&
+			    (!sym.segment || (*sym.segment == segment)) &&
+			    (!expected || (sym.value >= expected->value))) { // later one wins
+				expected = &sym;
+			}
+		}
+
+		CPUProfiler profiler;
+		profiler.record(slot, segment, address, 1);
+		auto report = profiler.getReport(files);
+		REQUIRE(report.size() == 1);
+		INFO("slot=" << int(slot) << " segment=" << segment << " address=" << address);
+		CHECK(report[0].name == (expected ? std::string_view(expected->name) : std::string_view{}));
+	}
+}
@@ -0,0 +1,149 @@
+#include "catch.hpp"
+#include "CompiledCondition.hh"
+#include "Interpreter.hh"
+#include "TclObject.hh"
+#include "strCat.hh"
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+using namespace openmsx;
+
+namespace {
+
+struct FakeMachine {
+	std::array<uint8_t, 28> regs = {};
+	std::array<uint8_t, 0x10000> mem = {};
+	std::array<std::pair<int, int>, 4> slots = {};
+
+	unsigned readReg(unsigned index) { return regs[index]; }
+	unsigned peek(unsigned address) { return mem[address]; }
+	std::pair<int, int> getSelectedSlot(int page) { return slots[page]; }
+};
+
+}
+
+static std::optional<bool> eval(std::string_view expr, FakeMachine& m)
+{
+	auto c = CompiledCondition::compile(expr);
+	REQUIRE(c);
+	return c->evaluate(m);
+}
+
+TEST_CASE("CompiledCondition: supported subset")
+{
+	FakeMachine m;
+	m.regs[0] = 0x12; // A
+	m.regs[6] = 0x80; m.regs[7] = 0x01; // HL = 0x8001
+	m.regs[20] = 0xC0; m.regs[21] = 0x34; // PC = 0xC034
+	m.mem[0x8001] = 0xFE;
+	m.mem[0x8002] = 0x03;
+	m.mem[0xC000] = 7;
+	m.slots[3] = {3, 2};
+
+	CHECK(eval("1", m) == true);
+	CHECK(eval("0", m) == false);
+	CHECK(eval("[reg A] == 0x12", m) == true);
+	CHECK(eval("[reg a]==18", m) == true);
+	CHECK(eval("[reg A] != 0x12", m) == false);
+	CHECK(eval("[reg HL] == 0x8001", m) == true);
+	CHECK(eval("[reg PC] >= 0xC000 && [reg PC] < 0xC100", m) == true);
+	CHECK(eval("[peek [reg HL]] == 254", m) == true);
+	CHECK(eval("[peek_s8 [reg HL]] == -2", m) == true);
+	CHECK(eval("[peek16 0x8001] == 0x03FE", m) == true);
+	CHECK(eval("[peek16_BE 0x8001] == 0xFE03", m) == true);
+	CHECK(eval("[debug read memory 0xC000] == 7", m) == true);
+	CHECK(eval("[debug read \"memory\" 0xC000] == 7", m) == true);
+	CHECK(eval("[pc_in_slot 3]", m) == true);
+	CHECK(eval("[pc_in_slot 3 2]", m) == true);
+	CHECK(eval("[pc_in_slot 3 1]", m) == false);
+	CHECK(eval("[pc_in_slot X 2 X]", m) == true);
+	CHECK(eval("[pc_in_slot 1]", m) == false);
+	CHECK(eval("[peek [reg SP]] == 0x99 && [reg SP] == 0", m) == false); // cpu_benchmark
+
+	// precedence and associativity like in Tcl
+	CHECK(eval("1 + 2 * 3 == 7", m) == true);
+	CHECK(eval("(1 + 2) * 3 == 9", m) == true);
+	CHECK(eval("10 - 3 - 2 == 5", m) == true);
+	CHECK(eval("1 << 4 + 1 == 32", m) == true);
+	CHECK(eval("6 & 3 == 2", m) == false); // '==' binds stronger than '&'
+	CHECK(eval("(6 & 3) == 2", m) == true);
+	CHECK(eval("1 | 2 ^ 3", m) == true);
+	CHECK(eval("0 || 0 && 1", m) == false);
+	CHECK(eval("!0 && ~0 == -1", m) == true);
+	CHECK(eval("-[reg A] < 0", m) == true);
+	CHECK(eval("0b101 == 5 && 0o17 == 15 && 0X1f == 31", m) == true);
+	CHECK(eval("-8 >> 1 == -4", m) == true);
+}
+
+TEST_CASE("CompiledCondition: fall back to Tcl")
+{
+	// not compiled
+	for (auto expr : {
+		"", "$::foo == 1", "[reg XYZ] == 1", "[peek 0x100 VRAM] == 0",
+		"[pc_in_slot 3 0 5]", "[debug read VRAM 0]", "[my_proc 1]",
+		"010 == 8", "1.5 > 1", "4 / 2", "5 % 2", "2 ** 3",
+		"[reg A] eq {18}", "true", "1 ? 2 : 3", "(1", "1)", "0x100000000",
+		"[reg A", "[reg A] == 1 ]", "[peek -1]"}) {
+		CHECK(!CompiledCondition::compile(expr));
+	}
+
+	// compiled, but evaluated in Tcl because that gives an error
+	FakeMachine m;
+	CHECK(!eval("[peek16 0xFFFF]", m));
+	CHECK(!eval("[peek 0x10000]", m));
+	CHECK(!eval("1 << 64", m));
+	CHECK(!eval("0xFFFFFFFF * 0xFFFFFFFF * 0xFFFFFFFF", m));
+}
+
+TEST_CASE("CompiledCondition: pc_in_slot matches the Tcl proc")
+{
+	// Compare with the real Tcl implementation, with the commands it uses
+	// to inspect the machine replaced by stubs.
+	auto script = std::filesystem::path(__FILE__).parent_path() / "../../share/scripts/_slot.tcl";
+	REQUIRE(std::filesystem::exists(script));
+	Interpreter interp;
+	interp.execute("proc set_help_text {args} {}");
+	interp.execute(strCat("source {", script.generic_string(), '}'));
+	interp.execute(
+		"proc reg {name} { return $::pc }\n"
+		"proc debug {cmd name addr} {\n"
+		"    expr {($name eq \"ioports\") ? $::ps_reg : $::ss_reg}\n"
+		"}\n"
+		"proc machine_info {what ps} { expr {$::expanded == $ps} }");
+
+	FakeMachine m;
+	for (int page = 0; page < 4; ++page) {
+		for (int ps = 0; ps < 4; ++ps) {
+			for (int ss = -1; ss < 4; ++ss) { // -1: not expanded
+				int pc = 0x4000 * page + 0x123;
+				int psReg = ps << (2 * page);
+				int ssReg = ~((ss < 0 ? 0 : ss) << (2 * page)) & 0xFF;
+				interp.execute(strCat("set ::pc ", pc, " ; set ::ps_reg ", psReg,
+				                      " ; set ::ss_reg ", ssReg,
+				                      " ; set ::expanded ", (ss < 0 ? -1 : ps)));
+				m.regs[20] = uint8_t(pc >> 8);
+				m.regs[21] = uint8_t(pc & 0xFF);
+				m.slots[page] = {ps, ss};
+
+				for (std::string_view qps : {"0", "1", "2", "3", "X"}) {
+					for (std::string_view qss : {"", " 0", " 1", " 2", " 3", " X", " X X"}) {
+						for (std::string_view fmt : {"[pc_in_slot %]", "[pc_in_slot %] == 1"}) {
+							auto call = strCat(qps, qss);
+							auto pos = fmt.find('%');
+							auto expr = strCat(fmt.substr(0, pos), call, fmt.substr(pos + 1));
+							INFO(expr << " page=" << page << " ps=" << ps << " ss=" << ss);
+							bool tcl = interp.execute(strCat("expr {", expr, '}')).getBoolean(interp);
+							CHECK(eval(expr, m) == tcl);
+						}
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,247 @@
+#include "catch.hpp"
+#include "DeltaBlock.hh"
+#include "DirtyPages.hh"
+
+#include "ranges.hh"
+#include "xrange.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <span>
+#include <vector>
+
+using namespace openmsx;
+
+// Fill 'buf' with a (reproducible) pseudo random pattern.
+static void randomFill(std::span<uint8_t> buf, unsigned seed)
+{
+	std::minstd_rand gen(seed);
+	for (auto& b : buf) b = uint8_t(gen());
+}
+
+// Overwrite 'count' runs of 'runLen' bytes at pseudo random positions.
+static void scatterWrites(std::span<uint8_t> buf, unsigned count, size_t runLen, unsigned seed)
+{
+	std::minstd_rand gen(seed);
+	repeat(count, [&] {
+		auto pos = gen() % (buf.size() - runLen + 1);
+		for (auto j : xrange(runLen)) buf[pos + j] ^= uint8_t(1 + gen() % 255);
+	});
+}
+
+static void checkDiff(std::span<const uint8_t> oldData, std::span<const uint8_t> newData)
+{
+	auto prev = std::make_shared<DeltaBlockCopy>(oldData);
+	DeltaBlockDiff diff(prev, newData);
+
+	std::vector<uint8_t> out(newData.size());
+	diff.apply(out);
+	CHECK(std::ranges::equal(out, newData));
+}
+
+TEST_CASE("DeltaBlockDiff")
+{
+	// Different sizes, so that the (SIMD) word loops, the unrolled loops
+	// and the byte-at-a-time tails all get exercised.
+	for (size_t size : {1, 2, 15, 16, 17, 31, 32, 33, 63, 64, 65, 127, 128,
+	                    129, 255, 256, 1000, 4096, 65536 + 7}) {
+		std::vector<uint8_t> oldData(size);
+		randomFill(oldData, unsigned(size));
+
+		SECTION("identical") {
+			checkDiff(oldData, oldData);
+		}
+		SECTION("completely different") {
+			std::vector<uint8_t> newData(size);
+			for (auto i : xrange(size)) newData[i] = uint8_t(~oldData[i]);
+			checkDiff(oldData, newData);
+		}
+		SECTION("first and last byte") {
+			auto newData = oldData;
+			newData.front() ^= 1;
+			newData.back() ^= 1;
+			checkDiff(oldData, newData);
+		}
+		SECTION("sparse writes") {
+			auto newData = oldData;
+			scatterWrites(newData, unsigned(size / 100 + 1), 1, 1);
+			checkDiff(oldData, newData);
+		}
+		SECTION("clustered writes") {
+			auto newData = oldData;
+			scatterWrites(newData, unsigned(size / 1000 + 1), std::min<size_t>(size, 40), 2);
+			checkDiff(oldData, newData);
+		}
+		SECTION("alternating") {
+			// equal and different bytes interleaved, runs of length 1..3
+			auto newData = oldData;
+			for (size_t i = 0; i < size; i += 1 + (i % 3)) newData[i] ^= 0x55;
+			checkDiff(oldData, newData);
+		}
+		SECTION("unaligned") {
+			// buffers with different alignment (only the non-SIMD build
+			// falls back to the byte-wise loop for those)
+			std::vector<uint8_t> buf(size + 1);
+			auto newData = std::span{buf}.subspan(1);
+			ranges::copy(oldData, newData);
+			newData.back() ^= 0xff;
+			checkDiff(oldData, newData);
+		}
+	}
+}
+
+TEST_CASE("DeltaBlockMapped")
+{
+	std::vector<uint8_t> oldData(4096);
+	randomFill(oldData, 3);
+	auto newData = oldData;
+	scatterWrites(newData, 20, 5, 4);
+
+	auto delta = calcBlockDelta(oldData, newData);
+	CHECK(delta.size() < newData.size());
+	CHECK(isValidBlockDelta(delta, newData.size()));
+	CHECK(!isValidBlockDelta(delta, newData.size() - 1));
+	CHECK(!isValidBlockDelta(std::span{delta}.first(delta.size() / 2), newData.size()));
+
+	auto owner = std::make_shared<int>(0);
+	auto full = std::make_shared<const DeltaBlockMapped>(owner, oldData);
+	DeltaBlockMapped diff(owner, full, delta);
+	CHECK(!full->isDelta());
+	CHECK(diff.isDelta());
+	CHECK(diff.getSize() == newData.size());
+	CHECK(diff.getStorageSize() == delta.size());
+
+	std::vector<uint8_t> out(newData.size());
+	full->apply(out);
+	CHECK(out == oldData);
+	diff.apply(out);
+	CHECK(out == newData);
+
+	auto copy = oldData;
+	applyBlockDelta(copy, delta);
+	CHECK(copy == newData);
+}
+
+TEST_CASE("LastDeltaBlocks")
+{
+	LastDeltaBlocks lastBlocks;
+	std::vector<uint8_t> mem(64 * 1024);
+	randomFill(mem, 0);
+
+	std::vector<std::shared_ptr<DeltaBlock>> blocks;
+	std::vector<std::vector<uint8_t>> expected;
+	for (auto i : xrange(50u)) {
+		scatterWrites(mem, 100, 1 + (i % 16), i);
+		blocks.push_back(lastBlocks.createNew(mem.data(), mem));
+		expected.push_back(mem);
+	}
+	lastBlocks.clear(); // compresses the reference blocks
+	for (auto i : xrange(blocks.size())) {
+		std::vector<uint8_t> out(mem.size());
+		blocks[i]->apply(out);
+		CHECK(out == expected[i]);
+	}
+}
+
+TEST_CASE("DirtyPages")
+{
+	DirtyPages dirty(1000); // partial last page
+	CHECK(dirty.getPages().size() == 4);
+	CHECK(dirty.any());
+	dirty.clear();
+	CHECK(!dirty.any());
+	dirty.mark(999);
+	CHECK(dirty.isDirty(3));
+	CHECK(!dirty.isDirty(2));
+	dirty.markRange(255, 2);
+	CHECK( dirty.isDirty(0));
+	CHECK( dirty.isDirty(1));
+	CHECK(!dirty.isDirty(2));
+	dirty.markRange(600, 0);
+	CHECK(!dirty.isDirty(2));
+}
+
+TEST_CASE("LastDeltaBlocks with dirty pages")
+{
+	LastDeltaBlocks lastBlocks;
+	std::vector<uint8_t> mem(64 * 1024 + 100);
+	randomFill(mem, 0);
+	DirtyPages dirty(mem.size());
+
+	// Same logic as MemOutputArchive::serialize_blob() for reverse snapshots.
+	auto snapshot = [&] {
+		auto b = dirty.any() ? lastBlocks.createNew(mem.data(), mem, &dirty)
+		                     : lastBlocks.createNullDiff(mem.data(), mem);
+		dirty.clear();
+		return b;
+	};
+
+	std::vector<std::shared_ptr<DeltaBlock>> blocks;
+	std::vector<std::vector<uint8_t>> expected;
+	std::minstd_rand gen(1);
+	for (auto i : xrange(60u)) {
+		// some snapshots without any writes at all
+		unsigned count = (i % 7 == 3) ? 0 : 1 + (i % 20);
+		repeat(count, [&] {
+			auto pos = gen() % mem.size();
+			auto len = std::min<size_t>(1 + gen() % 600, mem.size() - pos);
+			for (auto j : xrange(len)) mem[pos + j] ^= uint8_t(1 + gen() % 255);
+			dirty.markRange(pos, len);
+		});
+		if (i % 11 == 5) {
+			// writing the same value still marks the page, that's fine
+			dirty.mark(gen() % mem.size());
+		}
+		blocks.push_back(snapshot());
+		expected.push_back(mem);
+	}
+	lastBlocks.clear();
+	for (auto i : xrange(blocks.size())) {
+		std::vector<uint8_t> out(mem.size());
+		blocks[i]->apply(out);
+		CHECK(out == expected[i]);
+	}
+}
+
+// Not run by default, select it explicitly with:
+//   unittest "[benchmark]"
+TEST_CASE("DeltaBlock scan benchmark", "[.][benchmark]")
+{
+	// Typical big memory blocks: 512kB VRAM, 4MB mapper RAM.
+	for (size_t size : {512 * 1024, 4 * 1024 * 1024}) {
+		std::vector<uint8_t> oldData(size);
+		randomFill(oldData, 0);
+		auto prev = std::make_shared<DeltaBlockCopy>(oldData);
+
+		struct Pattern {
+			const char* name;
+			unsigned count;
+			size_t runLen;
+		};
+		for (auto [name, count, runLen] : {
+				Pattern{"unchanged",        0,    0},
+				Pattern{"few sparse writes", 64,   1},
+				Pattern{"many sparse writes", 4096, 2},
+				Pattern{"clustered writes", 64, 2048}}) {
+			auto newData = oldData;
+			if (count) scatterWrites(newData, count, runLen, 1);
+
+			using clock = std::chrono::steady_clock;
+			static constexpr int REPEAT = 20;
+			size_t deltaSize = 0;
+			auto start = clock::now();
+			repeat(REPEAT, [&] {
+				DeltaBlockDiff diff(prev, newData);
+				deltaSize = diff.getDeltaSize();
+			});
+			std::chrono::duration<double> elapsed = clock::now() - start;
+			double gbPerSec = double(REPEAT) * double(size) / elapsed.count() * 1e-9;
+			std::cout << "DeltaBlockDiff " << (size / 1024) << "kB, "
+			          << name << ": " << gbPerSec << " GB/s"
+			          << " (delta " << deltaSize << " bytes)\n";
+		}
+	}
+}
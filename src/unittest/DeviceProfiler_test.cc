@@ -0,0 +1,67 @@
+#include "catch.hpp"
+#include "DeviceProfiler.hh"
+
+#include <thread>
+
+using namespace openmsx;
+
+namespace {
+	struct Foo {};
+}
+
+TEST_CASE("DeviceProfiler: ids")
+{
+	using enum DeviceProfiler::Category;
+	DeviceProfiler profiler;
+	auto a = profiler.getId(SOUND, "PSG");
+	auto b = profiler.getId(SOUND, "SCC");
+	CHECK(a != b);
+	CHECK(profiler.getId(SOUND, "PSG") == a);
+	CHECK(profiler.getId(RENDER, "PSG") != a); // same name, other category
+
+	auto c = profiler.getId(SYNC_POINT, typeid(Foo));
+	auto entries = profiler.getEntries();
+	REQUIRE(entries.size() == 4);
+	CHECK(entries[c].name.ends_with("Foo"));
+	CHECK(!entries[c].name.starts_with("openmsx::"));
+}
+
+TEST_CASE("DeviceProfiler: measure")
+{
+	using enum DeviceProfiler::Category;
+	DeviceProfiler profiler;
+	auto outer = profiler.getId(SYNC_POINT, "outer");
+	auto inner = profiler.getId(RENDER, "inner");
+	auto t0 = EmuTime::zero();
+	auto t1 = t0 + EmuDuration::sec(2);
+
+	// not active: nothing is measured, but the function is executed
+	CHECK(profiler.measure(outer, [] { return 42; }) == 42);
+	CHECK(profiler.getEntries()[outer].calls == 0);
+
+	profiler.setActive(true, t0);
+	CHECK(profiler.isActive());
+	profiler.measure(outer, [&] {
+		profiler.measure(inner, [] {
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		});
+		profiler.measure(inner, [] {});
+	});
+	profiler.setActive(false, t1);
+
+	const auto& o = profiler.getEntries()[outer];
+	const auto& i = profiler.getEntries()[inner];
+	CHECK(o.calls == 1);
+	CHECK(i.calls == 2);
+	CHECK(i.totalTime == i.selfTime);
+	CHECK(i.totalTime >= 2'000'000);
+	CHECK(o.totalTime >= i.totalTime);
+	CHECK(o.selfTime == o.totalTime - i.totalTime);
+	CHECK(profiler.getEmulatedTime(t1 + EmuDuration::sec(5)) == EmuDuration::sec(2));
+
+	profiler.reset(t1);
+	CHECK(profiler.getEntries().size() == 2); // ids remain valid
+	CHECK(profiler.getEntries()[outer].calls == 0);
+	CHECK(profiler.getEntries()[inner].totalTime == 0);
+	CHECK(profiler.getEmulatedTime(t1) == EmuDuration::zero());
+}
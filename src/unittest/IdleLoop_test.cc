@@ -0,0 +1,241 @@
+#include "catch.hpp"
+#include "IdleLoop.hh"
+
+#include "CPUClock.hh"
+#include "CPURegs.hh"
+#include "Schedulable.hh"
+#include "Scheduler.hh"
+
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <vector>
+
+using namespace openmsx;
+
+namespace {
+
+// Memory in which each 256-byte line can be made uncached, like the read
+// cache lines of the CPU (e.g. I/O mapped memory or a line with a watchpoint).
+struct FakeMemory {
+	std::array<uint8_t, 0x10000> mem = {};
+	std::array<bool, 0x100> uncached = {};
+
+	void write(unsigned addr, std::initializer_list<uint8_t> bytes) {
+		for (auto b : bytes) mem[addr++ & 0xFFFF] = b;
+	}
+
+	uint8_t analyze(unsigned begin, unsigned branchPC, unsigned branchLen, unsigned hl = 0) const {
+		return analyzeIdleLoop(
+			begin, branchPC, branchLen, hl,
+			[&](unsigned addr) { return !uncached[addr >> 8]; },
+			[&](unsigned addr) { return mem[addr]; });
+	}
+};
+
+}
+
+TEST_CASE("IdleLoop: accepted loops")
+{
+	FakeMemory m;
+	SECTION("jr $") {
+		m.write(0xC000, {0x18, 0xFE});
+		CHECK(m.analyze(0xC000, 0xC000, 2) == 1);
+	}
+	SECTION("djnz $") {
+		m.write(0xC000, {0x10, 0xFE});
+		CHECK(m.analyze(0xC000, 0xC000, 2) == 1);
+	}
+	SECTION("ld a,(nn) ; and n ; jr nz,loop") {
+		m.write(0xC000, {0x3A, 0x00, 0xE0, 0xE6, 0x80, 0x20, 0xF9});
+		CHECK(m.analyze(0xC000, 0xC005, 2) == 3);
+	}
+	SECTION("ld a,(hl) ; or a ; djnz loop") {
+		m.write(0xC000, {0x7E, 0xB7, 0x10, 0xFC});
+		CHECK(m.analyze(0xC000, 0xC002, 2, 0xE000) == 3);
+	}
+	SECTION("ld a,(nn) ; bit 7,a ; jp z,loop") {
+		m.write(0xC000, {0x3A, 0x00, 0xE0, 0xCB, 0x7F, 0xCA, 0x00, 0xC0});
+		CHECK(m.analyze(0xC000, 0xC005, 3) == 4);
+	}
+	SECTION("ld a,(nn) ; jr z,loop") {
+		m.write(0xC000, {0x3A, 0x00, 0xE0, 0x28, 0xFB});
+		CHECK(m.analyze(0xC000, 0xC003, 2) == 2);
+	}
+}
+
+TEST_CASE("IdleLoop: rejected loops")
+{
+	FakeMemory m;
+	SECTION("I/O") {
+		// in a,(0x99) ; and 0x80 ; jr z,loop
+		m.write(0xC000, {0xDB, 0x99, 0xE6, 0x80, 0x28, 0xFA});
+		CHECK(m.analyze(0xC000, 0xC004, 2) == 0);
+		// ld a,(nn) ; out (0x98),a ; jr loop
+		m.write(0xC000, {0x3A, 0x00, 0xE0, 0xD3, 0x98, 0x18, 0xF9});
+		CHECK(m.analyze(0xC000, 0xC005, 2) == 0);
+	}
+	SECTION("memory write") {
+		// ld (nn),a ; jr loop
+		m.write(0xC000, {0x32, 0x00, 0xE0, 0x18, 0xFB});
+		CHECK(m.analyze(0xC000, 0xC003, 2) == 0);
+		// ld a,(nn) ; ld (hl),a ; jr loop
+		m.write(0xC000, {0x3A, 0x00, 0xE0, 0x77, 0x18, 0xFA});
+		CHECK(m.analyze(0xC000, 0xC004, 2, 0xE000) == 0);
+	}
+	SECTION("register changes") {
+		// ld a,(nn) ; inc a ; jr nz,loop
+		m.write(0xC000, {0x3A, 0x00, 0xE0, 0x3C, 0x20, 0xFA});
+		CHECK(m.analyze(0xC000, 0xC004, 2) == 0);
+		// ld a,(nn) ; bit 7,b ; jr z,loop
+		m.write(0xC000, {0x3A, 0x00, 0xE0, 0xCB, 0x78, 0x28, 0xF9});
+		CHECK(m.analyze(0xC000, 0xC005, 2) == 0);
+	}
+	SECTION("read of a watched address") {
+		m.write(0xC000, {0x3A, 0x00, 0xE0, 0xB7, 0x28, 0xFA});
+		CHECK(m.analyze(0xC000, 0xC004, 2) == 2 + 1);
+		m.uncached[0xE0] = true;
+		CHECK(m.analyze(0xC000, 0xC004, 2) == 0);
+		// same for 'ld a,(hl)'
+		m.write(0xD000, {0x7E, 0xB7, 0x28, 0xFC});
+		CHECK(m.analyze(0xD000, 0xD002, 2, 0xE010) == 0);
+		CHECK(m.analyze(0xD000, 0xD002, 2, 0xF010) == 3);
+	}
+	SECTION("code in uncached memory") {
+		m.write(0x40FE, {0x3A, 0x00, 0xE0, 0x28, 0xFB});
+		m.uncached[0x41] = true;
+		CHECK(m.analyze(0x40FE, 0x4101, 2) == 0);
+		m.uncached[0x41] = false;
+		CHECK(m.analyze(0x40FE, 0x4101, 2) == 2);
+	}
+	SECTION("jump into the middle") {
+		// The branch doesn't end at the end of the recognized body.
+		m.write(0xC000, {0x3A, 0x00, 0xE0, 0xB7, 0x00, 0x28, 0xF9});
+		CHECK(m.analyze(0xC000, 0xC005, 2) == 0);
+	}
+}
+
+namespace {
+
+class SyncPoint final : public Schedulable
+{
+public:
+	explicit SyncPoint(Scheduler& scheduler_) : Schedulable(scheduler_) {}
+	void executeUntil(EmuTime::param /*time*/) override {}
+	using Schedulable::setSyncPoint;
+};
+
+class TestClock final : public CPUClock
+{
+public:
+	explicit TestClock(Scheduler& scheduler_)
+		: CPUClock(EmuTime::zero(), scheduler_)
+	{
+		setFreq(3579545);
+		enableLimit();
+	}
+	using CPUClock::add;
+	using CPUClock::getRemaining;
+	using CPUClock::getTime;
+	using CPUClock::limitReached;
+	using CPUClock::skipIterations;
+};
+
+struct Result {
+	EmuTime time;
+	uint8_t r;
+	uint8_t b;
+	unsigned skipped; // number of skipped iterations
+};
+
+// Runs a loop in the same way as CPUCore: the limit is checked after each
+// instruction, the branch instruction takes 'pre' cycles before the branch
+// is taken (checkIdleLoop() is called) and 'post' cycles after it. When
+// 'skip' is set, the iterations are skipped as in CPUCore::skipIdleLoop().
+// When 'djnz' is set, the branch is only taken while B doesn't become zero.
+Result runLoop(const std::vector<unsigned>& body, unsigned pre, unsigned post,
+               uint8_t rIncrement, bool djnz, uint8_t b, bool skip)
+{
+	Scheduler scheduler;
+	SyncPoint syncPoint(scheduler);
+	syncPoint.setSyncPoint(EmuTime::zero() + EmuDuration::msec(10));
+	TestClock clock(scheduler);
+
+	CPURegs regs(false);
+	regs.setR(0x80 | 0x7A); // bit 7 is never changed by incR()
+	regs.setB(b);
+
+	unsigned skipped = 0;
+	int branchRemaining = 0;
+	bool first = true;
+	while (!clock.limitReached()) {
+		for (auto cycles : body) {
+			clock.add(cycles);
+			if (clock.limitReached()) goto done;
+		}
+		clock.add(pre);
+		regs.incR(rIncrement);
+		if (djnz) {
+			regs.setB(uint8_t(regs.getB() - 1));
+			if (regs.getB() == 0) {
+				clock.add(post);
+				break;
+			}
+		}
+		if (skip) {
+			if (!first) {
+				int ticks = branchRemaining - clock.getRemaining();
+				REQUIRE(ticks > 0);
+				unsigned maxIterations = djnz ? regs.getB() - 1u
+				                              : std::numeric_limits<unsigned>::max();
+				unsigned n = clock.skipIterations(unsigned(ticks), maxIterations);
+				regs.incR(uint8_t(n * rIncrement));
+				if (djnz) regs.setB(uint8_t(regs.getB() - n));
+				skipped += n;
+			}
+			branchRemaining = clock.getRemaining();
+			first = false;
+		}
+		clock.add(post);
+	}
+done:
+	return {clock.getTime(), regs.getR(), regs.getB(), skipped};
+}
+
+// Returns the number of skipped iterations.
+unsigned compare(const std::vector<unsigned>& body, unsigned pre, unsigned post,
+                 uint8_t rIncrement, bool djnz = false, uint8_t b = 0)
+{
+	auto step = runLoop(body, pre, post, rIncrement, djnz, b, false);
+	auto fast = runLoop(body, pre, post, rIncrement, djnz, b, true);
+	CHECK(step.skipped == 0);
+	CHECK(fast.time == step.time);
+	CHECK(fast.r == step.r);
+	CHECK(fast.b == step.b);
+	return fast.skipped;
+}
+
+}
+
+TEST_CASE("IdleLoop: skipped iterations match step-by-step execution")
+{
+	// jr $
+	CHECK(compare({}, 5, 8, 1) > 0);
+	// ld a,(nn) ; and n ; jr nz,loop
+	CHECK(compare({14, 8}, 5, 8, 3) > 0);
+	// the limit is reached in the middle of an iteration
+	CHECK(compare({14, 8}, 5, 9, 3) > 0);
+	CHECK(compare({14, 8, 1000}, 5, 9, 4) > 0);
+
+	// djnz $, B runs out before the limit is reached ...
+	CHECK(compare({}, 9, 5, 1, true, 1) == 0);
+	CHECK(compare({}, 9, 5, 1, true, 2) == 0);
+	CHECK(compare({}, 9, 5, 1, true, 3) == 0);
+	CHECK(compare({}, 9, 5, 1, true, 4) == 1);
+	CHECK(compare({}, 9, 5, 1, true, 100) == 97);
+	CHECK(compare({}, 9, 5, 1, true, 0) == 253);
+	// ... or not: ld a,(hl) ; or a ; djnz loop, with a slow memory read
+	CHECK(compare({800, 5}, 9, 5, 3, true, 0) > 0);
+	CHECK(compare({800, 5}, 9, 5, 3, true, 200) > 0);
+}
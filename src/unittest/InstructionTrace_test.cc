@@ -0,0 +1,174 @@
+#include "catch.hpp"
+#include "InstructionTrace.hh"
+
+#include "MSXException.hh"
+#include "xrange.hh"
+
+#include <chrono>
+#include <iostream>
+
+using namespace openmsx;
+
+static InstructionTrace::Regs makeRegs(unsigned i)
+{
+	InstructionTrace::Regs regs = {};
+	regs[InstructionTrace::AF] = uint16_t(i * 3);   // changes every instruction
+	regs[InstructionTrace::HL] = uint16_t(i / 10);  // changes sometimes
+	regs[InstructionTrace::SP] = 0xF380;            // never changes
+	return regs;
+}
+
+TEST_CASE("InstructionTrace: record and decode")
+{
+	InstructionTrace trace;
+	CHECK(trace.size() == 0);
+	CHECK(trace.getLast(10).empty());
+
+	std::array<uint8_t, 4> op = {0xDD, 0x21, 0x34, 0x12};
+	uint64_t time = 1000;
+	for (auto i : xrange(100u)) {
+		auto len = (i % 4) + 1;
+		trace.record(uint16_t(0x4000 + i), std::span{op}.first(len), makeRegs(i), time);
+		time += (i == 50) ? 0x123456789ull : (i % 7) * 100; // also a huge delta
+	}
+	CHECK(trace.size() == 100);
+
+	auto entries = trace.getLast(30);
+	REQUIRE(entries.size() == 30);
+	uint64_t expectedTime = 1000;
+	for (auto i : xrange(70u)) {
+		expectedTime += (i == 50) ? 0x123456789ull : (i % 7) * 100;
+	}
+	for (auto j : xrange(30u)) {
+		auto i = 70 + j;
+		const auto& e = entries[j];
+		CHECK(e.pc == 0x4000 + i);
+		CHECK(e.getOpcode().size() == (i % 4) + 1);
+		CHECK(e.opcode[0] == 0xDD);
+		CHECK(e.regs == makeRegs(i));
+		CHECK(e.time == expectedTime);
+		expectedTime += (i % 7) * 100;
+	}
+	CHECK(trace.getLast(1000).size() == 100);
+
+	trace.clear();
+	CHECK(trace.size() == 0);
+}
+
+TEST_CASE("InstructionTrace: ring buffer")
+{
+	// minimum size is 2 chunks
+	InstructionTrace trace(0);
+	CHECK(trace.getMaxSize() == 2 * InstructionTrace::CHUNK_SIZE);
+
+	std::array<uint8_t, 1> op = {0x00};
+	unsigned n = 100000; // doesn't fit in 2 chunks
+	for (auto i : xrange(n)) {
+		trace.record(uint16_t(i), op, makeRegs(i), 10 * i);
+	}
+	auto size = trace.size();
+	CHECK(size < n);
+	CHECK(size > InstructionTrace::CHUNK_SIZE / InstructionTrace::MAX_RECORD_SIZE);
+
+	// the newest instructions are kept, decoding a chunk from its start
+	// gives the exact same registers
+	auto entries = trace.getLast(size);
+	REQUIRE(entries.size() == size);
+	for (auto j : xrange(size)) {
+		auto i = unsigned(n - size + j);
+		CHECK(entries[j].pc == uint16_t(i));
+		CHECK(entries[j].regs == makeRegs(i));
+		CHECK(entries[j].time == 10 * i);
+	}
+
+	auto bin = trace.exportBinary();
+	CHECK(bin.size() > 16);
+	CHECK(bin[0] == 'o');
+	CHECK(bin[8] == 1);  // version
+	CHECK(bin[12] == 2); // number of chunks
+}
+
+TEST_CASE("InstructionTrace: export and import")
+{
+	InstructionTrace trace(0); // 2 chunks
+	std::array<uint8_t, 2> op = {0xED, 0xB0};
+	unsigned n = 20000; // more than 1 chunk
+	for (auto i : xrange(n)) {
+		trace.record(uint16_t(i), op, makeRegs(i), 7 * i);
+	}
+	auto bin = trace.exportBinary();
+
+	InstructionTrace loaded(0);
+	loaded.importBinary(bin);
+	CHECK(loaded.size() == trace.size());
+	auto expected = trace.getLast(trace.size());
+	auto entries = loaded.getLast(loaded.size());
+	REQUIRE(entries.size() == expected.size());
+	for (auto j : xrange(entries.size())) {
+		CHECK(entries[j].pc == expected[j].pc);
+		CHECK(entries[j].regs == expected[j].regs);
+		CHECK(entries[j].time == expected[j].time);
+	}
+	CHECK(loaded.exportBinary() == bin);
+
+	SECTION("continue recording after import") {
+		loaded.record(0x1234, op, makeRegs(n), 7 * n);
+		auto last = loaded.getLast(2);
+		REQUIRE(last.size() == 2);
+		CHECK(last[0].pc == uint16_t(n - 1));
+		CHECK(last[1].pc == 0x1234);
+		CHECK(last[1].regs == makeRegs(n));
+		CHECK(last[1].time == 7 * n);
+	}
+	SECTION("smaller buffer keeps the newest chunks") {
+		InstructionTrace big;
+		for (auto i : xrange(100000u)) {
+			big.record(uint16_t(i), op, makeRegs(i), i);
+		}
+		loaded.importBinary(big.exportBinary());
+		CHECK(loaded.size() < big.size());
+		CHECK(loaded.getLast(1)[0].pc == big.getLast(1)[0].pc);
+	}
+	SECTION("invalid data leaves the recording unchanged") {
+		auto size = loaded.size();
+		auto bad = bin;
+		bad[0] = 'x'; // magic
+		CHECK_THROWS_AS(loaded.importBinary(bad), MSXException);
+		bad = bin;
+		bad[8] = 2; // version
+		CHECK_THROWS_AS(loaded.importBinary(bad), MSXException);
+		bad = bin;
+		bad.pop_back(); // truncated
+		CHECK_THROWS_AS(loaded.importBinary(bad), MSXException);
+		bad = bin;
+		bad.push_back(0); // trailing data
+		CHECK_THROWS_AS(loaded.importBinary(bad), MSXException);
+		bad = bin;
+		bad[16 + 16] = 0; // first record header: opcode length 0
+		CHECK_THROWS_AS(loaded.importBinary(bad), MSXException);
+		bad = bin;
+		bad[16 + 8] ^= 1; // record count of the first chunk
+		CHECK_THROWS_AS(loaded.importBinary(bad), MSXException);
+		CHECK(loaded.size() == size);
+	}
+}
+
+// Measure the cost of recording one instruction. This is only part of the
+// overhead while tracing: CPUCore then also has to execute one instruction
+// at a time. Not run by default, select it explicitly with:
+//   unittest "[benchmark]"
+TEST_CASE("InstructionTrace benchmark", "[.][benchmark]")
+{
+	using Clock = std::chrono::steady_clock;
+
+	InstructionTrace trace;
+	std::array<uint8_t, 3> op = {0x21, 0x00, 0x40};
+	unsigned n = 30'000'000; // wraps the default 64MB buffer a few times
+	auto start = Clock::now();
+	for (auto i : xrange(n)) {
+		trace.record(uint16_t(i), op, makeRegs(i), 5 * i);
+	}
+	auto secs = std::chrono::duration<double>(Clock::now() - start).count();
+	std::cout << "InstructionTrace::record(): " << 1e9 * secs / n << " ns per instruction, "
+	          << trace.size() << " instructions in " << trace.getMaxSize() / 1024 << " kB\n";
+}
@@ -0,0 +1,130 @@
+#include "catch.hpp"
+#include "LineChangeTracker.hh"
+
+#include "xrange.hh"
+
+#include <vector>
+
+using namespace openmsx;
+
+static constexpr int N = LineChangeTracker::NUM_LINES;
+
+// The changed lines of the current frame.
+static std::vector<int> changedLines(const LineChangeTracker& tracker)
+{
+	std::vector<int> result;
+	for (auto y : xrange(N)) {
+		if (!tracker.isUnchanged(y)) result.push_back(y);
+	}
+	return result;
+}
+
+static std::vector<int> range(int from, int to)
+{
+	std::vector<int> result;
+	for (auto y : xrange(from, to)) result.push_back(y);
+	return result;
+}
+
+// Draw lines [from, to) of the current frame, one by one.
+static void draw(LineChangeTracker& tracker, int from, int to)
+{
+	for (auto y : xrange(from, to)) tracker.drawn(y + 1);
+}
+
+static void drawFrame(LineChangeTracker& tracker)
+{
+	tracker.frameStart();
+	draw(tracker, 0, N);
+	tracker.frameEnd();
+}
+
+TEST_CASE("LineChangeTracker")
+{
+	LineChangeTracker tracker;
+
+	// The first frame has no previous frame.
+	tracker.frameStart();
+	CHECK(changedLines(tracker) == range(0, N));
+	draw(tracker, 0, N);
+	tracker.frameEnd();
+
+	tracker.frameStart();
+	CHECK(changedLines(tracker).empty());
+	draw(tracker, 0, N);
+	tracker.frameEnd();
+
+	SECTION("change during the frame") {
+		tracker.frameStart();
+		draw(tracker, 0, 100);
+		tracker.stateChanged();
+		// the rest of the last drawn line and all lines below it
+		CHECK(changedLines(tracker) == range(99, N));
+		draw(tracker, 100, N);
+		tracker.frameEnd();
+
+		// the lines above it (rendered with the old state in the
+		// previous frame)
+		tracker.frameStart();
+		CHECK(changedLines(tracker) == range(0, 100));
+		draw(tracker, 0, N);
+		tracker.frameEnd();
+
+		tracker.frameStart();
+		CHECK(changedLines(tracker).empty());
+	}
+	SECTION("several changes in one frame") {
+		tracker.frameStart();
+		draw(tracker, 0, 150);
+		tracker.stateChanged();
+		draw(tracker, 150, 200);
+		tracker.stateChanged();
+		tracker.stateChanged();
+		draw(tracker, 200, N);
+		tracker.frameEnd();
+		tracker.frameStart();
+		CHECK(changedLines(tracker) == range(0, 200));
+
+		draw(tracker, 0, 30);
+		tracker.stateChanged();
+		// both the old and the new change
+		CHECK(changedLines(tracker) == range(0, N));
+		draw(tracker, 30, N);
+		tracker.frameEnd();
+
+		tracker.frameStart();
+		CHECK(changedLines(tracker) == range(0, 30));
+	}
+	SECTION("change before the first line is drawn") {
+		tracker.frameStart();
+		tracker.stateChanged();
+		CHECK(changedLines(tracker) == range(0, N));
+		drawFrame(tracker);
+		CHECK(changedLines(tracker).empty());
+	}
+	SECTION("change after the end of the frame") {
+		tracker.frameStart();
+		draw(tracker, 0, N);
+		tracker.frameEnd();
+		tracker.stateChanged();
+		tracker.frameStart();
+		CHECK(changedLines(tracker) == range(0, N));
+	}
+	SECTION("change after the last display line") {
+		// e.g. 212 display lines, the bottom border isn't drawn
+		tracker.frameStart();
+		draw(tracker, 0, 212);
+		tracker.stateChanged();
+		tracker.frameEnd();
+		tracker.frameStart();
+		CHECK(changedLines(tracker) == range(0, 212));
+	}
+	SECTION("change in a skipped frame") {
+		// Skipped frames don't call frameStart() and frameEnd().
+		tracker.stateChanged();
+		tracker.frameStart();
+		CHECK(changedLines(tracker) == range(0, N));
+		drawFrame(tracker);
+		CHECK(changedLines(tracker).empty());
+	}
+}
@@ -0,0 +1,58 @@
+#include "catch.hpp"
+#include "MemoryAccessStats.hh"
+
+using namespace openmsx;
+using enum MemoryAccessStats::Type;
+
+TEST_CASE("MemoryAccessStats")
+{
+	MemoryAccessStats stats;
+	CHECK(!stats.isActive());
+	CHECK(stats.get(READ, 0x1234) == 0);
+	CHECK(stats.getMax(WRITE) == 0);
+	CHECK(stats.getPageTotals(EXECUTE)[0x12] == 0);
+
+	stats.setActive(true);
+	stats.count(READ, 0x1234);
+	stats.count(READ, 0x1234);
+	stats.count(READ, 0x12FF);
+	stats.count(WRITE, 0xC000);
+	stats.count(EXECUTE, 0x0000);
+	CHECK(stats.get(READ, 0x1234) == 2);
+	CHECK(stats.get(WRITE, 0x1234) == 0);
+	CHECK(stats.get(WRITE, 0xC000) == 1);
+	CHECK(stats.getMax(READ) == 2);
+
+	auto totals = stats.getPageTotals(READ);
+	CHECK(totals[0x12] == 3);
+	CHECK(totals[0x13] == 0);
+	CHECK(stats.getPageTotals(EXECUTE)[0x00] == 1);
+
+	// stopping keeps the results
+	stats.setActive(false);
+	CHECK(stats.get(READ, 0x1234) == 2);
+
+	stats.reset();
+	CHECK(stats.get(READ, 0x1234) == 0);
+	CHECK(stats.getMax(WRITE) == 0);
+}
+
+TEST_CASE("MemoryAccessStats: parseType")
+{
+	CHECK(MemoryAccessStats::parseType("read") == READ);
+	CHECK(MemoryAccessStats::parseType("write") == WRITE);
+	CHECK(MemoryAccessStats::parseType("execute") == EXECUTE);
+	CHECK(!MemoryAccessStats::parseType("exec"));
+}
+
+TEST_CASE("MemoryAccessStats: fast-forward warning")
+{
+	MemoryAccessStats stats;
+	CHECK(!stats.needFastForwardWarning()); // not active
+	stats.setActive(true);
+	CHECK(stats.needFastForwardWarning());
+	CHECK(!stats.needFastForwardWarning()); // only once
+	stats.setActive(false);
+	stats.setActive(true);
+	CHECK(stats.needFastForwardWarning()); // again after a restart
+}
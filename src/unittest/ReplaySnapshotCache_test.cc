@@ -0,0 +1,94 @@
+#include "catch.hpp"
+
+#include "ReplaySnapshotCache.hh"
+#include "DeltaBlock.hh"
+#include "FileOperations.hh"
+#include "MSXException.hh"
+
+#include "xrange.hh"
+
+#include <string>
+#include <vector>
+
+using namespace openmsx;
+
+static std::vector<uint8_t> makeData(size_t size, unsigned seed)
+{
+	std::vector<uint8_t> result(size);
+	for (auto i : xrange(size)) result[i] = uint8_t((i * 7 + seed * 13) ^ (i >> 5));
+	return result;
+}
+
+// Snapshots with one savestate and two blocks each, consecutive snapshots
+// only differ a little (so most blocks are stored as a delta).
+struct TestSnapshots {
+	explicit TestSnapshots(unsigned num, unsigned seed) {
+		for (auto i : xrange(num)) {
+			auto& savestate = savestates.emplace_back(makeData(100 + i, seed + i));
+			auto block0 = makeData(4096, seed);
+			block0[i] = 0xFF;
+			auto block1 = makeData(1000, seed + 1);
+			block1[999 - i] = 0xEE;
+			blocks.push_back({block0, block1});
+			snapshots.push_back({
+				EmuTime::makeEmuTime(uint64_t(1000) * i), i * 3, savestate,
+				{std::make_shared<DeltaBlockCopy>(block0),
+				 std::make_shared<DeltaBlockCopy>(block1)}});
+		}
+	}
+	std::vector<std::vector<uint8_t>> savestates;
+	std::vector<std::vector<std::vector<uint8_t>>> blocks;
+	std::vector<ReplaySnapshotCache::Snapshot> snapshots;
+};
+
+static void check(std::span<const ReplaySnapshotCache::Snapshot> loaded, const TestSnapshots& expected)
+{
+	REQUIRE(loaded.size() == expected.snapshots.size());
+	for (auto i : xrange(loaded.size())) {
+		const auto& s = loaded[i];
+		CHECK(s.time == expected.snapshots[i].time);
+		CHECK(s.eventCount == expected.snapshots[i].eventCount);
+		CHECK(std::ranges::equal(s.savestate, expected.savestates[i]));
+		REQUIRE(s.deltaBlocks.size() == 2);
+		for (auto j : xrange(2)) {
+			std::vector<uint8_t> buf(s.deltaBlocks[j]->getSize());
+			s.deltaBlocks[j]->apply(buf);
+			CHECK(buf == expected.blocks[i][j]);
+		}
+	}
+}
+
+TEST_CASE("ReplaySnapshotCache")
+{
+	auto tmp = FileOperations::getTempDir() + "/snapshotcache_unittest";
+	FileOperations::deleteRecursive(tmp);
+	FileOperations::mkdirp(tmp);
+	auto filename = tmp + "/test.omr.cache";
+
+	TestSnapshots first(20, 1); // more than one keyframe interval
+	ReplaySnapshotCache::save(filename, "key1", first.snapshots);
+	{
+		ReplaySnapshotCache cache(filename, "key1");
+		check(cache.getSnapshots(), first);
+	}
+	CHECK_THROWS_AS(ReplaySnapshotCache(filename, "key2"), MSXException);
+
+	SECTION("overwrite while mapped") {
+		// The old file stays valid for whoever still has it mapped.
+		auto cache = std::make_unique<ReplaySnapshotCache>(filename, "key1");
+		auto mapping = cache->getMapping();
+		auto oldSnapshots = std::vector(cache->getSnapshots().begin(),
+		                                cache->getSnapshots().end());
+		cache.reset();
+
+		TestSnapshots second(5, 100);
+		ReplaySnapshotCache::save(filename, "key2", second.snapshots);
+		check(oldSnapshots, first);
+		CHECK(!FileOperations::exists(filename + ".tmp"));
+
+		ReplaySnapshotCache newCache(filename, "key2");
+		check(newCache.getSnapshots(), second);
+	}
+
+	FileOperations::deleteRecursive(tmp);
+}
@@ -0,0 +1,156 @@
+#include "catch.hpp"
+
+#include "ReplayStream.hh"
+#include "File.hh"
+#include "FileOperations.hh"
+#include "StateChange.hh"
+
+#include "cstdiop.hh" // for dup()
+#include "xrange.hh"
+
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+using namespace openmsx;
+
+// Write a segment the same way as XmlOutputArchive does.
+static void writeSegment(ReplayStreamWriter& writer, const std::string& content)
+{
+	FILE* f = writer.beginSegment();
+	REQUIRE(fflush(f) == 0);
+	gzFile gz = gzdopen(dup(fileno(f)), "wb9");
+	REQUIRE(gz);
+	gzwrite(gz, content.data(), unsigned(content.size()));
+	gzclose(gz);
+	writer.endSegment();
+}
+
+static std::string readSegment(const ReplayStreamReader& reader, size_t i)
+{
+	auto buf = reader.getSegment(i);
+	return {buf.begin(), buf.end()};
+}
+
+TEST_CASE("ReplayStream")
+{
+	auto tmp = FileOperations::getTempDir() + "/replaystream_unittest";
+	FileOperations::deleteRecursive(tmp);
+	FileOperations::mkdirp(tmp);
+	auto filename = tmp + "/test.omr";
+
+	std::string large;
+	for (auto i : xrange(100000)) large += char('a' + (i * 7919) % 26);
+
+	{
+		ReplayStreamWriter writer(filename);
+		writeSegment(writer, "first");
+		writeSegment(writer, large);
+		writeSegment(writer, "third");
+		CHECK(writer.getNumSegments() == 3);
+	}
+	CHECK(ReplayStreamReader::isReplayStream(filename));
+	{
+		ReplayStreamReader reader(filename);
+		REQUIRE(reader.getNumSegments() == 3);
+		CHECK(readSegment(reader, 0) == "first");
+		CHECK(readSegment(reader, 1) == large);
+		CHECK(readSegment(reader, 2) == "third");
+	}
+
+	SECTION("interrupted write") {
+		// Chop off the last index and part of the last segment. The
+		// remaining segments are found by scanning the records.
+		{
+			File file(filename);
+			std::vector<uint8_t> content(file.getSize());
+			file.read(std::span{content});
+			file.close();
+			auto f = FileOperations::openFile(filename, "wb");
+			fwrite(content.data(), 1, content.size() - 60, f.get());
+		}
+		ReplayStreamReader reader(filename);
+		REQUIRE(reader.getNumSegments() == 2);
+		CHECK(readSegment(reader, 0) == "first");
+		CHECK(readSegment(reader, 1) == large);
+	}
+
+	FileOperations::deleteRecursive(tmp);
+}
+
+namespace {
+class TestEvent final : public StateChange
+{
+public:
+	explicit TestEvent(EmuTime::param time_) : StateChange(time_) {}
+};
+
+// Like the history of ReverseManager: an event log and the snapshot times.
+struct TestHistory {
+	ReplayStreamPosition::Events events;
+	std::vector<EmuTime> snapshots;
+
+	static EmuTime t(unsigned n) { return EmuTime::makeEmuTime(1000 * n); }
+	void input(unsigned n) { events.push_back(std::make_unique<TestEvent>(t(n))); }
+	void snapshot(unsigned n) { snapshots.push_back(t(n)); }
+	// 'reverse goto' followed by new input: the snapshots and events after
+	// the goto time are dropped
+	void goTo(unsigned n) {
+		std::erase_if(snapshots, [&](EmuTime s) { return s > t(n); });
+		while (!events.empty() && (events.back()->getTime() > t(n))) events.pop_back();
+	}
+	bool isPrefix(const ReplayStreamPosition& pos) const {
+		return pos.isPrefixOf(events, events.size(), snapshots);
+	}
+};
+}
+
+TEST_CASE("ReplayStreamPosition")
+{
+	TestHistory hist;
+	hist.snapshot(0);
+	for (auto n : {10, 20, 30, 40}) hist.input(n);
+	hist.snapshot(50);
+	for (auto n : {60, 70}) hist.input(n);
+
+	ReplayStreamPosition pos;
+	CHECK(!hist.isPrefix(pos)); // nothing written yet
+	pos.firstSnapshotTime = TestHistory::t(0);
+	pos.update(hist.events, hist.events.size(), TestHistory::t(50));
+	CHECK(hist.isPrefix(pos));
+
+	SECTION("new input") {
+		hist.input(80);
+		hist.snapshot(100);
+		CHECK(hist.isPrefix(pos));
+	}
+	SECTION("goto after the written data, then new input") {
+		hist.goTo(75);
+		hist.input(76);
+		CHECK(hist.isPrefix(pos));
+	}
+	SECTION("goto before the last written event, then new input") {
+		hist.goTo(65); // drops the event at 70
+		hist.input(66); // same number of events as written
+		CHECK(!hist.isPrefix(pos));
+	}
+	SECTION("same object for a different event") {
+		// the allocator may reuse the memory of a dropped event
+		hist.goTo(65);
+		hist.input(66);
+		pos.lastEvent = hist.events.back().get();
+		CHECK(!hist.isPrefix(pos));
+	}
+	SECTION("goto before the last written snapshot, then new input") {
+		ReplayStreamPosition pos2;
+		pos2.firstSnapshotTime = TestHistory::t(0);
+		pos2.update(hist.events, 4, TestHistory::t(50)); // up to the event at 40
+		hist.goTo(45); // drops the snapshot at 50, keeps the written events
+		hist.input(46);
+		CHECK(!hist.isPrefix(pos2));
+	}
+	SECTION("different first snapshot") {
+		pos.firstSnapshotTime = TestHistory::t(1);
+		CHECK(!hist.isPrefix(pos));
+	}
+}
@@ -0,0 +1,117 @@
+#include "catch.hpp"
+#include "ResampleHQKernels.hh"
+
+#include "xrange.hh"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+using namespace openmsx::ResampleHQKernels;
+
+template<unsigned CHANNELS, bool REVERSE>
+static void check(size_t len, unsigned seed)
+{
+	std::minstd_rand gen(seed);
+	std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+	// Extra elements before/after, so that unaligned start positions and
+	// (for REVERSE) negative offsets are tested.
+	std::vector<float> buf((len + 3) * CHANNELS);
+	std::vector<float> tab(len + 3);
+	for (auto& b : buf) b = dist(gen);
+	for (auto& t : tab) t = dist(gen);
+
+	for (auto offset : xrange(4)) {
+		const float* b = buf.data() + offset * CHANNELS / 2;
+		const float* t = REVERSE ? (tab.data() + len + offset / 2) : (tab.data() + offset / 2);
+
+		float expected[CHANNELS];
+		float actual[CHANNELS];
+		calcScalar<CHANNELS, REVERSE>(b, t, len, expected);
+		calc<CHANNELS, REVERSE>(b, t, len, actual);
+
+		// Same terms, but summed in a different order (and possibly with
+		// fused multiply-add). So allow a few ulps of the sum of the
+		// absolute values of the terms.
+		for (auto ch : xrange(CHANNELS)) {
+			double absSum = 0.0;
+			for (auto i : xrange(len)) {
+				auto c = REVERSE ? t[-ptrdiff_t(i) - 1] : t[i];
+				absSum += std::abs(double(c) * double(b[CHANNELS * i + ch]));
+			}
+			CHECK(std::abs(double(actual[ch]) - double(expected[ch])) <= absSum * 1e-6);
+		}
+	}
+}
+
+TEST_CASE("ResampleHQKernels")
+{
+	// all multiples of 4, small ones and typical filter lengths
+	for (size_t len : {4, 8, 12, 16, 20, 24, 28, 32, 36, 60, 64, 68, 100, 124, 128, 132}) {
+		check<1, false>(len, unsigned(len));
+		check<1, true >(len, unsigned(len));
+		check<2, false>(len, unsigned(len));
+		check<2, true >(len, unsigned(len));
+	}
+}
+
+TEST_CASE("ResampleHQKernels exact")
+{
+	// With small integer values all versions must give the exact result.
+	std::vector<float> buf(2 * 64);
+	std::vector<float> tab(64);
+	for (auto i : xrange(buf.size())) buf[i] = float(int(i % 7) - 3);
+	for (auto i : xrange(tab.size())) tab[i] = float(int(i % 5) - 2);
+	for (size_t len : {4, 8, 12, 16, 28, 32, 60, 64}) {
+		float expected[2], actual[2];
+		calcScalar<1, false>(buf.data(), tab.data(), len, expected);
+		calc      <1, false>(buf.data(), tab.data(), len, actual);
+		CHECK(actual[0] == expected[0]);
+		calcScalar<2, true>(buf.data(), tab.data() + len, len, expected);
+		calc      <2, true>(buf.data(), tab.data() + len, len, actual);
+		CHECK(actual[0] == expected[0]);
+		CHECK(actual[1] == expected[1]);
+	}
+}
+
+// Not run by default, select it explicitly with:
+//   unittest "[benchmark]"
+template<unsigned CHANNELS, bool SCALAR>
+static void benchmark(size_t len)
+{
+	static constexpr int N = 1000000;
+	std::vector<float> buf((len + N / 1000) * CHANNELS, 0.25f);
+	std::vector<float> tab(len, 0.5f);
+	float out[CHANNELS];
+	float sum = 0.0f;
+
+	using clock = std::chrono::steady_clock;
+	auto start = clock::now();
+	for (auto i : xrange(N)) {
+		const float* b = &buf[(i % (N / 1000)) * CHANNELS];
+		if constexpr (SCALAR) {
+			calcScalar<CHANNELS, false>(b, tab.data(), len, out);
+		} else {
+			calc      <CHANNELS, false>(b, tab.data(), len, out);
+		}
+		sum += out[0];
+	}
+	std::chrono::duration<double> elapsed = clock::now() - start;
+	std::cout << "ResampleHQ kernel " << (SCALAR ? "scalar" : "simd  ")
+	          << (CHANNELS == 1 ? " mono  " : " stereo") << " len=" << len << ": "
+	          << (elapsed.count() * 1e9 / N) << " ns/sample"
+	          << " (" << sum << ")\n"; // print sum to avoid optimizing it away
+}
+
+TEST_CASE("ResampleHQKernels benchmark", "[.][benchmark]")
+{
+	for (size_t len : {32, 64, 124}) {
+		benchmark<1, true >(len);
+		benchmark<1, false>(len);
+		benchmark<2, true >(len);
+		benchmark<2, false>(len);
+	}
+}
@@ -0,0 +1,72 @@
+#include "catch.hpp"
+#include "SPSCRingBuffer.hh"
+
+#include "xrange.hh"
+
+#include <array>
+#include <thread>
+#include <vector>
+
+using namespace openmsx;
+
+TEST_CASE("SPSCRingBuffer")
+{
+	SPSCRingBuffer<int> buf(5);
+	CHECK(buf.getCapacity() == 5);
+	CHECK(buf.empty());
+
+	std::array<int, 3> in1 = {1, 2, 3};
+	CHECK(buf.push(in1) == 3);
+	CHECK(buf.size() == 3);
+
+	std::array<int, 2> out2 = {};
+	CHECK(buf.pop(out2) == 2);
+	CHECK(out2 == std::array{1, 2});
+	CHECK(buf.size() == 1);
+
+	// wraps around, and only partially fits
+	std::array<int, 6> in2 = {4, 5, 6, 7, 8, 9};
+	CHECK(buf.push(in2) == 4);
+	CHECK(buf.size() == 5);
+	CHECK(buf.push(in2) == 0);
+
+	std::array<int, 6> out6 = {};
+	CHECK(buf.pop(out6) == 5);
+	CHECK(out6 == std::array{3, 4, 5, 6, 7, 0});
+	CHECK(buf.empty());
+	CHECK(buf.pop(out6) == 0);
+
+	CHECK(buf.push(in1) == 3);
+	buf.clear();
+	CHECK(buf.empty());
+}
+
+TEST_CASE("SPSCRingBuffer threads")
+{
+	static constexpr int N = 1000000;
+	SPSCRingBuffer<int> buf(97);
+
+	std::thread producer([&] {
+		std::array<int, 13> chunk;
+		int next = 0;
+		while (next < N) {
+			int n = std::min(int(chunk.size()), N - next);
+			for (auto i : xrange(n)) chunk[i] = next + i;
+			next += int(buf.push(std::span{chunk}.first(n)));
+		}
+	});
+
+	std::vector<int> received;
+	received.reserve(N);
+	std::array<int, 17> chunk;
+	while (received.size() < N) {
+		auto n = buf.pop(chunk);
+		received.insert(received.end(), chunk.begin(), chunk.begin() + n);
+	}
+	producer.join();
+
+	CHECK(buf.empty());
+	bool ok = true;
+	for (auto i : xrange(N)) ok &= received[i] == i;
+	CHECK(ok);
+}
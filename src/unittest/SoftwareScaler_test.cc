@@ -0,0 +1,123 @@
+#include "catch.hpp"
+
+#include "SoftwareScaler.hh"
+#include "PixelOperations.hh"
+#include "RawFrame.hh"
+
+#include "MemBuffer.hh"
+#include "aligned.hh"
+#include "ranges.hh"
+#include "xrange.hh"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+using namespace openmsx;
+using Pixel = SoftwareScaler::Pixel;
+
+// A 320x240 frame (the most common MSX output), with a pattern that's
+// different for each pixel.
+static void fillFrame(RawFrame& frame, unsigned seed)
+{
+	for (auto y : xrange(frame.getHeight())) {
+		auto line = frame.getLineDirect(y);
+		for (auto x : xrange(320u)) {
+			line[x] = (x * 0x010203 + y * 0x030201 + seed) | 0xff000000;
+		}
+		frame.setLineWidth(y, 320);
+	}
+}
+
+TEST_CASE("SoftwareScaler")
+{
+	RawFrame frame(320, 240);
+	fillFrame(frame, 0);
+
+	unsigned width = 640;
+	unsigned height = 480;
+	MemBuffer<Pixel, SSE_ALIGNMENT> out1(width * height);
+	MemBuffer<Pixel, SSE_ALIGNMENT> out2(width * height);
+	std::span<Pixel> dst1{out1.data(), width * height};
+	std::span<Pixel> dst2{out2.data(), width * height};
+
+	SECTION("no scanlines") {
+		SoftwareScaler scaler;
+		scaler.scale(frame, nullptr, 255, dst1, width, height);
+		for (auto y : xrange(height)) {
+			auto src = frame.getLineDirect(y / 2);
+			for (auto x : xrange(width)) {
+				CHECK(dst1[y * width + x] == src[x / 2]);
+			}
+		}
+	}
+	SECTION("scanlines") {
+		SoftwareScaler scaler;
+		scaler.scale(frame, nullptr, 100, dst1, width, height);
+		for (auto y : xrange(height)) {
+			auto src = frame.getLineDirect(y / 2);
+			for (auto x : xrange(width)) {
+				auto expected = (y & 1) ? PixelOperations::multiply(src[x / 2], 100)
+				                        : src[x / 2];
+				CHECK(dst1[y * width + x] == expected);
+			}
+		}
+	}
+	SECTION("multi-threaded gives the same result") {
+		SoftwareScaler scaler1(1);
+		SoftwareScaler scalerN(3);
+		CHECK(scalerN.getNumThreads() == 3);
+		for (auto scanline : {255u, 100u}) {
+			scaler1.scale(frame, nullptr, scanline, dst1, width, height);
+			ranges::fill(dst2, 0);
+			scalerN.scale(frame, nullptr, scanline, dst2, width, height);
+			CHECK(ranges::equal(dst1, dst2));
+		}
+		scalerN.setNumThreads(1);
+		CHECK(scalerN.getNumThreads() == 1);
+		ranges::fill(dst2, 0);
+		scalerN.scale(frame, nullptr, 100, dst2, width, height);
+		CHECK(ranges::equal(dst1, dst2));
+	}
+}
+
+
+// Measure the frames/sec of the software renderer scaler at the output sizes
+// used for scale_factor 1, 2 and 3. Not run by default, select it explicitly
+// with:
+//   unittest "[benchmark]"
+TEST_CASE("SoftwareScaler benchmark", "[.][benchmark]")
+{
+	using Clock = std::chrono::steady_clock;
+
+	// two different frames, so that each scale() has to read new data
+	RawFrame frame0(320, 240);
+	RawFrame frame1(320, 240);
+	fillFrame(frame0, 0);
+	fillFrame(frame1, 12345);
+
+	auto maxThreads = std::max(4u, std::thread::hardware_concurrency());
+	for (auto factor : {1u, 2u, 3u}) {
+		unsigned width = 320 * factor;
+		unsigned height = 240 * factor;
+		MemBuffer<Pixel, SSE_ALIGNMENT> out(width * height);
+		std::span<Pixel> dst{out.data(), width * height};
+		for (auto numThreads : {1u, 2u, maxThreads}) {
+			SoftwareScaler scaler(numThreads);
+			unsigned frames = 0;
+			auto start = Clock::now();
+			auto end = start + std::chrono::milliseconds(500);
+			Clock::time_point now;
+			do {
+				scaler.scale((frames & 1) ? frame1 : frame0, nullptr, 200,
+				             dst, width, height);
+				++frames;
+				now = Clock::now();
+			} while (now < end);
+			auto secs = std::chrono::duration<double>(now - start).count();
+			std::cout << factor << "x (" << width << 'x' << height << "), "
+			          << numThreads << " thread(s): "
+			          << unsigned(frames / secs) << " frames/sec\n";
+		}
+	}
+}
@@ -0,0 +1,254 @@
+#include "catch.hpp"
+
+#include "BooleanSetting.hh"
+#include "Debuggable.hh"
+#include "Debugger.hh"
+#include "DeltaBlock.hh"
+#include "File.hh"
+#include "FileOperations.hh"
+#include "GlobalCommandController.hh"
+#include "MSXCommandController.hh"
+#include "MSXMotherBoard.hh"
+#include "Reactor.hh"
+#include "Scheduler.hh"
+#include "SettingsManager.hh"
+#include "VDP.hh"
+#include "serialize.hh"
+
+#include "xrange.hh"
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+// Compares the two ways VDPCmdEngine executes the block commands: complete
+// lines at once (see VDPCmdEngine::executeLines()) and one VRAM access at a
+// time (with the 'vdpcmdfastpath' setting turned off). Both must give the
+// same VRAM content and the same timing.
+//
+// VDPCmdEngine needs a VDP, and that needs a machine. So this test creates a
+// Reactor with a machine that only has a VDP, and drives that VDP directly
+// via its I/O ports.
+
+using namespace openmsx;
+
+namespace {
+
+constexpr const char* MACHINE_NAME = "vdpcmdengine_unittest";
+constexpr const char* MACHINE_CONFIG = R"(<?xml version="1.0" ?>
+<!DOCTYPE msxconfig SYSTEM 'msxconfig2.dtd'>
+<msxconfig>
+  <info>
+    <type>MSX2+</type>
+  </info>
+  <devices>
+    <VDP id="VDP">
+      <io base="0x98" num="4" type="O"/>
+      <io base="0x98" num="2" type="I"/>
+      <version>V9958</version>
+      <vram>128</vram>
+    </VDP>
+  </devices>
+</msxconfig>
+)";
+
+struct VDPCommand {
+	uint8_t cmd; // including the logical operation
+	unsigned sx, sy, dx, dy, nx, ny;
+	uint8_t arg;
+	uint8_t clr = 0x5A;
+};
+
+struct Result {
+	std::vector<uint8_t> vram;
+	std::vector<uint8_t> state; // the VDP savestate, includes the engine time
+	unsigned polls = 0; // how many status reads until CE was reset
+
+	bool operator==(const Result&) const = default;
+};
+
+class VDPMachine
+{
+public:
+	VDPMachine(Reactor& reactor, uint8_t mode, bool fastPath)
+		: board(reactor.createEmptyMotherBoard())
+	{
+		board->loadMachine(MACHINE_NAME);
+		board->powerUp();
+		vdp = dynamic_cast<VDP*>(board->findDevice("VDP"));
+		REQUIRE(vdp);
+		auto* setting = dynamic_cast<BooleanSetting*>(
+			board->getMSXCommandController().findSetting("vdpcmdfastpath"));
+		REQUIRE(setting);
+		setting->setBoolean(fastPath);
+		time = board->getCurrentTime();
+
+		// Some (deterministic) content, so that the source and the
+		// destination of the commands differ.
+		vram = board->getDebugger().findDebuggable("physical VRAM");
+		REQUIRE(vram);
+		uint32_t seed = 1;
+		for (auto addr : xrange(0x20000u)) {
+			seed = seed * 1664525 + 1013904223;
+			vram->write(addr, uint8_t(seed >> 24));
+		}
+
+		setRegister(0, mode);
+		setRegister(1, 0x40); // display enabled
+		setRegister(8, 0x0A); // 64kx4 VRAM chips, sprites disabled
+		setRegister(9, 0x00);
+		setRegister(15, 2); // status register 2 (for CE)
+	}
+
+	void setRegister(uint8_t reg, uint8_t value) {
+		write(0x99, value);
+		write(0x99, 0x80 | reg);
+	}
+
+	void execute(const VDPCommand& c) {
+		for (auto [reg, value] : {std::pair{32, c.sx}, {34, c.sy}, {36, c.dx},
+		                          {38, c.dy}, {40, c.nx}, {42, c.ny}}) {
+			setRegister(uint8_t(reg + 0), uint8_t(value & 0xFF));
+			setRegister(uint8_t(reg + 1), uint8_t(value >> 8));
+		}
+		setRegister(44, c.clr);
+		setRegister(45, c.arg);
+		setRegister(46, c.cmd);
+	}
+
+	// The CPU doesn't look at the VDP until the command is surely done.
+	Result waitIdle() {
+		advance(EmuDuration::msec(200));
+		uint8_t status = vdp->readIO(0x99, time);
+		CHECK((status & 0x01) == 0);
+		return getResult(0);
+	}
+
+	// The CPU polls the CE bit (so the command engine is synced often).
+	Result waitPolling() {
+		unsigned polls = 0;
+		do {
+			advance(EmuDuration::usec(7));
+			++polls;
+		} while (vdp->readIO(0x99, time) & 0x01);
+		return getResult(polls);
+	}
+
+private:
+	void write(uint16_t port, uint8_t value) {
+		advance(EmuDuration::usec(2));
+		vdp->writeIO(port, value, time);
+	}
+
+	void advance(EmuDuration d) {
+		time += d;
+		board->getScheduler().schedule(time);
+	}
+
+	Result getResult(unsigned polls) {
+		Result result;
+		result.polls = polls;
+		result.vram.resize(0x20000);
+		for (auto addr : xrange(0x20000u)) {
+			result.vram[addr] = vram->read(addr);
+		}
+		LastDeltaBlocks lastDeltaBlocks;
+		std::vector<std::shared_ptr<DeltaBlock>> deltaBlocks;
+		MemOutputArchive out(lastDeltaBlocks, deltaBlocks, false);
+		out.serialize("vdp", *vdp);
+		size_t size;
+		auto buf = out.releaseBuffer(size);
+		result.state.assign(buf.data(), buf.data() + size);
+		return result;
+	}
+
+private:
+	Reactor::Board board;
+	VDP* vdp = nullptr;
+	Debuggable* vram = nullptr;
+	EmuTime time = EmuTime::zero();
+};
+
+class VDPReactor
+{
+public:
+	VDPReactor() {
+		auto dir = FileOperations::join(FileOperations::getUserDataDir(), "machines");
+		FileOperations::mkdirp(dir);
+		filename = FileOperations::join(dir, std::string(MACHINE_NAME) + ".xml");
+		File(filename, File::OpenMode::TRUNCATE).write(
+			std::span{reinterpret_cast<const uint8_t*>(MACHINE_CONFIG),
+			          std::char_traits<char>::length(MACHINE_CONFIG)});
+
+		reactor.init();
+		// Don't sync the emulated time with the real time.
+		auto* throttle = dynamic_cast<BooleanSetting*>(
+			reactor.getGlobalCommandController().getSettingsManager().findSetting("throttle"));
+		REQUIRE(throttle);
+		throttle->setBoolean(false);
+		// This also creates the Display, with the dummy renderer (the
+		// renderer setting is still 'uninitialized').
+		reactor.switchMachine(MACHINE_NAME);
+	}
+	~VDPReactor() {
+		FileOperations::unlink(filename);
+	}
+
+	Reactor reactor;
+
+private:
+	std::string filename;
+};
+
+Result run(Reactor& reactor, uint8_t mode, const VDPCommand& c, bool fastPath, bool polling)
+{
+	VDPMachine machine(reactor, mode, fastPath);
+	machine.execute(c);
+	return polling ? machine.waitPolling() : machine.waitIdle();
+}
+
+} // namespace
+
+TEST_CASE("VDPCmdEngine: line path matches the per access path")
+{
+	VDPReactor vr;
+	struct Mode { const char* name; uint8_t r0; unsigned width; };
+	for (auto [modeName, r0, width] : {Mode{"G4", 0x06, 256}, Mode{"G5", 0x08, 512},
+	                                   Mode{"G6", 0x0A, 512}, Mode{"G7", 0x0E, 256}}) {
+		// Write to lines 256 and up: this way the sprite tables (at
+		// address 0) are not overwritten, those would need the per
+		// access path.
+		for (uint8_t dir : {0x00, 0x04, 0x08, 0x0C}) {
+			bool left = dir & 0x04;
+			bool up   = dir & 0x08;
+			unsigned dy = up ? 330 : 290;
+			for (bool clipped : {false, true}) {
+				unsigned nx = clipped ? 200 : 100;
+				unsigned dx = left ? (clipped ? 40 : 150) : (clipped ? width - 60 : 37);
+				unsigned sx = left ? 120 : 11;
+				std::vector<VDPCommand> commands = {
+					{0xC0, 0, 0, dx, dy, nx, 40, dir},        // HMMV
+					{0xD0, sx, 20, dx, dy, nx, 40, dir},      // HMMM
+					{0x90, sx, 20, dx, dy, nx, 40, dir},      // LMMM IMP
+					{0x93, sx, 20, dx, dy, nx, 40, dir},      // LMMM XOR
+					{0x98, sx, 20, dx, dy, nx, 40, dir},      // LMMM TIMP
+				};
+				for (const auto& c : commands) {
+					for (bool polling : {false, true}) {
+						INFO(modeName << " CMD=0x" << std::hex << int(c.cmd)
+						     << " ARG=0x" << int(c.arg) << std::dec
+						     << " DX=" << c.dx << " NX=" << c.nx
+						     << (polling ? " polling" : " idle"));
+						auto fast  = run(vr.reactor, r0, c, true,  polling);
+						auto exact = run(vr.reactor, r0, c, false, polling);
+						CHECK(fast.vram == exact.vram);
+						CHECK(fast.state == exact.state);
+						CHECK(fast.polls == exact.polls);
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,52 @@
+#include "catch.hpp"
+
+#include "WorkerPool.hh"
+
+#include "ranges.hh"
+#include "xrange.hh"
+
+#include <thread>
+#include <vector>
+
+using namespace openmsx;
+
+TEST_CASE("WorkerPool")
+{
+	WorkerPool pool(4);
+	CHECK(pool.getNumThreads() == 4);
+
+	auto check = [&](unsigned numParts) {
+		std::vector<int> count(numParts, 0);
+		std::vector<std::thread::id> ids(numParts);
+		pool.run(numParts, [&](unsigned part) {
+			++count[part];
+			ids[part] = std::this_thread::get_id();
+		});
+		CHECK(ranges::all_of(count, [](int c) { return c == 1; }));
+		CHECK(ids[0] == std::this_thread::get_id()); // part 0 on caller
+		for (auto i : xrange(numParts)) {
+			for (auto j : xrange(i)) {
+				CHECK(ids[i] != ids[j]);
+			}
+		}
+	};
+
+	SECTION("all parts") {
+		for (auto n = 0; n < 100; ++n) check(4);
+	}
+	SECTION("fewer parts than threads") {
+		for (auto n = 0; n < 100; ++n) check(1 + (n % 4));
+	}
+	SECTION("change number of threads") {
+		pool.setNumThreads(2);
+		CHECK(pool.getNumThreads() == 2);
+		check(2);
+		pool.setNumThreads(0); // clipped to 1
+		CHECK(pool.getNumThreads() == 1);
+		check(1);
+		pool.setNumThreads(6);
+		CHECK(pool.getNumThreads() == 6);
+		check(6);
+		check(3);
+	}
+}
@@ -1,2 +1,24 @@
-#define CATCH_CONFIG_MAIN
+#define CATCH_CONFIG_RUNNER
 #include "catch.hpp"
+
+#include "FileOperations.hh"
+#include "Thread.hh"
+
+#include <cstdlib>
+
+int main(int argc, char* argv[])
+{
+	openmsx::Thread::setMainThread();
+
+	// Tests that create a Reactor must not read or write the user's
+	// openMSX directory.
+	auto home = openmsx::FileOperations::join(
+		openmsx::FileOperations::getTempDir(), "openmsx_unittest");
+#ifdef _WIN32
+	_putenv_s("OPENMSX_HOME", home.c_str());
+#else
+	setenv("OPENMSX_HOME", home.c_str(), 1);
+#endif
+
+	return Catch::Session().run(argc, argv);
+}
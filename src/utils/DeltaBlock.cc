@@ -2,7 +2,9 @@
 
 #include "ranges.hh"
 #include "lz4.hh"
+#include "xrange.hh"
 
+#include <algorithm>
 #include <bit>
 #include <cassert>
 #include <tuple>
@@ -13,6 +15,16 @@
 #ifdef __SSE2__
 #include <emmintrin.h>
 #endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define DELTA_BLOCK_NEON 1 // (32-bit ARM lacks some of the needed instructions)
+#endif
+#if defined(__SSE2__) || defined(DELTA_BLOCK_NEON)
+#define DELTA_BLOCK_SIMD 1
+#endif
 
 namespace openmsx {
 
@@ -45,9 +57,36 @@ static void storeUleb(std::vector<uint8_t>& result, size_t value)
 }
 
 
-// --- Helper functions to compare {4,8,16} bytes at aligned memory locations ---
+// --- Helper functions to compare N bytes at (word-)aligned memory locations ---
+
+// When SIMD instructions are available, work with 16- or 32-byte words,
+// otherwise 4 or 8 bytes. Like in the rest of openMSX the instruction set is
+// selected at compile time (e.g. AVX2 is only used when the build targets a
+// CPU that has it).
+#if defined(__AVX2__)
+static constexpr int WORD_SIZE = sizeof(__m256i);
+#elif defined(DELTA_BLOCK_SIMD)
+static constexpr int WORD_SIZE = 16;
+#else
+static constexpr int WORD_SIZE = sizeof(void*);
+#endif
+// Alignment we try to reach before starting the word-at-a-time loops. The
+// SIMD loads don't require alignment, but avoiding cache-line splits helps.
+static constexpr int ALIGN_SIZE = std::min(WORD_SIZE, 16);
 
-template<int N> bool comp(const uint8_t* p, const uint8_t* q);
+// Returns true iff the N bytes at 'p' and 'q' are all equal. The generic
+// version combines (scalar) words, so that there's only one branch.
+template<int N> bool comp(const uint8_t* p, const uint8_t* q)
+{
+	using Word = uintptr_t;
+	static_assert((N % sizeof(Word)) == 0);
+	Word diff = 0;
+	for (int i = 0; i < N; i += int(sizeof(Word))) {
+		diff |= *std::bit_cast<const Word*>(p + i) ^
+		        *std::bit_cast<const Word*>(q + i);
+	}
+	return diff == 0;
+}
 
 template<> bool comp<4>(const uint8_t* p, const uint8_t* q)
 {
@@ -62,18 +101,122 @@ template<> bool comp<8>(const uint8_t* p, const uint8_t* q)
 }
 
 #ifdef __SSE2__
+[[nodiscard]] static inline __m128i cmpeq16(const uint8_t* p, const uint8_t* q)
+{
+	__m128i a = _mm_loadu_si128(std::bit_cast<const __m128i*>(p));
+	__m128i b = _mm_loadu_si128(std::bit_cast<const __m128i*>(q));
+	return _mm_cmpeq_epi8(a, b);
+}
+
 template<> bool comp<16>(const uint8_t* p, const uint8_t* q)
 {
 	// Tests show that (on my machine) using 1 128-bit load is faster than
 	// 2 64-bit loads. Even though the actual comparison is slightly more
 	// complicated with SSE instructions.
-	__m128i a = _mm_loadu_si128(std::bit_cast<const __m128i*>(p));
-	__m128i b = _mm_loadu_si128(std::bit_cast<const __m128i*>(q));
-	__m128i d = _mm_cmpeq_epi8(a, b);
+	return _mm_movemask_epi8(cmpeq16(p, q)) == 0xffff;
+}
+
+template<> bool comp<64>(const uint8_t* p, const uint8_t* q)
+{
+	__m128i d0 = cmpeq16(p +  0, q +  0);
+	__m128i d1 = cmpeq16(p + 16, q + 16);
+	__m128i d2 = cmpeq16(p + 32, q + 32);
+	__m128i d3 = cmpeq16(p + 48, q + 48);
+	__m128i d = _mm_and_si128(_mm_and_si128(d0, d1), _mm_and_si128(d2, d3));
 	return _mm_movemask_epi8(d) == 0xffff;
 }
 #endif
 
+#ifdef __AVX2__
+[[nodiscard]] static inline __m256i cmpeq32(const uint8_t* p, const uint8_t* q)
+{
+	__m256i a = _mm256_loadu_si256(std::bit_cast<const __m256i*>(p));
+	__m256i b = _mm256_loadu_si256(std::bit_cast<const __m256i*>(q));
+	return _mm256_cmpeq_epi8(a, b);
+}
+
+template<> bool comp<32>(const uint8_t* p, const uint8_t* q)
+{
+	return _mm256_movemask_epi8(cmpeq32(p, q)) == -1;
+}
+
+template<> bool comp<128>(const uint8_t* p, const uint8_t* q)
+{
+	__m256i d0 = cmpeq32(p +  0, q +  0);
+	__m256i d1 = cmpeq32(p + 32, q + 32);
+	__m256i d2 = cmpeq32(p + 64, q + 64);
+	__m256i d3 = cmpeq32(p + 96, q + 96);
+	__m256i d = _mm256_and_si256(_mm256_and_si256(d0, d1), _mm256_and_si256(d2, d3));
+	return _mm256_movemask_epi8(d) == -1;
+}
+#endif
+
+#ifdef DELTA_BLOCK_NEON
+[[nodiscard]] static inline uint8x16_t cmpeq16(const uint8_t* p, const uint8_t* q)
+{
+	return vceqq_u8(vld1q_u8(p), vld1q_u8(q));
+}
+
+template<> bool comp<16>(const uint8_t* p, const uint8_t* q)
+{
+	return vminvq_u8(cmpeq16(p, q)) == 0xff;
+}
+
+template<> bool comp<64>(const uint8_t* p, const uint8_t* q)
+{
+	uint8x16_t d0 = cmpeq16(p +  0, q +  0);
+	uint8x16_t d1 = cmpeq16(p + 16, q + 16);
+	uint8x16_t d2 = cmpeq16(p + 32, q + 32);
+	uint8x16_t d3 = cmpeq16(p + 48, q + 48);
+	uint8x16_t d = vandq_u8(vandq_u8(d0, d1), vandq_u8(d2, d3));
+	return vminvq_u8(d) == 0xff;
+}
+#endif
+
+// Returns the index of the first equal (firstEqual) or different
+// (firstMismatch) byte in the WORD_SIZE bytes at 'p' and 'q', or WORD_SIZE
+// if there is no such byte.
+#if defined(__AVX2__)
+[[nodiscard]] static inline int firstEqual(const uint8_t* p, const uint8_t* q)
+{
+	auto mask = uint32_t(_mm256_movemask_epi8(cmpeq32(p, q)));
+	return mask ? std::countr_zero(mask) : WORD_SIZE;
+}
+[[nodiscard]] static inline int firstMismatch(const uint8_t* p, const uint8_t* q)
+{
+	auto mask = ~uint32_t(_mm256_movemask_epi8(cmpeq32(p, q)));
+	return mask ? std::countr_zero(mask) : WORD_SIZE;
+}
+#elif defined(__SSE2__)
+[[nodiscard]] static inline int firstEqual(const uint8_t* p, const uint8_t* q)
+{
+	auto mask = uint32_t(_mm_movemask_epi8(cmpeq16(p, q)));
+	return mask ? std::countr_zero(mask) : WORD_SIZE;
+}
+[[nodiscard]] static inline int firstMismatch(const uint8_t* p, const uint8_t* q)
+{
+	auto mask = ~uint32_t(_mm_movemask_epi8(cmpeq16(p, q))) & 0xffff;
+	return mask ? std::countr_zero(mask) : WORD_SIZE;
+}
+#elif defined(DELTA_BLOCK_NEON)
+// NEON has no 'movemask', instead narrow each byte to 4 bits.
+[[nodiscard]] static inline uint64_t nibbleMask(uint8x16_t v)
+{
+	uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(v), 4);
+	return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0);
+}
+[[nodiscard]] static inline int firstEqual(const uint8_t* p, const uint8_t* q)
+{
+	auto mask = nibbleMask(cmpeq16(p, q));
+	return mask ? (std::countr_zero(mask) / 4) : WORD_SIZE;
+}
+[[nodiscard]] static inline int firstMismatch(const uint8_t* p, const uint8_t* q)
+{
+	auto mask = nibbleMask(vmvnq_u8(cmpeq16(p, q)));
+	return mask ? (std::countr_zero(mask) / 4) : WORD_SIZE;
+}
+#endif
+
 
 // --- Optimized mismatch function ---
 
@@ -84,38 +227,46 @@ template<> bool comp<16>(const uint8_t* p, const uint8_t* q)
 // Compared to the std::mismatch() this implementation is faster because:
 // - We make use of sentinels. This requires to temporarily change the content
 //   of the buffer. So it won't work with read-only-memory.
-// - We compare words-at-a-time instead of byte-at-a-time.
+// - We compare words-at-a-time instead of byte-at-a-time, and in the common
+//   case (long runs of equal bytes) even 4 words per iteration.
 static std::pair<const uint8_t*, const uint8_t*> scan_mismatch(
 	const uint8_t* p, const uint8_t* p_end, const uint8_t* q, const uint8_t* q_end)
 {
 	assert((p_end - p) == (q_end - q));
 
-	// When SSE is available, work with 16-byte words, otherwise 4 or 8
-	// bytes. This routine also benefits from AVX2 instructions. Though not
-	// all x86_64 CPUs have AVX2 (all have SSE2), so using them requires
-	// extra run-time checks and that's not worth it at this point.
-	constexpr int WORD_SIZE =
-#ifdef __SSE2__
-		sizeof(__m128i);
-#else
-		sizeof(void*);
-#endif
+#ifdef DELTA_BLOCK_SIMD
+	// Region too small.
+	if ((p_end - p) < (2 * WORD_SIZE)) [[unlikely]] {
+		goto end;
+	}
 
+	// SIMD loads don't need aligned addresses, so buffers with different
+	// alignment are fine. Check the first (unaligned) word, then continue
+	// from the next aligned position in 'p'.
+	{
+		if (auto n = firstMismatch(p, q); n != WORD_SIZE) {
+			return {p + n, q + n};
+		}
+		auto skip = ALIGN_SIZE - (std::bit_cast<uintptr_t>(p) & (ALIGN_SIZE - 1));
+		p += skip; q += skip;
+	}
+#else
 	// Region too small or
 	// both buffers are differently aligned.
 	if (((p_end - p) < (2 * WORD_SIZE)) ||
-	    ((std::bit_cast<uintptr_t>(p) & (WORD_SIZE - 1)) !=
-	     (std::bit_cast<uintptr_t>(q) & (WORD_SIZE - 1)))) [[unlikely]] {
+	    ((std::bit_cast<uintptr_t>(p) & (ALIGN_SIZE - 1)) !=
+	     (std::bit_cast<uintptr_t>(q) & (ALIGN_SIZE - 1)))) [[unlikely]] {
 		goto end;
 	}
 
-	// Align to WORD_SIZE boundary. No need for end-of-buffer checks.
-	if (std::bit_cast<uintptr_t>(p) & (WORD_SIZE - 1)) [[unlikely]] {
+	// Align to ALIGN_SIZE boundary. No need for end-of-buffer checks.
+	if (std::bit_cast<uintptr_t>(p) & (ALIGN_SIZE - 1)) [[unlikely]] {
 		do {
 			if (*p != *q) return {p, q};
 			p += 1; q += 1;
-		} while (std::bit_cast<uintptr_t>(p) & (WORD_SIZE - 1));
+		} while (std::bit_cast<uintptr_t>(p) & (ALIGN_SIZE - 1));
 	}
+#endif
 
 	// Fast path. Compare words-at-a-time.
 	{
@@ -126,12 +277,29 @@ static std::pair<const uint8_t*, const uint8_t*> scan_mismatch(
 		auto save = *sentinel;
 		*sentinel = ~q_end[-WORD_SIZE];
 
+		// First compare 4 words per iteration, as long as those stay
+		// within the buffer. This stops at (or before) the block that
+		// contains the first mismatch (possibly the sentinel) ...
+		static constexpr int BLOCK_SIZE = 4 * WORD_SIZE;
+		while (((p_end - p) >= BLOCK_SIZE) && comp<BLOCK_SIZE>(p, q)) {
+			p += BLOCK_SIZE; q += BLOCK_SIZE;
+		}
+		// ... then locate the mismatching word.
 		while (comp<WORD_SIZE>(p, q)) {
 			p += WORD_SIZE; q += WORD_SIZE;
 		}
 
 		// Restore sentinel.
 		*sentinel = save;
+
+#ifdef DELTA_BLOCK_SIMD
+		// When the sentinel isn't part of the mismatching word, we
+		// can locate the exact position within the word right away.
+		if ((p + WORD_SIZE) <= sentinel) {
+			auto n = firstMismatch(p, q);
+			return {p + n, q + n};
+		}
+#endif
 	}
 
 	// Slow path. This handles:
@@ -149,14 +317,24 @@ end:	return std::mismatch(p, p_end, q);
 // Like scan_mismatch(), this places a temporary sentinel in the buffer, so the
 // buffer cannot be read-only memory.
 //
-// Unlike scan_mismatch() it's less obvious how to perform this function
+// Without SIMD instructions it's less obvious how to perform this function
 // word-at-a-time (it's possible with some bit hacks). Though luckily this
 // function is also less performance critical.
-[[nodiscard]] static constexpr std::pair<const uint8_t*, const uint8_t*> scan_match(
+[[nodiscard]] static std::pair<const uint8_t*, const uint8_t*> scan_match(
 	const uint8_t* p, const uint8_t* p_end, const uint8_t* q, const uint8_t* q_end)
 {
 	assert((p_end - p) == (q_end - q));
 
+#ifdef DELTA_BLOCK_SIMD
+	while ((p_end - p) >= WORD_SIZE) {
+		if (auto n = firstEqual(p, q); n != WORD_SIZE) {
+			return {p + n, q + n};
+		}
+		p += WORD_SIZE; q += WORD_SIZE;
+	}
+	// remaining (less than WORD_SIZE) bytes are handled below
+#endif
+
 	// Code below is functionally equivalent to:
 	//   while ((p != p_end) && (*p != *q)) { ++p; ++q; }
 	//   return {p, q};
@@ -175,6 +353,42 @@ end:	return std::mismatch(p, p_end, q);
 }
 
 
+// --- Dirty page aware scanning ---
+
+// Like scan_mismatch(), but only looks at the dirty pages (see DirtyPages).
+// Bytes in clean pages are known to be equal, so those pages are skipped
+// without looking at the actual data. An empty 'dirty' span means that all
+// pages are (possibly) dirty.
+[[nodiscard]] static std::pair<const uint8_t*, const uint8_t*> skip_equal(
+	const uint8_t* p, const uint8_t* p_end, const uint8_t* q, const uint8_t* q_end,
+	const uint8_t* q_begin, std::span<const uint8_t> dirty)
+{
+	if (dirty.empty()) return scan_mismatch(p, p_end, q, q_end);
+
+	auto size = size_t(q_end - q_begin);
+	while (q != q_end) {
+		auto offset = size_t(q - q_begin);
+		auto page = offset >> DirtyPages::PAGE_BITS;
+		auto it = dirty.begin() + page;
+		if (!*it) {
+			// skip clean pages
+			it = std::find_if(it, dirty.end(), [](uint8_t d) { return d != 0; });
+			auto next = std::min(size, size_t(it - dirty.begin()) << DirtyPages::PAGE_BITS);
+			p += next - offset;
+			q += next - offset;
+			continue;
+		}
+		// scan a run of dirty pages
+		it = std::find(it, dirty.end(), uint8_t(0));
+		auto runEnd = std::min(size, size_t(it - dirty.begin()) << DirtyPages::PAGE_BITS);
+		auto n = runEnd - offset;
+		std::tie(p, q) = scan_mismatch(p, p + n, q, q + n);
+		if (size_t(q - q_begin) != runEnd) break; // found a mismatch
+	}
+	return {p, q};
+}
+
+
 // --- delta (de)compression routines ---
 
 // Calculate a 'delta' between two binary buffers of equal size.
@@ -183,8 +397,12 @@ end:	return std::mismatch(p, p_end, q);
 //   n2 number of bytes are different, and here are the bytes
 //   n3 number of bytes are equal
 //   ...
+//
+// When 'dirty' is not empty, only the dirty pages are compared, see
+// skip_equal().
 [[nodiscard]] static std::vector<uint8_t> calcDelta(
-	const uint8_t* oldBuf, std::span<const uint8_t> newBuf)
+	const uint8_t* oldBuf, std::span<const uint8_t> newBuf,
+	std::span<const uint8_t> dirty)
 {
 	std::vector<uint8_t> result;
 
@@ -196,7 +414,7 @@ end:	return std::mismatch(p, p_end, q);
 
 	// scan equal bytes (possibly zero)
 	const auto* q1 = q;
-	std::tie(p, q) = scan_mismatch(p, p_end, q, q_end);
+	std::tie(p, q) = skip_equal(p, p_end, q, q_end, newBuf.data(), dirty);
 	auto n1 = q - q1;
 	storeUleb(result, n1);
 
@@ -209,7 +427,7 @@ end:	return std::mismatch(p, p_end, q);
 		auto n2 = q - q2;
 
 		const auto* q3 = q;
-		std::tie(p, q) = scan_mismatch(p, p_end, q, q_end);
+		std::tie(p, q) = skip_equal(p, p_end, q, q_end, newBuf.data(), dirty);
 		auto n3 = q - q3;
 		if ((q != q_end) && (n3 <= 2)) goto different;
 
@@ -255,6 +473,7 @@ DeltaBlock::~DeltaBlock()
 
 DeltaBlockCopy::DeltaBlockCopy(std::span<const uint8_t> data)
 	: block(data.size())
+	, blockSize(data.size())
 {
 #ifdef DEBUG
 	sha1 = SHA1::calc(data);
@@ -271,6 +490,7 @@ DeltaBlockCopy::DeltaBlockCopy(std::span<const uint8_t> data)
 
 void DeltaBlockCopy::apply(std::span<uint8_t> dst) const
 {
+	std::lock_guard lock(mutex);
 	if (compressed()) {
 		LZ4::decompress(block.data(), dst.data(), int(compressedSize), int(dst.size()));
 	} else {
@@ -281,34 +501,48 @@ void DeltaBlockCopy::apply(std::span<uint8_t> dst) const
 #endif
 }
 
+size_t DeltaBlockCopy::getStorageSize() const
+{
+	std::lock_guard lock(mutex);
+	return compressed() ? compressedSize : blockSize;
+}
+
 void DeltaBlockCopy::compress(size_t size)
 {
-	if (compressed()) return;
+	{
+		std::lock_guard lock(mutex);
+		if (compressed() || compressing) return;
+		compressing = true;
+	}
 
 	size_t dstLen = LZ4::compressBound(int(size));
 	MemBuffer<uint8_t> buf2(dstLen);
 	dstLen = LZ4::compress(block.data(), buf2.data(), int(size));
 
-	if (dstLen >= size) {
-		// compression isn't beneficial
-		return;
+	{
+		std::lock_guard lock(mutex);
+		compressing = false;
+		if (dstLen >= size) {
+			// compression isn't beneficial
+			return;
+		}
+		compressedSize = dstLen;
+		std::swap(block, buf2);
+		block.resize(compressedSize); // shrink to fit
+		assert(compressed());
+#if STATISTICS
+		int delta = compressedSize - allocSize;
+		allocSize = compressedSize;
+		globalAllocSize += delta;
+		std::cout << "stat: compress " << globalAllocSize
+		          << " (" << delta << ")\n";
+#endif
 	}
-	compressedSize = dstLen;
-	std::swap(block, buf2);
-	block.resize(compressedSize); // shrink to fit
-	assert(compressed());
 #ifdef DEBUG
 	MemBuffer<uint8_t> buf3(size);
 	apply({buf3.data(), size});
 	assert(ranges::equal(std::span{buf3.data(), size}, std::span{buf2.data(), size}));
 #endif
-#if STATISTICS
-	int delta = compressedSize - allocSize;
-	allocSize = compressedSize;
-	globalAllocSize += delta;
-	std::cout << "stat: compress " << globalAllocSize
-	          << " (" << delta << ")\n";
-#endif
 }
 
 const uint8_t* DeltaBlockCopy::getData()
@@ -322,9 +556,10 @@ const uint8_t* DeltaBlockCopy::getData()
 
 DeltaBlockDiff::DeltaBlockDiff(
 		std::shared_ptr<DeltaBlockCopy> prev_,
-		std::span<const uint8_t> data)
+		std::span<const uint8_t> data,
+		std::span<const uint8_t> dirtyPages)
 	: prev(std::move(prev_))
-	, delta(calcDelta(prev->getData(), data))
+	, delta(calcDelta(prev->getData(), data, dirtyPages))
 {
 #ifdef DEBUG
 	sha1 = SHA1::calc(data);
@@ -350,16 +585,140 @@ void DeltaBlockDiff::apply(std::span<uint8_t> dst) const
 #endif
 }
 
+size_t DeltaBlockDiff::getStorageSize() const
+{
+	return delta.size();
+}
+
 size_t DeltaBlockDiff::getDeltaSize() const
 {
 	return delta.size();
 }
 
 
+// class DeltaBlockMapped
+
+DeltaBlockMapped::DeltaBlockMapped(
+		std::shared_ptr<const void> owner_, std::span<const uint8_t> data_)
+	: owner(std::move(owner_))
+	, data(data_)
+{
+}
+
+DeltaBlockMapped::DeltaBlockMapped(
+		std::shared_ptr<const void> owner_,
+		std::shared_ptr<const DeltaBlockMapped> ref_,
+		std::span<const uint8_t> delta)
+	: owner(std::move(owner_))
+	, ref(std::move(ref_))
+	, data(delta)
+{
+	assert(ref && !ref->isDelta());
+}
+
+void DeltaBlockMapped::apply(std::span<uint8_t> dst) const
+{
+	if (ref) {
+		ref->apply(dst);
+		applyDeltaInPlace(dst, data);
+	} else {
+		assert(dst.size() == data.size());
+		ranges::copy(data, dst);
+	}
+}
+
+
+std::vector<uint8_t> calcBlockDelta(
+	std::span<const uint8_t> oldData, std::span<const uint8_t> newData)
+{
+	assert(oldData.size() == newData.size());
+	return calcDelta(oldData.data(), newData, {});
+}
+
+void applyBlockDelta(std::span<uint8_t> buf, std::span<const uint8_t> delta)
+{
+	applyDeltaInPlace(buf, delta);
+}
+
+bool isValidBlockDelta(std::span<const uint8_t> delta, size_t size)
+{
+	// Same structure as applyDeltaInPlace(), but with bounds checks.
+	auto load = [&](size_t& result) {
+		result = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			if (delta.empty()) return false;
+			uint8_t b = delta.front();
+			delta = delta.subspan(1);
+			result |= size_t(b & 0x7F) << shift;
+			if ((b & 0x80) == 0) return true;
+		}
+		return false;
+	};
+	while (size != 0) {
+		size_t n1;
+		if (!load(n1) || (n1 > size)) return false;
+		size -= n1;
+		if (size == 0) break;
+
+		size_t n2;
+		if (!load(n2) || (n2 > size) || (n2 > delta.size())) return false;
+		size  -= n2;
+		delta  = delta.subspan(n2);
+	}
+	return true;
+}
+
+
+// class DeltaBlockCompressor
+
+DeltaBlockCompressor::~DeltaBlockCompressor()
+{
+	{
+		std::lock_guard lock(mutex);
+		stopping = true;
+	}
+	workAvailable.notify_all();
+	for (auto& t : threads) t.join();
+}
+
+void DeltaBlockCompressor::schedule(std::shared_ptr<DeltaBlockCopy> block, size_t size)
+{
+	{
+		std::lock_guard lock(mutex);
+		queue.emplace_back(std::move(block), size);
+	}
+	if (threads.empty()) {
+		// Leave one core for the emulation itself, but use at least
+		// one thread (and there's no point in using too many).
+		auto num = std::clamp(std::thread::hardware_concurrency(), 2u, 5u) - 1;
+		for (unsigned i = 0; i < num; ++i) {
+			threads.emplace_back([this]() { run(); });
+		}
+	}
+	workAvailable.notify_one();
+}
+
+void DeltaBlockCompressor::run()
+{
+	std::unique_lock lock(mutex);
+	while (true) {
+		workAvailable.wait(lock, [&] { return !queue.empty() || stopping; });
+		if (queue.empty()) break; // stop requested and no work left
+
+		auto [block, size] = std::move(queue.front());
+		queue.pop_front();
+		lock.unlock();
+		block->compress(size);
+		block.reset(); // possibly the last reference, release outside the lock
+		lock.lock();
+	}
+}
+
+
 // class LastDeltaBlocks
 
 std::shared_ptr<DeltaBlock> LastDeltaBlocks::createNew(
-		const void* id, std::span<const uint8_t> data)
+		const void* id, std::span<const uint8_t> data, const DirtyPages* dirty)
 {
 	auto size = data.size();
 	auto it = ranges::lower_bound(infos, std::tuple(id, size), {},
@@ -376,7 +735,7 @@ std::shared_ptr<DeltaBlock> LastDeltaBlocks::createNew(
 		if (ref) {
 			// We will switch to a new DeltaBlockCopy object. So
 			// now is a good time to compress the old one.
-			ref->compress(size);
+			compress(std::move(ref), size);
 		}
 		// Heuristic: create a new block when too many small
 		// differences have accumulated.
@@ -384,11 +743,22 @@ std::shared_ptr<DeltaBlock> LastDeltaBlocks::createNew(
 		it->ref = b;
 		it->last = b;
 		it->accSize = 0;
+		it->dirtyValid = dirty != nullptr;
+		if (dirty) it->dirtySinceRef.assign(dirty->getPages().size(), 0);
 		return b;
 	} else {
 		// Create diff based on earlier reference block.
 		// Reference remains unchanged.
-		auto b = std::make_shared<DeltaBlockDiff>(ref, data);
+		std::span<const uint8_t> dirtyPages;
+		if (dirty && it->dirtyValid) {
+			auto pages = dirty->getPages();
+			assert(pages.size() == it->dirtySinceRef.size());
+			for (auto i : xrange(pages.size())) it->dirtySinceRef[i] |= pages[i];
+			dirtyPages = it->dirtySinceRef;
+		} else {
+			it->dirtyValid = false;
+		}
+		auto b = std::make_shared<DeltaBlockDiff>(ref, data, dirtyPages);
 		it->last = b;
 		it->accSize += b->getDeltaSize();
 		return b;
@@ -412,6 +782,7 @@ std::shared_ptr<DeltaBlock> LastDeltaBlocks::createNullDiff(
 		it->ref = b;
 		it->last = b;
 		it->accSize = 0;
+		it->dirtyValid = false;
 		return b;
 	} else {
 #ifdef DEBUG
@@ -425,10 +796,19 @@ void LastDeltaBlocks::clear()
 {
 	for (const Info& info : infos) {
 		if (auto ref = info.ref.lock()) {
-			ref->compress(info.size);
+			compress(std::move(ref), info.size);
 		}
 	}
 	infos.clear();
 }
 
+void LastDeltaBlocks::compress(std::shared_ptr<DeltaBlockCopy> block, size_t size)
+{
+	if (compressor) {
+		compressor->schedule(std::move(block), size);
+	} else {
+		block->compress(size);
+	}
+}
+
 } // namespace openmsx
@@ -3,10 +3,17 @@
 
 #define STATISTICS 0
 
+#include "DirtyPages.hh"
 #include "MemBuffer.hh"
+#include <concepts>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <span>
+#include <thread>
+#include <utility>
 #include <vector>
 #ifdef DEBUG
 #include "sha1.hh"
@@ -23,6 +30,10 @@ public:
 	virtual ~DeltaBlock() = default;
 #endif
 	virtual void apply(std::span<uint8_t> dst) const = 0;
+	/** Amount of memory used to store this block (in bytes). */
+	[[nodiscard]] virtual size_t getStorageSize() const = 0;
+	/** Size of the block after apply() (in bytes). */
+	[[nodiscard]] virtual size_t getSize() const = 0;
 
 protected:
 	DeltaBlock() = default;
@@ -45,23 +56,50 @@ class DeltaBlockCopy final : public DeltaBlock
 public:
 	explicit DeltaBlockCopy(std::span<const uint8_t> data);
 	void apply(std::span<uint8_t> dst) const override;
+	[[nodiscard]] size_t getStorageSize() const override;
+	[[nodiscard]] size_t getSize() const override { return blockSize; }
+	/** Compress the block (when that's beneficial). This may be called
+	  * from a different thread, also while other threads are using
+	  * apply() on this block.
+	  */
 	void compress(size_t size);
 	[[nodiscard]] const uint8_t* getData();
+	/** When the block is lz4 compressed (see compress()), call 'f' with
+	  * the compressed data and return true, else return false.
+	  */
+	bool withCompressedData(std::invocable<std::span<const uint8_t>> auto f) const {
+		std::lock_guard lock(mutex);
+		if (!compressed()) return false;
+		f(std::span<const uint8_t>{block.data(), compressedSize});
+		return true;
+	}
 
 private:
 	[[nodiscard]] bool compressed() const { return compressedSize != 0; }
 
+	// Protects 'block' and 'compressedSize'. While 'compressing' is set
+	// 'block' doesn't change, so it can be read without holding the lock.
+	mutable std::mutex mutex;
 	MemBuffer<uint8_t> block;
+	const size_t blockSize; // uncompressed size
 	size_t compressedSize = 0;
+	bool compressing = false;
 };
 
 
 class DeltaBlockDiff final : public DeltaBlock
 {
 public:
+	/** When 'dirtyPages' is given (one byte per DirtyPages::PAGE_SIZE
+	  * bytes) only the dirty pages are compared against 'prev'. The
+	  * clean pages must be equal.
+	  */
 	DeltaBlockDiff(std::shared_ptr<DeltaBlockCopy> prev_,
-	               std::span<const uint8_t> data);
+	               std::span<const uint8_t> data,
+	               std::span<const uint8_t> dirtyPages = {});
 	void apply(std::span<uint8_t> dst) const override;
+	[[nodiscard]] size_t getStorageSize() const override;
+	[[nodiscard]] size_t getSize() const override { return prev->getSize(); }
 	[[nodiscard]] size_t getDeltaSize() const;
 
 private:
@@ -70,15 +108,98 @@ private:
 };
 
 
+/** A block stored in an external buffer (e.g. a memory mapped file), either
+  * as a full copy or as a delta relative to such a full copy. The delta uses
+  * the same format as DeltaBlockDiff, see calcBlockDelta(). 'owner' keeps the
+  * external buffer alive.
+  */
+class DeltaBlockMapped final : public DeltaBlock
+{
+public:
+	DeltaBlockMapped(std::shared_ptr<const void> owner_,
+	                 std::span<const uint8_t> data_);
+	DeltaBlockMapped(std::shared_ptr<const void> owner_,
+	                 std::shared_ptr<const DeltaBlockMapped> ref_,
+	                 std::span<const uint8_t> delta);
+	void apply(std::span<uint8_t> dst) const override;
+	[[nodiscard]] size_t getStorageSize() const override { return data.size(); }
+	[[nodiscard]] size_t getSize() const override {
+		return ref ? ref->getSize() : data.size();
+	}
+	[[nodiscard]] bool isDelta() const { return ref != nullptr; }
+
+private:
+	const std::shared_ptr<const void> owner;
+	const std::shared_ptr<const DeltaBlockMapped> ref; // null for a full copy
+	const std::span<const uint8_t> data; // full copy or delta
+};
+
+/** Calculate the delta between two (equally sized) buffers in the format
+  * used by DeltaBlockDiff. 'oldData' is temporarily modified (so it can't be
+  * in read-only memory), but it's restored before returning.
+  */
+[[nodiscard]] std::vector<uint8_t> calcBlockDelta(
+	std::span<const uint8_t> oldData, std::span<const uint8_t> newData);
+/** Apply a delta calculated by calcBlockDelta() to (a copy of) 'oldData'. */
+void applyBlockDelta(std::span<uint8_t> buf, std::span<const uint8_t> delta);
+/** Check whether 'delta' is well-formed for a block of 'size' bytes, IOW
+  * whether it can safely be applied. Useful for deltas loaded from a file.
+  */
+[[nodiscard]] bool isValidBlockDelta(std::span<const uint8_t> delta, size_t size);
+
+
+/** Compresses DeltaBlockCopy objects in background threads. This keeps the
+  * (lz4) compression out of the thread that creates the blocks (e.g. the
+  * main thread taking a reverse snapshot). The threads are only started
+  * when the first block gets scheduled.
+  */
+class DeltaBlockCompressor
+{
+public:
+	DeltaBlockCompressor() = default;
+	DeltaBlockCompressor(const DeltaBlockCompressor&) = delete;
+	DeltaBlockCompressor(DeltaBlockCompressor&&) = delete;
+	DeltaBlockCompressor& operator=(const DeltaBlockCompressor&) = delete;
+	DeltaBlockCompressor& operator=(DeltaBlockCompressor&&) = delete;
+	~DeltaBlockCompressor(); // first compresses all pending blocks
+
+	void schedule(std::shared_ptr<DeltaBlockCopy> block, size_t size);
+
+private:
+	void run();
+
+private:
+	std::vector<std::thread> threads;
+	std::mutex mutex; // protects the members below
+	std::condition_variable workAvailable;
+	std::deque<std::pair<std::shared_ptr<DeltaBlockCopy>, size_t>> queue;
+	bool stopping = false;
+};
+
+
 class LastDeltaBlocks
 {
 public:
+	/** When 'dirty' is given, it must contain the pages that were
+	  * written since the previous call for this block (for the first
+	  * call: all pages).
+	  */
 	[[nodiscard]] std::shared_ptr<DeltaBlock> createNew(
-		const void* id, std::span<const uint8_t> data);
+		const void* id, std::span<const uint8_t> data,
+		const DirtyPages* dirty = nullptr);
 	[[nodiscard]] std::shared_ptr<DeltaBlock> createNullDiff(
 		const void* id, std::span<const uint8_t> data);
 	void clear();
 
+	/** When set, blocks that are no longer used as reference block are
+	  * compressed in the background, otherwise they're compressed
+	  * immediately.
+	  */
+	void setCompressor(DeltaBlockCompressor* compressor_) { compressor = compressor_; }
+
+private:
+	void compress(std::shared_ptr<DeltaBlockCopy> block, size_t size);
+
 private:
 	struct Info {
 		Info(const void* id_, size_t size_)
@@ -89,9 +210,14 @@ private:
 		std::weak_ptr<DeltaBlockCopy> ref;
 		std::weak_ptr<DeltaBlock> last;
 		size_t accSize = 0;
+		// Pages written since 'ref' was created, only valid when dirty
+		// information was available for all blocks since then.
+		std::vector<uint8_t> dirtySinceRef;
+		bool dirtyValid = false;
 	};
 
 	std::vector<Info> infos;
+	DeltaBlockCompressor* compressor = nullptr;
 };
 
 } // namespace openmsx
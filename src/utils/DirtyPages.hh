@@ -0,0 +1,70 @@
+#ifndef DIRTY_PAGES_HH
+#define DIRTY_PAGES_HH
+
+#include "ranges.hh"
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace openmsx {
+
+/** Keeps track of which pages of a memory block were written since the last
+  * reverse snapshot.
+  *
+  * The delta-compression for reverse snapshots (see DeltaBlock.hh) normally
+  * has to compare the full memory block against the reference block. With
+  * this information it only needs to look at the pages that were actually
+  * written. Snapshots of a block without any dirty page are (almost) free.
+  *
+  * This is only correct when _all_ write paths to the memory block mark the
+  * corresponding page. When in doubt, call markAll().
+  *
+  * The page size matches CacheLine::SIZE (256 bytes). Memory is tracked with
+  * one byte (instead of one bit) per page, this keeps mark() branch-free and
+  * cheap enough to put in the write path of the emulated memory.
+  */
+class DirtyPages
+{
+public:
+	static constexpr unsigned PAGE_BITS = 8;
+	static constexpr size_t PAGE_SIZE = size_t(1) << PAGE_BITS;
+
+	/** Initially all pages are dirty. */
+	explicit DirtyPages(size_t size)
+		: pages((size + PAGE_SIZE - 1) >> PAGE_BITS, 1) {}
+
+	void mark(size_t addr) {
+		pages[addr >> PAGE_BITS] = 1;
+	}
+	void markRange(size_t addr, size_t num) {
+		if (num == 0) return;
+		std::fill(pages.begin() + (addr >> PAGE_BITS),
+		          pages.begin() + ((addr + num - 1) >> PAGE_BITS) + 1,
+		          uint8_t(1));
+	}
+	void markAll() {
+		ranges::fill(pages, uint8_t(1));
+	}
+	void clear() {
+		ranges::fill(pages, uint8_t(0));
+	}
+
+	[[nodiscard]] bool any() const {
+		return ranges::any_of(pages, [](auto p) { return p != 0; });
+	}
+	[[nodiscard]] bool isDirty(size_t page) const {
+		return pages[page] != 0;
+	}
+	/** One byte per page, non-zero means dirty. */
+	[[nodiscard]] std::span<const uint8_t> getPages() const {
+		return pages;
+	}
+
+private:
+	std::vector<uint8_t> pages;
+};
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef SPSCRINGBUFFER_HH
+#define SPSCRINGBUFFER_HH
+
+#include "MemBuffer.hh"
+#include "ranges.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <span>
+
+namespace openmsx {
+
+/** Lock-free ring buffer for one producer thread and one consumer thread.
+  *
+  * The producer only calls push(), the consumer only calls pop(). Both may
+  * run concurrently without any further synchronization. For example the
+  * emulation thread produces sound samples while the audio callback (on a
+  * thread owned by the audio library) consumes them.
+  *
+  * Each side only writes its own index. The release store of that index
+  * publishes the elements (push) or the freed space (pop), the acquire load
+  * of the other index makes them visible. The indices increase without
+  * wrapping to the buffer size, so completely full and completely empty
+  * can be distinguished and the full capacity is usable.
+  */
+template<typename T>
+class SPSCRingBuffer
+{
+public:
+	SPSCRingBuffer() = default;
+	explicit SPSCRingBuffer(size_t capacity_)
+		: buffer(capacity_), capacity(capacity_)
+	{
+		assert(capacity > 0);
+	}
+
+	/** Change the capacity, this also discards all elements. Only allowed
+	  * while neither the producer nor the consumer is active.
+	  */
+	void resize(size_t capacity_) {
+		assert(capacity_ > 0);
+		buffer.resize(capacity_);
+		capacity = capacity_;
+		clear();
+	}
+
+	[[nodiscard]] size_t getCapacity() const { return capacity; }
+
+	/** Number of elements in the buffer. When called concurrently with
+	  * push() or pop() this is only a snapshot: from the producer side the
+	  * real value can only be smaller, from the consumer side only larger.
+	  */
+	[[nodiscard]] size_t size() const {
+		auto r = readIdx.load(std::memory_order_acquire);
+		auto w = writeIdx.load(std::memory_order_acquire);
+		return w - r;
+	}
+	[[nodiscard]] bool empty() const { return size() == 0; }
+
+	/** Producer: append as many elements from 'data' as fit.
+	  * @return The number of elements that were appended.
+	  */
+	size_t push(std::span<const T> data) {
+		auto w = writeIdx.load(std::memory_order_relaxed);
+		auto r = readIdx.load(std::memory_order_acquire);
+		auto num = std::min(data.size(), capacity - (w - r));
+		auto pos = w % capacity;
+		auto len1 = std::min(num, capacity - pos);
+		ranges::copy(data.first(len1), &buffer[pos]);
+		ranges::copy(data.subspan(len1, num - len1), &buffer[0]);
+		writeIdx.store(w + num, std::memory_order_release);
+		return num;
+	}
+
+	/** Consumer: remove elements from the buffer and store them in 'out'.
+	  * @return The number of elements that were stored (can be less than
+	  *         the size of 'out' if the buffer didn't contain enough).
+	  */
+	size_t pop(std::span<T> out) {
+		auto r = readIdx.load(std::memory_order_relaxed);
+		auto w = writeIdx.load(std::memory_order_acquire);
+		auto num = std::min(out.size(), w - r);
+		auto pos = r % capacity;
+		auto len1 = std::min(num, capacity - pos);
+		ranges::copy(std::span{&buffer[pos], len1}, out);
+		ranges::copy(std::span{&buffer[0], num - len1}, out.subspan(len1));
+		readIdx.store(r + num, std::memory_order_release);
+		return num;
+	}
+
+	/** Discard all elements. Only allowed while neither the producer nor
+	  * the consumer is active.
+	  */
+	void clear() {
+		readIdx.store(0, std::memory_order_relaxed);
+		writeIdx.store(0, std::memory_order_relaxed);
+	}
+
+private:
+	MemBuffer<T> buffer;
+	size_t capacity = 0;
+	// On separate cache lines, to avoid false sharing between the threads.
+	alignas(64) std::atomic<size_t> readIdx = 0;  // only written by consumer
+	alignas(64) std::atomic<size_t> writeIdx = 0; // only written by producer
+};
+
+} // namespace openmsx
+
+#endif
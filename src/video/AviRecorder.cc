@@ -11,16 +11,21 @@
 #include "PostProcessor.hh"
 #include "MSXMixer.hh"
 #include "Filename.hh"
+#include "FrameSource.hh"
 #include "CliComm.hh"
 #include "FileOperations.hh"
 #include "TclArgParser.hh"
 #include "TclObject.hh"
+#include "Timer.hh"
 
 #include "Math.hh"
 #include "enumerate.hh"
 #include "narrow.hh"
 #include "outer.hh"
+#include "ranges.hh"
 #include "small_buffer.hh"
+#include "unreachable.hh"
+#include "xrange.hh"
 
 #include <array>
 #include <cassert>
@@ -38,6 +43,7 @@ AviRecorder::~AviRecorder()
 {
 	assert(!aviWriter);
 	assert(!wavWriter);
+	assert(!encodeThread.joinable());
 }
 
 void AviRecorder::start(bool recordAudio, bool recordVideo, bool recordMono,
@@ -94,6 +100,7 @@ void AviRecorder::start(bool recordAudio, bool recordVideo, bool recordMono,
 		wavWriter = std::make_unique<Wav16Writer>(
 			filename, stereo ? 2 : 1, sampleRate);
 	}
+	if (aviWriter) startEncodeThread();
 	// only set recorders when all errors are checked for
 	for (auto* pp : postProcessors) {
 		pp->setRecorder(this);
@@ -112,10 +119,70 @@ void AviRecorder::stop()
 		mixer = nullptr;
 	}
 	sampleRate = 0;
+	stopEncodeThread();
 	aviWriter.reset();
 	wavWriter.reset();
 }
 
+void AviRecorder::startEncodeThread()
+{
+	assert(!encodeThread.joinable());
+	queue.clear();
+	encodeError.clear();
+	stopEncoding = false;
+	capturedFrames = 0;
+	maxQueuedFrames = 0;
+	stalls = 0;
+	stallTime = 0;
+	encodeThread = std::thread([this]() { encodeLoop(); });
+}
+
+void AviRecorder::stopEncodeThread()
+{
+	if (!encodeThread.joinable()) return;
+	{
+		std::lock_guard lock(queueMutex);
+		stopEncoding = true;
+	}
+	frameQueued.notify_one();
+	encodeThread.join(); // first encodes all pending frames
+
+	if (!encodeError.empty()) {
+		reactor.getCliComm().printWarning(
+			"Recording stopped with error: ", encodeError);
+		encodeError.clear();
+	}
+	queue.clear();
+	spareFrames.clear();
+}
+
+void AviRecorder::encodeLoop()
+{
+	std::unique_lock lock(queueMutex);
+	while (true) {
+		frameQueued.wait(lock, [&] { return !queue.empty() || stopEncoding; });
+		if (queue.empty()) break; // stop requested and all frames written
+
+		auto frame = std::move(queue.front());
+		queue.pop_front();
+		lock.unlock();
+		try {
+			if (frame.fps != 0.0f) aviWriter->setFps(frame.fps);
+			aviWriter->addFrame(frame.pixels, frame.audio);
+		} catch (MSXException& e) {
+			lock.lock();
+			encodeError = e.getMessage();
+			frameEncoded.notify_one();
+			break;
+		}
+		lock.lock();
+		frame.audio.clear();
+		frame.fps = 0.0f;
+		spareFrames.push_back(std::move(frame));
+		frameEncoded.notify_one();
+	}
+}
+
 static int16_t float2int16(float f)
 {
 	return Math::clipToInt16(lrintf(32768.0f * f));
@@ -177,6 +244,7 @@ void AviRecorder::addWave(std::span<const StereoFloat> data)
 void AviRecorder::addImage(const FrameSource* frame, EmuTime::param time)
 {
 	assert(!wavWriter);
+	float fps = 0.0f; // set once, passed to the encode thread with this frame
 	if (duration != EmuDuration::infinity()) {
 		if (!warnedFps && ((time - prevTime) != duration)) {
 			warnedFps = true;
@@ -187,15 +255,59 @@ void AviRecorder::addImage(const FrameSource* frame, EmuTime::param time)
 		}
 	} else if (prevTime != EmuTime::infinity()) {
 		duration = time - prevTime;
-		aviWriter->setFps(narrow_cast<float>(1.0 / duration.toDouble()));
+		fps = narrow_cast<float>(1.0 / duration.toDouble());
 	}
 	prevTime = time;
 
 	if (mixer) {
 		mixer->updateStream(time);
 	}
-	aviWriter->addFrame(frame, audioBuf);
-	audioBuf.clear();
+
+	CapturedFrame captured;
+	{
+		std::lock_guard lock(queueMutex);
+		if (!spareFrames.empty()) {
+			captured = std::move(spareFrames.back());
+			spareFrames.pop_back();
+		}
+	}
+	// The FrameSource is only valid during this call, so the (scaled)
+	// pixels must be copied before handing them to the encode thread.
+	captured.pixels.resize(size_t(frameWidth) * frameHeight);
+	for (auto y : xrange(frameHeight)) {
+		auto line = std::span{captured.pixels}.subspan(y * frameWidth, frameWidth);
+		auto scaled = [&]() -> std::span<const uint32_t> {
+			switch (frameHeight) {
+			case 240: return frame->getLinePtr320_240(y, line.first<320>());
+			case 480: return frame->getLinePtr640_480(y, line.first<640>());
+			case 720: return frame->getLinePtr960_720(y, line.first<960>());
+			default: UNREACHABLE;
+			}
+		}();
+		if (scaled.data() != line.data()) ranges::copy(scaled, line);
+	}
+	std::swap(captured.audio, audioBuf); // 'captured.audio' was empty
+	captured.fps = fps;
+
+	{
+		std::unique_lock lock(queueMutex);
+		auto canQueue = [&] {
+			return (queue.size() < MAX_QUEUED_FRAMES) || !encodeError.empty();
+		};
+		if (!canQueue()) {
+			++stalls;
+			auto start = Timer::getTime();
+			frameEncoded.wait(lock, canQueue);
+			stallTime += Timer::getTime() - start;
+		}
+		if (!encodeError.empty()) {
+			throw MSXException(std::exchange(encodeError, {}));
+		}
+		queue.push_back(std::move(captured));
+		maxQueuedFrames = std::max(maxQueuedFrames, narrow<unsigned>(queue.size()));
+	}
+	frameQueued.notify_one();
+	++capturedFrames;
 }
 
 // TODO: Can this be dropped?
@@ -296,6 +408,17 @@ bool AviRecorder::isRecording() const
 void AviRecorder::status(std::span<const TclObject> /*tokens*/, TclObject& result) const
 {
 	result.addDictKeyValue("status", isRecording() ? "recording" : "idle");
+	if (!encodeThread.joinable()) return;
+
+	auto queued = [&] {
+		std::lock_guard lock(queueMutex);
+		return narrow<unsigned>(queue.size());
+	}();
+	result.addDictKeyValues("frames", capturedFrames,
+	                        "queued", queued,
+	                        "max_queued", maxQueuedFrames,
+	                        "stalls", stalls,
+	                        "stall_time", double(stallTime) * 1.0e-6);
 }
 
 // class AviRecorder::Cmd
@@ -330,7 +453,8 @@ std::string AviRecorder::Cmd::help(std::span<const TclObject> /*tokens*/) const
 	       "record start -prefix foo  Record to file 'fooNNNN.avi'\n"
 	       "record stop               Stop recording\n"
 	       "record toggle             Toggle recording (useful as keybinding)\n"
-	       "record status             Query recording state\n"
+	       "record status             Query recording state (and, while recording\n"
+	       "                          video, encoder queue statistics)\n"
 	       "\n"
 	       "The start subcommand also accepts an optional -audioonly, -videoonly, "
 	       " -mono, -stereo, -doublesize, -triplesize flag.\n"
@@ -5,9 +5,14 @@
 #include "EmuDuration.hh"
 #include "EmuTime.hh"
 #include "Mixer.hh"
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <span>
+#include <string>
+#include <thread>
 #include <vector>
 
 namespace openmsx {
@@ -45,6 +50,10 @@ private:
 		   bool recordStereo, const Filename& filename);
 	void status(std::span<const TclObject> tokens, TclObject& result) const;
 
+	void startEncodeThread();
+	void stopEncodeThread();
+	void encodeLoop();
+
 	void processStart (Interpreter& interp, std::span<const TclObject> tokens, TclObject& result);
 	void processStop  (std::span<const TclObject> tokens);
 	void processToggle(Interpreter& interp, std::span<const TclObject> tokens, TclObject& result);
@@ -60,6 +69,8 @@ private:
 	} recordCommand;
 
 	std::vector<int16_t> audioBuf;
+	// While the encode thread is running, 'aviWriter' is only accessed
+	// from that thread (also the frame rate is passed via the queue).
 	std::unique_ptr<AviWriter>   aviWriter; // can be nullptr
 	std::unique_ptr<Wav16Writer> wavWriter; // can be nullptr
 	std::vector<PostProcessor*> postProcessors;
@@ -73,6 +84,34 @@ private:
 	bool warnedSampleRate;
 	bool warnedStereo;
 	bool stereo;
+
+	// Video frames are captured (scaled and copied) on the main thread,
+	// the ZMBV encoding, zlib compression and file I/O happen in a
+	// separate thread. ZMBV frames depend on the previous frame, so
+	// there's exactly one encode thread.
+	struct CapturedFrame {
+		std::vector<uint32_t> pixels; // frameWidth x frameHeight
+		std::vector<int16_t> audio;
+		float fps = 0.0f; // only set in the frame that determines the rate
+	};
+	// When the encode thread falls behind this much, the main thread
+	// blocks (we can't drop frames without losing audio/video sync).
+	static constexpr size_t MAX_QUEUED_FRAMES = 8;
+
+	std::thread encodeThread;
+	mutable std::mutex queueMutex; // protects the members below
+	std::condition_variable frameQueued;  // main -> encode thread
+	std::condition_variable frameEncoded; // encode thread -> main
+	std::deque<CapturedFrame> queue; // captured, not yet encoded
+	std::vector<CapturedFrame> spareFrames; // recycled buffers
+	std::string encodeError; // set when the encode thread failed
+	bool stopEncoding = false;
+
+	// statistics, only accessed from the main thread
+	unsigned capturedFrames = 0;
+	unsigned maxQueuedFrames = 0;
+	unsigned stalls = 0; // number of times the main thread had to wait
+	uint64_t stallTime = 0; // total waiting time (in us)
 };
 
 } // namespace openmsx
@@ -274,7 +274,7 @@ void AviWriter::addAviChunk(std::span<const char, 4> tag, std::span<const uint8_
 	index[idxSize + 3] = size32;
 }
 
-void AviWriter::addFrame(const FrameSource* video, std::span<const int16_t> audio)
+void AviWriter::addFrame(std::span<const ZMBVEncoder::Pixel> video, std::span<const int16_t> audio)
 {
 	bool keyFrame = (frames++ % 300 == 0);
 	auto buffer = codec.compressFrame(keyFrame, video);
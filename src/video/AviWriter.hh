@@ -16,7 +16,6 @@
 namespace openmsx {
 
 class Filename;
-class FrameSource;
 
 class AviWriter
 {
@@ -24,7 +23,7 @@ public:
 	AviWriter(const Filename& filename, unsigned width, unsigned height,
 	          unsigned channels, unsigned freq);
 	~AviWriter();
-	void addFrame(const FrameSource* video, std::span<const int16_t> audio);
+	void addFrame(std::span<const ZMBVEncoder::Pixel> video, std::span<const int16_t> audio);
 	void setFps(float fps_) { fps = fps_; }
 
 private:
@@ -10,8 +10,152 @@
 #include <bit>
 #include <tuple>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// The SIMD versions of the render routines below produce exactly the same
+// output as the plain c++ versions (see BitmapConverter_test.cc). Like
+// elsewhere in openMSX, the version is selected at compile time:
+// - Graphic 4, 5 and 6 look up 16 (or 32) palette entries at once with a
+//   byte shuffle, so they need SSSE3 (or AVX2).
+// - Graphic 7 and the palette lookups of YJK/YAE use gather on AVX2.
+// - The YJK to RGB calculation only needs SSE2.
+// So a default x86-64 build (SSE2 only) uses the plain c++ versions for
+// Graphic 4-7, only YJK and YAE are faster there. (SSE2 versions that
+// select the colors with bit masks instead of a byte shuffle turned out to
+// be slower than the table lookups of the plain c++ versions.) On other
+// architectures everything uses the plain c++ versions.
+
 namespace openmsx {
 
+using Pixel = BitmapConverter::Pixel;
+
+#ifdef __SSSE3__
+// Look up the palette entries for 32 4-bit color indices, given as two
+// vectors of 16 byte-sized indices.
+class PaletteLookup
+{
+public:
+	explicit PaletteLookup(const BitmapConverter::PalettePlanes& planes)
+		: p0(load(planes[0])), p1(load(planes[1]))
+		, p2(load(planes[2])), p3(load(planes[3])) {}
+
+	void operator()(__m128i idx0, __m128i idx1, Pixel* out) const
+	{
+#ifdef __AVX2__
+		__m256i idx = _mm256_inserti128_si256(_mm256_castsi128_si256(idx0), idx1, 1);
+		__m256i b0 = _mm256_shuffle_epi8(p0, idx);
+		__m256i b1 = _mm256_shuffle_epi8(p1, idx);
+		__m256i b2 = _mm256_shuffle_epi8(p2, idx);
+		__m256i b3 = _mm256_shuffle_epi8(p3, idx);
+		__m256i lo01 = _mm256_unpacklo_epi8(b0, b1);
+		__m256i hi01 = _mm256_unpackhi_epi8(b0, b1);
+		__m256i lo23 = _mm256_unpacklo_epi8(b2, b3);
+		__m256i hi23 = _mm256_unpackhi_epi8(b2, b3);
+		// The unpack instructions work per 128-bit lane: e.g. r0
+		// contains pixels [0..3] and [16..19].
+		__m256i r0 = _mm256_unpacklo_epi16(lo01, lo23);
+		__m256i r1 = _mm256_unpackhi_epi16(lo01, lo23);
+		__m256i r2 = _mm256_unpacklo_epi16(hi01, hi23);
+		__m256i r3 = _mm256_unpackhi_epi16(hi01, hi23);
+		auto* o = std::bit_cast<__m256i*>(out);
+		_mm256_storeu_si256(o + 0, _mm256_permute2x128_si256(r0, r1, 0x20));
+		_mm256_storeu_si256(o + 1, _mm256_permute2x128_si256(r2, r3, 0x20));
+		_mm256_storeu_si256(o + 2, _mm256_permute2x128_si256(r0, r1, 0x31));
+		_mm256_storeu_si256(o + 3, _mm256_permute2x128_si256(r2, r3, 0x31));
+#else
+		lookup16(idx0, out +  0);
+		lookup16(idx1, out + 16);
+#endif
+	}
+
+private:
+#ifdef __AVX2__
+	static __m256i load(const std::array<uint8_t, 16>& plane)
+	{
+		return _mm256_broadcastsi128_si256(
+			_mm_load_si128(std::bit_cast<const __m128i*>(plane.data())));
+	}
+	__m256i p0, p1, p2, p3;
+#else
+	static __m128i load(const std::array<uint8_t, 16>& plane)
+	{
+		return _mm_load_si128(std::bit_cast<const __m128i*>(plane.data()));
+	}
+	void lookup16(__m128i idx, Pixel* out) const
+	{
+		__m128i b0 = _mm_shuffle_epi8(p0, idx);
+		__m128i b1 = _mm_shuffle_epi8(p1, idx);
+		__m128i b2 = _mm_shuffle_epi8(p2, idx);
+		__m128i b3 = _mm_shuffle_epi8(p3, idx);
+		__m128i lo01 = _mm_unpacklo_epi8(b0, b1);
+		__m128i hi01 = _mm_unpackhi_epi8(b0, b1);
+		__m128i lo23 = _mm_unpacklo_epi8(b2, b3);
+		__m128i hi23 = _mm_unpackhi_epi8(b2, b3);
+		auto* o = std::bit_cast<__m128i*>(out);
+		_mm_storeu_si128(o + 0, _mm_unpacklo_epi16(lo01, lo23));
+		_mm_storeu_si128(o + 1, _mm_unpackhi_epi16(lo01, lo23));
+		_mm_storeu_si128(o + 2, _mm_unpacklo_epi16(hi01, hi23));
+		_mm_storeu_si128(o + 3, _mm_unpackhi_epi16(hi01, hi23));
+	}
+	__m128i p0, p1, p2, p3;
+#endif
+};
+
+static inline __m128i load16(const byte* p)
+{
+	return _mm_loadu_si128(std::bit_cast<const __m128i*>(p));
+}
+#endif
+
+#ifdef __SSE2__
+// Replicate the N-th 16-bit value of each group of four.
+template<int N> static inline __m128i broadcastInGroup(__m128i x)
+{
+	static constexpr int imm = N * 0x55;
+	return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, imm), imm);
+}
+
+// Same calculation as yjk2rgb() below, for two groups of four pixels. 'x'
+// contains the VRAM bytes as 16-bit values, the result is the index in
+// palette32768 of each pixel.
+static inline __m128i yjkIndex(__m128i x)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i c2 = _mm_set1_epi16(2);
+	const __m128i c7 = _mm_set1_epi16(7);
+	const __m128i c31 = _mm_set1_epi16(31);
+	const __m128i c32 = _mm_set1_epi16(32);
+	auto clamp = [&](__m128i v) { return _mm_min_epi16(_mm_max_epi16(v, zero), c31); };
+	// 'k' and 'j' are 6-bit signed values, made from the low 3 bits of
+	// the first resp. last two bytes of a group.
+	auto get6 = [&](__m128i lo, __m128i hi) {
+		__m128i v = _mm_or_si128(_mm_and_si128(lo, c7),
+		                         _mm_slli_epi16(_mm_and_si128(hi, c7), 3));
+		return _mm_sub_epi16(_mm_xor_si128(v, c32), c32); // sign extend
+	};
+	__m128i k = get6(broadcastInGroup<0>(x), broadcastInGroup<1>(x));
+	__m128i j = get6(broadcastInGroup<2>(x), broadcastInGroup<3>(x));
+	__m128i y = _mm_srli_epi16(x, 3);
+
+	__m128i r = clamp(_mm_add_epi16(y, j));
+	__m128i g = clamp(_mm_add_epi16(y, k));
+	// Shifting rounds towards minus infinity instead of towards zero, but
+	// that only matters for negative values, which are clamped to zero.
+	__m128i y5 = _mm_add_epi16(_mm_slli_epi16(y, 2), y);
+	__m128i j2k = _mm_add_epi16(_mm_add_epi16(j, j), k);
+	__m128i b = clamp(_mm_srai_epi16(_mm_add_epi16(_mm_sub_epi16(y5, j2k), c2), 2));
+	return _mm_or_si128(_mm_or_si128(_mm_slli_epi16(r, 10), _mm_slli_epi16(g, 5)), b);
+}
+#endif
+
 BitmapConverter::BitmapConverter(
 		std::span<const Pixel, 16 * 2> palette16_,
 		std::span<const Pixel, 256>    palette256_,
@@ -35,6 +179,18 @@ void BitmapConverter::calcDPalette()
 			dPalette[16 * i + j] = dp;
 		}
 	}
+
+	for (auto b : xrange(4)) {
+		auto getByte = [&](Pixel p) { return uint8_t(p >> (8 * b)); };
+		for (auto i : xrange(16)) {
+			palette16Planes[b][i] = getByte(palette16[i]);
+		}
+		ranges::fill(graphic5Planes[b], 0);
+		for (auto i : xrange(4)) {
+			graphic5Planes[b][i + 0] = getByte(palette16[i +  0]);
+			graphic5Planes[b][i + 4] = getByte(palette16[i + 16]);
+		}
+	}
 }
 
 void BitmapConverter::convertLine(std::span<Pixel> buf, std::span<const byte, 128> vramPtr)
@@ -122,6 +278,19 @@ void BitmapConverter::renderGraphic4(
 		calcDPalette();
 	}
 
+#if defined(__SSSE3__)
+	PaletteLookup lookup(palette16Planes);
+	const __m128i mask = _mm_set1_epi8(0x0F);
+	for (auto i : xrange(128 / 16)) {
+		// 32 pixels per iteration
+		__m128i v = load16(&vramPtr0[16 * i]);
+		__m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+		__m128i lo = _mm_and_si128(v, mask);
+		lookup(_mm_unpacklo_epi8(hi, lo), _mm_unpackhi_epi8(hi, lo), &buf[32 * i]);
+	}
+	return;
+#endif
+
 	Pixel* __restrict pixelPtr = buf.data();
 	      auto* out = std::bit_cast<DPixel*>(pixelPtr);
 	const auto* in  = std::bit_cast<const unsigned*>(vramPtr0.data());
@@ -144,8 +313,34 @@ void BitmapConverter::renderGraphic4(
 
 void BitmapConverter::renderGraphic5(
 	std::span<Pixel, 512> buf,
-	std::span<const byte, 128> vramPtr0) const
+	std::span<const byte, 128> vramPtr0)
 {
+#if defined(__SSSE3__)
+	if (!dPaletteValid) [[unlikely]] {
+		calcDPalette();
+	}
+	PaletteLookup lookup(graphic5Planes);
+#endif
+#if defined(__SSSE3__)
+	const __m128i mask = _mm_set1_epi8(3);
+	const __m128i odd = _mm_set1_epi8(4); // entries 4-7 are the odd pixels
+	for (auto i : xrange(128 / 16)) {
+		// 64 pixels per iteration
+		__m128i v = load16(&vramPtr0[16 * i]);
+		__m128i a = _mm_and_si128(_mm_srli_epi16(v, 6), mask);
+		__m128i b = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(v, 4), mask), odd);
+		__m128i c = _mm_and_si128(_mm_srli_epi16(v, 2), mask);
+		__m128i d = _mm_or_si128(_mm_and_si128(v, mask), odd);
+		__m128i abLo = _mm_unpacklo_epi8(a, b);
+		__m128i abHi = _mm_unpackhi_epi8(a, b);
+		__m128i cdLo = _mm_unpacklo_epi8(c, d);
+		__m128i cdHi = _mm_unpackhi_epi8(c, d);
+		lookup(_mm_unpacklo_epi16(abLo, cdLo), _mm_unpackhi_epi16(abLo, cdLo), &buf[64 * i +  0]);
+		lookup(_mm_unpacklo_epi16(abHi, cdHi), _mm_unpackhi_epi16(abHi, cdHi), &buf[64 * i + 32]);
+	}
+	return;
+#endif
+
 	Pixel* __restrict pixelPtr = buf.data();
 	for (auto i : xrange(128)) {
 		unsigned data = vramPtr0[i];
@@ -173,6 +368,28 @@ void BitmapConverter::renderGraphic6(
 	if (!dPaletteValid) [[unlikely]] {
 		calcDPalette();
 	}
+
+#if defined(__SSSE3__)
+	PaletteLookup lookup(palette16Planes);
+	const __m128i mask = _mm_set1_epi8(0x0F);
+	for (auto i : xrange(128 / 16)) {
+		// 64 pixels per iteration
+		__m128i v0 = load16(&vramPtr0[16 * i]);
+		__m128i v1 = load16(&vramPtr1[16 * i]);
+		__m128i hi0 = _mm_and_si128(_mm_srli_epi16(v0, 4), mask);
+		__m128i lo0 = _mm_and_si128(v0, mask);
+		__m128i hi1 = _mm_and_si128(_mm_srli_epi16(v1, 4), mask);
+		__m128i lo1 = _mm_and_si128(v1, mask);
+		__m128i n0lo = _mm_unpacklo_epi8(hi0, lo0);
+		__m128i n0hi = _mm_unpackhi_epi8(hi0, lo0);
+		__m128i n1lo = _mm_unpacklo_epi8(hi1, lo1);
+		__m128i n1hi = _mm_unpackhi_epi8(hi1, lo1);
+		lookup(_mm_unpacklo_epi16(n0lo, n1lo), _mm_unpackhi_epi16(n0lo, n1lo), &pixelPtr[64 * i +  0]);
+		lookup(_mm_unpacklo_epi16(n0hi, n1hi), _mm_unpackhi_epi16(n0hi, n1hi), &pixelPtr[64 * i + 32]);
+	}
+	return;
+#endif
+
 	      auto* out = std::bit_cast<DPixel*>(pixelPtr);
 	const auto* in0 = std::bit_cast<const unsigned*>(vramPtr0.data());
 	const auto* in1 = std::bit_cast<const unsigned*>(vramPtr1.data());
@@ -208,6 +425,21 @@ void BitmapConverter::renderGraphic7(
 	std::span<const byte, 128> vramPtr1) const
 {
 	Pixel* __restrict pixelPtr = buf.data();
+#ifdef __AVX2__
+	const auto* pal = std::bit_cast<const int*>(palette256.data());
+	for (auto i : xrange(128 / 8)) {
+		// 16 pixels per iteration
+		__m128i v0 = _mm_loadl_epi64(std::bit_cast<const __m128i*>(&vramPtr0[8 * i]));
+		__m128i v1 = _mm_loadl_epi64(std::bit_cast<const __m128i*>(&vramPtr1[8 * i]));
+		__m128i idx = _mm_unpacklo_epi8(v0, v1);
+		__m256i p0 = _mm256_i32gather_epi32(pal, _mm256_cvtepu8_epi32(idx), 4);
+		__m256i p1 = _mm256_i32gather_epi32(pal, _mm256_cvtepu8_epi32(_mm_srli_si128(idx, 8)), 4);
+		auto* o = std::bit_cast<__m256i*>(&pixelPtr[16 * i]);
+		_mm256_storeu_si256(o + 0, p0);
+		_mm256_storeu_si256(o + 1, p1);
+	}
+	return;
+#endif
 	for (auto i : xrange(128)) {
 		pixelPtr[2 * i + 0] = palette256[vramPtr0[i]];
 		pixelPtr[2 * i + 1] = palette256[vramPtr1[i]];
@@ -233,6 +465,31 @@ void BitmapConverter::renderYJK(
 	std::span<const byte, 128> vramPtr1) const
 {
 	Pixel* __restrict pixelPtr = buf.data();
+#if defined(__SSE2__)
+	const __m128i zero = _mm_setzero_si128();
+	for (auto i : xrange(128 / 8)) {
+		// 16 pixels per iteration
+		__m128i v0 = _mm_loadl_epi64(std::bit_cast<const __m128i*>(&vramPtr0[8 * i]));
+		__m128i v1 = _mm_loadl_epi64(std::bit_cast<const __m128i*>(&vramPtr1[8 * i]));
+		__m128i q = _mm_unpacklo_epi8(v0, v1);
+		__m128i idx0 = yjkIndex(_mm_unpacklo_epi8(q, zero));
+		__m128i idx1 = yjkIndex(_mm_unpackhi_epi8(q, zero));
+#ifdef __AVX2__
+		const auto* pal = std::bit_cast<const int*>(palette32768.data());
+		auto* o = std::bit_cast<__m256i*>(&pixelPtr[16 * i]);
+		_mm256_storeu_si256(o + 0, _mm256_i32gather_epi32(pal, _mm256_cvtepu16_epi32(idx0), 4));
+		_mm256_storeu_si256(o + 1, _mm256_i32gather_epi32(pal, _mm256_cvtepu16_epi32(idx1), 4));
+#else
+		alignas(16) std::array<uint16_t, 16> idx;
+		_mm_store_si128(std::bit_cast<__m128i*>(&idx[0]), idx0);
+		_mm_store_si128(std::bit_cast<__m128i*>(&idx[8]), idx1);
+		for (auto n : xrange(16)) {
+			pixelPtr[16 * i + n] = palette32768[idx[n]];
+		}
+#endif
+	}
+	return;
+#endif
 	for (auto i : xrange(64)) {
 		std::array<unsigned, 4> p = {
 			vramPtr0[2 * i + 0],
@@ -258,6 +515,49 @@ void BitmapConverter::renderYAE(
 	std::span<const byte, 128> vramPtr1) const
 {
 	Pixel* __restrict pixelPtr = buf.data();
+#if defined(__SSE2__)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i c8 = _mm_set1_epi16(8);
+	for (auto i : xrange(128 / 8)) {
+		// 16 pixels per iteration
+		__m128i v0 = _mm_loadl_epi64(std::bit_cast<const __m128i*>(&vramPtr0[8 * i]));
+		__m128i v1 = _mm_loadl_epi64(std::bit_cast<const __m128i*>(&vramPtr1[8 * i]));
+		__m128i q = _mm_unpacklo_epi8(v0, v1);
+		auto convert8 = [&](__m128i x, Pixel* out) {
+			__m128i idx = yjkIndex(x);
+			__m128i yae = _mm_cmpeq_epi16(_mm_and_si128(x, c8), c8);
+			__m128i yaeIdx = _mm_srli_epi16(x, 4);
+#ifdef __AVX2__
+			const auto* pal16 = std::bit_cast<const int*>(palette16.data());
+			const auto* pal32768 = std::bit_cast<const int*>(palette32768.data());
+			__m256i mask = _mm256_cvtepi16_epi32(yae);
+			__m256i pix = _mm256_mask_i32gather_epi32(
+				_mm256_setzero_si256(), pal16, _mm256_cvtepu16_epi32(yaeIdx), mask, 4);
+			pix = _mm256_mask_i32gather_epi32(
+				pix, pal32768, _mm256_cvtepu16_epi32(idx),
+				_mm256_xor_si256(mask, _mm256_set1_epi32(-1)), 4);
+			_mm256_storeu_si256(std::bit_cast<__m256i*>(out), pix);
+#else
+			// Mark the YAE pixels with bit 15 (that bit is never set in
+			// a palette32768 index).
+			yaeIdx = _mm_or_si128(yaeIdx, _mm_set1_epi16(int16_t(0x8000)));
+			__m128i sel = _mm_or_si128(_mm_and_si128(yae, yaeIdx), _mm_andnot_si128(yae, idx));
+			alignas(16) std::array<uint16_t, 8> tmp;
+			_mm_store_si128(std::bit_cast<__m128i*>(tmp.data()), sel);
+			for (auto n : xrange(8)) {
+				// look up both, so that it can be a conditional move
+				auto t = tmp[n];
+				Pixel yaePix = palette16[t & 15];
+				Pixel yjkPix = palette32768[t & 0x7FFF];
+				out[n] = (t & 0x8000) ? yaePix : yjkPix;
+			}
+#endif
+		};
+		convert8(_mm_unpacklo_epi8(q, zero), &pixelPtr[16 * i + 0]);
+		convert8(_mm_unpackhi_epi8(q, zero), &pixelPtr[16 * i + 8]);
+	}
+	return;
+#endif
 	for (auto i : xrange(64)) {
 		std::array<unsigned, 4> p = {
 			vramPtr0[2 * i + 0],
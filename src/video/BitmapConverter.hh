@@ -17,6 +17,9 @@ class BitmapConverter
 public:
 	using Pixel = uint32_t;
 	using DPixel = uint64_t;
+	/** Byte 0, 1, 2 and 3 of (up to) 16 palette entries. This allows to
+	  * look up 16 palette entries at once with a SIMD byte shuffle. */
+	using PalettePlanes = std::array<std::array<uint8_t, 16>, 4>;
 
 	/** Create a new bitmap scanline converter.
 	  * @param palette16 Pointer to 2*16-entries array that specifies
@@ -81,13 +84,24 @@ public:
 		dPaletteValid = false;
 	}
 
+	/** Update the internal state that depends on the palette. Must be
+	  * called before convertLine() is called concurrently from several
+	  * threads, otherwise it's done lazily.
+	  */
+	inline void prepareConcurrentUse()
+	{
+		if (!dPaletteValid) calcDPalette();
+	}
+
 private:
+	/** Update 'dPalette', 'palette16Planes' and 'graphic5Planes' after a
+	  * change in 'palette16'. */
 	void calcDPalette();
 
 	inline void renderGraphic4(std::span<Pixel, 256> buf,
 	                           std::span<const byte, 128> vramPtr0);
 	inline void renderGraphic5(std::span<Pixel, 512> buf,
-	                           std::span<const byte, 128> vramPtr0) const;
+	                           std::span<const byte, 128> vramPtr0);
 	inline void renderGraphic6(std::span<Pixel, 512> buf,
 	                           std::span<const byte, 128> vramPtr0,
 				   std::span<const byte, 128> vramPtr1);
@@ -108,6 +122,10 @@ private:
 	std::span<const Pixel, 32768>  palette32768;
 
 	std::array<DPixel, 16 * 16> dPalette;
+	/** 'palette16', split in byte planes. For Graphic 5 the first four
+	  * entries are for the even pixels, the next four for the odd pixels. */
+	alignas(16) PalettePlanes palette16Planes;
+	alignas(16) PalettePlanes graphic5Planes;
 	DisplayMode mode;
 	bool dPaletteValid = false;
 };
@@ -83,6 +83,11 @@ void DummyRenderer::updateVRAM(unsigned /*offset*/, EmuTime::param /*time*/) {
 void DummyRenderer::updateWindow(bool /*enabled*/, EmuTime::param /*time*/) {
 }
 
+bool DummyRenderer::needsExactUpdates(
+	unsigned /*first*/, unsigned /*last*/, EmuTime::param /*time*/) const {
+	return false;
+}
+
 void DummyRenderer::paint(OutputSurface& /*output*/) {
 }
 
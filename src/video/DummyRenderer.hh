@@ -40,6 +40,8 @@ public:
 	void updateSpritesEnabled(bool enabled, EmuTime::param time) override;
 	void updateVRAM(unsigned offset, EmuTime::param time) override;
 	void updateWindow(bool enabled, EmuTime::param time) override;
+	[[nodiscard]] bool needsExactUpdates(
+		unsigned first, unsigned last, EmuTime::param time) const override;
 
 	// Layer interface:
 	void paint(OutputSurface& output) override;
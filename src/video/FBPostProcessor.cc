@@ -0,0 +1,136 @@
+#include "FBPostProcessor.hh"
+
+#include "RawFrame.hh"
+#include "RenderSettings.hh"
+#include "SoftwareScaler.hh"
+#include "SoftwareSurface.hh"
+
+#include "ranges.hh"
+
+#include <algorithm>
+
+namespace openmsx {
+
+FBPostProcessor::FBPostProcessor(
+	MSXMotherBoard& motherBoard_, Display& display_,
+	SoftwareSurface& screen_, SoftwareScaler& scaler_,
+	const std::string& videoSource,
+	unsigned maxWidth_, unsigned height_, bool canDoInterlace_)
+	: PostProcessor(motherBoard_, display_, screen_, videoSource,
+	                maxWidth_, height_, canDoInterlace_)
+	, surface(screen_)
+	, scaler(scaler_)
+{
+}
+
+FBPostProcessor::~FBPostProcessor()
+{
+	if (!renderThread.joinable()) return;
+	{
+		std::lock_guard lock(mutex);
+		stopping = true;
+	}
+	renderCond.notify_all();
+	renderThread.join();
+}
+
+void FBPostProcessor::paint(OutputSurface& /*output*/)
+{
+	if (renderSettings.getInterleaveBlackFrame()) {
+		interleaveCount ^= 1;
+		if (interleaveCount) {
+			ranges::fill(surface.getPixels(), surface.mapRGB255({0, 0, 0}));
+			surface.setPainter(nullptr);
+			return;
+		}
+	}
+	if (!paintFrame) {
+		ranges::fill(surface.getPixels(), surface.mapRGB255({0, 0, 0}));
+		surface.setPainter(nullptr);
+		return;
+	}
+
+	auto scanline = unsigned(renderSettings.getScanlineFactor());
+	Painted current{frameCounter, scanline, surface.getPhysicalSize()};
+	if ((surface.getPainter() == this) && (current == painted)) {
+		return; // already up-to-date
+	}
+
+	auto [w, h] = current.size;
+	waitForRender();
+	if (rendered == current) {
+		ranges::copy(std::span{renderedPixels.data(), size_t(w) * size_t(h)},
+		             surface.getPixels());
+	} else {
+		// Not rendered ahead, or the settings changed in the meantime.
+		scaler.scale(*paintFrame, superImposeVideoFrame, scanline,
+		             surface.getPixels(), w, h);
+	}
+	surface.setPainter(this);
+	painted = current;
+}
+
+bool FBPostProcessor::canRenderAhead() const
+{
+	// Superimposed frames are rotated independently of our frames. And
+	// without interlace support, the paint frame is reused as the next
+	// work frame (see rotateFrames()).
+	return (renderSettings.getRenderThreads() > 1) && canDoInterlace &&
+	       !superImposeVideoFrame && !superImposeVdpFrame;
+}
+
+void FBPostProcessor::frameRotating()
+{
+	// The render thread may still be reading the frames that are about
+	// to be recycled.
+	waitForRender();
+}
+
+void FBPostProcessor::frameRotated()
+{
+	if (!canRenderAhead()) {
+		// The new frame gets scaled on the next paint().
+		return;
+	}
+	if (!renderThread.joinable()) {
+		renderThread = std::thread([this] { renderLoop(); });
+	}
+	auto size = surface.getPhysicalSize();
+	// 'frameCounter' is incremented right after this call.
+	rendered = Painted{frameCounter + 1,
+	                   unsigned(renderSettings.getScanlineFactor()), size};
+	renderedPixels.resize(size_t(size.x) * size_t(size.y));
+	{
+		std::lock_guard lock(mutex);
+		renderPending = true;
+	}
+	renderCond.notify_all();
+}
+
+void FBPostProcessor::waitForRender()
+{
+	std::unique_lock lock(mutex);
+	renderCond.wait(lock, [&] { return !renderPending; });
+}
+
+void FBPostProcessor::renderLoop()
+{
+	std::unique_lock lock(mutex);
+	while (true) {
+		renderCond.wait(lock, [&] { return stopping || renderPending; });
+		if (stopping) break;
+		lock.unlock();
+		// Single threaded, the helper threads of 'scaler' are used by
+		// paint() on the main thread.
+		auto [w, h] = rendered.size;
+		SoftwareScaler::scaleLines(
+			*paintFrame, nullptr, rendered.scanline,
+			std::span{renderedPixels.data(), size_t(w) * size_t(h)},
+			w, h, 0, h);
+		lock.lock();
+		renderPending = false;
+		renderCond.notify_all();
+	}
+}
+
+} // namespace openmsx
@@ -0,0 +1,80 @@
+#ifndef FBPOSTPROCESSOR_HH
+#define FBPOSTPROCESSOR_HH
+
+#include "PostProcessor.hh"
+
+#include "MemBuffer.hh"
+#include "aligned.hh"
+#include "gl_vec.hh"
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace openmsx {
+
+class SoftwareScaler;
+class SoftwareSurface;
+
+/** A post processor that scales the MSX frame on the CPU into a
+  * SoftwareSurface (see SoftwareScaler). Only the scanline effect is
+  * supported, other effects (scale_algorithm, blur, glow, noise, ...)
+  * require the GL post processor.
+  *
+  * When render_threads is more than 1, a finished frame is scaled on a
+  * separate render thread while the emulation continues with the next
+  * frame. paint() then only has to copy the result.
+  */
+class FBPostProcessor final : public PostProcessor
+{
+public:
+	FBPostProcessor(
+		MSXMotherBoard& motherBoard, Display& display,
+		SoftwareSurface& screen, SoftwareScaler& scaler,
+		const std::string& videoSource,
+		unsigned maxWidth, unsigned height, bool canDoInterlace);
+	~FBPostProcessor() override;
+
+	// Layer interface:
+	void paint(OutputSurface& output) override;
+
+private:
+	// PostProcessor
+	void frameRotating() override;
+	void frameRotated() override;
+
+	[[nodiscard]] bool canRenderAhead() const;
+	void waitForRender();
+	void renderLoop();
+
+private:
+	SoftwareSurface& surface;
+	SoftwareScaler& scaler;
+
+	// The parameters of a scaled frame, used to skip repaints when nothing
+	// changed (e.g. the periodic repaints while emulation is paused).
+	struct Painted {
+		unsigned frame = unsigned(-1);
+		unsigned scanline = 0;
+		gl::ivec2 size;
+
+		[[nodiscard]] bool operator==(const Painted&) const = default;
+	};
+	Painted painted; // what we last painted in 'surface'
+
+	// Render thread, started on first use. While 'renderPending' is set,
+	// it reads 'paintFrame' (and the frames it refers to) and writes
+	// 'rendered' and 'renderedPixels', the main thread doesn't touch them.
+	std::thread renderThread;
+	std::mutex mutex; // protects the 2 members below
+	std::condition_variable renderCond;
+	bool renderPending = false;
+	bool stopping = false;
+	Painted rendered; // content of 'renderedPixels'
+	MemBuffer<uint32_t, SSE_ALIGNMENT> renderedPixels;
+};
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef LINECHANGETRACKER_HH
+#define LINECHANGETRACKER_HH
+
+#include <algorithm>
+
+namespace openmsx {
+
+/** Keeps track of which lines of the current frame may render differently
+  * than the same line in the previous frame, because the VDP state (a
+  * register, the palette, ...) changed in between. Used by the line cache in
+  * SDLRasterizer; changes in VRAM are tracked separately.
+  *
+  * A change during a frame affects the lines that are not yet (completely)
+  * drawn in that frame, and the lines that were already (partly) drawn in the
+  * next frame. So instead of per-line flags, two ranges are sufficient:
+  *  - [changedFrom, NUM_LINES) for changes in the current frame.
+  *  - [0, changedUntil) for changes in the previous frame.
+  * A line is unchanged when it's in neither range.
+  */
+class LineChangeTracker
+{
+public:
+	static constexpr int NUM_LINES = 240;
+
+	void frameStart()
+	{
+		changedUntil = nextChangedUntil;
+		nextChangedUntil = 0;
+		changedFrom = NUM_LINES;
+		drawnLimit = 0;
+	}
+
+	/** After the end of the frame, a change affects the whole next frame. */
+	void frameEnd()
+	{
+		drawnLimit = NUM_LINES;
+	}
+
+	/** Lines [.., limitY) are (possibly only partly) drawn in the current
+	  * frame.
+	  */
+	void drawn(int limitY)
+	{
+		drawnLimit = std::max(drawnLimit, limitY);
+	}
+
+	/** The state used to render the display changed. */
+	void stateChanged()
+	{
+		// The last drawn line may be only partly drawn, the rest of it
+		// uses the new state. (When it was drawn completely, it's not
+		// drawn again in this frame, so marking it costs nothing.)
+		changedFrom = std::min(changedFrom, std::max(drawnLimit - 1, 0));
+		nextChangedUntil = std::max(nextChangedUntil, drawnLimit);
+	}
+
+	/** Is line 'y' rendered with the same state as in the previous frame? */
+	[[nodiscard]] bool isUnchanged(int y) const
+	{
+		return (changedUntil <= y) && (y < changedFrom);
+	}
+
+private:
+	int changedFrom = 0; // first frame: no previous frame
+	int changedUntil = NUM_LINES;
+	int nextChangedUntil = NUM_LINES;
+	int drawnLimit = 0;
+};
+
+} // namespace openmsx
+
+#endif
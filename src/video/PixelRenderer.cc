@@ -22,6 +22,7 @@ TODO:
 #include "GlobalSettings.hh"
 #include "MSXMotherBoard.hh"
 #include "Reactor.hh"
+#include "Scheduler.hh"
 #include "Timer.hh"
 #include "narrow.hh"
 #include "one_of.hh"
@@ -122,6 +123,8 @@ PixelRenderer::PixelRenderer(VDP& vdp_, Display& display)
 	, videoSourceSetting(vdp.getMotherBoard().getVideoSource())
 	, spriteChecker(vdp.getSpriteChecker())
 	, rasterizer(display.getVideoSystem().createRasterizer(vdp))
+	, profiler(vdp.getScheduler().getDeviceProfiler())
+	, profileId(profiler.getId(DeviceProfiler::Category::RENDER, vdp.getName()))
 {
 	// In case of loadstate we can't yet query any state from the VDP
 	// (because that object is not yet fully deserialized). But
@@ -160,6 +163,7 @@ void PixelRenderer::updateDisplayEnabled(bool enabled, EmuTime::param time)
 {
 	sync(time, true);
 	displayEnabled = enabled;
+	rasterizer->stateChanged();
 }
 
 void PixelRenderer::frameStart(EmuTime::param time)
@@ -261,6 +265,7 @@ void PixelRenderer::updateHorizontalScrollHigh(
 	byte /*scroll*/, EmuTime::param time)
 {
 	if (displayEnabled) sync(time);
+	rasterizer->stateChanged();
 }
 
 void PixelRenderer::updateBorderMask(
@@ -274,6 +279,7 @@ void PixelRenderer::updateMultiPage(
 	bool /*multiPage*/, EmuTime::param time)
 {
 	if (displayEnabled) sync(time);
+	rasterizer->stateChanged();
 }
 
 void PixelRenderer::updateTransparency(
@@ -294,6 +300,7 @@ void PixelRenderer::updateForegroundColor(
 	byte /*color*/, EmuTime::param time)
 {
 	if (displayEnabled) sync(time);
+	rasterizer->stateChanged();
 }
 
 void PixelRenderer::updateBackgroundColor(
@@ -307,12 +314,14 @@ void PixelRenderer::updateBlinkForegroundColor(
 	byte /*color*/, EmuTime::param time)
 {
 	if (displayEnabled) sync(time);
+	rasterizer->stateChanged();
 }
 
 void PixelRenderer::updateBlinkBackgroundColor(
 	byte /*color*/, EmuTime::param time)
 {
 	if (displayEnabled) sync(time);
+	rasterizer->stateChanged();
 }
 
 void PixelRenderer::updateBlinkState(
@@ -323,6 +332,7 @@ void PixelRenderer::updateBlinkState(
 	//       I don't know why exactly, but it's probably related to
 	//       being called at frame start.
 	//sync(time);
+	rasterizer->stateChanged();
 }
 
 void PixelRenderer::updatePalette(
@@ -351,6 +361,7 @@ void PixelRenderer::updateVerticalScroll(
 	int /*scroll*/, EmuTime::param time)
 {
 	if (displayEnabled) sync(time);
+	rasterizer->stateChanged();
 }
 
 void PixelRenderer::updateHorizontalAdjust(
@@ -379,18 +390,21 @@ void PixelRenderer::updateNameBase(
 	unsigned /*addr*/, EmuTime::param time)
 {
 	if (displayEnabled) sync(time);
+	rasterizer->stateChanged();
 }
 
 void PixelRenderer::updatePatternBase(
 	unsigned /*addr*/, EmuTime::param time)
 {
 	if (displayEnabled) sync(time);
+	rasterizer->stateChanged();
 }
 
 void PixelRenderer::updateColorBase(
 	unsigned /*addr*/, EmuTime::param time)
 {
 	if (displayEnabled) sync(time);
+	rasterizer->stateChanged();
 }
 
 void PixelRenderer::updateSpritesEnabled(
@@ -509,6 +523,9 @@ bool PixelRenderer::checkSync(unsigned offset, EmuTime::param time) const
 
 void PixelRenderer::updateVRAM(unsigned offset, EmuTime::param time)
 {
+	// Because the range is the entire VRAM, offset == address.
+	rasterizer->vramChanged(offset);
+
 	// Note: No need to sync if display is disabled, because then the
 	//       output does not depend on VRAM (only on background color).
 	if (renderFrame && displayEnabled && checkSync(offset, time)) {
@@ -516,12 +533,35 @@ void PixelRenderer::updateVRAM(unsigned offset, EmuTime::param time)
 	}
 }
 
+bool PixelRenderer::needsExactUpdates(
+	unsigned first, unsigned last, EmuTime::param time) const
+{
+	switch (vdp.getDisplayMode().getBase()) {
+	case DisplayMode::GRAPHIC4:
+	case DisplayMode::GRAPHIC5:
+	case DisplayMode::GRAPHIC6:
+	case DisplayMode::GRAPHIC7:
+		// In the bitmap modes the rasterizer keeps track of changes
+		// per 128 bytes, so a single vramChanged() call per block is
+		// enough. What remains is the sync, see updateVRAM(). Note
+		// that checkSync() only looks at the (32kB) page in these
+		// modes, so checking both ends of the range is sufficient.
+		if (!renderFrame || !displayEnabled) return false;
+		return checkSync(first, time) || checkSync(last, time);
+	default:
+		return true;
+	}
+}
+
 void PixelRenderer::updateWindow(bool /*enabled*/, EmuTime::param /*time*/)
 {
 	// The bitmapVisibleWindow has moved to a different area.
 	// This update is redundant: Renderer will be notified in another way
 	// as well (updateDisplayEnabled or updateNameBase, for example).
 	// TODO: Can this be used as the main update method instead?
+	// This is also called when the VRAM content is rearranged without
+	// updateVRAM() calls (switching the VR mode or the 4k/8k mapping).
+	rasterizer->stateChanged();
 }
 
 void PixelRenderer::sync(EmuTime::param time, bool force)
@@ -547,6 +587,11 @@ void PixelRenderer::sync(EmuTime::param time, bool force)
 }
 
 void PixelRenderer::renderUntil(EmuTime::param time)
+{
+	profiler.measure(profileId, [&] { doRenderUntil(time); });
+}
+
+void PixelRenderer::doRenderUntil(EmuTime::param time)
 {
 	// Translate from time to pixel position.
 	int limitTicks = vdp.getTicksThisFrame(time);
@@ -2,6 +2,7 @@
 #define PIXELRENDERER_HH
 
 #include "Renderer.hh"
+#include "DeviceProfiler.hh"
 #include "Observer.hh"
 #include "RenderSettings.hh"
 #include "openmsx.hh"
@@ -59,6 +60,8 @@ public:
 	void updateSpritesEnabled(bool enabled, EmuTime::param time) override;
 	void updateVRAM(unsigned offset, EmuTime::param time) override;
 	void updateWindow(bool enabled, EmuTime::param time) override;
+	[[nodiscard]] bool needsExactUpdates(
+		unsigned first, unsigned last, EmuTime::param time) const override;
 
 private:
 	/** Indicates whether the area to be drawn is border or display. */
@@ -101,6 +104,7 @@ private:
 	  * @param time Moment in emulated time to render lines until.
 	  */
 	void renderUntil(EmuTime::param time);
+	void doRenderUntil(EmuTime::param time);
 
 private:
 	/** The VDP of which the video output is being rendered.
@@ -124,6 +128,9 @@ private:
 
 	const std::unique_ptr<Rasterizer> rasterizer;
 
+	DeviceProfiler& profiler;
+	DeviceProfiler::Id profileId;
+
 	float finishFrameDuration = 0.0f;
 	float frameSkipCounter = 999.0f; // force drawing of frame
 
@@ -1,7 +1,6 @@
-#ifndef GLPOSTPROCESSOR_HH
-#define GLPOSTPROCESSOR_HH
+#ifndef POSTPROCESSOR_HH
+#define POSTPROCESSOR_HH
 
-#include "GLUtil.hh"
 #include "RenderSettings.hh"
 #include "VideoLayer.hh"
 
@@ -10,7 +9,6 @@
 
 #include <array>
 #include <memory>
-#include <vector>
 
 namespace openmsx {
 
@@ -22,27 +20,21 @@ class Display;
 class DoubledFrame;
 class EventDistributor;
 class FrameSource;
-class GLScaler;
 class MSXMotherBoard;
+class OutputSurface;
 class RawFrame;
-class RenderSettings;
 class SuperImposedFrame;
 
 /** A post processor builds the frame that is displayed from the MSX frame,
   * while applying effects such as scalers, noise etc.
+  * This base class keeps track of the (unscaled) frames, the subclasses
+  * implement the actual drawing (see GLPostProcessor and FBPostProcessor).
   */
-class PostProcessor final : public VideoLayer, private Schedulable
+class PostProcessor : public VideoLayer, private Schedulable
 {
 public:
-	PostProcessor(
-		MSXMotherBoard& motherBoard, Display& display,
-		OutputSurface& screen, const std::string& videoSource,
-		unsigned maxWidth, unsigned height, bool canDoInterlace);
 	~PostProcessor() override;
 
-	// Layer interface:
-	void paint(OutputSurface& output) override;
-
 	/** Sets up the "abcdFrame" variables for a new frame.
 	  * TODO: The point of passing the finished frame in and the new workFrame
 	  *       out is to be able to split off the scaler application as a
@@ -93,36 +85,40 @@ public:
 	  */
 	[[nodiscard]] FrameSource* getPaintFrame() const { return paintFrame; }
 
+	/** Get the frame that was passed to the last rotateFrames() call, or
+	  * nullptr if there is none (yet).
+	  */
+	[[nodiscard]] const RawFrame* getLastFrame() const { return lastFrames[0].get(); }
+
 	// VideoLayer
 	void takeRawScreenShot(unsigned height, const std::string& filename) override;
 
 	[[nodiscard]] CliComm& getCliComm();
 
-private:
-	// Observer<Setting> interface:
-	void update(const Setting& setting) noexcept override;
-
-	// Schedulable
-	void executeUntil(EmuTime::param time) override;
+protected:
+	PostProcessor(
+		MSXMotherBoard& motherBoard, Display& display,
+		OutputSurface& screen, const std::string& videoSource,
+		unsigned maxWidth, unsigned height, bool canDoInterlace);
 
-	/** Returns the maximum width for lines [y..y+step).
+	/** Called at the start of rotateFrames(), before the frames that
+	  * 'paintFrame' refers to are changed.
 	  */
-	[[nodiscard]] static unsigned getLineWidth(FrameSource* frame, unsigned y, unsigned step);
+	virtual void frameRotating() {}
 
-	void initBuffers();
-	void createRegions();
-	void uploadFrame();
-	void uploadBlock(unsigned srcStartY, unsigned srcEndY,
-	                 unsigned lineWidth);
-
-	void preCalcNoise(float factor);
-	void drawNoise() const;
-	void drawGlow(int glow);
+	/** Called at the end of rotateFrames(), 'paintFrame' has changed.
+	  */
+	virtual void frameRotated() = 0;
 
-	void preCalcMonitor3D(float width);
-	void drawMonitor3D() const;
+	/** Returns the maximum width for lines [y..y+step).
+	  */
+	[[nodiscard]] static unsigned getLineWidth(const FrameSource* frame, unsigned y, unsigned step);
 
 private:
+	// Schedulable
+	void executeUntil(EmuTime::param time) override;
+
+protected:
 	Display& display;
 	RenderSettings& renderSettings;
 	EventDistributor& eventDistributor;
@@ -171,63 +167,11 @@ private:
 	const bool canDoInterlace;
 
 	EmuTime lastRotate;
-	/** The currently active scaler.
-	  */
-	std::unique_ptr<GLScaler> currScaler;
-
-	struct StoredFrame {
-		gl::ivec2 size; // (re)allocate when window size changes
-		gl::Texture tex;
-		gl::FrameBufferObject fbo;
-	};
-	std::array<StoredFrame, 2> renderedFrames;
-
-	// Noise effect:
-	gl::Texture noiseTextureA{true, true}; // interpolate + wrap
-	gl::Texture noiseTextureB{true, true};
-	float noiseX = 0.0f, noiseY = 0.0f;
-
-	struct TextureData {
-		gl::ColorTexture tex;
-		[[nodiscard]] unsigned width() const { return tex.getWidth(); }
-	};
-	std::vector<TextureData> textures;
-	gl::PixelBuffer<unsigned> pbo;
-
-	gl::ColorTexture superImposeTex;
-
-	struct Region {
-		Region(unsigned srcStartY_, unsigned srcEndY_,
-		       unsigned dstStartY_, unsigned dstEndY_,
-		       unsigned lineWidth_)
-			: srcStartY(srcStartY_)
-			, srcEndY(srcEndY_)
-			, dstStartY(dstStartY_)
-			, dstEndY(dstEndY_)
-			, lineWidth(lineWidth_) {}
-		unsigned srcStartY;
-		unsigned srcEndY;
-		unsigned dstStartY;
-		unsigned dstEndY;
-		unsigned lineWidth;
-	};
-	std::vector<Region> regions;
 
+	/** Incremented on each rotateFrames() call. */
 	unsigned frameCounter = 0;
-
-	/** Currently active scale algorithm, used to detect scaler changes.
-	  */
-	RenderSettings::ScaleAlgorithm scaleAlgorithm = RenderSettings::ScaleAlgorithm::NO;
-
-	gl::ShaderProgram monitor3DProg;
-	gl::BufferObject arrayBuffer;
-	gl::BufferObject elementBuffer;
-	gl::BufferObject vbo;
-	gl::BufferObject stretchVBO;
-
-	bool storedFrame = false;
 };
 
 } // namespace openmsx
 
-#endif // GLPOSTPROCESSOR_HH
+#endif // POSTPROCESSOR_HH
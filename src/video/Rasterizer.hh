@@ -62,6 +62,19 @@ public:
 	virtual void setTransparency(bool enabled) = 0;
 	virtual void setSuperimposeVideoFrame(const RawFrame* videoSource) = 0;
 
+	/** A byte in VRAM has changed.
+	  * Unlike the other methods, this is also called for frames that are
+	  * not rendered.
+	  * @param address The (physical) VRAM address of the changed byte.
+	  */
+	virtual void vramChanged(unsigned address) = 0;
+
+	/** VDP state that affects the display area (other than VRAM and the
+	  * state passed via the setXXX() methods above) has changed. E.g. a
+	  * scroll register or the base address of a VRAM table.
+	  */
+	virtual void stateChanged() = 0;
+
 	/** Render a rectangle of border pixels on the host screen.
 	  * The units are absolute lines (Y) and VDP clock ticks (X).
 	  * @param fromX X coordinate of render start (inclusive).
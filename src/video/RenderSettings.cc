@@ -36,7 +36,8 @@ EnumSetting<RenderSettings::RendererID>::Map RenderSettings::getRendererMap()
 	EnumSetting<RendererID>::Map rendererMap = {
 		{"uninitialized", UNINITIALIZED},
 		{"none",          DUMMY},
-		{"SDLGL-PP",      SDLGL_PP}
+		{"SDLGL-PP",      SDLGL_PP},
+		{"software",      SOFTWARE}
 	};
 	return rendererMap;
 }
@@ -106,6 +107,11 @@ RenderSettings::RenderSettings(CommandController& commandController)
 		"scale_factor", "scale factor",
 		std::clamp(2, MIN_SCALE_FACTOR, MAX_SCALE_FACTOR), MIN_SCALE_FACTOR, MAX_SCALE_FACTOR)
 
+	, renderThreadsSetting(commandController,
+		"render_threads",
+		"number of threads used to render the MSX screen",
+		1, 1, 16)
+
 	, scanlineAlphaSetting(commandController,
 		"scanline", "amount of scanline effect: 0 = none, 100 = full",
 		20, 0, 100)
@@ -25,7 +25,7 @@ public:
 	/** Enumeration of Renderers known to openMSX.
 	  * This is the full list, the list of available renderers may be smaller.
 	  */
-	enum class RendererID { UNINITIALIZED, DUMMY, SDLGL_PP };
+	enum class RendererID { UNINITIALIZED, DUMMY, SDLGL_PP, SOFTWARE };
 	using RendererSetting = EnumSetting<RendererID>;
 
 	/** Render accuracy: granularity of the rendered area.
@@ -128,6 +128,11 @@ public:
 	[[nodiscard]] IntegerSetting& getScaleFactorSetting() { return scaleFactorSetting; }
 	[[nodiscard]] int getScaleFactor() const { return scaleFactorSetting.getInt(); }
 
+	/** The number of threads used to convert VRAM to pixels, and (for the
+	  * software renderer) to scale the output. */
+	[[nodiscard]] IntegerSetting& getRenderThreadsSetting() { return renderThreadsSetting; }
+	[[nodiscard]] int getRenderThreads() const { return renderThreadsSetting.getInt(); }
+
 	/** Limit number of sprites per line?
 	  * If true, limit number of sprites per line as real VDP does.
 	  * If false, display all sprites.
@@ -229,6 +234,7 @@ private:
 	IntegerSetting horizontalBlurSetting;
 	EnumSetting<ScaleAlgorithm> scaleAlgorithmSetting;
 	IntegerSetting scaleFactorSetting;
+	IntegerSetting renderThreadsSetting;
 	IntegerSetting scanlineAlphaSetting;
 	BooleanSetting limitSpritesSetting;
 	BooleanSetting disableSpritesSetting;
@@ -9,6 +9,7 @@
 #include "components.hh"
 #include "DummyVideoSystem.hh"
 #include "SDLVideoSystem.hh"
+#include "SoftwareVideoSystem.hh"
 
 // Renderers:
 #include "DummyRenderer.hh"
@@ -31,6 +32,8 @@ std::unique_ptr<VideoSystem> createVideoSystem(Reactor& reactor)
 			return std::make_unique<DummyVideoSystem>();
 		case RenderSettings::RendererID::SDLGL_PP:
 			return std::make_unique<SDLVideoSystem>(reactor);
+		case RenderSettings::RendererID::SOFTWARE:
+			return std::make_unique<SoftwareVideoSystem>(reactor);
 		default:
 			UNREACHABLE;
 	}
@@ -42,6 +45,7 @@ std::unique_ptr<Renderer> createRenderer(VDP& vdp, Display& display)
 		case RenderSettings::RendererID::DUMMY:
 			return std::make_unique<DummyRenderer>();
 		case RenderSettings::RendererID::SDLGL_PP:
+		case RenderSettings::RendererID::SOFTWARE:
 			return std::make_unique<PixelRenderer>(vdp, display);
 		default:
 			UNREACHABLE;
@@ -54,6 +58,7 @@ std::unique_ptr<V9990Renderer> createV9990Renderer(V9990& vdp, Display& display)
 		case RenderSettings::RendererID::DUMMY:
 			return std::make_unique<V9990DummyRenderer>();
 		case RenderSettings::RendererID::SDLGL_PP:
+		case RenderSettings::RendererID::SOFTWARE:
 			return std::make_unique<V9990PixelRenderer>(vdp);
 		default:
 			UNREACHABLE;
@@ -67,6 +72,7 @@ std::unique_ptr<LDRenderer> createLDRenderer(LaserdiscPlayer& ld, Display& displ
 		case RenderSettings::RendererID::DUMMY:
 			return std::make_unique<LDDummyRenderer>();
 		case RenderSettings::RendererID::SDLGL_PP:
+		case RenderSettings::RendererID::SOFTWARE:
 			return std::make_unique<LDPixelRenderer>(ld, display);
 		default:
 			UNREACHABLE;
@@ -7,12 +7,18 @@
 #include "RenderSettings.hh"
 #include "PostProcessor.hh"
 #include "MemoryOps.hh"
+#include "MSXMotherBoard.hh"
 #include "OutputSurface.hh"
+#include "SpriteChecker.hh"
+#include "TclObject.hh"
 #include "enumerate.hh"
 #include "one_of.hh"
+#include "outer.hh"
+#include "strCat.hh"
 #include "xrange.hh"
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <cstdint>
 #include <memory>
@@ -99,6 +105,10 @@ SDLRasterizer::SDLRasterizer(
 	, characterConverter(vdp, subspan<16>(palFg), palBg)
 	, bitmapConverter(palFg, PALETTE256, V9958_COLORS)
 	, spriteConverter(vdp.getSpriteChecker(), palBg)
+	, workers(renderSettings.getRenderThreads())
+	, vramBlockStamps(vram.getData().size() / 128, 0)
+	, lineCacheInfo(vdp.getMotherBoard().getMachineInfoCommand(),
+	                strCat(vdp.getName(), "_line_cache"))
 {
 	// Init the palette.
 	precalcPalette();
@@ -115,10 +125,12 @@ SDLRasterizer::SDLRasterizer(
 	renderSettings.getBrightnessSetting() .attach(*this);
 	renderSettings.getContrastSetting()   .attach(*this);
 	renderSettings.getColorMatrixSetting().attach(*this);
+	renderSettings.getRenderThreadsSetting().attach(*this);
 }
 
 SDLRasterizer::~SDLRasterizer()
 {
+	renderSettings.getRenderThreadsSetting().detach(*this);
 	renderSettings.getColorMatrixSetting().detach(*this);
 	renderSettings.getGammaSetting()      .detach(*this);
 	renderSettings.getBrightnessSetting() .detach(*this);
@@ -134,11 +146,13 @@ bool SDLRasterizer::isActive()
 {
 	return postProcessor->needRender() &&
 	       vdp.getMotherBoard().isActive() &&
-	       !vdp.getMotherBoard().isFastForwarding();
+	       !vdp.getMotherBoard().skipRendering();
 }
 
 void SDLRasterizer::reset()
 {
+	stateChanged();
+
 	// Init renderer state.
 	setDisplayMode(vdp.getDisplayMode());
 	spriteConverter.setTransparency(vdp.getTransparency());
@@ -158,6 +172,7 @@ void SDLRasterizer::resetPalette()
 
 void SDLRasterizer::setSuperimposeVideoFrame(const RawFrame* videoSource)
 {
+	stateChanged();
 	postProcessor->setSuperimposeVideoFrame(videoSource);
 	precalcColorIndex0(vdp.getDisplayMode(), vdp.getTransparency(),
 	                   videoSource, vdp.getBackgroundColor());
@@ -166,6 +181,11 @@ void SDLRasterizer::setSuperimposeVideoFrame(const RawFrame* videoSource)
 void SDLRasterizer::frameStart(EmuTime::param time)
 {
 	workFrame = postProcessor->rotateFrames(std::move(workFrame), time);
+	prevFrame = postProcessor->getLastFrame();
+	prevLines = currLines;
+	ranges::fill(currLines, CachedLine{});
+	prevGeneration = generation++;
+	lineChanges.frameStart();
 	workFrame->init(
 	    vdp.isInterlaced() ? (vdp.getEvenOdd() ? FrameSource::FieldType::ODD
 	                                           : FrameSource::FieldType::EVEN)
@@ -176,15 +196,22 @@ void SDLRasterizer::frameStart(EmuTime::param time)
 	// 240 - 212 = 28 lines available for top/bottom border; 14 each.
 	// NTSC: display at [32..244),
 	// PAL:  display at [59..271).
-	lineRenderTop = vdp.isPalTiming() ? 59 - 14 : 32 - 14;
+	int top = vdp.isPalTiming() ? 59 - 14 : 32 - 14;
+	if (top != lineRenderTop) {
+		// all lines shifted
+		lineRenderTop = top;
+		lineChanges.stateChanged();
+	}
 }
 
 void SDLRasterizer::frameEnd()
 {
+	lineChanges.frameEnd();
 }
 
 void SDLRasterizer::setDisplayMode(DisplayMode mode)
 {
+	stateChanged();
 	if (mode.isBitmapMode()) {
 		bitmapConverter.setDisplayMode(mode);
 	} else {
@@ -200,6 +227,7 @@ void SDLRasterizer::setDisplayMode(DisplayMode mode)
 
 void SDLRasterizer::setPalette(unsigned index, int grb)
 {
+	stateChanged();
 	// Update SDL colors in palette.
 	Pixel newColor = V9938_COLORS[(grb >> 4) & 7][grb >> 8][grb & 7];
 	palFg[index     ] = newColor;
@@ -213,6 +241,7 @@ void SDLRasterizer::setPalette(unsigned index, int grb)
 
 void SDLRasterizer::setBackgroundColor(byte index)
 {
+	stateChanged();
 	if (vdp.getDisplayMode().getByte() != DisplayMode::GRAPHIC7) {
 		precalcColorIndex0(vdp.getDisplayMode(), vdp.getTransparency(),
 				   vdp.isSuperimposing(), index);
@@ -221,23 +250,65 @@ void SDLRasterizer::setBackgroundColor(byte index)
 
 void SDLRasterizer::setHorizontalAdjust(int /*adjust*/)
 {
+	stateChanged();
 }
 
 void SDLRasterizer::setHorizontalScrollLow(byte /*scroll*/)
 {
+	stateChanged();
 }
 
 void SDLRasterizer::setBorderMask(bool /*masked*/)
 {
+	stateChanged();
 }
 
 void SDLRasterizer::setTransparency(bool enabled)
 {
+	stateChanged();
 	spriteConverter.setTransparency(enabled);
 	precalcColorIndex0(vdp.getDisplayMode(), enabled,
 	                   vdp.isSuperimposing(), vdp.getBackgroundColor());
 }
 
+void SDLRasterizer::vramChanged(unsigned address)
+{
+	vramBlockStamps[address / 128] = generation;
+
+	DisplayMode mode = vdp.getDisplayMode();
+	if (mode.isBitmapMode()) return;
+	if (vram.patternTable.isInside(address) || vram.colorTable.isInside(address)) {
+		charTablesStamp = generation;
+	}
+	if (vram.nameTable.isInside(address)) {
+		// Only the lower 10 bits of the name table index map directly to
+		// the address. In the text modes the rows don't fit in 1kB, so
+		// mark all rows that could have been hit.
+		unsigned x = address & 0x3FF;
+		auto markRow = [&](unsigned row) {
+			if (row < 32) nameRowStamps[row] = generation;
+		};
+		switch (mode.getBase()) {
+		case DisplayMode::TEXT1:
+		case DisplayMode::TEXT1Q:
+			markRow(x / 40);
+			markRow((x + 0x400) / 40);
+			break;
+		case DisplayMode::TEXT2:
+			for (auto i : xrange(4u)) markRow((x + i * 0x400) / 80);
+			break;
+		default:
+			markRow(x / 32);
+			break;
+		}
+	}
+}
+
+void SDLRasterizer::stateChanged()
+{
+	lineChanges.stateChanged();
+}
+
 void SDLRasterizer::precalcPalette()
 {
 	if (vdp.isMSX1VDP()) {
@@ -460,6 +531,7 @@ void SDLRasterizer::drawDisplay(
 	}
 	displayHeight = screenLimitY - screenY;
 	if (displayHeight <= 0) return;
+	lineChanges.drawn(screenLimitY);
 
 	int leftBackground =
 		translateX(vdp.getLeftBackground(), lineWidth == 512);
@@ -492,8 +564,74 @@ void SDLRasterizer::drawDisplay(
 		pageBorder = pageSplit;
 	}
 
+	bool useLineCache = prevFrame != nullptr;
+	DisplayArea area{mode, lineWidth, leftBackground, displayX, displayWidth,
+	                 hScroll, pageBorder, scrollPage1, scrollPage2, useLineCache};
+
+	// Each line is converted independently, so large areas (e.g. when
+	// a whole frame is rendered at once) can be split over several
+	// threads. Small areas aren't worth the synchronization overhead.
+	static constexpr int MIN_LINES_PER_BAND = 16;
+	auto numBands = std::clamp(
+		unsigned(displayHeight / MIN_LINES_PER_BAND), 1u, workers.getNumThreads());
+	unsigned reused = 0;
+	if (numBands == 1) {
+		reused = drawDisplayLines(area, screenY, screenLimitY, displayY);
+	} else {
+		bitmapConverter.prepareConcurrentUse();
+		std::atomic<unsigned> reusedAll = 0;
+		workers.run(numBands, [&](unsigned band) {
+			int startY = screenY + narrow<int>(band * displayHeight / numBands);
+			int endY = screenY + narrow<int>((band + 1) * displayHeight / numBands);
+			reusedAll += drawDisplayLines(area, startY, endY,
+			                              (displayY + startY - screenY) & 255);
+		});
+		reused = reusedAll;
+	}
+	reusedLines += reused;
+	convertedLines += displayHeight - reused;
+}
+
+bool SDLRasterizer::isBitmapLineChanged(unsigned vramLine) const
+{
+	auto changed = [&](const byte* ptr) {
+		auto block = (ptr - vram.getData().data()) / 128;
+		return vramBlockStamps[block] >= prevGeneration;
+	};
+	if (vdp.getDisplayMode().isPlanar()) {
+		auto [vramPtr0, vramPtr1] =
+			vram.bitmapCacheWindow.getReadAreaPlanar<256>(vramLine * 256);
+		return changed(vramPtr0.data()) || changed(vramPtr1.data());
+	} else {
+		return changed(vram.bitmapCacheWindow.getReadArea<128>(vramLine * 128).data());
+	}
+}
+
+bool SDLRasterizer::reuseLine(const DisplayArea& area, int y, uint32_t key, bool vramChanged)
+{
+	// Note: like drawDisplayLines() this only modifies state for line 'y'.
+	currLines[y].key = key;
+	if (!area.useLineCache || vramChanged || !lineChanges.isUnchanged(y) ||
+	    (prevLines[y].key != key) || prevLines[y].sprites) {
+		return false;
+	}
+	auto x = area.leftBackground + area.displayX;
+	ranges::copy(subspan(prevFrame->getLineDirect(y), x, area.displayWidth),
+	             subspan(workFrame->getLineDirect(y), x));
+	return true;
+}
+
+unsigned SDLRasterizer::drawDisplayLines(
+	const DisplayArea& area, int screenY, int screenLimitY, int displayY)
+{
+	// Note: this can be called concurrently for different lines, so it
+	// must not modify any (shared) state, except for its own lines in
+	// 'workFrame' and 'currLines'.
+	auto [mode, lineWidth, leftBackground, displayX, displayWidth,
+	      hScroll, pageBorder, scrollPage1, scrollPage2, useLineCache] = area;
+	unsigned reused = 0;
 	if (mode.isBitmapMode()) {
-		for (auto y : xrange(screenY, screenLimitY)) {
+		for (int y = screenY; y < screenLimitY; ++y, displayY = (displayY + 1) & 255) {
 			// Which bits in the name mask determine the page?
 			// TODO optimize this?
 			//   Calculating pageMaskOdd/Even is a non-trivial amount
@@ -510,6 +648,14 @@ void SDLRasterizer::drawDisplay(
 				(vram.nameTable.getMask() >> 7) & (pageMaskEven | displayY),
 				(vram.nameTable.getMask() >> 7) & (pageMaskOdd  | displayY)
 			};
+			uint32_t key = (uint32_t(mode.getByte()) << 24) | (vramLine[0] << 12) | vramLine[1];
+			bool vramChanged = useLineCache &&
+				(isBitmapLineChanged(vramLine[scrollPage1]) ||
+				 isBitmapLineChanged(vramLine[scrollPage2]));
+			if (reuseLine(area, y, key, vramChanged)) {
+				++reused;
+				continue;
+			}
 
 			std::array<Pixel, 512> buf;
 			auto lineInBuf = unsigned(-1); // buffer data not valid
@@ -538,14 +684,21 @@ void SDLRasterizer::drawDisplay(
 				ranges::copy(subspan(buf, x, displayWidth - firstPageWidth),
 				             subspan(dst, firstPageWidth));
 			}
-
-			displayY = (displayY + 1) & 255;
 		}
 	} else {
 		// horizontal scroll (high) is implemented in CharacterConverter
-		for (auto y : xrange(screenY, screenLimitY)) {
+		for (int y = screenY; y < screenLimitY; ++y, displayY = (displayY + 1) & 255) {
 			assert(!vdp.isMSX1VDP() || displayY < 192);
 
+			uint32_t key = (uint32_t(mode.getByte()) << 24) | displayY;
+			bool vramChanged = useLineCache &&
+				((charTablesStamp >= prevGeneration) ||
+				 (nameRowStamps[displayY / 8] >= prevGeneration));
+			if (reuseLine(area, y, key, vramChanged)) {
+				++reused;
+				continue;
+			}
+
 			auto dst = workFrame->getLineDirect(y).subspan(leftBackground + displayX);
 			if ((displayX == 0) && (displayWidth == narrow<int>(lineWidth))){
 				characterConverter.convertLine(dst, displayY);
@@ -555,10 +708,9 @@ void SDLRasterizer::drawDisplay(
 				auto src = subspan(buf, displayX, displayWidth);
 				ranges::copy(src, dst);
 			}
-
-			displayY = (displayY + 1) & 255;
 		}
 	}
+	return reused;
 }
 
 void SDLRasterizer::drawSprites(
@@ -579,6 +731,14 @@ void SDLRasterizer::drawSprites(
 	displayHeight = screenLimitY - screenY;
 	if (displayHeight <= 0) return;
 
+	// Lines with sprites can't be reused in the next frame.
+	const auto& spriteChecker = vdp.getSpriteChecker();
+	for (auto i : xrange(displayHeight)) {
+		if (!spriteChecker.getSprites(fromY + i).empty()) {
+			currLines[screenY + i].sprites = true;
+		}
+	}
+
 	// Render sprites.
 	// TODO: Call different SpriteConverter methods depending on narrow/wide
 	//       pixels in this display mode?
@@ -630,7 +790,36 @@ void SDLRasterizer::update(const Setting& setting) noexcept
 	                       &renderSettings.getColorMatrixSetting())) {
 		precalcPalette();
 		resetPalette();
+		stateChanged();
+	} else if (&setting == &renderSettings.getRenderThreadsSetting()) {
+		workers.setNumThreads(renderSettings.getRenderThreads());
 	}
 }
 
+
+// class LineCacheInfo
+
+SDLRasterizer::LineCacheInfo::LineCacheInfo(
+		InfoCommand& machineInfoCommand, const std::string& name)
+	: InfoTopic(machineInfoCommand, name)
+{
+}
+
+void SDLRasterizer::LineCacheInfo::execute(
+	std::span<const TclObject> /*tokens*/, TclObject& result) const
+{
+	const auto& rasterizer = OUTER(SDLRasterizer, lineCacheInfo);
+	// 64-bit, TclObject has no overload
+	result.addDictKeyValues("reused",    strCat(rasterizer.reusedLines),
+	                        "converted", strCat(rasterizer.convertedLines));
+}
+
+std::string SDLRasterizer::LineCacheInfo::help(std::span<const TclObject> /*tokens*/) const
+{
+	return "Returns the number of display lines that were copied from the "
+	       "previous frame because nothing they depend on changed (reused), "
+	       "and the number of lines that were converted from VRAM "
+	       "(converted), since the renderer was created.";
+}
+
 } // namespace openmsx
@@ -5,11 +5,15 @@
 #include "BitmapConverter.hh"
 #include "CharacterConverter.hh"
 #include "SpriteConverter.hh"
+#include "InfoTopic.hh"
+#include "LineChangeTracker.hh"
 #include "Observer.hh"
+#include "WorkerPool.hh"
 #include "openmsx.hh"
 #include <array>
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace openmsx {
 
@@ -54,6 +58,8 @@ public:
 	void setBorderMask(bool masked) override;
 	void setTransparency(bool enabled) override;
 	void setSuperimposeVideoFrame(const RawFrame* videoSource) override;
+	void vramChanged(unsigned address) override;
+	void stateChanged() override;
 	void drawBorder(int fromX, int fromY, int limitX, int limitY) override;
 	void drawDisplay(
 		int fromX, int fromY,
@@ -67,6 +73,29 @@ public:
 
 private:
 	inline void renderBitmapLine(std::span<Pixel> buf, unsigned vramLine);
+	struct DisplayArea {
+		DisplayMode mode;
+		unsigned lineWidth;
+		int leftBackground;
+		int displayX;
+		int displayWidth;
+		unsigned hScroll;
+		int pageBorder;
+		int scrollPage1;
+		int scrollPage2;
+		bool useLineCache;
+	};
+	/** @return The number of lines that were copied from the previous frame. */
+	unsigned drawDisplayLines(const DisplayArea& area, int screenY, int screenLimitY, int displayY);
+
+	[[nodiscard]] bool isBitmapLineChanged(unsigned vramLine) const;
+	/** Copy the display part of line 'y' from the previous frame, if that
+	  * is possible and still up-to-date.
+	  * @param key Identifies the content of the line, see 'CachedLine'.
+	  * @param vramChanged Did the VRAM used by this line change since the
+	  *                    previous frame?
+	  */
+	bool reuseLine(const DisplayArea& area, int y, uint32_t key, bool vramChanged);
 
 	/** Reload entire palette from VDP.
 	  */
@@ -129,10 +158,51 @@ private:
 	  */
 	SpriteConverter spriteConverter;
 
+	/** Threads to convert large areas in parallel, see drawDisplay().
+	  */
+	WorkerPool workers;
+
+	/** Line cache: display lines for which nothing has changed since the
+	  * previous frame are copied from that frame instead of converted again.
+	  * Changes in VRAM are stamped with 'generation', which is incremented
+	  * on each rendered frame. A line can be reused when none of the stamps
+	  * of the VRAM it depends on are at least 'prevGeneration'. Changes in
+	  * other state are tracked per range of lines in 'lineChanges'.
+	  */
+	struct CachedLine {
+		/** Display mode and VRAM lines (bitmap modes) or display line
+		  * (character modes) from which this line was rendered. */
+		uint32_t key = uint32_t(-1);
+		/** Were any sprites drawn on this line? */
+		bool sprites = false;
+	};
+	std::array<CachedLine, 240> prevLines;
+	std::array<CachedLine, 240> currLines;
+	/** Last change of each 128 byte block of VRAM. */
+	std::vector<uint32_t> vramBlockStamps;
+	/** Last change of each row in the name table (character modes). */
+	std::array<uint32_t, 32> nameRowStamps = {};
+	/** Last change of the pattern or color table (character modes). */
+	uint32_t charTablesStamp = 0;
+	/** Lines affected by changes of any other state. */
+	LineChangeTracker lineChanges;
+	uint32_t generation = 1;
+	uint32_t prevGeneration = 0;
+	const RawFrame* prevFrame = nullptr;
+	uint64_t reusedLines = 0;
+	uint64_t convertedLines = 0;
+
+	struct LineCacheInfo final : InfoTopic {
+		LineCacheInfo(InfoCommand& machineInfoCommand, const std::string& name);
+		void execute(std::span<const TclObject> tokens,
+		             TclObject& result) const override;
+		[[nodiscard]] std::string help(std::span<const TclObject> tokens) const override;
+	} lineCacheInfo;
+
 	/** Line to render at top of display.
 	  * After all, our screen is 240 lines while display is 262 or 313.
 	  */
-	int lineRenderTop;
+	int lineRenderTop = 0;
 
 	/** Host colors corresponding to each VDP palette entry.
 	  * palFg has entry 0 set to the current background color.
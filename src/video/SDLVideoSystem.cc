@@ -1,7 +1,7 @@
 #include "SDLVideoSystem.hh"
 #include "SDLRasterizer.hh"
 #include "VisibleSurface.hh"
-#include "PostProcessor.hh"
+#include "GLPostProcessor.hh"
 #include "V9990SDLRasterizer.hh"
 #include "Reactor.hh"
 #include "Display.hh"
@@ -63,7 +63,7 @@ std::unique_ptr<Rasterizer> SDLVideoSystem::createRasterizer(VDP& vdp)
 	auto& motherBoard = vdp.getMotherBoard();
 	return std::make_unique<SDLRasterizer>(
 		vdp, display, *screen,
-		std::make_unique<PostProcessor>(
+		std::make_unique<GLPostProcessor>(
 			motherBoard, display, *screen,
 			videoSource, 640, 240, true));
 }
@@ -78,7 +78,7 @@ std::unique_ptr<V9990Rasterizer> SDLVideoSystem::createV9990Rasterizer(
 	MSXMotherBoard& motherBoard = vdp.getMotherBoard();
 	return std::make_unique<V9990SDLRasterizer>(
 		vdp, display, *screen,
-		std::make_unique<PostProcessor>(
+		std::make_unique<GLPostProcessor>(
 			motherBoard, display, *screen,
 			videoSource, 1280, 240, true));
 }
@@ -91,7 +91,7 @@ std::unique_ptr<LDRasterizer> SDLVideoSystem::createLDRasterizer(
 	std::string videoSource = "Laserdisc"; // TODO handle multiple???
 	MSXMotherBoard& motherBoard = ld.getMotherBoard();
 	return std::make_unique<LDSDLRasterizer>(
-		std::make_unique<PostProcessor>(
+		std::make_unique<GLPostProcessor>(
 			motherBoard, display, *screen,
 			videoSource, 640, 480, false));
 }
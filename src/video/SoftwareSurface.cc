@@ -0,0 +1,35 @@
+#include "SoftwareSurface.hh"
+
+#include "PNG.hh"
+
+#include "ranges.hh"
+#include "xrange.hh"
+
+#include <vector>
+
+namespace openmsx {
+
+SoftwareSurface::SoftwareSurface(gl::ivec2 size)
+{
+	resize(size);
+}
+
+void SoftwareSurface::resize(gl::ivec2 size)
+{
+	calculateViewPort(size, size);
+	pixels.resize(size_t(size.x) * size_t(size.y));
+	ranges::fill(getPixels(), 0);
+	painter = nullptr;
+}
+
+void SoftwareSurface::saveScreenshot(const std::string& filename)
+{
+	auto [w, h] = getPhysicalSize();
+	std::vector<const Pixel*> rows(h);
+	for (auto y : xrange(h)) {
+		rows[y] = getLine(y).data();
+	}
+	PNG::saveRGBA(w, rows, filename);
+}
+
+} // namespace openmsx
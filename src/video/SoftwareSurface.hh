@@ -0,0 +1,49 @@
+#ifndef SOFTWARESURFACE_HH
+#define SOFTWARESURFACE_HH
+
+#include "OutputSurface.hh"
+
+#include "MemBuffer.hh"
+#include "aligned.hh"
+
+#include <span>
+
+namespace openmsx {
+
+/** An OutputSurface that is simply a buffer in (host) memory, it doesn't
+  * require a window or an openGL context.
+  */
+class SoftwareSurface final : public OutputSurface
+{
+public:
+	explicit SoftwareSurface(gl::ivec2 size);
+
+	/** Change the size, this invalidates the content. */
+	void resize(gl::ivec2 size);
+
+	[[nodiscard]] std::span<Pixel> getPixels() {
+		auto [w, h] = getPhysicalSize();
+		return {pixels.data(), size_t(w) * size_t(h)};
+	}
+	[[nodiscard]] std::span<Pixel> getLine(unsigned y) {
+		auto w = size_t(getPhysicalSize().x);
+		return getPixels().subspan(y * w, w);
+	}
+
+	/** Who painted the current content (nullptr after a resize). This
+	  * allows a painter to skip repainting identical content.
+	  */
+	[[nodiscard]] const void* getPainter() const { return painter; }
+	void setPainter(const void* p) { painter = p; }
+
+	// OutputSurface
+	void saveScreenshot(const std::string& filename) override;
+
+private:
+	MemBuffer<Pixel, SSE_ALIGNMENT> pixels;
+	const void* painter = nullptr;
+};
+
+} // namespace openmsx
+
+#endif
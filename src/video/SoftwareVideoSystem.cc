@@ -0,0 +1,154 @@
+#include "SoftwareVideoSystem.hh"
+#include "SoftwareSurface.hh"
+#include "FBPostProcessor.hh"
+#include "SDLRasterizer.hh"
+#include "V9990SDLRasterizer.hh"
+#include "Reactor.hh"
+#include "Display.hh"
+#include "RenderSettings.hh"
+#include "IntegerSetting.hh"
+#include "VDP.hh"
+#include "V9990.hh"
+#include "unreachable.hh"
+#include <algorithm>
+#include <memory>
+
+#include "components.hh"
+#if COMPONENT_LASERDISC
+#include "LaserdiscPlayer.hh"
+#include "LDSDLRasterizer.hh"
+#endif
+
+namespace openmsx {
+
+SoftwareVideoSystem::SoftwareVideoSystem(Reactor& reactor)
+	: display(reactor.getDisplay())
+	, renderSettings(display.getRenderSettings())
+	, scaler(renderSettings.getRenderThreads())
+	, screen(std::make_unique<SoftwareSurface>(getSurfaceSize()))
+{
+	renderSettings.getScaleFactorSetting().attach(*this);
+	renderSettings.getRenderThreadsSetting().attach(*this);
+}
+
+SoftwareVideoSystem::~SoftwareVideoSystem()
+{
+	renderSettings.getRenderThreadsSetting().detach(*this);
+	renderSettings.getScaleFactorSetting().detach(*this);
+}
+
+gl::ivec2 SoftwareVideoSystem::getSurfaceSize() const
+{
+	// SoftwareScaler supports output widths of 320 up to 1280 pixels.
+	int factor = std::clamp(renderSettings.getScaleFactor(), 1, 4);
+	return {320 * factor, 240 * factor};
+}
+
+std::unique_ptr<Rasterizer> SoftwareVideoSystem::createRasterizer(VDP& vdp)
+{
+	assert(renderSettings.getRenderer() == RenderSettings::RendererID::SOFTWARE);
+	std::string videoSource = (vdp.getName() == "VDP")
+	                        ? "MSX" // for backwards compatibility
+	                        : vdp.getName();
+	auto& motherBoard = vdp.getMotherBoard();
+	return std::make_unique<SDLRasterizer>(
+		vdp, display, *screen,
+		std::make_unique<FBPostProcessor>(
+			motherBoard, display, *screen, scaler,
+			videoSource, 640, 240, true));
+}
+
+std::unique_ptr<V9990Rasterizer> SoftwareVideoSystem::createV9990Rasterizer(
+	V9990& vdp)
+{
+	assert(renderSettings.getRenderer() == RenderSettings::RendererID::SOFTWARE);
+	std::string videoSource = (vdp.getName() == "Sunrise GFX9000")
+	                        ? "GFX9000" // for backwards compatibility
+	                        : vdp.getName();
+	MSXMotherBoard& motherBoard = vdp.getMotherBoard();
+	return std::make_unique<V9990SDLRasterizer>(
+		vdp, display, *screen,
+		std::make_unique<FBPostProcessor>(
+			motherBoard, display, *screen, scaler,
+			videoSource, 1280, 240, true));
+}
+
+#if COMPONENT_LASERDISC
+std::unique_ptr<LDRasterizer> SoftwareVideoSystem::createLDRasterizer(
+	LaserdiscPlayer& ld)
+{
+	assert(renderSettings.getRenderer() == RenderSettings::RendererID::SOFTWARE);
+	std::string videoSource = "Laserdisc"; // TODO handle multiple???
+	MSXMotherBoard& motherBoard = ld.getMotherBoard();
+	return std::make_unique<LDSDLRasterizer>(
+		std::make_unique<FBPostProcessor>(
+			motherBoard, display, *screen, scaler,
+			videoSource, 640, 480, false));
+}
+#endif
+
+void SoftwareVideoSystem::flush()
+{
+	// nothing to show
+}
+
+void SoftwareVideoSystem::takeScreenShot(const std::string& filename, bool /*withOsd*/)
+{
+	// There are no OSD layers, the surface always has the latest content.
+	screen->saveScreenshot(filename);
+}
+
+gl::ivec2 SoftwareVideoSystem::getMouseCoord()
+{
+	return {0, 0};
+}
+
+OutputSurface* SoftwareVideoSystem::getOutputSurface()
+{
+	return screen.get();
+}
+
+void SoftwareVideoSystem::showCursor(bool /*show*/)
+{
+}
+
+bool SoftwareVideoSystem::getCursorEnabled()
+{
+	return false;
+}
+
+std::string SoftwareVideoSystem::getClipboardText()
+{
+	return "";
+}
+
+void SoftwareVideoSystem::setClipboardText(zstring_view /*text*/)
+{
+}
+
+std::optional<gl::ivec2> SoftwareVideoSystem::getWindowPosition()
+{
+	return {};
+}
+
+void SoftwareVideoSystem::setWindowPosition(gl::ivec2 /*pos*/)
+{
+}
+
+void SoftwareVideoSystem::repaint()
+{
+	display.repaintImpl();
+}
+
+void SoftwareVideoSystem::update(const Setting& subject) noexcept
+{
+	if (&subject == &renderSettings.getScaleFactorSetting()) {
+		screen->resize(getSurfaceSize());
+	} else if (&subject == &renderSettings.getRenderThreadsSetting()) {
+		scaler.setNumThreads(renderSettings.getRenderThreads());
+	} else {
+		UNREACHABLE;
+	}
+}
+
+} // namespace openmsx
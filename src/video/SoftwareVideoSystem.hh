@@ -0,0 +1,64 @@
+#ifndef SOFTWAREVIDEOSYSTEM_HH
+#define SOFTWAREVIDEOSYSTEM_HH
+
+#include "VideoSystem.hh"
+#include "Observer.hh"
+#include "SoftwareScaler.hh"
+#include "components.hh"
+#include <memory>
+
+namespace openmsx {
+
+class Display;
+class Reactor;
+class RenderSettings;
+class Setting;
+class SoftwareSurface;
+
+/** A video system that renders into a buffer in (host) memory, entirely on
+  * the CPU. It doesn't open a window nor does it need openGL, so it's
+  * usable on headless machines. The output is only observable via
+  * screenshots and video recordings.
+  */
+class SoftwareVideoSystem final : public VideoSystem, private Observer<Setting>
+{
+public:
+	explicit SoftwareVideoSystem(Reactor& reactor);
+	~SoftwareVideoSystem() override;
+
+	// VideoSystem interface:
+	[[nodiscard]] std::unique_ptr<Rasterizer> createRasterizer(VDP& vdp) override;
+	[[nodiscard]] std::unique_ptr<V9990Rasterizer> createV9990Rasterizer(
+		V9990& vdp) override;
+#if COMPONENT_LASERDISC
+	[[nodiscard]] std::unique_ptr<LDRasterizer> createLDRasterizer(
+		LaserdiscPlayer& ld) override;
+#endif
+	void flush() override;
+	void takeScreenShot(const std::string& filename, bool withOsd) override;
+	[[nodiscard]] gl::ivec2 getMouseCoord() override;
+	[[nodiscard]] OutputSurface* getOutputSurface() override;
+	void showCursor(bool show) override;
+	[[nodiscard]] bool getCursorEnabled() override;
+	[[nodiscard]] std::string getClipboardText() override;
+	void setClipboardText(zstring_view text) override;
+	[[nodiscard]] std::optional<gl::ivec2> getWindowPosition() override;
+	void setWindowPosition(gl::ivec2 pos) override;
+	void repaint() override;
+
+private:
+	// Observer
+	void update(const Setting& subject) noexcept override;
+
+	[[nodiscard]] gl::ivec2 getSurfaceSize() const;
+
+private:
+	Display& display;
+	RenderSettings& renderSettings;
+	SoftwareScaler scaler;
+	std::unique_ptr<SoftwareSurface> screen;
+};
+
+} // namespace openmsx
+
+#endif
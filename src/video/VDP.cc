@@ -1190,6 +1190,7 @@ void VDP::changeRegister(byte reg, byte val, EmuTime::param time)
 			// confirmed: VRAM remapping only happens on TMS99xx
 			// see VDPVRAM for details on the remapping itself
 			vram->change4k8kMapping((val & 0x80) != 0);
+			renderer->updateWindow(true, time);
 		}
 		break;
 	case 2:
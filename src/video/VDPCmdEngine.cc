@@ -38,15 +38,19 @@ TODO:
 #include "VDPVRAM.hh"
 
 #include "EmuTime.hh"
+#include "Scheduler.hh"
 #include "serialize.hh"
 
 #include "unreachable.hh"
+#include "xrange.hh"
 
 #include <algorithm>
 #include <array>
 #include <cassert>
 #include <iostream>
+#include <span>
 #include <string_view>
+#include <type_traits>
 
 namespace openmsx {
 
@@ -669,6 +673,9 @@ struct DummyOp {
 	{
 		// Undefined logical operations do nothing.
 	}
+	void operator()(byte& /*dst*/, byte /*src*/, byte /*color*/, byte /*mask*/) const
+	{
+	}
 };
 
 struct ImpOp {
@@ -677,6 +684,10 @@ struct ImpOp {
 	{
 		vram.cmdWrite(addr, (src & mask) | color, time);
 	}
+	void operator()(byte& dst, byte src, byte color, byte mask) const
+	{
+		dst = (src & mask) | color;
+	}
 };
 
 struct AndOp {
@@ -685,6 +696,10 @@ struct AndOp {
 	{
 		vram.cmdWrite(addr, src & (color | mask), time);
 	}
+	void operator()(byte& dst, byte src, byte color, byte mask) const
+	{
+		dst = src & (color | mask);
+	}
 };
 
 struct OrOp {
@@ -693,6 +708,10 @@ struct OrOp {
 	{
 		vram.cmdWrite(addr, src | color, time);
 	}
+	void operator()(byte& dst, byte src, byte color, byte /*mask*/) const
+	{
+		dst = src | color;
+	}
 };
 
 struct XorOp {
@@ -701,6 +720,10 @@ struct XorOp {
 	{
 		vram.cmdWrite(addr, src ^ color, time);
 	}
+	void operator()(byte& dst, byte src, byte color, byte /*mask*/) const
+	{
+		dst = src ^ color;
+	}
 };
 
 struct NotOp {
@@ -709,6 +732,10 @@ struct NotOp {
 	{
 		vram.cmdWrite(addr, (src & mask) | ~(color | mask), time);
 	}
+	void operator()(byte& dst, byte src, byte color, byte mask) const
+	{
+		dst = (src & mask) | ~(color | mask);
+	}
 };
 
 template<typename Op>
@@ -721,6 +748,10 @@ struct TransparentOp : Op {
 		//      the same address between the command read and write
 		if (color) Op::operator()(time, vram, addr, src, color, mask);
 	}
+	void operator()(byte& dst, byte src, byte color, byte mask) const
+	{
+		if (color) Op::operator()(dst, src, color, mask);
+	}
 };
 using TImpOp = TransparentOp<ImpOp>;
 using TAndOp = TransparentOp<AndOp>;
@@ -729,6 +760,110 @@ using TXorOp = TransparentOp<XorOp>;
 using TNotOp = TransparentOp<NotOp>;
 
 
+// Fast path for the block commands:
+
+/** The VRAM of one line in a bitmap mode, obtained via
+  * VDPVRAM::cmdWriteBlock(). In the planar modes (Graphic 6 and 7) a line is
+  * spread over two 128-byte blocks (one in each plane), in the other modes
+  * both blocks are the same.
+  */
+class LineBlocks
+{
+public:
+	LineBlocks(std::span<byte, 128> block0_, std::span<byte, 128> block1_,
+	           unsigned addr0_)
+		: block0(block0_), block1(block1_), addr0(addr0_) {}
+
+	/** Get the VRAM byte at the given address, this address must be
+	  * inside this line. */
+	[[nodiscard]] byte& operator[](unsigned addr) const {
+		assert(((addr ^ addr0) & ~(0x10000 | 127)) == 0);
+		return ((addr ^ addr0) & 0x10000) ? block1[addr & 127]
+		                                  : block0[addr & 127];
+	}
+
+private:
+	std::span<byte, 128> block0;
+	std::span<byte, 128> block1;
+	unsigned addr0;
+};
+
+/** Executes a logical operation on a LineBlocks object instead of via
+  * VDPVRAM::cmdWrite(), so that it can be passed to the Mode::pset()
+  * functions. */
+template<typename LogOp>
+struct BlockOp {
+	void operator()(EmuTime::param /*time*/, VDPVRAM& /*vram*/, unsigned addr,
+	                byte src, byte color, byte mask) const
+	{
+		LogOp()(blocks[addr], src, color, mask);
+	}
+	const LineBlocks& blocks;
+};
+
+/** Advance 'calculator' over the VRAM accesses of 'num' elements (pixels or
+  * bytes). Each element does one access per entry in 'deltas', such an entry
+  * is the delay till the next access. On success the calculator ends at the
+  * last access of the last element. Returns false when the limit is reached
+  * before that access, then the calculator is left at an unspecified
+  * position.
+  */
+static bool skipAccesses(VDPAccessSlots::Calculator& calculator, unsigned num,
+                         std::span<const Delta> deltas)
+{
+	assert(num > 0);
+	for (auto i : xrange(num)) {
+		for (auto j : xrange(deltas.size())) {
+			if (calculator.limitReached()) return false;
+			if ((i == (num - 1)) && (j == (deltas.size() - 1))) return true;
+			calculator.next(deltas[j]);
+		}
+	}
+	UNREACHABLE;
+}
+
+template<typename Mode, typename ExecuteLine>
+bool VDPCmdEngine::executeLines(
+	VDPAccessSlots::Calculator& calculator, unsigned& tmpNY,
+	std::span<const Delta> deltas, Delta lineDelta, ExecuteLine executeLine)
+{
+	// The address calculations below don't work for the non-planar
+	// 256 bytes per line layout.
+	if constexpr (std::is_same_v<Mode, NonBitmapMode>) {
+		return false;
+	} else {
+		if (!cmdFastPathSetting.getBoolean()) return false;
+		while (true) {
+			unsigned addr0 = Mode::addressOf(0, DY, false);
+			unsigned addr1 = Mode::addressOf(Mode::PIXELS_PER_BYTE, DY, false);
+			auto canWrite = [&](EmuTime::param t) {
+				return vram.cmdCanWriteBlock(addr0, t) &&
+				       vram.cmdCanWriteBlock(addr1, t);
+			};
+			// Cheap check first, so that the timing is only
+			// calculated twice when it's likely worth it.
+			if (!canWrite(calculator.getTime())) return false;
+			auto c = calculator;
+			if (!skipAccesses(c, ANX, deltas)) return false;
+			EmuTime time = c.getTime();
+			if (!canWrite(time)) return false;
+
+			auto block0 = vram.cmdWriteBlock(addr0, time);
+			auto block1 = ((addr0 ^ addr1) & ~127u)
+			            ? vram.cmdWriteBlock(addr1, time) : block0;
+			executeLine(LineBlocks(block0, block1, addr0));
+
+			calculator = c;
+			if (--tmpNY == 0) {
+				commandDone(time);
+				return true;
+			}
+			calculator.next(lineDelta);
+		}
+	}
+}
+
+
 // Commands
 
 void VDPCmdEngine::setStatusChangeTime(EmuTime::param t)
@@ -990,9 +1125,29 @@ void VDPCmdEngine::executeLmmv(EmuTime::param limit)
 	byte CL = COL & Mode::COLOR_MASK;
 	bool dstExt = (ARG & MXD) != 0;
 	bool doPset = !dstExt || hasExtendedVRAM;
-	unsigned addr = Mode::addressOf(ADX, DY, dstExt);
 	auto calculator = getSlotCalculator(limit);
 
+	if ((phase == 0) && !dstExt) {
+		static constexpr std::array deltas = {Delta::D24, Delta::D72};
+		if (executeLines<Mode>(calculator, tmpNY, deltas, Delta::D136,
+		                       [&](const LineBlocks& blocks) {
+			BlockOp<LogOp> op{blocks};
+			repeat(ANX, [&] {
+				unsigned a = Mode::addressOf(ADX, DY, false);
+				tmpDst = blocks[a];
+				Mode::pset(EmuTime::dummy(), vram, ADX, a,
+				           tmpDst, CL, op);
+				ADX += TX;
+			});
+			DY += TY; --NY;
+			ADX = DX; ANX = tmpNX;
+		})) {
+			engineTime = calculator.getTime();
+			return;
+		}
+	}
+
+	unsigned addr = Mode::addressOf(ADX, DY, dstExt);
 	switch (phase) {
 	case 0:
 loop:		if (calculator.limitReached()) [[unlikely]] { phase = 0; break; }
@@ -1116,9 +1271,30 @@ void VDPCmdEngine::executeLmmm(EmuTime::param limit)
 	bool dstExt  = (ARG & MXD) != 0;
 	bool doPoint = !srcExt || hasExtendedVRAM;
 	bool doPset  = !dstExt || hasExtendedVRAM;
-	unsigned dstAddr = Mode::addressOf(ADX, DY, dstExt);
 	auto calculator = getSlotCalculator(limit);
 
+	if ((phase == 0) && !srcExt && !dstExt) {
+		static constexpr std::array deltas = {Delta::D32, Delta::D24, Delta::D64};
+		if (executeLines<Mode>(calculator, tmpNY, deltas, Delta::D128,
+		                       [&](const LineBlocks& blocks) {
+			BlockOp<LogOp> op{blocks};
+			repeat(ANX, [&] {
+				tmpSrc = Mode::point(vram, ASX, SY, false);
+				unsigned a = Mode::addressOf(ADX, DY, false);
+				tmpDst = blocks[a];
+				Mode::pset(EmuTime::dummy(), vram, ADX, a,
+				           tmpDst, tmpSrc, op);
+				ASX += TX; ADX += TX;
+			});
+			SY += TY; DY += TY; --NY;
+			ASX = SX; ADX = DX; ANX = tmpNX;
+		})) {
+			engineTime = calculator.getTime();
+			return;
+		}
+	}
+
+	unsigned dstAddr = Mode::addressOf(ADX, DY, dstExt);
 	switch (phase) {
 	case 0:
 loop:		if (calculator.limitReached()) [[unlikely]] { phase = 0; break; }
@@ -1377,6 +1553,22 @@ void VDPCmdEngine::executeHmmv(EmuTime::param limit)
 	bool doPset = !dstExt || hasExtendedVRAM;
 	auto calculator = getSlotCalculator(limit);
 
+	if (!dstExt) {
+		static constexpr std::array deltas = {Delta::D48};
+		if (executeLines<Mode>(calculator, tmpNY, deltas, Delta::D104,
+		                       [&](const LineBlocks& blocks) {
+			repeat(ANX, [&] {
+				blocks[Mode::addressOf(ADX, DY, false)] = COL;
+				ADX += TX;
+			});
+			DY += TY; --NY;
+			ADX = DX; ANX = tmpNX;
+		})) {
+			engineTime = calculator.getTime();
+			return;
+		}
+	}
+
 	while (!calculator.limitReached()) {
 		if (doPset) [[likely]] {
 			vram.cmdWrite(Mode::addressOf(ADX, DY, dstExt),
@@ -1485,6 +1677,23 @@ void VDPCmdEngine::executeHmmm(EmuTime::param limit)
 	bool doPset  = !dstExt || hasExtendedVRAM;
 	auto calculator = getSlotCalculator(limit);
 
+	if ((phase == 0) && !srcExt && !dstExt) {
+		static constexpr std::array deltas = {Delta::D24, Delta::D64};
+		if (executeLines<Mode>(calculator, tmpNY, deltas, Delta::D128,
+		                       [&](const LineBlocks& blocks) {
+			repeat(ANX, [&] {
+				tmpSrc = vram.cmdReadWindow.readNP(Mode::addressOf(ASX, SY, false));
+				blocks[Mode::addressOf(ADX, DY, false)] = tmpSrc;
+				ASX += TX; ADX += TX;
+			});
+			SY += TY; DY += TY; --NY;
+			ASX = SX; ADX = DX; ANX = tmpNX;
+		})) {
+			engineTime = calculator.getTime();
+			return;
+		}
+	}
+
 	switch (phase) {
 	case 0:
 loop:		if (calculator.limitReached()) [[unlikely]] { phase = 0; break; }
@@ -1623,6 +1832,23 @@ void VDPCmdEngine::executeYmmm(EmuTime::param limit)
 	bool doPset  = !dstExt || hasExtendedVRAM;
 	auto calculator = getSlotCalculator(limit);
 
+	if ((phase == 0) && !dstExt) {
+		static constexpr std::array deltas = {Delta::D24, Delta::D40};
+		if (executeLines<Mode>(calculator, tmpNY, deltas, Delta::D40,
+		                       [&](const LineBlocks& blocks) {
+			repeat(ANX, [&] {
+				tmpSrc = vram.cmdReadWindow.readNP(Mode::addressOf(ADX, SY, false));
+				blocks[Mode::addressOf(ADX, DY, false)] = tmpSrc;
+				ADX += TX;
+			});
+			SY += TY; DY += TY; --NY;
+			ADX = DX; ANX = tmpNX;
+		})) {
+			engineTime = calculator.getTime();
+			return;
+		}
+	}
+
 	switch (phase) {
 	case 0:
 loop:		if (calculator.limitReached()) [[unlikely]] { phase = 0; break; }
@@ -1782,11 +2008,19 @@ VDPCmdEngine::VDPCmdEngine(VDP& vdp_, CommandController& commandController)
 		"detected while the previous command is still in progress.",
 		"",
 		Setting::Save::YES)
+	, cmdFastPathSetting(
+		commandController, vdp_.getName() == "VDP" ? "vdpcmdfastpath" :
+		vdp_.getName() + " vdpcmdfastpath",
+		"Execute the VDP block commands line by line when possible "
+		"(same result, only turn off for testing)",
+		true, Setting::Save::NO)
 	, executingProbe(
 		vdp_.getMotherBoard().getDebugger(),
 		strCat(vdp.getName(), '.', "commandExecuting"),
 		"Is the V99x8 VDP is currently executing a command",
 		false)
+	, profiler(vdp_.getScheduler().getDeviceProfiler())
+	, profileId(profiler.getId(DeviceProfiler::Category::VDP_COMMAND, vdp_.getName()))
 	, hasExtendedVRAM(vram.getSize() == (192 * 1024))
 {
 }
@@ -2019,6 +2253,11 @@ void VDPCmdEngine::executeCommand(EmuTime::param time)
 }
 
 void VDPCmdEngine::sync2(EmuTime::param time)
+{
+	profiler.measure(profileId, [&] { doSync(time); });
+}
+
+void VDPCmdEngine::doSync(EmuTime::param time)
 {
 	switch ((scrMode << 8) | CMD) {
 	case 0x000: case 0x100: case 0x200: case 0x300: case 0x400:
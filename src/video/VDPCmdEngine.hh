@@ -5,11 +5,14 @@
 #include "VDPAccessSlots.hh"
 
 #include "BooleanSetting.hh"
+#include "DeviceProfiler.hh"
 #include "Probe.hh"
 #include "TclCallback.hh"
 #include "openmsx.hh"
 #include "serialize_meta.hh"
 
+#include <span>
+
 namespace openmsx {
 
 class VDPVRAM;
@@ -122,6 +125,7 @@ public:
 	void serialize(Archive& ar, unsigned version);
 
 private:
+	void doSync(EmuTime::param time);
 	void executeCommand(EmuTime::param time);
 
 	void setStatusChangeTime(EmuTime::param t);
@@ -154,6 +158,31 @@ private:
 	template<typename Mode>                 void executeYmmm(EmuTime::param limit);
 	template<typename Mode>                 void executeHmmc(EmuTime::param limit);
 
+	/** Fast path for the block commands: execute complete lines (the
+	  * first line may already be partially done) at once, with a single
+	  * VRAM update per 128-byte block, see VDPVRAM::cmdWriteBlock(). This
+	  * is only done while the whole line executes before the limit of
+	  * 'calculator' and none of the VRAM observers needs to see the
+	  * individual writes. The timing is the same as for the regular (per
+	  * access) loops. It can be turned off with the 'vdpcmdfastpath'
+	  * setting.
+	  * @param calculator Positioned at the first access of the current
+	  *        line. On return it's positioned at the first access of the
+	  *        first line that was not executed, or at the last access when
+	  *        the command finished.
+	  * @param tmpNY The number of lines left, including the current line.
+	  * @param deltas The accesses of one element, see skipAccesses().
+	  * @param lineDelta The delay after the last access of a line.
+	  * @param executeLine Executes the current line on the given
+	  *        LineBlocks object, this includes the register updates at the
+	  *        end of the line (except for NY).
+	  * @return Did the command finish?
+	  */
+	template<typename Mode, typename ExecuteLine>
+	bool executeLines(VDPAccessSlots::Calculator& calculator, unsigned& tmpNY,
+	                  std::span<const VDPAccessSlots::Delta> deltas,
+	                  VDPAccessSlots::Delta lineDelta, ExecuteLine executeLine);
+
 	// Advance to the next access slot at or past the given time.
 	inline EmuTime getNextAccessSlot(EmuTime::param time) const {
 		return vdp.getAccessSlot(time, VDPAccessSlots::Delta::D0);
@@ -192,9 +221,15 @@ private:
 	  */
 	BooleanSetting cmdTraceSetting;
 	TclCallback cmdInProgressCallback;
+	/** Allows to turn off executeLines(), to compare both paths.
+	  */
+	BooleanSetting cmdFastPathSetting;
 
 	Probe<bool> executingProbe;
 
+	DeviceProfiler& profiler;
+	DeviceProfiler::Id profileId;
+
 	/** Time at which the next vram access slot is available.
 	  * Only valid when a command is executing.
 	  */
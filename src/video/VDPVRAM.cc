@@ -103,6 +103,7 @@ static constexpr unsigned bufferSize(unsigned size)
 VDPVRAM::VDPVRAM(VDP& vdp_, unsigned size, EmuTime::param time)
 	: vdp(vdp_)
 	, data(*vdp_.getDeviceConfig2().getXML(), bufferSize(size))
+	, dirtyPages(bufferSize(size))
 	, logicalVRAMDebug (vdp)
 	, physicalVRAMDebug(vdp, size)
 	, actualSize(size)
@@ -128,6 +129,7 @@ VDPVRAM::VDPVRAM(VDP& vdp_, unsigned size, EmuTime::param time)
 void VDPVRAM::clear()
 {
 	// Initialise VRAM data array.
+	dirtyPages.markAll();
 	data.clear(0); // fill with zeros (unless initialContent is specified)
 	if (data.size() != actualSize) {
 		assert(data.size() > actualSize);
@@ -201,6 +203,7 @@ void VDPVRAM::updateVRMode(bool newVRmode, EmuTime::param time)
 	}
 	vrMode = newVRmode;
 	setSizeMask(time);
+	dirtyPages.markAll(); // the swap below touches all (128kB) pages
 
 	if (vrMode) {
 		// switch from VR=0 to VR=1
@@ -294,6 +297,7 @@ void VDPVRAM::change4k8kMapping(bool mapping8k)
 	}
 	//ranges::copy(tmp, std::span{data}); // TODO error with clang-15/libc++
 	ranges::copy(tmp, std::span{data.begin(), data.end()});
+	dirtyPages.markRange(0, tmp.size());
 }
 
 
@@ -318,7 +322,7 @@ void VDPVRAM::serialize(Archive& ar, unsigned /*version*/)
 		setSizeMask(static_cast<MSXDevice&>(vdp).getCurrentTime());
 	}
 
-	ar.serialize_blob("data", std::span{data.data(), actualSize});
+	ar.serialize_blob("data", std::span{data.data(), actualSize}, dirtyPages);
 	ar.serialize("cmdReadWindow",       cmdReadWindow,
 	             "cmdWriteWindow",      cmdWriteWindow,
 	             "nameTable",           nameTable,
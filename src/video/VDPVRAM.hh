@@ -6,6 +6,7 @@
 #include "VDPCmdEngine.hh"
 #include "SimpleDebuggable.hh"
 #include "Ram.hh"
+#include "DirtyPages.hh"
 #include "Math.hh"
 #include "openmsx.hh"
 #include <cassert>
@@ -119,6 +120,10 @@ class DummyVRAMObserver final : public VRAMObserver
 public:
 	void updateVRAM(unsigned /*offset*/, EmuTime::param /*time*/) override {}
 	void updateWindow(bool /*enabled*/, EmuTime::param /*time*/) override {}
+	[[nodiscard]] bool needsExactUpdates(unsigned /*first*/, unsigned /*last*/,
+	                                     EmuTime::param /*time*/) const override {
+		return false;
+	}
 };
 
 /** Specifies an address range in the VRAM.
@@ -320,6 +325,22 @@ public:
 		}
 	}
 
+	/** Does a change in the address range [first, last] need to be
+	  * reported byte per byte to the observer of this window? See
+	  * VRAMObserver::needsExactUpdates().
+	  */
+	[[nodiscard]] inline bool needsExactUpdates(
+			unsigned first, unsigned last, EmuTime::param time) const {
+		// Only the address bits that are the same for the whole range
+		// are checked, so a range might be considered (partly) inside
+		// while it's not. That's fine, the observer will decide.
+		unsigned varying = Math::floodRight(first ^ last);
+		if ((first & combiMask & ~varying) != (baseAddr & ~varying)) {
+			return false;
+		}
+		return observer->needsExactUpdates(first, last, time);
+	}
+
 	/** Inform VRAMWindow of changed sizeMask.
 	  * For the moment this only happens when switching the VR bit in VDP
 	  * register 8 (in VR=0 mode only 32kB VRAM is addressable).
@@ -444,6 +465,47 @@ public:
 		writeCommon(address, value, time);
 	}
 
+	/** The command engine has a fast path for the block commands that
+	  * writes VRAM per 128-byte block (one line in the bitmap modes)
+	  * instead of per byte, see VDPCmdEngine.
+	  * Can the block that contains the given address be written like that,
+	  * for changes up to the given time? IOW is the block backed by RAM
+	  * and does no observer need to be informed of each individual change
+	  * in this block?
+	  * @param address Any (physical) address in the block.
+	  * @param time The moment in emulated time of the last change.
+	  */
+	[[nodiscard]] inline bool cmdCanWriteBlock(unsigned address, EmuTime::param time) const {
+		unsigned first = address & sizeMask & ~127u;
+		unsigned last = first + 127;
+		if (last >= actualSize) return false;
+		return !bitmapVisibleWindow.needsExactUpdates(first, last, time)
+		    && !spriteAttribTable  .needsExactUpdates(first, last, time)
+		    && !spritePatternTable .needsExactUpdates(first, last, time);
+	}
+
+	/** Get write access to the block that contains the given address, see
+	  * cmdCanWriteBlock(). This informs the observers that (possibly) the
+	  * whole block changes, so it must be called before the block is
+	  * changed.
+	  * @param address Any (physical) address in the block.
+	  * @param time The moment in emulated time of the last change.
+	  */
+	[[nodiscard]] inline std::span<byte, 128> cmdWriteBlock(unsigned address, EmuTime::param time) {
+		assert(vdp.isInsideFrame(time));
+		assert(cmdCanWriteBlock(address, time));
+		unsigned first = address & sizeMask & ~127u;
+		#ifdef DEBUG
+		assert(time >= vramTime);
+		vramTime = time;
+		#endif
+		bitmapVisibleWindow.notify(first, time);
+		spriteAttribTable.notify(first, time);
+		spritePatternTable.notify(first, time);
+		dirtyPages.mark(first);
+		return std::span<byte, 128>{&data[first], 128};
+	}
+
 	/** Write a byte to VRAM through the CPU interface.
 	  * @param address The address to write.
 	  * @param value The value to write.
@@ -590,6 +652,7 @@ private:
 		spritePatternTable.notify(address, time);
 
 		data[address] = value;
+		dirtyPages.mark(address);
 
 		// Cache dirty marking should happen after the commit,
 		// otherwise the cache could be re-validated based on old state.
@@ -628,6 +691,10 @@ private:
 	  */
 	Ram data;
 
+	/** Pages of 'data' written since the last reverse snapshot.
+	  */
+	DirtyPages dirtyPages;
+
 	/** Debuggable with mode dependent view on the vram
 	  *   Screen7/8 are not interleaved in this mode.
 	  *   This debuggable is also at least 128kB in size (it possibly
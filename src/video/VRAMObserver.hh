@@ -35,6 +35,22 @@ public:
 	  */
 	virtual void updateWindow(bool enabled, EmuTime::param time) = 0;
 
+	/** Does this observer need to be informed of each individual change
+	  * in the address range [first, last], at the exact moment it occurs?
+	  * If not, the changes in this range up to the given time may instead
+	  * be reported with a single updateVRAM() call per 128-byte block (see
+	  * VDPVRAM::cmdWriteBlock()).
+	  * Note: unlike for updateVRAM() these are addresses, not offsets.
+	  * @param first The first address in the range.
+	  * @param last The last address in the range (inclusive).
+	  * @param time The moment in emulated time the last change occurs.
+	  */
+	[[nodiscard]] virtual bool needsExactUpdates(
+		unsigned /*first*/, unsigned /*last*/, EmuTime::param /*time*/) const
+	{
+		return true;
+	}
+
 protected:
 	~VRAMObserver() = default;
 };
@@ -2,14 +2,12 @@
 
 #include "ZMBVEncoder.hh"
 
-#include "FrameSource.hh"
 #include "PixelOperations.hh"
 
 #include "cstd.hh"
 #include "endian.hh"
 #include "narrow.hh"
 #include "ranges.hh"
-#include "unreachable.hh"
 
 #include <array>
 #include <bit>
@@ -286,21 +284,7 @@ void ZMBVEncoder::addFullFrame(unsigned& workUsed)
 	});
 }
 
-const ZMBVEncoder::Pixel* ZMBVEncoder::getScaledLine(const FrameSource* frame, unsigned y, Pixel* workBuf) const
-{
-	switch (height) {
-	case 240:
-		return frame->getLinePtr320_240(y, std::span<uint32_t, 320>(workBuf, 320)).data();
-	case 480:
-		return frame->getLinePtr640_480(y, std::span<uint32_t, 640>(workBuf, 640)).data();
-	case 720:
-		return frame->getLinePtr960_720(y, std::span<uint32_t, 960>(workBuf, 960)).data();
-	default:
-		UNREACHABLE;
-	}
-}
-
-std::span<const uint8_t> ZMBVEncoder::compressFrame(bool keyFrame, const FrameSource* frame)
+std::span<const uint8_t> ZMBVEncoder::compressFrame(bool keyFrame, std::span<const Pixel> frame)
 {
 	std::swap(newFrame, oldFrame); // replace oldFrame with newFrame
 
@@ -327,16 +311,11 @@ std::span<const uint8_t> ZMBVEncoder::compressFrame(bool keyFrame, const FrameSo
 	}
 
 	// copy lines (to add black border)
-	static constexpr size_t pixelSize = sizeof(Pixel);
-	auto linePitch = pitch * pixelSize;
-	auto lineWidth = size_t(width) * pixelSize;
-	uint8_t* dest =
-		&newFrame[pixelSize * (MAX_VECTOR + MAX_VECTOR * pitch)];
+	assert(frame.size() == size_t(width) * height);
+	auto* dest = &(std::bit_cast<Pixel*>(newFrame.data()))[MAX_VECTOR + MAX_VECTOR * pitch];
 	for (auto i : xrange(height)) {
-		const auto* scaled = std::bit_cast<const uint8_t*>(
-			getScaledLine(frame, i, std::bit_cast<Pixel*>(dest)));
-		if (scaled != dest) memcpy(dest, scaled, lineWidth);
-		dest += linePitch;
+		ranges::copy(frame.subspan(i * width, width), dest);
+		dest += pitch;
 	}
 
 	// Add the frame data.
@@ -14,8 +14,6 @@
 
 namespace openmsx {
 
-class FrameSource;
-
 class ZMBVEncoder
 {
 public:
@@ -29,7 +27,14 @@ public:
 	ZMBVEncoder& operator=(ZMBVEncoder&&) = delete;
 	~ZMBVEncoder() = default;
 
-	[[nodiscard]] std::span<const uint8_t> compressFrame(bool keyFrame, const FrameSource* frame);
+	/** Encode one frame.
+	  * @param keyFrame Encode as key frame (no dependency on the previous frame).
+	  * @param frame The (already scaled) pixels, 'width x height' pixels,
+	  *              line after line without padding.
+	  * Does not access any emulator state, so it can be called from a
+	  * different thread than the one that captured the frame.
+	  */
+	[[nodiscard]] std::span<const uint8_t> compressFrame(bool keyFrame, std::span<const Pixel> frame);
 
 private:
 	void setupBuffers();
@@ -39,7 +44,6 @@ private:
 	[[nodiscard]] unsigned possibleBlock(int vx, int vy, size_t offset);
 	[[nodiscard]] unsigned compareBlock(int vx, int vy, size_t offset);
 	void addXorBlock(int vx, int vy, size_t offset, unsigned& workUsed);
-	[[nodiscard]] const Pixel* getScaledLine(const FrameSource* frame, unsigned y, Pixel* workBuf) const;
 
 private:
 	MemBuffer<uint8_t, SSE_ALIGNMENT> oldFrame;
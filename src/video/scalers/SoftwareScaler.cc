@@ -0,0 +1,73 @@
+#include "SoftwareScaler.hh"
+
+#include "FrameSource.hh"
+#include "LineScalers.hh"
+#include "PixelOperations.hh"
+#include "RawFrame.hh"
+
+#include "aligned.hh"
+#include "narrow.hh"
+#include "one_of.hh"
+#include "ranges.hh"
+#include "xrange.hh"
+
+#include <array>
+#include <cassert>
+
+namespace openmsx {
+
+void SoftwareScaler::scale(
+	const FrameSource& src, const RawFrame* superImpose, unsigned scanline,
+	std::span<Pixel> dst, unsigned width, unsigned height)
+{
+	assert(width == one_of(320u, 640u, 960u, 1280u));
+	assert(dst.size() >= size_t(width) * height);
+
+	auto numBands = workers.getNumThreads();
+	workers.run(numBands, [&](unsigned i) {
+		scaleLines(src, superImpose, scanline, dst, width, height,
+		           height * i / numBands, height * (i + 1) / numBands);
+	});
+}
+
+void SoftwareScaler::scaleLines(
+	const FrameSource& src, const RawFrame* superImpose, unsigned scanline,
+	std::span<Pixel> dst, unsigned width, unsigned height,
+	unsigned startY, unsigned endY)
+{
+	assert(endY <= height);
+	unsigned srcHeight = src.getHeight();
+	// Scanlines only for a whole number of output lines per source line.
+	unsigned linesPerSrc = ((height % srcHeight) == 0) ? (height / srcHeight) : 0;
+	bool doScanline = (scanline < 255) && (linesPerSrc >= 2);
+
+	ALIGNAS_SSE std::array<Pixel, 1280> videoBuf;
+	auto video = std::span{videoBuf}.first(width);
+	std::span<Pixel> prevLine;
+	int prevSrcY = -1;
+	for (auto y : xrange(startY, endY)) {
+		auto line = dst.subspan(y * size_t(width), width);
+		auto srcY = narrow<int>(y * srcHeight / height);
+		if ((srcY == prevSrcY) && !superImpose) {
+			// Same source line as the previous output line (and that
+			// line is never a scanline gap), no need to scale again.
+			ranges::copy(prevLine, line);
+		} else {
+			auto l = src.getLine(srcY, line);
+			if (l.data() != line.data()) ranges::copy(l, line);
+			if (superImpose) {
+				auto videoY = narrow<int>(y * superImpose->getHeight() / height);
+				auto v = superImpose->getLine(videoY, video);
+				alphaBlendLines(line, v, line);
+			}
+		}
+		prevLine = line;
+		prevSrcY = srcY;
+
+		if (doScanline && ((y % linesPerSrc) == (linesPerSrc - 1))) {
+			for (auto& p : line) p = PixelOperations::multiply(p, scanline);
+		}
+	}
+}
+
+} // namespace openmsx
@@ -0,0 +1,63 @@
+#ifndef SOFTWARESCALER_HH
+#define SOFTWARESCALER_HH
+
+#include "WorkerPool.hh"
+
+#include <cstdint>
+#include <span>
+
+namespace openmsx {
+
+class FrameSource;
+class RawFrame;
+
+/** Scales a FrameSource into an in-memory pixel buffer on the CPU, using the
+  * routines from LineScalers.hh. The result is similar to the 'simple' GL
+  * scaler: pixels are replicated and (for integer vertical scale factors)
+  * the last output line of each source line is darkened to simulate
+  * scanlines.
+  *
+  * Each output line is calculated independently, so the output can be split
+  * in horizontal bands that are scaled in parallel.
+  */
+class SoftwareScaler
+{
+public:
+	using Pixel = uint32_t;
+
+	/** @param numThreads Number of threads used by scale(), this includes
+	  *                   the calling thread (so 1 means single threaded).
+	  */
+	explicit SoftwareScaler(unsigned numThreads = 1)
+		: workers(numThreads) {}
+
+	void setNumThreads(unsigned numThreads) { workers.setNumThreads(numThreads); }
+	[[nodiscard]] unsigned getNumThreads() const { return workers.getNumThreads(); }
+
+	/** Scale the given frame to fill the output buffer.
+	  * @param src The frame to scale.
+	  * @param superImpose When not nullptr, this (video) frame is shown
+	  *                    behind the transparent pixels of 'src'.
+	  * @param scanline The brightness [0..255] of the scanline gaps, 255
+	  *                 means no scanlines.
+	  * @param dst Output buffer, 'width' x 'height' pixels.
+	  * @param width Output width, must be 320, 640, 960 or 1280.
+	  * @param height Output height.
+	  */
+	void scale(const FrameSource& src, const RawFrame* superImpose, unsigned scanline,
+	           std::span<Pixel> dst, unsigned width, unsigned height);
+
+	/** Same as scale(), but only calculates output lines [startY, endY),
+	  * always on the calling thread.
+	  */
+	static void scaleLines(const FrameSource& src, const RawFrame* superImpose, unsigned scanline,
+	                       std::span<Pixel> dst, unsigned width, unsigned height,
+	                       unsigned startY, unsigned endY);
+
+private:
+	WorkerPool workers;
+};
+
+} // namespace openmsx
+
+#endif
@@ -55,7 +55,7 @@ bool V9990SDLRasterizer::isActive()
 {
 	return postProcessor->needRender() &&
 	       vdp.getMotherBoard().isActive() &&
-	       !vdp.getMotherBoard().isFastForwarding();
+	       !vdp.getMotherBoard().skipRendering();
 }
 
 void V9990SDLRasterizer::reset()